@@ -87,6 +87,7 @@ INCLUDE_DIRS := $(patsubst %,-I%,$(INCDIRS) $(SRC) $(call filter_dirs,$(call rec
 # DEFINEs to be used when building C/C++ code
 MAIN_DEFINES := $(DEFINES) -DMRI_ENABLE=$(DEVICE_MRI_ENABLE) -DMRI_INIT_PARAMETERS='"$(MRI_INIT_PARAMETERS)"'
 MAIN_DEFINES += -DMRI_BREAK_ON_INIT=$(MRI_BREAK_ON_INIT) -DMRI_SEMIHOST_STDIO=$(MRI_SEMIHOST_STDIO)
+MAIN_DEFINES += -DTLSF_HEAP=$(TLSF_HEAP)
 
 # Libraries to be linked into final binary
 SYS_LIBS  := -lstdc++ -lsupc++ -lm -lgcc -lc -lgcc -lc -lnosys
@@ -118,9 +119,16 @@ else
 MRI_WRAPS :=
 endif
 
+# The TLSF heap also takes the calloc() and reentrant allocations which newlib makes internally.
+ifeq "$(TLSF_HEAP)" "1"
+HEAP_WRAPS := ,--wrap=calloc,--wrap=_malloc_r,--wrap=_realloc_r,--wrap=_free_r,--wrap=_calloc_r
+else
+HEAP_WRAPS :=
+endif
+
 # Linker Options.
 $(MBED_DEVICE): LD_FLAGS := $(LD_FLAGS) -specs=$(GCC4MBED_DIR)/build/startfile.spec -u mbed_sdk_init -u mbed_main
-$(MBED_DEVICE): LD_FLAGS += -Wl,-Map=$(OUTDIR)/$(PROJECT).map,--cref,--gc-sections,--wrap=_isatty,--wrap=malloc,--wrap=realloc,--wrap=free,--wrap=main$(MRI_WRAPS)
+$(MBED_DEVICE): LD_FLAGS += -Wl,-Map=$(OUTDIR)/$(PROJECT).map,--cref,--gc-sections,--wrap=_isatty,--wrap=malloc,--wrap=realloc,--wrap=free,--wrap=main$(MRI_WRAPS)$(HEAP_WRAPS)
 ifneq "$(NO_FLOAT_SCANF)" "1"
 $(MBED_DEVICE): LD_FLAGS += -u _scanf_float
 endif
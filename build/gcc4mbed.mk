@@ -90,6 +90,11 @@
 #   MRI_UART: Select the UART to be used by the debugger.  See mri.h for
 #             allowed values.
 #             default: MRI_UART_MBED_USB - Use USB based UART on the mbed.
+#   TLSF_HEAP: Set to 1 to have malloc(), free(), realloc(), calloc(), new
+#              and delete use the O(1) TLSF heap of mbed_heap.h in place of
+#              newlib's, which also allows allocations from interrupt
+#              handlers.
+#              default: 0 - use the newlib heap.
 #
 # Example makefile:
 #       PROJECT      := HelloWorld
@@ -131,6 +136,7 @@ MRI_BREAK_ON_INIT ?= 1
 MRI_UART          ?= MRI_UART_MBED_USB
 DEVICES           ?= LPC1768
 NEWLIB_NANO       ?= 1
+TLSF_HEAP         ?= 0
 
 
 # Configure MRI variables based on GCC4MBED_TYPE build type variable.
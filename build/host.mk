@@ -0,0 +1,251 @@
+# Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+###############################################################################
+# USAGE:
+# Builds a project and a subset of the official mbed libraries with the
+# host's native compiler so that they can be unit tested and benchmarked on
+# Linux or OS X.  More information can be found at following link:
+#  https://github.com/adamgreen/gcc4mbed/blob/master/notes/host.creole
+#
+# Variables that must be defined in including makefile.
+#   PROJECT: Name to be given to the output executable for this project.
+#   GCC4MBED_DIR: The root directory for where the gcc4mbed sources are located
+#                 in your project.  This should point to the parent directory
+#                 of the build directory which contains this host.mk file.
+#
+# Variables that may be optionally set in makefile.
+#   SRC: The root directory for the sources of your project.  Defaults to '.'.
+#   HOST_LIBS: Specifies which official mbed libraries have host ports and
+#              should be built along with the application.  These include:
+#               net/eth - lwIP, the Socket classes and the paired in-memory
+#                         EMAC found in lwip-eth/arch/TARGET_HOST.
+#               net/https - HTTPSClient and axTLS, on top of net/lwip.
+#               rtos - The rtos:: classes on a simulation of RTX, in which
+#                      threads are pthreads run one at a time by priority,
+#                      with a virtual clock for timeouts.
+#               heap - The TLSF heap of mbed_heap.h, locked with a pthread
+#                      mutex in place of masking interrupts.
+#               rpc - The RPC dispatcher.  There is no host port of the mbed
+#                     API so the project supplies the mbed.h, platform.h and
+#                     PinNames.h that it includes, Stream and Timer for
+#                     RPCStream, as well as parse_pins().
+#   DEFINES: Project specific #defines to be set when compiling both the main
+#            application and the mbed libraries.  Each macro should start
+#            with "-D" as required by GCC.
+#   INCDIRS: Space delimited list of extra directories to use for #include
+#            searches.
+#   GPFLAGS: Additional compiler flags used when building C++ sources.
+#   GCFLAGS: Additional compiler flags used when building C sources.
+#   LIBS: Additional host libraries to link against (ie. -lssl).
+#   OPTIMIZATION: Optional variable that can be set to s, g, 0, 1, 2, or 3 for
+#                 overriding the compiler's optimization level.  Defaults to 2.
+#   RUN_ARGS: Command line arguments passed to the executable by the run rule.
+#   VERBOSE: When set to 1, all build commands will be displayed to console.
+#
+# Example makefile:
+#       PROJECT      := NetBench
+#       GCC4MBED_DIR := ../..
+#       HOST_LIBS    := net/eth
+#
+#       include $(GCC4MBED_DIR)/build/host.mk
+#
+###############################################################################
+
+# Check for undefined variables.
+ifndef PROJECT
+$(error makefile must set PROJECT variable.)
+endif
+
+ifndef GCC4MBED_DIR
+$(error makefile must set GCC4MBED_DIR.)
+endif
+
+
+# Set VERBOSE make variable to 1 to output all tool commands.
+VERBOSE?=0
+ifeq "$(VERBOSE)" "0"
+Q := @
+else
+Q :=
+endif
+
+
+# Default variables.
+SRC          ?= .
+OPTIMIZATION ?= 2
+
+
+#  Compiler/Linker Paths
+HOST_GCC ?= gcc
+HOST_GPP ?= g++
+HOST_LD  ?= g++
+
+REMOVE_DIR = rm -r -f
+MKDIR      = mkdir -p
+QUIET      = > /dev/null 2>&1 ; exit 0
+
+
+# Add in library dependencies.
+HOST_LIBS := $(patsubst net/eth,net/lwip net/eth,$(HOST_LIBS))
+HOST_LIBS := $(patsubst net/https,net/lwip net/https,$(HOST_LIBS))
+HOST_LIBS := $(sort $(HOST_LIBS))
+
+
+# Directories where mbed source files are found.
+MBED_LIB_SRC_ROOT := $(GCC4MBED_DIR)/external/mbed/libraries
+
+
+# Output directory and final executable.
+OUTDIR     := Host
+TARGET_EXE := $(OUTDIR)/$(PROJECT)
+
+
+# Macros for selecting sources/objects to be built for the host.  Directories
+# named TARGET_* are only kept when they are TARGET_HOST.
+recurse_dir    = $(patsubst %/,%,$(sort $1 $(shell find $1 -type d)))
+find_srcs      = $(foreach i,c cpp,$(foreach j,$1,$(wildcard $j/*.$i)))
+other_targets  = $(filter-out TARGET_HOST,$(sort $(filter TARGET_%,$(notdir $1))))
+filter_targets = $(foreach d,$1,$(if $(filter $(call other_targets,$1),$(subst /, ,$d)),,$d))
+host_dirs      = $(call filter_targets,$(call recurse_dir,$1))
+
+
+###############################################################################
+# Library sources and include directories.
+###############################################################################
+HOST_LIB_SRCS :=
+HOST_LIB_INCS :=
+
+# The rtos:: classes on the host simulation of RTX in rtx/TARGET_HOST, whose
+# cmsis_os.h must be found before the stand-in from lwip-sys/TARGET_HOST.
+# Tickless idle, tracing, stack statistics and the us_ticker based
+# HighResTimer are only found on the target.
+ifeq "$(findstring rtos,$(HOST_LIBS))" "rtos"
+    RTOS_DIRS     := $(call host_dirs,$(MBED_LIB_SRC_ROOT)/rtos)
+    HOST_LIB_SRCS += $(filter-out %/Tickless.cpp %/Trace.cpp %/StackStats.cpp %/HighResTimer.cpp,$(call find_srcs,$(RTOS_DIRS)))
+    HOST_LIB_INCS += $(RTOS_DIRS) $(MBED_LIB_SRC_ROOT)/mbed/api
+endif
+
+# The TLSF heap, which is only given the regions the application adds.
+ifeq "$(findstring heap,$(HOST_LIBS))" "heap"
+    HOST_LIB_SRCS += $(MBED_LIB_SRC_ROOT)/mbed/common/mbed_heap.c
+    HOST_LIB_INCS += $(MBED_LIB_SRC_ROOT)/mbed/api
+endif
+
+# lwIP and the Socket classes.  The pthreads port in lwip-sys/TARGET_HOST
+# replaces the CMSIS-RTOS port found in lwip-sys/arch.
+ifeq "$(findstring net/lwip,$(HOST_LIBS))" "net/lwip"
+    LWIP_DIRS     := $(filter-out %/lwip-sys %/lwip-sys/arch,$(call host_dirs,$(MBED_LIB_SRC_ROOT)/net/lwip))
+    HOST_LIB_SRCS += $(call find_srcs,$(LWIP_DIRS))
+    HOST_LIB_INCS += $(LWIP_DIRS)
+    # TCPSocketConnection::send_file() takes a FileHandle from the mbed API.
+    HOST_LIB_INCS += $(MBED_LIB_SRC_ROOT)/mbed/api
+endif
+
+# Host EMAC driver.  EthernetInterface itself depends on the rtos library and
+# is therefore only used for its headers.
+ifeq "$(findstring net/eth,$(HOST_LIBS))" "net/eth"
+    ETH_DIRS      := $(call host_dirs,$(MBED_LIB_SRC_ROOT)/net/eth)
+    HOST_LIB_SRCS += $(call find_srcs,$(filter-out %/EthernetInterface,$(ETH_DIRS)))
+    HOST_LIB_INCS += $(ETH_DIRS)
+endif
+
+# HTTPSClient and axTLS.
+ifeq "$(findstring net/https,$(HOST_LIBS))" "net/https"
+    HTTPS_DIRS    := $(call host_dirs,$(MBED_LIB_SRC_ROOT)/net/https)
+    HOST_LIB_SRCS += $(call find_srcs,$(HTTPS_DIRS))
+    HOST_LIB_INCS += $(HTTPS_DIRS)
+endif
+
+# RPC dispatcher, along with the pinmap.h it needs from the HAL.  parse_pins.cpp
+# only knows the pins of real targets.
+ifeq "$(findstring rpc,$(HOST_LIBS))" "rpc"
+    HOST_LIB_SRCS += $(filter-out %/parse_pins.cpp,$(call find_srcs,$(MBED_LIB_SRC_ROOT)/rpc))
+    HOST_LIB_INCS += $(MBED_LIB_SRC_ROOT)/rpc $(MBED_LIB_SRC_ROOT)/mbed/hal
+endif
+
+
+###############################################################################
+# Build flags
+###############################################################################
+DEP_FLAGS := -MMD -MP
+
+C_FLAGS := -O$(OPTIMIZATION) -g3 -pthread -DTARGET_HOST $(DEFINES)
+# Keep symbols such as axTLS's RSA_free() and SHA1_Init() from interposing on
+# the functions of the same name in host libraries like OpenSSL.
+C_FLAGS += -fvisibility=hidden
+C_FLAGS += -Wall -Wextra -Wno-unused-parameter -Wno-missing-field-initializers -Wno-missing-braces
+C_FLAGS += $(DEP_FLAGS)
+C_FLAGS += $(patsubst %,-I%,$(INCDIRS) $(SRC) $(HOST_LIB_INCS))
+
+CPP_FLAGS := $(C_FLAGS) -std=gnu++11 -Wno-literal-suffix $(GPFLAGS)
+C_FLAGS   += -std=gnu99 $(GCFLAGS)
+
+LD_FLAGS := -pthread
+SYS_LIBS := $(LIBS)
+ifeq "$(shell uname)" "Linux"
+SYS_LIBS += -lrt
+endif
+
+
+###############################################################################
+# Objects
+###############################################################################
+APP_OBJECTS := $(patsubst $(SRC)/%,$(OUTDIR)/%.o,$(basename $(call find_srcs,$(call recurse_dir,$(SRC)))))
+APP_OBJECTS := $(filter-out $(OUTDIR)/$(OUTDIR)/%,$(APP_OBJECTS))
+LIB_OBJECTS := $(patsubst $(MBED_LIB_SRC_ROOT)/%,$(OUTDIR)/mbed/%.o,$(basename $(HOST_LIB_SRCS)))
+OBJECTS     := $(APP_OBJECTS) $(LIB_OBJECTS)
+DEPFILES    := $(patsubst %.o,%.d,$(OBJECTS))
+
+
+###############################################################################
+# Rules
+###############################################################################
+.PHONY: all clean run
+
+all: $(TARGET_EXE)
+
+run: $(TARGET_EXE)
+	$(Q) $(TARGET_EXE) $(RUN_ARGS)
+
+clean:
+	@echo Cleaning $(PROJECT)/$(OUTDIR)
+	$(Q) $(REMOVE_DIR) $(OUTDIR) $(QUIET)
+
+$(TARGET_EXE): $(OBJECTS)
+	@echo Linking $@
+	$(Q) $(HOST_LD) $(LD_FLAGS) $+ $(SYS_LIBS) -o $@
+
+$(OUTDIR)/mbed/%.o : $(MBED_LIB_SRC_ROOT)/%.c makefile
+	@echo Compiling $<
+	$(Q) $(MKDIR) $(dir $@) $(QUIET)
+	$(Q) $(HOST_GCC) $(C_FLAGS) -c $< -o $@
+
+$(OUTDIR)/mbed/%.o : $(MBED_LIB_SRC_ROOT)/%.cpp makefile
+	@echo Compiling $<
+	$(Q) $(MKDIR) $(dir $@) $(QUIET)
+	$(Q) $(HOST_GPP) $(CPP_FLAGS) -c $< -o $@
+
+$(OUTDIR)/%.o : $(SRC)/%.c makefile
+	@echo Compiling $<
+	$(Q) $(MKDIR) $(dir $@) $(QUIET)
+	$(Q) $(HOST_GCC) $(C_FLAGS) -c $< -o $@
+
+$(OUTDIR)/%.o : $(SRC)/%.cpp makefile
+	@echo Compiling $<
+	$(Q) $(MKDIR) $(dir $@) $(QUIET)
+	$(Q) $(HOST_GPP) $(CPP_FLAGS) -c $< -o $@
+
+
+# Pull in all header dependencies.
+-include $(DEPFILES)
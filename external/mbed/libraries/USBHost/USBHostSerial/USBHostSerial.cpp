@@ -227,7 +227,8 @@ void USBHostSerialPort::init(void)
     line_coding.data_bits = 8;
     line_coding.parity = None;
     line_coding.stop_bits = 1;
-    circ_buf.flush();
+    circ_buf.reset();
+    rx_dropped = 0;
 }
 
 void USBHostSerialPort::connect(USBHost* _host, USBDeviceConnected * _dev,
@@ -254,9 +255,11 @@ void USBHostSerialPort::rxHandler() {
     if (bulk_in) {
         int len = bulk_in->getLengthTransferred();
         if (bulk_in->getState() == USB_TYPE_IDLE) {
-            for (int i = 0; i < len; i++) {
-                circ_buf.queue(buf[i]);
-            }
+            // This runs in the thread shared by every USB device, so bytes
+            // which don't fit are counted and dropped rather than waited on
+            int i = circ_buf.write(buf, len);
+            if (i < len)
+                rx_dropped += len - i;
             rx.call();
             host->bulkRead(dev, bulk_in, buf, size_bulk_in, false);
         }
@@ -303,8 +306,7 @@ int USBHostSerialPort::_getc() {
         init();
         return -1;
     }
-    while (circ_buf.isEmpty());
-    circ_buf.dequeue(&c);
+    while (!circ_buf.get(&c));
     return c;
 }
 
@@ -328,8 +330,12 @@ int USBHostSerialPort::readBuf(char* b, int s)
     int i = 0;
     if (bulk_in)
     {
-        for (i = 0; i < s; )
+        while (i < s)
+        {
+            // Block for the first byte, then take whatever else is queued
             b[i++] = getc();
+            i += circ_buf.read((uint8_t *)(b+i), s-i);
+        }
     }
     return i;
 }
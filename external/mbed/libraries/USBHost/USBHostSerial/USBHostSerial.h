@@ -23,7 +23,7 @@
 
 #include "USBHost.h"
 #include "Stream.h"
-#include "MtxCircBuffer.h"
+#include "SPSCRingBuffer.h"
 
 /**
  * A class to communicate a USB virtual serial port
@@ -58,6 +58,15 @@ public:
     */
     uint8_t available();
 
+    /**
+    * Check the number of bytes dropped because they arrived while the
+    * receive buffer was full.  The newest bytes are dropped, so that a
+    * reader which falls behind doesn't hold up the other USB devices.
+    *
+    * @returns the number of bytes dropped since the device was connected
+    */
+    uint32_t dropped() const { return rx_dropped; }
+
     /**
      *  Attach a member function to call when a packet is received.
      *
@@ -122,7 +131,9 @@ private:
 
     void init();
 
-    MtxCircBuffer<uint8_t, 128> circ_buf;
+    // Written by rxHandler() in the USBHost thread, read by the caller
+    mbed::SPSCRingBuffer<uint8_t, 128> circ_buf;
+    volatile uint32_t rx_dropped;
 
     uint8_t buf[64];
 
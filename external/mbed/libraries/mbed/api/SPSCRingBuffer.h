@@ -0,0 +1,314 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_SPSCRINGBUFFER_H
+#define MBED_SPSCRINGBUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+
+namespace mbed {
+
+/** Lock-free ring buffer for one writer and one reader
+ *
+ * The writer and the reader may be different threads, or a thread and an
+ * interrupt handler, without a mutex or disabling interrupts, as each index
+ * is only ever stored by one side.  Items are copied with memcpy() and may be
+ * written and read in bulk, or in place through the contiguous spans
+ * returned by write_span() and read_span().
+ *
+ * Either side can ask to be woken once a number of items, or of free
+ * slots, is reached, so that the other side only has to signal a waiting
+ * thread, with a Semaphore for example, when there is enough for it to do:
+ * @code
+ * // Reader thread                          // Writer interrupt handler
+ * if (!ring.arm_reader(16))                 ring.write(data, length);
+ *     semaphore.wait();                     if (ring.reader_wakeup())
+ * ring.read(buffer, sizeof(buffer));            semaphore.release();
+ * @endcode
+ *
+ * @tparam T Type of the items, which is copied with memcpy().
+ * @tparam BufferSize Number of items the buffer holds, a power of two.
+ */
+template<typename T, uint32_t BufferSize>
+class SPSCRingBuffer {
+public:
+    SPSCRingBuffer() {
+        // The indices run freely and are masked, so must wrap with the size.
+        (void)sizeof(char[(BufferSize && !(BufferSize & (BufferSize - 1))) ? 1 : -1]);
+        reset();
+    }
+
+    /** Empty the buffer and forget any wakeups, while neither side is using it
+     */
+    void reset() {
+        _head = 0;
+        _tail = 0;
+        _reader_wants = 0;
+        _reader_armed = 0;
+        _reader_woken = 0;
+        _writer_wants = 0;
+        _writer_armed = 0;
+        _writer_woken = 0;
+    }
+
+    /** Number of items which can be read
+     */
+    uint32_t available() const {
+        return _head - _tail;
+    }
+
+    /** Number of items which can be written
+     */
+    uint32_t space() const {
+        return BufferSize - (_head - _tail);
+    }
+
+    bool empty() const {
+        return _head == _tail;
+    }
+
+    bool full() const {
+        return (_head - _tail) == BufferSize;
+    }
+
+    /** Write one item, from the writer side
+     *
+     *  @returns false if the buffer is full
+     */
+    bool put(const T& item) {
+        uint32_t head = _head;
+
+        if ((head - _tail) == BufferSize) {
+            return false;
+        }
+        _buffer[head & (BufferSize - 1)] = item;
+        barrier();
+        _head = head + 1;
+        return true;
+    }
+
+    /** Write as many of the items as fit, from the writer side
+     *
+     *  @returns the number of items written
+     */
+    uint32_t write(const T* data, uint32_t length) {
+        uint32_t written = 0;
+
+        // At most two copies, either side of the end of the buffer.
+        while (written < length) {
+            T* span;
+            uint32_t count = write_span(&span);
+            if (count == 0) {
+                break;
+            }
+            if (count > length - written) {
+                count = length - written;
+            }
+            memcpy(span, data + written, count * sizeof(T));
+            commit(count);
+            written += count;
+        }
+        return written;
+    }
+
+    /** Get the free slots which can be filled in place, from the writer side
+     *
+     *  @param span Set to the first free slot.
+     *  @returns the number of contiguous free slots, up to the end of the buffer
+     */
+    uint32_t write_span(T** span) {
+        uint32_t head = _head;
+        uint32_t offset = head & (BufferSize - 1);
+        uint32_t count = BufferSize - (head - _tail);
+
+        if (count > BufferSize - offset) {
+            count = BufferSize - offset;
+        }
+        *span = &_buffer[offset];
+        return count;
+    }
+
+    /** Make items filled in through write_span() readable
+     */
+    void commit(uint32_t length) {
+        barrier();
+        _head = _head + length;
+    }
+
+    /** Read one item, from the reader side
+     *
+     *  @returns false if the buffer is empty
+     */
+    bool get(T* item) {
+        uint32_t tail = _tail;
+
+        if (_head == tail) {
+            return false;
+        }
+        barrier();
+        *item = _buffer[tail & (BufferSize - 1)];
+        barrier();
+        _tail = tail + 1;
+        return true;
+    }
+
+    /** Read up to length items, from the reader side
+     *
+     *  @returns the number of items read
+     */
+    uint32_t read(T* data, uint32_t length) {
+        uint32_t done = 0;
+
+        while (done < length) {
+            const T* span;
+            uint32_t count = read_span(&span);
+            if (count == 0) {
+                break;
+            }
+            if (count > length - done) {
+                count = length - done;
+            }
+            memcpy(data + done, span, count * sizeof(T));
+            consume(count);
+            done += count;
+        }
+        return done;
+    }
+
+    /** Get the items which can be read in place, from the reader side
+     *
+     *  @param span Set to the first item.
+     *  @returns the number of contiguous items, up to the end of the buffer
+     */
+    uint32_t read_span(const T** span) {
+        uint32_t tail = _tail;
+        uint32_t offset = tail & (BufferSize - 1);
+        uint32_t count = _head - tail;
+
+        barrier();
+        if (count > BufferSize - offset) {
+            count = BufferSize - offset;
+        }
+        *span = &_buffer[offset];
+        return count;
+    }
+
+    /** Free items read in place through read_span()
+     */
+    void consume(uint32_t length) {
+        barrier();
+        _tail = _tail + length;
+    }
+
+    /** Ask to be woken once count items can be read, from the reader side
+     *
+     *  @returns true if they already can, in which case the writer may still
+     *  signal a wakeup, so that whoever waits must check available() again
+     */
+    bool arm_reader(uint32_t count) {
+        return arm(&_reader_wants, &_reader_armed, count, &SPSCRingBuffer::available);
+    }
+
+    /** Cancel the wakeup asked for by arm_reader(), after a timeout
+     */
+    void disarm_reader() {
+        _reader_wants = 0;
+    }
+
+    /** Check, from the writer side after writing, whether the reader asked to
+     *  be woken and now can read what it asked for
+     *
+     *  @returns true at most once for each call to arm_reader()
+     */
+    bool reader_wakeup() {
+        return wakeup(&_reader_wants, &_reader_armed, &_reader_woken, &SPSCRingBuffer::available);
+    }
+
+    /** Ask to be woken once count items can be written, from the writer side
+     *
+     *  @returns true if they already can, in which case the reader may still
+     *  signal a wakeup, so that whoever waits must check space() again
+     */
+    bool arm_writer(uint32_t count) {
+        return arm(&_writer_wants, &_writer_armed, count, &SPSCRingBuffer::space);
+    }
+
+    /** Cancel the wakeup asked for by arm_writer(), after a timeout
+     */
+    void disarm_writer() {
+        _writer_wants = 0;
+    }
+
+    /** Check, from the reader side after reading, whether the writer asked to
+     *  be woken and now has the space it asked for
+     *
+     *  @returns true at most once for each call to arm_writer()
+     */
+    bool writer_wakeup() {
+        return wakeup(&_writer_wants, &_writer_armed, &_writer_woken, &SPSCRingBuffer::space);
+    }
+
+private:
+    typedef uint32_t (SPSCRingBuffer::*Level)() const;
+
+    static void barrier() {
+        __sync_synchronize();
+    }
+
+    // The side being woken owns wants and armed, the other side owns woken.
+    // Their stores are ordered against those of the indices so that either
+    // the waiting side sees enough items, or the other side sees the wakeup.
+    bool arm(volatile uint32_t* wants, volatile uint32_t* armed, uint32_t count, Level level) {
+        *wants = count;
+        barrier();
+        *armed = *armed + 1;
+        barrier();
+        if ((this->*level)() >= count) {
+            *wants = 0;
+            return true;
+        }
+        return false;
+    }
+
+    bool wakeup(volatile uint32_t* wants, volatile uint32_t* armed, volatile uint32_t* woken, Level level) {
+        barrier();
+        uint32_t sequence = *armed;
+        if (sequence == *woken) {
+            return false;
+        }
+        barrier();
+        uint32_t count = *wants;
+        if (count == 0 || (this->*level)() < count) {
+            return false;
+        }
+        *woken = sequence;
+        return true;
+    }
+
+    T _buffer[BufferSize];
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+    volatile uint32_t _reader_wants;
+    volatile uint32_t _reader_armed;
+    volatile uint32_t _reader_woken;
+    volatile uint32_t _writer_wants;
+    volatile uint32_t _writer_armed;
+    volatile uint32_t _writer_woken;
+};
+
+} // namespace mbed
+
+#endif
@@ -0,0 +1,101 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MBED_HEAP_H
+#define MBED_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** A two level segregated fit (TLSF) heap, whose allocations and frees take
+ * the same few steps whatever the size or the state of the heap.
+ *
+ * Free blocks are kept in lists by size class, found through two levels of
+ * bitmaps, and are merged with their free neighbours as soon as they are
+ * freed, which keeps fragmentation low on units which run for a long time.
+ * Each call masks interrupts for those few steps, so that the heap may be
+ * used from any thread, under RTX or not, and from interrupt handlers.
+ *
+ * The heap grows through _sbrk() with the GCC toolchain, and can be given
+ * more regions of RAM, such as the AHB SRAM banks of the LPC1768.  Blocks of
+ * up to a few sizes can also be served from pools of fixed sized blocks,
+ * which are never merged, so that many small and short lived objects don't
+ * cut the heap up.
+ *
+ * With gcc4mbed, setting TLSF_HEAP to 1 in the project makefile routes
+ * malloc(), free(), realloc(), calloc(), new and delete to this heap.
+ *
+ * @code
+ * // All of AHB SRAM bank 1 on an LPC1768 where nothing else is placed in it.
+ * mbed_heap_add_region((void*)0x20080000, 16 * 1024);
+ * // Blocks of up to 32 bytes from a pool of 64.
+ * mbed_heap_add_pool(32, 64);
+ * @endcode
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t size;          /**< Bytes in all regions */
+    uint32_t used;          /**< Bytes in allocated blocks, headers included */
+    uint32_t peak;          /**< Highest value of used */
+    uint32_t largest_free;  /**< Bytes in the largest free block */
+    uint32_t fragmentation; /**< Percentage of the free bytes outside of the largest free block */
+    uint32_t allocs;        /**< Successful allocations, pools included */
+    uint32_t frees;         /**< Blocks freed, pools included */
+    uint32_t failures;      /**< Allocations which found no block */
+    uint32_t pooled;        /**< Allocations served from pools */
+    uint32_t regions;       /**< Regions added, _sbrk() growth included */
+} mbed_heap_stats_t;
+
+void* mbed_heap_malloc(size_t size);
+void* mbed_heap_calloc(size_t count, size_t size);
+void* mbed_heap_realloc(void* ptr, size_t size);
+void  mbed_heap_free(void* ptr);
+
+/** Give a region of RAM to the heap
+ *
+ * @param start Start of the region, aligned up to 8 bytes.
+ * @param size Size of the region in bytes.
+ * @returns 0 on success, -1 if the region is too small to hold a block.
+ */
+int mbed_heap_add_region(void* start, size_t size);
+
+/** Serve blocks of up to block_size bytes, which no smaller pool serves,
+ *  from a pool of count blocks taken from the heap
+ *
+ * Requests fall back to the heap while the pool is empty.  Up to 4 pools
+ * may be added, and they are never given back.
+ *
+ * @returns 0 on success, -1 if there is no room for the pool.
+ */
+int mbed_heap_add_pool(size_t block_size, size_t count);
+
+/** Fill in the statistics of the heap */
+void mbed_heap_stats(mbed_heap_stats_t* stats);
+
+/** Walk every block and free list, checking that they agree
+ *
+ * @returns 0 if the heap is consistent, -1 otherwise.
+ */
+int mbed_heap_check(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
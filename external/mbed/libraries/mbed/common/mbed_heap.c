@@ -0,0 +1,616 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+#include "mbed_heap.h"
+#ifdef TARGET_HOST
+#include <pthread.h>
+#else
+#include "cmsis.h"
+#endif
+
+/* A block starts with the address of the block before it, which is only
+ * kept while that block is free and otherwise belongs to its payload, then
+ * its size with two flags in the low bits.  The 8 byte aligned payload
+ * follows, where a free block keeps its links in the list of its size
+ * class.  Sizes count the whole block, up to the next one.  Each region ends
+ * with a sentinel block of size 0, which is never free.
+ */
+typedef struct heap_block {
+    struct heap_block* prev_phys;
+    size_t             size;
+    struct heap_block* next_free;
+    struct heap_block* prev_free;
+} heap_block_t;
+
+/* Regions are chained through a header at their start. */
+typedef struct heap_region {
+    struct heap_region* next;
+    heap_block_t*       sentinel;
+} heap_region_t;
+
+typedef struct {
+    char*  start;
+    char*  end;
+    size_t block_size;
+    void*  free;
+} heap_pool_t;
+
+#define BLOCK_FREE      1
+#define BLOCK_PREV_FREE 2
+#define BLOCK_FLAGS     (BLOCK_FREE | BLOCK_PREV_FREE)
+
+/* Sizes below SMALL_SIZE have a list every ALIGN bytes.  Above it, each
+ * power of two is split into SL_COUNT lists, up to blocks of 2^FL_MAX. */
+#define ALIGN_LOG2      3
+#define ALIGN           (1 << ALIGN_LOG2)
+#define SL_LOG2         3
+#define SL_COUNT        (1 << SL_LOG2)
+#define FL_SHIFT        (SL_LOG2 + ALIGN_LOG2)
+#define FL_MAX          18
+#define FL_COUNT        (FL_MAX - FL_SHIFT + 1)
+#define SMALL_SIZE      (1 << FL_SHIFT)
+
+#define HEADER          offsetof(heap_block_t, next_free)
+#define OVERHEAD        sizeof(size_t)
+#define BLOCK_MIN       sizeof(heap_block_t)
+#define BLOCK_MAX       (((size_t)1 << FL_MAX) - ALIGN)
+#define REGION_HEADER   ((sizeof(heap_region_t) + ALIGN - 1) & ~(size_t)(ALIGN - 1))
+
+#define HEAP_POOLS      4
+#define HEAP_GROW       1024
+
+static uint32_t          fl_bitmap;
+static uint32_t          sl_bitmap[FL_COUNT];
+static heap_block_t*     free_lists[FL_COUNT][SL_COUNT];
+static heap_region_t*    regions;
+static heap_pool_t       pools[HEAP_POOLS];
+static int               pool_count;
+static size_t            free_bytes;
+static mbed_heap_stats_t stats;
+
+
+#ifdef TARGET_HOST
+static pthread_mutex_t heap_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t heap_lock(void) {
+    pthread_mutex_lock(&heap_mutex);
+    return 0;
+}
+
+static void heap_unlock(uint32_t state) {
+    pthread_mutex_unlock(&heap_mutex);
+}
+#else
+static uint32_t heap_lock(void) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    return primask;
+}
+
+static void heap_unlock(uint32_t primask) {
+    __set_PRIMASK(primask);
+}
+#endif
+
+
+static int fls(size_t value) {
+    return 31 - __builtin_clz((unsigned int)value);
+}
+
+static size_t block_size(const heap_block_t* block) {
+    return block->size & ~(size_t)BLOCK_FLAGS;
+}
+
+static heap_block_t* block_next(heap_block_t* block) {
+    return (heap_block_t*)((char*)block + block_size(block));
+}
+
+static void* block_payload(heap_block_t* block) {
+    return (char*)block + HEADER;
+}
+
+static heap_block_t* payload_block(void* ptr) {
+    return (heap_block_t*)((char*)ptr - HEADER);
+}
+
+/* Size of the block which holds a payload of size bytes, or 0 if too big. */
+static size_t block_fit(size_t size) {
+    if (size > BLOCK_MAX - OVERHEAD) {
+        return 0;
+    }
+    size = (size + OVERHEAD + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+    return size < BLOCK_MIN ? BLOCK_MIN : size;
+}
+
+static void mapping(size_t size, int* fl, int* sl) {
+    if (size < SMALL_SIZE) {
+        *fl = 0;
+        *sl = (int)(size / ALIGN);
+    } else {
+        int bit = fls(size);
+        *sl = (int)(size >> (bit - SL_LOG2)) ^ SL_COUNT;
+        *fl = bit - (FL_SHIFT - 1);
+    }
+}
+
+static void insert_free(heap_block_t* block) {
+    int fl, sl;
+
+    mapping(block_size(block), &fl, &sl);
+    block->next_free = free_lists[fl][sl];
+    block->prev_free = NULL;
+    if (block->next_free) {
+        block->next_free->prev_free = block;
+    }
+    free_lists[fl][sl] = block;
+    fl_bitmap |= 1U << fl;
+    sl_bitmap[fl] |= 1U << sl;
+    free_bytes += block_size(block);
+}
+
+static void remove_free(heap_block_t* block) {
+    int fl, sl;
+
+    mapping(block_size(block), &fl, &sl);
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        free_lists[fl][sl] = block->next_free;
+        if (!block->next_free) {
+            sl_bitmap[fl] &= ~(1U << sl);
+            if (!sl_bitmap[fl]) {
+                fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+    free_bytes -= block_size(block);
+}
+
+/* First block of the lowest list whose blocks all hold size bytes. */
+static heap_block_t* find_free(size_t size) {
+    uint32_t map;
+    int fl, sl;
+
+    if (size >= SMALL_SIZE) {
+        size += ((size_t)1 << (fls(size) - SL_LOG2)) - 1;
+    }
+    mapping(size, &fl, &sl);
+    if (fl >= FL_COUNT) {
+        return NULL;
+    }
+    map = sl_bitmap[fl] & (~0U << sl);
+    if (!map) {
+        map = fl_bitmap & (~0U << (fl + 1));
+        if (!map) {
+            return NULL;
+        }
+        fl = __builtin_ctz(map);
+        map = sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(map);
+    return free_lists[fl][sl];
+}
+
+/* Free a block which is in no list, merging it with free neighbours unless
+ * that would make it too big for the lists. */
+static void release_block(heap_block_t* block) {
+    heap_block_t* next;
+
+    block->size |= BLOCK_FREE;
+    if (block->size & BLOCK_PREV_FREE) {
+        heap_block_t* prev = block->prev_phys;
+        if (block_size(prev) + block_size(block) <= BLOCK_MAX) {
+            remove_free(prev);
+            prev->size += block_size(block);
+            block = prev;
+        }
+    }
+    next = block_next(block);
+    if ((next->size & BLOCK_FREE) && block_size(block) + block_size(next) <= BLOCK_MAX) {
+        remove_free(next);
+        block->size += block_size(next);
+        next = block_next(block);
+    }
+    next->prev_phys = block;
+    next->size |= BLOCK_PREV_FREE;
+    insert_free(block);
+}
+
+/* Give the end of a used block beyond size bytes back to the heap. */
+static void trim_block(heap_block_t* block, size_t size) {
+    size_t rest = block_size(block) - size;
+
+    if (rest >= BLOCK_MIN) {
+        heap_block_t* tail = (heap_block_t*)((char*)block + size);
+        tail->size = rest;
+        block->size -= rest;
+        release_block(tail);
+    }
+}
+
+static int add_region(void* start, size_t size) {
+    uintptr_t      begin = ((uintptr_t)start + ALIGN - 1) & ~(uintptr_t)(ALIGN - 1);
+    uintptr_t      end = ((uintptr_t)start + size) & ~(uintptr_t)(ALIGN - 1);
+    heap_region_t* region;
+    heap_block_t*  block = NULL;
+    heap_block_t*  sentinel;
+    size_t         left;
+
+    /* Memory right after a region, as _sbrk() hands out, extends it. */
+    for (region = regions; region; region = region->next) {
+        if ((uintptr_t)region->sentinel + HEADER == ((uintptr_t)start & ~(uintptr_t)(ALIGN - 1))) {
+            block = region->sentinel;
+            break;
+        }
+    }
+    if (block) {
+        if (end < (uintptr_t)block + BLOCK_MIN + HEADER) {
+            return -1;
+        }
+        stats.size += end - ((uintptr_t)block + HEADER);
+    } else {
+        if (end < begin || end - begin < REGION_HEADER + BLOCK_MIN + HEADER) {
+            return -1;
+        }
+        region = (heap_region_t*)begin;
+        region->next = regions;
+        regions = region;
+        block = (heap_block_t*)(begin + REGION_HEADER);
+        block->size = 0;
+        stats.size += end - begin;
+    }
+    stats.regions++;
+
+    /* Lay out blocks of at most BLOCK_MAX, freeing each in turn. */
+    sentinel = (heap_block_t*)(end - HEADER);
+    sentinel->size = 0;
+    region->sentinel = sentinel;
+    left = (char*)sentinel - (char*)block;
+    while (left) {
+        size_t part = left > BLOCK_MAX ? BLOCK_MAX : left;
+        heap_block_t* next;
+        if (left - part && left - part < BLOCK_MIN) {
+            part -= BLOCK_MIN;
+        }
+        next = (heap_block_t*)((char*)block + part);
+        block->size = part | (block->size & BLOCK_PREV_FREE);
+        if (next != sentinel) {
+            next->size = 0;
+        }
+        release_block(block);
+        left -= part;
+        block = next;
+    }
+    return 0;
+}
+
+#if defined(TOOLCHAIN_GCC_ARM)
+extern void* _sbrk(int incr);
+
+/* Take more memory from above the heap, up to the stack of main. */
+static int grow(size_t size) {
+    size_t need = (size + BLOCK_MIN + REGION_HEADER + 2 * HEADER + ALIGN + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+    size_t chunk = need < HEAP_GROW ? HEAP_GROW : need;
+    void*  start = _sbrk((int)chunk);
+
+    if (start == (void*)-1 && chunk != need) {
+        chunk = need;
+        start = _sbrk((int)chunk);
+    }
+    if (start == (void*)-1) {
+        return -1;
+    }
+    return add_region(start, chunk);
+}
+#else
+static int grow(size_t size) {
+    return -1;
+}
+#endif
+
+static heap_block_t* allocate_block(size_t size) {
+    heap_block_t* block = find_free(size);
+
+    if (!block && grow(size) == 0) {
+        block = find_free(size);
+    }
+    if (!block) {
+        return NULL;
+    }
+    remove_free(block);
+    block->size &= ~(size_t)BLOCK_FREE;
+    block_next(block)->size &= ~(size_t)BLOCK_PREV_FREE;
+    trim_block(block, size);
+    stats.used += block_size(block);
+    if (stats.used > stats.peak) {
+        stats.peak = stats.used;
+    }
+    return block;
+}
+
+static heap_pool_t* find_pool(void* ptr) {
+    int i;
+
+    for (i = 0; i < pool_count; i++) {
+        if ((char*)ptr >= pools[i].start && (char*)ptr < pools[i].end) {
+            return &pools[i];
+        }
+    }
+    return NULL;
+}
+
+
+void* mbed_heap_malloc(size_t size) {
+    uint32_t      state;
+    size_t        fit = block_fit(size);
+    heap_block_t* block = NULL;
+    int           i;
+
+    state = heap_lock();
+    for (i = 0; i < pool_count; i++) {
+        if (size <= pools[i].block_size) {
+            void* ptr = pools[i].free;
+            if (ptr) {
+                pools[i].free = *(void**)ptr;
+                stats.allocs++;
+                stats.pooled++;
+                heap_unlock(state);
+                return ptr;
+            }
+            break;
+        }
+    }
+    if (fit) {
+        block = allocate_block(fit);
+    }
+    if (block) {
+        stats.allocs++;
+    } else {
+        stats.failures++;
+    }
+    heap_unlock(state);
+    return block ? block_payload(block) : NULL;
+}
+
+void* mbed_heap_calloc(size_t count, size_t size) {
+    void* ptr;
+
+    if (size && count > (size_t)-1 / size) {
+        return NULL;
+    }
+    ptr = mbed_heap_malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void mbed_heap_free(void* ptr) {
+    uint32_t      state;
+    heap_pool_t*  pool;
+    heap_block_t* block;
+
+    if (!ptr) {
+        return;
+    }
+    state = heap_lock();
+    pool = find_pool(ptr);
+    if (pool) {
+        *(void**)ptr = pool->free;
+        pool->free = ptr;
+        stats.frees++;
+    } else {
+        block = payload_block(ptr);
+        if (!(block->size & BLOCK_FREE)) {
+            stats.used -= block_size(block);
+            stats.frees++;
+            release_block(block);
+        }
+    }
+    heap_unlock(state);
+}
+
+void* mbed_heap_realloc(void* ptr, size_t size) {
+    uint32_t      state;
+    heap_pool_t*  pool;
+    heap_block_t* block;
+    heap_block_t* next;
+    size_t        fit = block_fit(size);
+    size_t        held;
+    void*         copy;
+
+    if (!ptr) {
+        return mbed_heap_malloc(size);
+    }
+    if (!size) {
+        mbed_heap_free(ptr);
+        return NULL;
+    }
+
+    /* Shrink or grow in place when the block or its free neighbour allow. */
+    state = heap_lock();
+    pool = find_pool(ptr);
+    if (pool) {
+        held = pool->block_size;
+        if (size <= held) {
+            heap_unlock(state);
+            return ptr;
+        }
+    } else {
+        block = payload_block(ptr);
+        held = block_size(block);
+        if (fit && fit <= held) {
+            trim_block(block, fit);
+            stats.used -= held - block_size(block);
+            heap_unlock(state);
+            return ptr;
+        }
+        next = block_next(block);
+        if (fit && (next->size & BLOCK_FREE) && held + block_size(next) >= fit &&
+            held + block_size(next) <= BLOCK_MAX) {
+            remove_free(next);
+            block->size += block_size(next);
+            block_next(block)->size &= ~(size_t)BLOCK_PREV_FREE;
+            trim_block(block, fit);
+            stats.used += block_size(block) - held;
+            if (stats.used > stats.peak) {
+                stats.peak = stats.used;
+            }
+            heap_unlock(state);
+            return ptr;
+        }
+        held -= OVERHEAD;
+    }
+    heap_unlock(state);
+
+    copy = mbed_heap_malloc(size);
+    if (copy) {
+        memcpy(copy, ptr, held < size ? held : size);
+        mbed_heap_free(ptr);
+    }
+    return copy;
+}
+
+int mbed_heap_add_region(void* start, size_t size) {
+    uint32_t state = heap_lock();
+    int      result = add_region(start, size);
+
+    heap_unlock(state);
+    return result;
+}
+
+int mbed_heap_add_pool(size_t block_size, size_t count) {
+    uint32_t      state;
+    heap_block_t* block = NULL;
+    size_t        fit;
+    size_t        size = (block_size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+    heap_pool_t   pool;
+    int           i;
+
+    if (!size || !count || count > BLOCK_MAX / size) {
+        return -1;
+    }
+    fit = block_fit(size * count);
+    state = heap_lock();
+    if (pool_count < HEAP_POOLS && fit) {
+        block = allocate_block(fit);
+    }
+    if (!block) {
+        heap_unlock(state);
+        return -1;
+    }
+    pool.start = block_payload(block);
+    pool.end = pool.start + size * count;
+    pool.block_size = size;
+    pool.free = NULL;
+    for (i = (int)count - 1; i >= 0; i--) {
+        void* ptr = pool.start + i * size;
+        *(void**)ptr = pool.free;
+        pool.free = ptr;
+    }
+
+    /* Keep the pools sorted by size, so the first that fits is the best. */
+    for (i = pool_count; i > 0 && pools[i - 1].block_size > size; i--) {
+        pools[i] = pools[i - 1];
+    }
+    pools[i] = pool;
+    pool_count++;
+    heap_unlock(state);
+    return 0;
+}
+
+void mbed_heap_stats(mbed_heap_stats_t* out) {
+    uint32_t      state = heap_lock();
+    heap_block_t* block;
+    size_t        largest = 0;
+
+    /* The largest free block is in the highest list which isn't empty. */
+    if (fl_bitmap) {
+        int fl = fls(fl_bitmap);
+        int sl = fls(sl_bitmap[fl]);
+        for (block = free_lists[fl][sl]; block; block = block->next_free) {
+            if (block_size(block) > largest) {
+                largest = block_size(block);
+            }
+        }
+    }
+    *out = stats;
+    out->largest_free = largest;
+    out->fragmentation = free_bytes ? (uint32_t)(100 - (uint64_t)largest * 100 / free_bytes) : 0;
+    heap_unlock(state);
+}
+
+int mbed_heap_check(void) {
+    uint32_t       state = heap_lock();
+    heap_region_t* region;
+    heap_block_t*  block;
+    size_t         walked_free = 0;
+    size_t         walked_used = 0;
+    size_t         listed_free = 0;
+    int            fl, sl;
+    int            result = 0;
+
+    for (region = regions; region && !result; region = region->next) {
+        int prev_free = 0;
+        heap_block_t* prev = NULL;
+        for (block = (heap_block_t*)((char*)region + REGION_HEADER); block_size(block); block = block_next(block)) {
+            if ((block_size(block) & (ALIGN - 1)) || block_size(block) < BLOCK_MIN ||
+                block_size(block) > BLOCK_MAX || !(block->size & BLOCK_PREV_FREE) != !prev_free ||
+                (prev_free && block->prev_phys != prev)) {
+                result = -1;
+                break;
+            }
+            prev_free = block->size & BLOCK_FREE;
+            if (prev_free) {
+                walked_free += block_size(block);
+            } else {
+                walked_used += block_size(block);
+            }
+            prev = block;
+        }
+        if (block != region->sentinel || !(block->size & BLOCK_PREV_FREE) != !prev_free) {
+            result = -1;
+        }
+    }
+
+    for (fl = 0; fl < FL_COUNT && !result; fl++) {
+        for (sl = 0; sl < SL_COUNT; sl++) {
+            int found = 0;
+            for (block = free_lists[fl][sl]; block; block = block->next_free) {
+                int block_fl, block_sl;
+                mapping(block_size(block), &block_fl, &block_sl);
+                if (!(block->size & BLOCK_FREE) || block_fl != fl || block_sl != sl ||
+                    (block->next_free && block->next_free->prev_free != block)) {
+                    result = -1;
+                }
+                listed_free += block_size(block);
+                found = 1;
+            }
+            if (!found != !(sl_bitmap[fl] & (1U << sl)) || !sl_bitmap[fl] != !(fl_bitmap & (1U << fl))) {
+                result = -1;
+            }
+        }
+    }
+    if (walked_free != listed_free || walked_free != free_bytes || walked_used != stats.used) {
+        result = -1;
+    }
+    heap_unlock(state);
+    return result;
+}
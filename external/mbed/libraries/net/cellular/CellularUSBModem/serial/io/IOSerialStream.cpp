@@ -56,31 +56,20 @@ m_availableSphre(1), m_spaceSphre(1), m_inBuf(), m_outBuf()
     WARN("Error %d while waiting for incoming data", ret);
     return ret;
   }
-  int readLen = MIN( available(), maxLength );
-  *pLength = readLen;
-  setupReadableISR(false);
-  while(readLen--)
-  {
-    m_inBuf.dequeue(buf);
-    buf++;
-  }
-  setupReadableISR(true);
+  *pLength = m_inBuf.read(buf, maxLength);
   DBG("Read %d chars successfully", *pLength);
   return OK;
 }
 
 /*virtual*/ size_t IOSerialStream::available()
 {
-  setupReadableISR(false); //m_inBuf.available() is not reentrant
-  size_t len = m_inBuf.available();
-  setupReadableISR(true);
-  return len;
+  return m_inBuf.available();
 }
 
 /*virtual*/ int IOSerialStream::waitAvailable(uint32_t timeout/*=osWaitForever*/) //Wait for data to be available
 {
   int ret;
-  if(available()) //Is data already available?
+  if(m_inBuf.arm_reader(1)) //Is data already available?
   {
     m_availableSphre.wait(0); //Clear the queue as data is available
     return OK;
@@ -88,6 +77,7 @@ m_availableSphre(1), m_spaceSphre(1), m_inBuf(), m_outBuf()
 
   DBG("Waiting for data availability %d ms (-1 is infinite)", timeout);
   ret = m_availableSphre.wait(timeout); //Wait for data to arrive or for abort
+  m_inBuf.disarm_reader();
   if(ret <= 0)
   {
     DBG("Timeout");
@@ -116,25 +106,19 @@ m_availableSphre(1), m_spaceSphre(1), m_inBuf(), m_outBuf()
   return OK;
 }
 
-void IOSerialStream::setupReadableISR(bool en)
-{
-  if(en)
-  {
-    UART_X->IER |= 1 << 0;
-  }
-  else
-  {
-    UART_X->IER &= ~(1 << 0);
-  }
-}
-
 void IOSerialStream::readable() //Callback from m_serial when new data is available
 {
   do
   {
-    m_inBuf.queue(m_serial.getc());
+    if(!m_inBuf.put(m_serial.getc()))
+    {
+      break; //Drop incoming data while the buffer is full
+    }
   } while(m_serial.readable());
-  m_availableSphre.release(); //Force exiting the waiting state
+  if(m_inBuf.reader_wakeup()) //Only signal a thread which is waiting
+  {
+    m_availableSphre.release(); //Force exiting the waiting state
+  }
 }
 
 //0 for non-blocking (returns immediately), osWaitForever for infinite blocking
@@ -148,50 +132,43 @@ void IOSerialStream::readable() //Callback from m_serial when new data is availa
     return ret;
   }
   DBG("Writing %d chars", length);
-  setupWriteableISR(false);
-  while(length)
+  while(true)
   {
-    m_outBuf.queue(*buf);
-    buf++;
-    length--;
-    if(length && !space())
+    size_t written = m_outBuf.write(buf, length);
+    buf += written;
+    length -= written;
+    startTx();
+    if(!length)
     {
-      DBG("Waiting to write remaining %d chars", length);
-      setupWriteableISR(true);
-      ret = waitSpace(timeout);
-      if(ret)
-      {
-        WARN("Error %d while waiting for space", ret);
-        return ret;
-      }
-      setupWriteableISR(false);
+      break;
+    }
+    DBG("Waiting to write remaining %d chars", length);
+    //Only wake up once a reasonable chunk can be written
+    ret = waitForSpace(MIN(length, (size_t)CIRCBUF_SIZE / 2), timeout);
+    if(ret)
+    {
+      WARN("Error %d while waiting for space", ret);
+      return ret;
     }
   }
-  //If m_serial tx fifo is empty we need to manually tx a byte in order to trigger the interrupt
-  if( m_outBuf.available() && m_serialTxFifoEmpty )
-  {
-    m_serialTxFifoEmpty = false;
-    uint8_t c;
-    m_outBuf.dequeue(&c);
-    m_serial.putc((char)c);
-  }
-  setupWriteableISR(true);
   DBG("Write successful");
   return OK;
 }
 
 /*virtual*/ size_t IOSerialStream::space()
 {
-  setupWriteableISR(false); //m_outBuf.available() is not reentrant
-  size_t len = CIRCBUF_SIZE - m_outBuf.available();
-  setupWriteableISR(true);
-  return len;
+  return m_outBuf.space();
 }
 
 /*virtual*/ int IOSerialStream::waitSpace(uint32_t timeout/*=osWaitForever*/) //Wait for space to be available
+{
+  return waitForSpace(1, timeout);
+}
+
+int IOSerialStream::waitForSpace(size_t count, uint32_t timeout)
 {
   int ret;
-  if(space()) //Is still space already left?
+  if(m_outBuf.arm_writer(count)) //Is still space already left?
   {
     m_spaceSphre.wait(0); //Clear the queue as space is available
     return OK;
@@ -199,12 +176,13 @@ void IOSerialStream::readable() //Callback from m_serial when new data is availa
 
   DBG("Waiting for data space %d ms (-1 is infinite)", timeout);
   ret = m_spaceSphre.wait(timeout); //Wait for space to be made or for abort
+  m_outBuf.disarm_writer();
   if(ret <= 0)
   {
     DBG("Timeout");
     return NET_TIMEOUT;
   }
-  if(!space()) //Even if abort has been called, return that space is available
+  if(space() < count) //Even if abort has been called, return that space is available
   {
     DBG("Aborted");
     return NET_INTERRUPTED;
@@ -215,10 +193,8 @@ void IOSerialStream::readable() //Callback from m_serial when new data is availa
 
 /*virtual*/ int IOSerialStream::abortWrite() //Abort current writing (or waiting) operation
 {
-  if( !space() ) //If there is space left, no need to abort
-  {
-    m_spaceSphre.release(); //Force exiting the waiting state
-  }
+  //A write may be waiting for more space than is left, so always signal
+  m_spaceSphre.release(); //Force exiting the waiting state
   return OK;
 }
 
@@ -234,20 +210,36 @@ void IOSerialStream::setupWriteableISR(bool en)
   }
 }
 
+void IOSerialStream::startTx()
+{
+  //If m_serial tx fifo is empty we need to manually tx a byte in order to trigger the interrupt
+  //The tx interrupt is disabled meanwhile as this thread then reads m_outBuf too
+  setupWriteableISR(false);
+  uint8_t c;
+  if( m_serialTxFifoEmpty && m_outBuf.get(&c) )
+  {
+    m_serialTxFifoEmpty = false;
+    m_serial.putc((char)c);
+  }
+  setupWriteableISR(true);
+}
+
 void IOSerialStream::writeable() //Callback from m_serial when new space is available
 {
-  if(m_outBuf.isEmpty())
+  if(m_outBuf.empty())
   {
     m_serialTxFifoEmpty = true;
   }
   else
   {
-    while(m_serial.writeable() && !m_outBuf.isEmpty())
+    uint8_t c;
+    while(m_serial.writeable() && m_outBuf.get(&c))
     {
-      uint8_t c;
-      m_outBuf.dequeue(&c);
       m_serial.putc((char)c);
     }
   }
-  m_spaceSphre.release(); //Force exiting the waiting state
+  if(m_outBuf.writer_wakeup()) //Only signal a thread which is waiting
+  {
+    m_spaceSphre.release(); //Force exiting the waiting state
+  }
 }
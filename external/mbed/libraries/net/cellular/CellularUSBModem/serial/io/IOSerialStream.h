@@ -24,7 +24,7 @@
 #include "RawSerial.h"
 
 #include "rtos.h"
-#include "core/MtxCircBuffer.h"
+#include "SPSCRingBuffer.h"
 
 /** Input Serial Stream for physical serial interfaces (UART...)
 This class is not thread-safe, except for the *Abort() methods that can be called by any thread/ISR
@@ -32,7 +32,7 @@ This class is not thread-safe, except for the *Abort() methods that can be calle
 class IOSerialStream : public IOStream
 {
 public:
-  enum { CIRCBUF_SIZE = 255 };
+  enum { CIRCBUF_SIZE = 256 }; //Must be a power of two
   IOSerialStream(mbed::RawSerial& serial);
   /*virtual*/ ~IOSerialStream();
 
@@ -54,7 +54,6 @@ private:
   mbed::RawSerial& m_serial;
   volatile bool m_serialTxFifoEmpty;
 
-  void setupReadableISR(bool en);
   void readable(); //Callback from m_serial when new data is available
 
   Semaphore m_availableSphre; //Used for signalling
@@ -64,8 +63,12 @@ private:
 
   Semaphore m_spaceSphre; //Used for signalling
 
-  MtxCircBuffer<uint8_t, CIRCBUF_SIZE + 1> m_inBuf;
-  MtxCircBuffer<uint8_t, CIRCBUF_SIZE + 1> m_outBuf;
+  int waitForSpace(size_t count, uint32_t timeout); //Wait for count bytes of space, or for at least one if aborted
+  void startTx(); //Start transmitting if the serial tx fifo has been drained
+
+  //Lock-free: the ISR writes m_inBuf and reads m_outBuf, the calling thread does the opposite
+  mbed::SPSCRingBuffer<uint8_t, CIRCBUF_SIZE> m_inBuf;
+  mbed::SPSCRingBuffer<uint8_t, CIRCBUF_SIZE> m_outBuf;
 
 };
 
@@ -53,33 +53,20 @@ m_availableSphre(1), m_spaceSphre(1), m_inBuf()
     WARN("Error %d while waiting for incoming data", ret);
     return ret;
   }
-  int a = available(); //Prevent macro issues
-  int readLen = MIN( a, maxLength );
-  *pLength = readLen;
-
-  setupReadableISR(false);
-  while(readLen--)
-  {
-    m_inBuf.dequeue(buf);
-    buf++;
-  }
-  setupReadableISR(true);
+  *pLength = m_inBuf.read(buf, maxLength);
   DBG("Read %d chars successfully", *pLength);
   return OK;
 }
 
 /*virtual*/ size_t USBSerialStream::available()
 {
-  setupReadableISR(false); //m_inBuf.available() is not reentrant
-  size_t len = m_inBuf.available();
-  setupReadableISR(true);
-  return len;
+  return m_inBuf.available();
 }
 
 /*virtual*/ int USBSerialStream::waitAvailable(uint32_t timeout/*=osWaitForever*/) //Wait for data to be available
 {
   int ret;
-  if(available()) //Is data already available?
+  if(m_inBuf.arm_reader(1)) //Is data already available?
   {
     while( m_availableSphre.wait(0) > 0 ); //Clear the queue as data is available
     return OK;
@@ -87,6 +74,7 @@ m_availableSphre(1), m_spaceSphre(1), m_inBuf()
 
   DBG("Waiting for data availability %d ms (-1 is infinite)", timeout);
   ret = m_availableSphre.wait(timeout); //Wait for data to arrive or for abort
+  m_inBuf.disarm_reader();
   if(ret <= 0)
   {
     DBG("Timeout");
@@ -115,19 +103,18 @@ m_availableSphre(1), m_spaceSphre(1), m_inBuf()
   return OK;
 }
 
-void USBSerialStream::setupReadableISR(bool en)
-{
-  m_serial.setupIrq(en, IUSBHostSerial::RxIrq);
-}
-
 void USBSerialStream::readable() //Callback from m_serial when new data is available
 {
   while(m_serial.readable())
   {
-    m_inBuf.queue(m_serial.getc());
+    uint8_t c = m_serial.getc();
+    m_inBuf.put(c); //Dropped while the buffer is full
   }
   m_serial.readPacket(); //Start read of next packet
-  m_availableSphre.release(); //Force exiting the waiting state
+  if(m_inBuf.reader_wakeup()) //Only signal a thread which is waiting
+  {
+    m_availableSphre.release(); //Force exiting the waiting state
+  }
 }
 
 //0 for non-blocking (returns immediately), -1 for infinite blocking
@@ -136,25 +123,21 @@ void USBSerialStream::readable() //Callback from m_serial when new data is avail
   DBG("Trying to write %d chars", length);
   do
   {
-    int ret = waitSpace(timeout);
+    //Only wake up once a reasonable chunk can be written
+    int ret = waitForSpace(MIN(length, (size_t)CIRCBUF_SIZE / 2), timeout);
     if(ret)
     {
       WARN("Error %d while waiting for space", ret);
       return ret;
     }
-    int s = space(); //Prevent macro issues
-    int writeLen = MIN( s, length );
-    DBG("Writing %d chars", writeLen);
-    setupWriteableISR(false);
-    while(writeLen)
-    {
-      m_outBuf.queue(*buf);
-      buf++;
-      length--;
-      writeLen--;
-    }
+    size_t writeLen = m_outBuf.write(buf, length);
+    DBG("Wrote %d chars", writeLen);
+    buf += writeLen;
+    length -= writeLen;
     //If m_serial tx fifo is empty we need to start the packet write
-    if( m_outBuf.available() && m_serialTxFifoEmpty )
+    //The tx interrupt is disabled meanwhile as this thread then reads m_outBuf too
+    setupWriteableISR(false);
+    if( !m_outBuf.empty() && m_serialTxFifoEmpty )
     {
       writeable();
     }
@@ -167,16 +150,18 @@ void USBSerialStream::readable() //Callback from m_serial when new data is avail
 
 /*virtual*/ size_t USBSerialStream::space()
 {
-  setupWriteableISR(false); //m_outBuf.available() is not reentrant
-  size_t len = CIRCBUF_SIZE - m_outBuf.available();
-  setupWriteableISR(true);
-  return len;
+  return m_outBuf.space();
 }
 
 /*virtual*/ int USBSerialStream::waitSpace(uint32_t timeout/*=-1*/) //Wait for space to be available
+{
+  return waitForSpace(1, timeout);
+}
+
+int USBSerialStream::waitForSpace(size_t count, uint32_t timeout)
 {
   int ret;
-  if(space()) //Is still space already left?
+  if(m_outBuf.arm_writer(count)) //Is still space already left?
   {
     while( m_spaceSphre.wait(0) > 0); //Clear the queue as space is available
     return OK;
@@ -184,12 +169,13 @@ void USBSerialStream::readable() //Callback from m_serial when new data is avail
 
   DBG("Waiting for data space %d ms (-1 is infinite)", timeout);
   ret = m_spaceSphre.wait(timeout); //Wait for space to be made or for abort
+  m_outBuf.disarm_writer();
   if(ret <= 0)
   {
     DBG("Timeout");
     return NET_TIMEOUT;
   }
-  if(!space()) //Even if abort has been called, return that space is available
+  if(space() < count) //Even if abort has been called, return that space is available
   {
     DBG("Aborted");
     return NET_INTERRUPTED;
@@ -200,10 +186,8 @@ void USBSerialStream::readable() //Callback from m_serial when new data is avail
 
 /*virtual*/ int USBSerialStream::abortWrite() //Abort current writing (or waiting) operation
 {
-  if( !space() ) //If there is space left, no need to abort
-  {
-    m_spaceSphre.release(); //Force exiting the waiting state
-  }
+  //A write may be waiting for more space than is left, so always signal
+  m_spaceSphre.release(); //Force exiting the waiting state
   return OK;
 }
 
@@ -214,22 +198,21 @@ void USBSerialStream::setupWriteableISR(bool en)
 
 void USBSerialStream::writeable() //Callback from m_serial when new space is available
 {
-  if(m_outBuf.isEmpty())
+  if(m_outBuf.empty())
   {
     m_serialTxFifoEmpty = true;
   }
   else
   {
     m_serialTxFifoEmpty = false;
-    while(m_serial.writeable() && !m_outBuf.isEmpty())
+    uint8_t c;
+    while(m_serial.writeable() && m_outBuf.get(&c))
     {
-      uint8_t c;
-      m_outBuf.dequeue(&c);
       m_serial.putc((char)c);
     }
     m_serial.writePacket(); //Start packet write
   }
-  if(!m_outBuf.isFull())
+  if(m_outBuf.writer_wakeup()) //Only signal a thread which is waiting
   {
     m_spaceSphre.release(); //Force exiting the waiting state
   }
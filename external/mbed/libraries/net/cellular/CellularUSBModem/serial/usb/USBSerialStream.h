@@ -27,7 +27,7 @@
 #include "USBHost3GModule/IUSBHostSerialListener.h"
 
 #include "rtos.h"
-#include "core/MtxCircBuffer.h"
+#include "SPSCRingBuffer.h"
 
 /* Input Serial Stream for USB virtual serial ports interfaces
 This class is not thread-safe, except for the *Abort() methods that can be called by any thread/ISR
@@ -36,7 +36,7 @@ This class is not thread-safe, except for the *Abort() methods that can be calle
 class USBSerialStream : public IOStream, IUSBHostSerialListener
 {
 public:
-  enum { CIRCBUF_SIZE = 127 };
+  enum { CIRCBUF_SIZE = 128 }; //Must be a power of two
   USBSerialStream(IUSBHostSerial& serial);
   /*virtual*/ ~USBSerialStream();
 
@@ -57,7 +57,6 @@ private:
   IUSBHostSerial& m_serial;
   volatile bool m_serialTxFifoEmpty;
 
-  void setupReadableISR(bool en);
   virtual void readable(); //Callback from m_serial when new data is available
 
   Semaphore m_availableSphre; //Used for signalling
@@ -67,8 +66,11 @@ private:
 
   Semaphore m_spaceSphre; //Used for signalling
 
-  MtxCircBuffer<uint8_t, CIRCBUF_SIZE + 1> m_inBuf;
-  MtxCircBuffer<uint8_t, CIRCBUF_SIZE + 1> m_outBuf;
+  int waitForSpace(size_t count, uint32_t timeout); //Wait for count bytes of space, or for at least one if aborted
+
+  //Lock-free: the ISR writes m_inBuf and reads m_outBuf, the calling thread does the opposite
+  mbed::SPSCRingBuffer<uint8_t, CIRCBUF_SIZE> m_inBuf;
+  mbed::SPSCRingBuffer<uint8_t, CIRCBUF_SIZE> m_outBuf;
 };
 
 #endif /* USBSERIALSTREAM_H_ */
@@ -24,6 +24,7 @@
 #include "lwip/dhcp.h"
 #include "eth_arch.h"
 #include "lwip/tcpip.h"
+#include "lwip/stats.h"
 
 #include "mbed.h"
 
@@ -153,4 +154,82 @@ char* EthernetInterface::getNetworkMask() {
     return networkmask;
 }
 
+#if LWIP_STATS
+static const char* const memp_names[] = {
+#define LWIP_MEMPOOL(name,num,size,desc) desc,
+#include "lwip/memp_std.h"
+};
+
+static void get_pool_stats(EthernetPoolStats* pool, const char* name, const struct stats_mem* mem) {
+    pool->name = name;
+    pool->avail = mem->avail;
+    pool->used = mem->used;
+    pool->max = mem->max;
+    pool->err = mem->err;
+}
+#endif
 
+int EthernetInterface::getStats(EthernetStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+#if LWIP_STATS
+#if MEM_STATS
+    get_pool_stats(&stats->heap, "HEAP", &lwip_stats.mem);
+#endif
+#if MEMP_STATS
+    for (int i = 0; i < MEMP_MAX; i++) {
+        get_pool_stats(&stats->pools[i], memp_names[i], &lwip_stats.memp[i]);
+    }
+#endif
+#if LINK_STATS
+    stats->link_recv = lwip_stats.link.recv;
+    stats->link_xmit = lwip_stats.link.xmit;
+    stats->link_drop = lwip_stats.link.drop;
+    stats->link_err = lwip_stats.link.err + lwip_stats.link.lenerr + lwip_stats.link.chkerr;
+#endif
+#if NETIF_STATS
+    stats->netif_rx_packets = netif.stats.rx_pkts;
+    stats->netif_rx_bytes = netif.stats.rx_bytes;
+    stats->netif_rx_drops = netif.stats.rx_drop;
+    stats->netif_tx_packets = netif.stats.tx_pkts;
+    stats->netif_tx_bytes = netif.stats.tx_bytes;
+#endif
+#if TCPIP_STATS
+    stats->tcpip_msgs = lwip_stats.tcpip.msgs;
+    stats->tcpip_drops = lwip_stats.tcpip.err;
+    stats->tcpip_depth_max = lwip_stats.tcpip.depth_max;
+    stats->tcpip_wait_avg_us = stats->tcpip_msgs ? lwip_stats.tcpip.wait_us / stats->tcpip_msgs : 0;
+    stats->tcpip_wait_max_us = lwip_stats.tcpip.wait_us_max;
+#endif
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+#define STATS_PRINTF(...) (stream ? stream->printf(__VA_ARGS__) : printf(__VA_ARGS__))
+
+void EthernetInterface::printStats(Stream* stream) {
+    EthernetStats stats;
+    
+    if (getStats(&stats) < 0) {
+        STATS_PRINTF("Network statistics disabled\r\n");
+        return;
+    }
+    
+    STATS_PRINTF("pool             used   max avail  err\r\n");
+    STATS_PRINTF("%-16s %4u  %4u  %4u %4u\r\n", stats.heap.name ? stats.heap.name : "HEAP",
+                 stats.heap.used, stats.heap.max, stats.heap.avail, stats.heap.err);
+    for (int i = 0; i < MEMP_MAX; i++) {
+        const EthernetPoolStats* pool = &stats.pools[i];
+        STATS_PRINTF("%-16s %4u  %4u  %4u %4u\r\n", pool->name ? pool->name : "?",
+                     pool->used, pool->max, pool->avail, pool->err);
+    }
+    STATS_PRINTF("link: recv %u xmit %u drop %u err %u\r\n",
+                 stats.link_recv, stats.link_xmit, stats.link_drop, stats.link_err);
+    STATS_PRINTF("netif: rx %u pkts %u bytes drop %u, tx %u pkts %u bytes\r\n",
+                 stats.netif_rx_packets, stats.netif_rx_bytes, stats.netif_rx_drops,
+                 stats.netif_tx_packets, stats.netif_tx_bytes);
+    STATS_PRINTF("tcpip: msgs %u drops %u depth max %u wait avg %uus max %uus\r\n",
+                 stats.tcpip_msgs, stats.tcpip_drops, stats.tcpip_depth_max,
+                 stats.tcpip_wait_avg_us, stats.tcpip_wait_max_us);
+}
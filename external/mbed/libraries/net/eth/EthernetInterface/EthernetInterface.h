@@ -25,7 +25,43 @@
 #endif
 
 #include "rtos.h"
+#include "Stream.h"
 #include "lwip/netif.h"
+#include "lwip/memp.h"
+
+/** Usage of one of the lwIP memory pools or the lwIP heap
+ */
+struct EthernetPoolStats {
+  const char* name;     /**< Name of the pool */
+  unsigned int avail;   /**< Number of elements (bytes for the heap) in the pool */
+  unsigned int used;    /**< Number of elements currently allocated */
+  unsigned int max;     /**< High-water mark of used */
+  unsigned int err;     /**< Number of failed allocations */
+};
+
+/** Snapshot of the network statistics returned by EthernetInterface::getStats()
+ */
+struct EthernetStats {
+  EthernetPoolStats heap;                /**< lwIP heap (MEM_SIZE) */
+  EthernetPoolStats pools[MEMP_MAX];     /**< lwIP memory pools (PBUF_POOL, TCP_PCB, ...) */
+  
+  unsigned int link_recv;     /**< Frames received by the interface */
+  unsigned int link_xmit;     /**< Frames sent by the interface */
+  unsigned int link_drop;     /**< Frames dropped by the interface (no pbuf, overruns, ...) */
+  unsigned int link_err;      /**< Receive/transmit errors (overruns, underruns, bad length or checksum) */
+  
+  unsigned int netif_rx_packets;   /**< IP packets received on the interface */
+  unsigned int netif_rx_bytes;     /**< Bytes of IP packets received on the interface */
+  unsigned int netif_rx_drops;     /**< Packets received but not passed on to the tcpip thread */
+  unsigned int netif_tx_packets;   /**< IP packets sent on the interface */
+  unsigned int netif_tx_bytes;     /**< Bytes of IP packets sent on the interface */
+  
+  unsigned int tcpip_msgs;         /**< Messages handled by the tcpip thread */
+  unsigned int tcpip_drops;        /**< Messages dropped because the tcpip mailbox was full */
+  unsigned int tcpip_depth_max;    /**< Most messages seen waiting in the tcpip mailbox */
+  unsigned int tcpip_wait_avg_us;  /**< Average time a message waited in the tcpip mailbox */
+  unsigned int tcpip_wait_max_us;  /**< Longest time a message waited in the tcpip mailbox */
+};
 
  /** Interface using Ethernet to connect to an IP-based network
  *
@@ -79,6 +115,17 @@ public:
    * \return a pointer to a string containing the Network mask
    */
   static char* getNetworkMask();
+
+  /** Get a snapshot of the network statistics
+   * \param stats structure to be filled in with the current counters
+   * \return 0 on success, -1 if statistics were disabled with LWIP_STATS
+   */
+  static int getStats(EthernetStats* stats);
+
+  /** Print the network statistics
+   * \param stream Serial (or other Stream) to print to, stdout if NULL
+   */
+  static void printStats(mbed::Stream* stream = NULL);
 };
 
 #include "TCPSocketConnection.h"
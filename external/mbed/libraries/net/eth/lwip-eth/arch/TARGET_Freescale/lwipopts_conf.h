@@ -24,6 +24,11 @@
 #define LWIP_TRANSPORT_ETHERNET       1
 #define ETH_PAD_SIZE                  2
 
+/* The K64F has enough internal RAM for an 8 segment window in the bulk
+   profile. */
+#define LWIP_BULK_WND_SEGS            8
+#define LWIP_BULK_SND_SEGS            8
+
 #define MEM_SIZE                      (ENET_RX_RING_LEN * (ENET_ETH_MAX_FLEN + RX_BUF_ALIGNMENT) + ENET_TX_RING_LEN * ENET_ETH_MAX_FLEN)
 
 #endif
@@ -0,0 +1,313 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+#include "lwip/tcpip.h"
+#include "netif/etharp.h"
+
+#include "eth_arch.h"
+#include "pair_emac.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/** \brief  Largest frame carried over the pair (Ethernet header + MTU). */
+#define PAIR_MAX_FRAME      (SIZEOF_ETH_HDR + 1500)
+
+/** \brief  Number of frames which can be in flight on the simulated wire. */
+#define PAIR_DELAY_SLOTS    64
+
+#define RX_PRIORITY         (osPriorityNormal)
+
+typedef struct {
+    uint64_t due_us;
+    u16_t    len;
+    u8_t     data[PAIR_MAX_FRAME];
+} pair_frame_t;
+
+/* Pair EMAC driver data structure */
+struct pair_enetdata {
+    struct netif*        netif;
+    pair_emac_config_t   config;
+    pair_emac_counters_t counters;
+    u32_t                rand_state;
+    pair_frame_t         delay_line[PAIR_DELAY_SLOTS];
+    u32_t                delay_head;
+    u32_t                delay_count;
+    u8_t                 tx_frame[PAIR_MAX_FRAME];
+    sys_mutex_t          TXLockMutex;
+};
+
+static struct pair_enetdata pair_enetdata;
+
+static uint64_t now_us(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/* xorshift32 keeps the loss pattern reproducible for a given seed. */
+static u32_t pair_rand(struct pair_enetdata* pEnet) {
+    u32_t x = pEnet->rand_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pEnet->rand_state = x;
+    return x;
+}
+
+int pair_emac_create_link(int fds[2]) {
+    /* Unix domain datagrams are reliable and keep frame boundaries. */
+    return socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+}
+
+void pair_emac_configure(const pair_emac_config_t* pConfig) {
+    memset(&pair_enetdata, 0, sizeof(pair_enetdata));
+    pair_enetdata.config = *pConfig;
+    pair_enetdata.rand_state = pConfig->seed ? pConfig->seed : 0x2545F491;
+}
+
+void pair_emac_get_counters(pair_emac_counters_t* pCounters) {
+    *pCounters = pair_enetdata.counters;
+}
+
+/** \brief  Hand one frame from the wire to lwIP.
+ *
+ *  \param[in] netif the lwip network interface structure for this pair
+ *  \param[in] pFrame frame to be copied into a pool pbuf
+ */
+static void pair_enetif_input(struct netif *netif, const pair_frame_t* pFrame)
+{
+    struct pair_enetdata* pEnet = netif->state;
+    struct eth_hdr*       ethhdr = (struct eth_hdr*)pFrame->data;
+    struct pbuf*          p;
+
+    switch (htons(ethhdr->type)) {
+        case ETHTYPE_IP:
+        case ETHTYPE_ARP:
+            break;
+        default:
+            return;
+    }
+
+    p = pbuf_alloc(PBUF_RAW, pFrame->len, PBUF_POOL);
+    if (p == NULL) {
+        pEnet->counters.rx_no_pbuf++;
+        LINK_STATS_INC(link.memerr);
+        LINK_STATS_INC(link.drop);
+        return;
+    }
+    pbuf_take(p, pFrame->data, pFrame->len);
+    LINK_STATS_INC(link.recv);
+    pEnet->counters.rx_frames++;
+    pEnet->counters.rx_bytes += pFrame->len;
+
+    /* full packet send to tcpip_thread to process */
+    if (netif->input(p, netif) != ERR_OK) {
+        LWIP_DEBUGF(NETIF_DEBUG, ("pair_enetif_input: IP input error\n"));
+        pbuf_free(p);
+    }
+}
+
+/** \brief  Deliver every frame on the simulated wire whose latency has expired.
+ *
+ *  \return microseconds until the next frame is due or -1 if the wire is empty
+ */
+static int64_t pair_deliver_due(struct pair_enetdata* pEnet)
+{
+    while (pEnet->delay_count > 0) {
+        pair_frame_t* pFrame = &pEnet->delay_line[pEnet->delay_head];
+        uint64_t      now = now_us();
+
+        if (pFrame->due_us > now)
+            return (int64_t)(pFrame->due_us - now);
+        pair_enetif_input(pEnet->netif, pFrame);
+        pEnet->delay_head = (pEnet->delay_head + 1) % PAIR_DELAY_SLOTS;
+        pEnet->delay_count--;
+    }
+    return -1;
+}
+
+/** \brief  Packet reception task
+ *
+ * This task is the host equivalent of the EMAC receive ISR + packet_rx()
+ * thread pair.  It waits on the socketpair, applies the loss and latency
+ * models and then feeds lwIP.
+ *
+ *  \param[in] pvParameters pointer to the interface data
+ */
+static void packet_rx(void* pvParameters) {
+    struct pair_enetdata* pEnet = pvParameters;
+
+    while (1) {
+        int64_t        wait_us = pair_deliver_due(pEnet);
+        struct timeval timeout;
+        fd_set         readSet;
+        pair_frame_t*  pFrame;
+        ssize_t        len;
+
+        FD_ZERO(&readSet);
+        FD_SET(pEnet->config.fd, &readSet);
+        timeout.tv_sec = wait_us / 1000000;
+        timeout.tv_usec = wait_us % 1000000;
+        if (select(pEnet->config.fd + 1, &readSet, NULL, NULL, wait_us < 0 ? NULL : &timeout) <= 0)
+            continue;
+
+        if (pEnet->delay_count >= PAIR_DELAY_SLOTS) {
+            /* The wire is full: deliver the oldest frame early rather than
+               stall, but count it so the report shows the latency model was
+               overrun. */
+            pEnet->counters.rx_delay_overflow++;
+            pair_enetif_input(pEnet->netif, &pEnet->delay_line[pEnet->delay_head]);
+            pEnet->delay_head = (pEnet->delay_head + 1) % PAIR_DELAY_SLOTS;
+            pEnet->delay_count--;
+        }
+        pFrame = &pEnet->delay_line[(pEnet->delay_head + pEnet->delay_count) % PAIR_DELAY_SLOTS];
+        len = recv(pEnet->config.fd, pFrame->data, sizeof(pFrame->data), 0);
+        if (len <= 0) {
+            /* Other end of the pair has gone away. */
+            return;
+        }
+        if (pEnet->config.loss_ppm && (pair_rand(pEnet) % 1000000) < pEnet->config.loss_ppm) {
+            pEnet->counters.rx_lost++;
+            LINK_STATS_INC(link.drop);
+            continue;
+        }
+
+        pFrame->len = (u16_t)len;
+        pFrame->due_us = now_us() + pEnet->config.latency_us;
+        pEnet->delay_count++;
+    }
+}
+
+/** \brief  Low level output of a packet. Never call this from an
+ *          interrupt context, as it may block until TX descriptors
+ *          become available.
+ *
+ *  \param[in] netif the lwip network interface structure for this pair
+ *  \param[in] p the MAC packet to send (e.g. IP packet including MAC addresses and type)
+ *  \return ERR_OK if the packet could be sent or an err_t value if the packet couldn't be sent
+ */
+static err_t pair_low_level_output(struct netif *netif, struct pbuf *p)
+{
+    struct pair_enetdata* pEnet = netif->state;
+    u16_t                 len;
+    ssize_t               sent;
+
+    if (p->tot_len > sizeof(pEnet->tx_frame)) {
+        LINK_STATS_INC(link.lenerr);
+        return ERR_BUF;
+    }
+
+    sys_mutex_lock(&pEnet->TXLockMutex);
+    len = pbuf_copy_partial(p, pEnet->tx_frame, p->tot_len, 0);
+    sent = send(pEnet->config.fd, pEnet->tx_frame, len, MSG_NOSIGNAL);
+    if (sent == len) {
+        pEnet->counters.tx_frames++;
+        pEnet->counters.tx_bytes += len;
+    }
+    sys_mutex_unlock(&pEnet->TXLockMutex);
+
+    if (sent != len) {
+        LINK_STATS_INC(link.err);
+        return ERR_IF;
+    }
+    LINK_STATS_INC(link.xmit);
+    return ERR_OK;
+}
+
+/**
+ * This function is the ethernet packet send function. It calls
+ * etharp_output after checking link status.
+ *
+ * \param[in] netif the lwip network interface structure for this pair
+ * \param[in] q Pointer to pbuf to send
+ * \param[in] ipaddr IP address
+ * \return ERR_OK or error code
+ */
+static err_t pair_etharp_output(struct netif *netif, struct pbuf *q, ip_addr_t *ipaddr)
+{
+    /* Only send packet is link is up */
+    if (netif->flags & NETIF_FLAG_LINK_UP)
+        return etharp_output(netif, q, ipaddr);
+
+    return ERR_CONN;
+}
+
+/**
+ * Should be called at the beginning of the program to set up the
+ * network interface.  pair_emac_configure() must have been called first.
+ *
+ * This function should be passed as a parameter to netif_add().
+ *
+ * @param[in] netif the lwip network interface structure for this pair
+ * @return ERR_OK if the interface is initialized
+ *         any other err_t on error
+ */
+err_t eth_arch_enetif_init(struct netif *netif)
+{
+    err_t err;
+
+    LWIP_ASSERT("netif != NULL", (netif != NULL));
+
+    pair_enetdata.netif = netif;
+
+    memcpy(netif->hwaddr, pair_enetdata.config.hwaddr, ETHARP_HWADDR_LEN);
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET | NETIF_FLAG_IGMP;
+    netif->state = &pair_enetdata;
+
+#if LWIP_NETIF_HOSTNAME
+    netif->hostname = "lwiphost";
+#endif /* LWIP_NETIF_HOSTNAME */
+
+    netif->name[0] = 'p';
+    netif->name[1] = 'r';
+
+    netif->output = pair_etharp_output;
+    netif->linkoutput = pair_low_level_output;
+
+    err = sys_mutex_new(&pair_enetdata.TXLockMutex);
+    LWIP_ASSERT("TXLockMutex creation error", (err == ERR_OK));
+
+    sys_thread_new("receive_thread", packet_rx, netif->state, DEFAULT_THREAD_STACKSIZE, RX_PRIORITY);
+
+    return err;
+}
+
+/* The wire is always connected so "enabling interrupts" just raises the link. */
+void eth_arch_enable_interrupts(void) {
+    tcpip_callback((tcpip_callback_fn)netif_set_link_up, pair_enetdata.netif);
+}
+
+void eth_arch_disable_interrupts(void) {
+    tcpip_callback((tcpip_callback_fn)netif_set_link_down, pair_enetdata.netif);
+}
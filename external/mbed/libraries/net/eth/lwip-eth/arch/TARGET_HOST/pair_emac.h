@@ -0,0 +1,62 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef PAIR_EMAC_H_
+#define PAIR_EMAC_H_
+
+#include <stdint.h>
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Host "EMAC" which connects two lwIP instances, each running in its own
+   process, through one end of a datagram socketpair().  Every lwIP frame
+   becomes one datagram so the wire never fragments or merges frames.  A
+   configurable one-way latency and random frame loss are applied on the
+   receive side to model a real link. */
+typedef struct {
+    int      fd;                /* This process' end of the socketpair. */
+    uint32_t latency_us;        /* One-way latency added to each received frame. */
+    uint32_t loss_ppm;          /* Received frames to drop, in parts per million. */
+    uint32_t seed;              /* Seed for the loss generator. */
+    uint8_t  hwaddr[6];         /* MAC address of this end of the link. */
+} pair_emac_config_t;
+
+typedef struct {
+    uint32_t tx_frames;
+    uint32_t tx_bytes;
+    uint32_t rx_frames;
+    uint32_t rx_bytes;
+    uint32_t rx_lost;           /* Dropped by the loss model. */
+    uint32_t rx_no_pbuf;        /* Dropped because PBUF_POOL was exhausted. */
+    uint32_t rx_delay_overflow; /* Dropped because the latency line was full. */
+} pair_emac_counters_t;
+
+/* Creates both ends of the simulated wire.  Returns 0 on success. */
+int  pair_emac_create_link(int fds[2]);
+
+/* Must be called before eth_arch_enetif_init() is handed to netif_add(). */
+void pair_emac_configure(const pair_emac_config_t* pConfig);
+void pair_emac_get_counters(pair_emac_counters_t* pCounters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAIR_EMAC_H_ */
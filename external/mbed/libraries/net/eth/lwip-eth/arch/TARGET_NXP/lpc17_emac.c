@@ -38,6 +38,9 @@
 #include "lpc_emac_config.h"
 #include "lpc_phy.h"
 #include "sys_arch.h"
+#if NO_SYS == 0
+#include "EventQueue.h"
+#endif
 
 #include "mbed_interface.h"
 #include <string.h>
@@ -61,14 +64,27 @@
  */
 
 #if NO_SYS == 0
-/** \brief  Driver transmit and receive thread priorities
+/** \brief  Driver event thread priority
+ *
+ * Priority of the one thread which runs the receive, TX cleanup and
+ * PHY status events of the driver, in place of a receive thread, a TX
+ * cleanup thread and the RTX timer thread. */
+#define EVENT_PRIORITY   (osPriorityNormal)
+
+/** \brief  Driver event queue size
+ *
+ * The ISR posts each of the receive and TX cleanup events only while
+ * it isn't already pending, so the queue never holds more than these
+ * and the start of the PHY status updates. */
+#define EVENT_QUEUE_SIZE 4
+
+/** \brief  Receive batch size
  *
- * Thread priorities for receive thread and TX cleanup thread. Alter
- * to prioritize receive or transmit bandwidth. In a heavily loaded
- * system or with LEIP_DEBUG enabled, the priorities might be better
- * the same. */
-#define RX_PRIORITY   (osPriorityNormal)
-#define TX_PRIORITY   (osPriorityNormal)
+ * Most packets passed to LWIP by one receive event.  When more are
+ * waiting the event is posted again, behind the TX cleanup and PHY
+ * status events, so that a flood of received packets doesn't hold
+ * up the reclaiming of TX descriptors on the shared thread. */
+#define RX_BATCH_SIZE    LPC_NUM_BUFF_RXDESCS
 
 /** \brief  Debug output formatter lock define
  *
@@ -88,10 +104,6 @@
  */
 #define TXINTGROUP (EMAC_INT_TX_UNDERRUN | EMAC_INT_TX_ERR | EMAC_INT_TX_DONE)
 
-/** \brief  Signal used for ethernet ISR to signal packet_rx() thread.
- */
-#define RX_SIGNAL  1
-
 #else
 #define RXINTGROUP 0
 #define TXINTGROUP 0
@@ -127,8 +139,9 @@ struct lpc_enetdata {
 	struct pbuf *txb[LPC_NUM_BUFF_TXDESCS]; /**< TX pbuf pointer list, zero-copy mode */
 	u32_t lpc_last_tx_idx; /**< TX last descriptor index, zero-copy mode */
 #if NO_SYS == 0
-	sys_thread_t RxThread; /**< RX receive thread data object pointer */
-	sys_sem_t TxCleanSem; /**< TX cleanup thread wakeup semaphore */
+	void *EventQueue; /**< Queue of the RX, TX cleanup and PHY events */
+	volatile u32_t rx_pending; /**< RX event posted and not yet run */
+	volatile u32_t tx_pending; /**< TX cleanup event posted and not yet run */
 	sys_mutex_t TXLockMutex; /**< TX critical section mutex */
 	sys_sem_t xTXDCountSem; /**< TX free buffer counting semaphore */
 #endif
@@ -681,6 +694,11 @@ static err_t lpc_low_level_output(struct netif *netif, struct pbuf *p)
 	return ERR_OK;
 }
 
+#if NO_SYS == 0
+static void packet_rx(void const* pvParameters);
+static void packet_tx(void const* pvParameters);
+#endif
+
 /** \brief  LPC EMAC interrupt handler.
  *
  *  This function handles the transmit, receive, and error interrupt of
@@ -695,19 +713,21 @@ void ENET_IRQHandler(void)
 	uint32_t ints;
 
 	/* Interrupts are of 2 groups - transmit or receive. Based on the
-	   interrupt, kick off the receive or transmit (cleanup) task */
+	   interrupt, post the receive or transmit (cleanup) event */
 
 	/* Get pending interrupts */
 	ints = LPC_EMAC->IntStatus;
 
-	if (ints & RXINTGROUP) {
-        /* RX group interrupt(s): Give signal to wakeup RX receive task.*/
-        osSignalSet(lpc_enetdata.RxThread->id, RX_SIGNAL);
+	if ((ints & RXINTGROUP) && !lpc_enetdata.rx_pending) {
+        /* RX group interrupt(s): Post the RX receive event.*/
+        lpc_enetdata.rx_pending = 1;
+        event_queue_post(lpc_enetdata.EventQueue, packet_rx, &lpc_enetdata);
     }
 
-    if (ints & TXINTGROUP) {
-        /* TX group interrupt(s): Give semaphore to wakeup TX cleanup task. */
-        sys_sem_signal(&lpc_enetdata.TxCleanSem);
+    if ((ints & TXINTGROUP) && !lpc_enetdata.tx_pending) {
+        /* TX group interrupt(s): Post the TX cleanup event. */
+        lpc_enetdata.tx_pending = 1;
+        event_queue_post(lpc_enetdata.EventQueue, packet_tx, &lpc_enetdata);
     }
 
 	/* Clear pending interrupts */
@@ -716,75 +736,84 @@ void ENET_IRQHandler(void)
 }
 
 #if NO_SYS == 0
-/** \brief  Packet reception task
+/** \brief  Packet reception event
  *
- * This task is called when a packet is received. It will
- * pass the packet to the LWIP core.
+ * This event is posted when a packet is received. It will
+ * pass the packets received to the LWIP core.
  *
- *  \param[in] pvParameters Not used yet
+ *  \param[in] pvParameters Pointer to the driver data
  */
-static void packet_rx(void* pvParameters) {
-    struct lpc_enetdata *lpc_enetif = pvParameters;
-
-    while (1) {
-        /* Wait for receive task to wakeup */
-        osSignalWait(RX_SIGNAL, osWaitForever);
+static void packet_rx(void const* pvParameters) {
+    struct lpc_enetdata *lpc_enetif = (struct lpc_enetdata *)pvParameters;
+    int count;
+
+    /* Packets received from now on post the event again */
+    lpc_enetif->rx_pending = 0;
+
+    /* Process packets until all empty, or a batch has been */
+    for (count = 0; count < RX_BATCH_SIZE; count++) {
+        if (LPC_EMAC->RxConsumeIndex == LPC_EMAC->RxProduceIndex)
+            return;
+        lpc_enetif_input(lpc_enetif->netif);
+    }
 
-        /* Process packets until all empty */
-        while (LPC_EMAC->RxConsumeIndex != LPC_EMAC->RxProduceIndex)
-            lpc_enetif_input(lpc_enetif->netif);
+    /* Come back for the rest after the other events, unless the ISR
+       has posted the event again meanwhile */
+    NVIC_DisableIRQ(ENET_IRQn);
+    if (!lpc_enetif->rx_pending) {
+        lpc_enetif->rx_pending = 1;
+        event_queue_post(lpc_enetif->EventQueue, packet_rx, lpc_enetif);
     }
+    NVIC_EnableIRQ(ENET_IRQn);
 }
 
-/** \brief  Transmit cleanup task
+/** \brief  Transmit cleanup event
  *
- * This task is called when a transmit interrupt occurs and
- * reclaims the pbuf and descriptor used for the packet once
- * the packet has been transferred.
+ * This event is posted when a transmit interrupt occurs and
+ * reclaims the pbufs and descriptors used for the packets once
+ * the packets have been transferred.
  *
- *  \param[in] pvParameters Not used yet
+ *  \param[in] pvParameters Pointer to the driver data
  */
-static void packet_tx(void* pvParameters) {
-    struct lpc_enetdata *lpc_enetif = pvParameters;
+static void packet_tx(void const* pvParameters) {
+    struct lpc_enetdata *lpc_enetif = (struct lpc_enetdata *)pvParameters;
     s32_t idx;
 
-    while (1) {
-        /* Wait for transmit cleanup task to wakeup */
-        sys_arch_sem_wait(&lpc_enetif->TxCleanSem, 0);
+    /* Packets sent from now on post the event again */
+    lpc_enetif->tx_pending = 0;
 
-        /* Error handling for TX underruns. This should never happen unless
-           something is holding the bus or the clocks are going too slow. It
-            can probably be safely removed. */
-        if (LPC_EMAC->IntStatus & EMAC_INT_TX_UNDERRUN) {
-            LINK_STATS_INC(link.err);
-            LINK_STATS_INC(link.drop);
+    /* Error handling for TX underruns. This should never happen unless
+       something is holding the bus or the clocks are going too slow. It
+        can probably be safely removed. */
+    if (LPC_EMAC->IntStatus & EMAC_INT_TX_UNDERRUN) {
+        LINK_STATS_INC(link.err);
+        LINK_STATS_INC(link.drop);
 
 #if NO_SYS == 0
-            /* Get exclusive access */
-            sys_mutex_lock(&lpc_enetif->TXLockMutex);
+        /* Get exclusive access */
+        sys_mutex_lock(&lpc_enetif->TXLockMutex);
 #endif
-            /* Reset the TX side */
-            LPC_EMAC->MAC1 |= EMAC_MAC1_RES_TX;
-            LPC_EMAC->IntClear = EMAC_INT_TX_UNDERRUN;
-
-            /* De-allocate all queued TX pbufs */
-            for (idx = 0; idx < LPC_NUM_BUFF_TXDESCS; idx++) {
-                if (lpc_enetif->txb[idx] != NULL) {
-                    pbuf_free(lpc_enetif->txb[idx]);
-                    lpc_enetif->txb[idx] = NULL;
-                }
+        /* Reset the TX side */
+        LPC_EMAC->MAC1 |= EMAC_MAC1_RES_TX;
+        LPC_EMAC->IntClear = EMAC_INT_TX_UNDERRUN;
+
+        /* De-allocate all queued TX pbufs */
+        for (idx = 0; idx < LPC_NUM_BUFF_TXDESCS; idx++) {
+            if (lpc_enetif->txb[idx] != NULL) {
+                pbuf_free(lpc_enetif->txb[idx]);
+                lpc_enetif->txb[idx] = NULL;
             }
+        }
 
 #if NO_SYS == 0
-            /* Restore access */
-            sys_mutex_unlock(&lpc_enetif->TXLockMutex);
+        /* Restore access */
+        sys_mutex_unlock(&lpc_enetif->TXLockMutex);
 #endif
-            /* Start TX side again */
-            lpc_tx_setup(lpc_enetif);
-        } else {
-            /* Free TX buffers that are done sending */
-            lpc_tx_reclaim(lpc_enetdata.netif);
-        }
+        /* Start TX side again */
+        lpc_tx_setup(lpc_enetif);
+    } else {
+        /* Free TX buffers that are done sending */
+        lpc_tx_reclaim(lpc_enetdata.netif);
     }
 }
 #endif
@@ -943,7 +972,11 @@ err_t lpc_etharp_output(struct netif *netif, struct pbuf *q,
 void phy_update(void const *nif) {
     lpc_phy_sts_sm((struct netif*)nif);
 }
-osTimerDef(phy_update, phy_update);
+
+/* Thread which runs the events of the driver */
+static void packet_events(void *queue) {
+    event_queue_dispatch(queue, osWaitForever);
+}
 #endif
 
 /**
@@ -1013,18 +1046,16 @@ err_t eth_arch_enetif_init(struct netif *netif)
 	err = sys_mutex_new(&lpc_enetdata.TXLockMutex);
 	LWIP_ASSERT("TXLockMutex creation error", (err == ERR_OK));
 
-	/* Packet receive task */
-	lpc_enetdata.RxThread = sys_thread_new("receive_thread", packet_rx, netif->state, DEFAULT_THREAD_STACKSIZE, RX_PRIORITY);
-	LWIP_ASSERT("RxThread creation error", (lpc_enetdata.RxThread));
-
-	/* Transmit cleanup task */
-	err = sys_sem_new(&lpc_enetdata.TxCleanSem, 0);
-	LWIP_ASSERT("TxCleanSem creation error", (err == ERR_OK));
-	sys_thread_new("txclean_thread", packet_tx, netif->state, DEFAULT_THREAD_STACKSIZE, TX_PRIORITY);
+	/* Packet receive, transmit cleanup and PHY status events */
+	lpc_enetdata.rx_pending = 0;
+	lpc_enetdata.tx_pending = 0;
+	lpc_enetdata.EventQueue = event_queue_create(EVENT_QUEUE_SIZE, 1);
+	if (lpc_enetdata.EventQueue == NULL)
+		return ERR_MEM;
+	sys_thread_new("emac_thread", packet_events, lpc_enetdata.EventQueue, DEFAULT_THREAD_STACKSIZE, EVENT_PRIORITY);
 
 	/* periodic PHY status update */
-	osTimerId phy_timer = osTimerCreate(osTimer(phy_update), osTimerPeriodic, (void *)netif);
-	osTimerStart(phy_timer, 250);
+	event_queue_post_every(lpc_enetdata.EventQueue, 250, phy_update, (void *)netif);
 #endif
 
     return ERR_OK;
@@ -25,6 +25,12 @@
 #define MEM_SIZE                      15360
 #elif defined(TARGET_LPC1768)
 #define MEM_SIZE                      16362
+
+/* The PBUF_POOL shares the 16k AHBSRAM1 bank with the rest of the memp pools
+   and the EMAC descriptors so the bulk profile's receive window is kept to 3
+   segments.  The send buffer comes from the heap in AHBSRAM0. */
+#define LWIP_BULK_WND_SEGS            3
+#define LWIP_BULK_SND_SEGS            4
 #endif
 
 #endif
@@ -1,24 +1,68 @@
 #include "HTTPHeader.h"
 #include <stdlib.h>    
-using std::map;
+#include <string.h>
+#include <strings.h>
 using std::string;
 
 HTTPHeader::HTTPHeader():
 _status(HTTP_ERROR),
-_fields()
+_statusCode(0),
+_size(0)
 {
 }
 
 std::string HTTPHeader::getField(const std::string& name)
 {
-    map<string,string>::iterator itor = _fields.find(name);
-    if(itor == _fields.end())
-        return string();
-    return itor->second;
+    const char* value = findField(name.c_str());
+    return value ? string(value) : string();
+}
+
+// Field names are case insensitive.
+const char* HTTPHeader::findField(const char* name) const
+{
+    const char* field = _fields;
+    const char* end = _fields + _size;
+
+    while(field < end)
+    {
+        const char* value = field + strlen(field) + 1;
+        if(strcasecmp(field, name) == 0)
+            return value;
+        field = value + strlen(value) + 1;
+    }
+    return NULL;
 }
 
 int HTTPHeader::getBodyLength()
 {
-    return atoi(getField("Content-Length").c_str());
+    const char* length = findField("Content-Length");
+    return length ? atoi(length) : 0;
 }
 
+int HTTPHeader::getStatusCode() const
+{
+    return _statusCode;
+}
+
+// Turns the "name: value" line of length bytes which was read in after the
+// last field into a field.  Lines which aren't fields are dropped.
+bool HTTPHeader::addField(int length)
+{
+    char* name = _fields + _size;
+    char* sep = (char*)memchr(name, ':', length);
+    if(sep == NULL)
+        return false;
+
+    char* value = sep + 1;
+    char* end = name + length;
+    while(value < end && (*value == ' ' || *value == '\t'))
+        value++;
+    while(end > value && (end[-1] == ' ' || end[-1] == '\t'))
+        end--;
+
+    *sep = '\0';
+    memmove(sep + 1, value, end - value);
+    sep[1 + (end - value)] = '\0';
+    _size = (sep + 2 + (end - value)) - _fields;
+    return true;
+}
@@ -2,7 +2,13 @@
 #define HTTPHEADER_H
 
 #include <string>
-#include <map>
+
+/** Bytes of header fields kept from a response.  Fields which don't fit are
+    dropped.
+*/
+#ifndef HTTP_HEADER_SIZE
+#define HTTP_HEADER_SIZE 512
+#endif
 
 enum HTTPStatus { HTTP_OK, HTTP_ERROR };
 
@@ -18,11 +24,27 @@ class HTTPHeader
         
         std::string getField(const std::string& name);  
         int getBodyLength();
+
+        /** Find a header field without copying it
+        \param name The name of the field, in any case.
+        \return The value of the field, or NULL if it isn't in the header.
+        */
+        const char* findField(const char* name) const;
+
+        /** HTTP status code of the response, ie. 200
+        */
+        int getStatusCode() const;
         
     private :
     
+        bool addField(int length);
+
         HTTPStatus _status;
-        std::map<std::string, std::string> _fields;
+        int _statusCode;
+        int _size;
+        // Each field is stored as its name and value strings, one after the
+        // other.
+        char _fields[HTTP_HEADER_SIZE];
 };
 
 
@@ -1,59 +1,171 @@
 #include "HTTPSClient.h"
 #include "HTTPHeader.h"
+#include "FileHandle.h"
 #include <string>
 #include <cstring>
-#include "mbed.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <strings.h>
 
 using std::memset;
-using std::memcpy;    
+using std::memcpy;
 using std::string;
 
 const static int HTTPS_PORT = 443;
-char buf[256];
+
+// The client SSL_CTX is shared by every HTTPSClient so that its session cache
+// outlives the connections.  axTLS keeps the master secret of each session in
+// it, indexed by session id, and the table below remembers which session id
+// was last used with which server.  None of it is locked, as axTLS is built
+// without CONFIG_SSL_CTX_MUTEXING, so HTTPSClient is single threaded.
+namespace {
+    struct CachedSession {
+        string host;
+        int port;
+        uint8_t id[SSL_SESSION_ID_SIZE];
+        uint8_t id_size;
+        unsigned int last_used;
+    };
+}
+
+static SSL_CTX ssl_ctx;
+static bool ssl_ctx_ready = false;
+static CachedSession sessions[HTTPS_SESSION_CACHE_SIZE];
+static unsigned int session_clock = 0;
+
+static SSL_CTX* get_ssl_ctx() {
+    if (!ssl_ctx_ready) {
+        if (ssl_ctx_new(&ssl_ctx, SSL_SERVER_VERIFY_LATER, HTTPS_SESSION_CACHE_SIZE) != &ssl_ctx)
+            return NULL;
+        ssl_ctx_ready = true;
+    }
+    return &ssl_ctx;
+}
+
+static CachedSession* find_session(const string& host, int port) {
+    for (int i = 0 ; i < HTTPS_SESSION_CACHE_SIZE ; i++) {
+        if (sessions[i].id_size && sessions[i].port == port && sessions[i].host == host)
+            return &sessions[i];
+    }
+    return NULL;
+}
+
+// axTLS drops sessions when they expire or when it needs their slot for a
+// new one.  Only offer the server a session whose master secret is still
+// there, otherwise the server could resume a session that can't be completed.
+static bool session_usable(const CachedSession* session) {
+    for (int i = 0 ; i < ssl_ctx.num_sessions ; i++) {
+        SSL_SESSION* cached = ssl_ctx.ssl_sessions[i];
+        if (cached && memcmp(cached->session_id, session->id, SSL_SESSION_ID_SIZE) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void remember_session(const string& host, int port, const SSL* ssl) {
+    CachedSession* session = find_session(host, port);
+    uint8_t id_size = ssl_get_session_id_size(ssl);
+
+    if (session == NULL) {
+        // Replace the least recently used server.
+        session = &sessions[0];
+        for (int i = 1 ; i < HTTPS_SESSION_CACHE_SIZE ; i++) {
+            if (sessions[i].last_used < session->last_used)
+                session = &sessions[i];
+        }
+    }
+    if (id_size == 0 || id_size > SSL_SESSION_ID_SIZE) {
+        // The server doesn't cache sessions.
+        session->id_size = 0;
+        return;
+    }
+    session->host = host;
+    session->port = port;
+    memset(session->id, 0, sizeof(session->id));
+    memcpy(session->id, ssl_get_session_id(ssl), id_size);
+    session->id_size = id_size;
+    session->last_used = ++session_clock;
+}
 
 HTTPSClient::HTTPSClient() :
         _is_connected(false),
-        _ssl_ctx(),
         _ssl(),
-        _host() {
+        _host(),
+        _port(HTTPS_PORT),
+        _keep_alive(false),
+        _body_left(0),
+        _chunked(false),
+        _chunk_crlf(false),
+        _handshakes(0),
+        _resumed_handshakes(0) {
 }
 
 HTTPSClient::~HTTPSClient() {
     close();
 }
 
-int HTTPSClient::connect(const char* host) {
-    if (init_socket(SOCK_STREAM) < 0)
+int HTTPSClient::connect(const char* host, const int port) {
+    close();
+    _host = host;
+    _port = port;
+    if (open() < 0) {
+        _host.clear();
         return -1;
-    
-    if (set_address(host, HTTPS_PORT) != 0)
+    }
+    return 0;
+}
+
+// Makes the TCP connection and the TLS handshake to _host and _port.
+int HTTPSClient::open() {
+    SSL_CTX* ctx = get_ssl_ctx();
+    if (ctx == NULL)
         return -1;
-    
-    if (lwip_connect(_sock_fd, (const struct sockaddr *) &_remoteHost, sizeof(_remoteHost)) < 0) {
-        close();
+
+    if (init_socket(SOCK_STREAM) < 0)
         return -1;
-    }
 
-    if(ssl_ctx_new(&_ssl_ctx, SSL_SERVER_VERIFY_LATER, SSL_DEFAULT_CLNT_SESS) != &_ssl_ctx)
+    // The handshake is made of several small writes which Nagle's algorithm
+    // would otherwise hold back until the server's delayed ACK.
+    int nodelay = 1;
+    set_option(IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    if (set_address(_host.c_str(), _port) != 0 ||
+        lwip_connect(_sock_fd, (const struct sockaddr *) &_remoteHost, sizeof(_remoteHost)) < 0) {
+        Socket::close();
         return -1;
+    }
+
+    CachedSession* session = find_session(_host, _port);
+    if (session && !session_usable(session)) {
+        session->id_size = 0;
+        session = NULL;
+    }
 
-    _ssl.ssl_ctx = &_ssl_ctx;
-    
-    if(ssl_client_new(&_ssl, _sock_fd, NULL, 0) == NULL)
+    _ssl.ssl_ctx = ctx;
+    if(ssl_client_new(&_ssl, _sock_fd, session ? session->id : NULL, session ? session->id_size : 0) == NULL)
     {
-        close();
+        Socket::close();
         return -1;
     }
     if(_ssl.hs_status != SSL_OK)
     {
-        close();
+        // Don't offer the session again if that is what the server refused.
+        if (session)
+            session->id_size = 0;
+        ssl_free(&_ssl);
+        Socket::close();
         return -1;
     }
-    
+
+    _handshakes++;
+    if (_ssl.flag & SSL_SESSION_RESUME)
+        _resumed_handshakes++;
+    remember_session(_host, _port, &_ssl);
+
     _is_connected = true;
-    _host = host;
+    _keep_alive = true;
+    _body_left = 0;
+    _chunked = false;
     return 0;
 }
 
@@ -61,82 +173,298 @@ bool HTTPSClient::is_connected(void) {
     return _is_connected;
 }
 
-int HTTPSClient::send(char* data, int length) {
+unsigned int HTTPSClient::get_handshakes(void) {
+    return _handshakes;
+}
+
+unsigned int HTTPSClient::get_resumed_handshakes(void) {
+    return _resumed_handshakes;
+}
+
+// Writes the request straight into the TLS record buffer, where it is
+// encrypted and sent from without another copy.
+bool HTTPSClient::send_request(const char* path) {
     if ((_sock_fd < 0) || !_is_connected)
-        return -1;
-            
-    return ssl_write(&_ssl, (uint8_t*)data, length);
+        return false;
+
+    uint8_t* buffer;
+    int size = ssl_write_buf(&_ssl, &buffer);
+    int len;
+    if(_port == HTTPS_PORT)
+        len = snprintf((char*)buffer, size, "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", path, _host.c_str());
+    else
+        len = snprintf((char*)buffer, size, "GET %s HTTP/1.1\r\nHost: %s:%d\r\n\r\n", path, _host.c_str(), _port);
+    if(len <= 0 || len >= size)
+        return false;
+
+    return ssl_write_done(&_ssl, len) == len;
 }
 
 
 
-HTTPHeader HTTPSClient::get(char *request)
+HTTPHeader HTTPSClient::get(const char *path)
 {
-    if((_sock_fd < 0) || !_is_connected)
-        return HTTPHeader();
-        
-    sprintf(buf, "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", request, _host.c_str());
-    printf("buf=%s\n", buf);
-    if(send(buf, strlen(buf)) != strlen(buf))
+    if(_host.empty())
         return HTTPHeader();
-    printf("Finished sending request\n");
-    return read_header();
+
+    // The connection can only carry the next request once the last response
+    // has been read to its end.
+    if(_is_connected && (!_keep_alive || !skip_body()))
+        disconnect();
+
+    for(int attempt = 0; attempt < 2; attempt++)
+    {
+        bool reused = _is_connected;
+        if(!_is_connected && open() < 0)
+            return HTTPHeader();
+
+        HTTPHeader hdr;
+        if(send_request(path) && read_header(hdr))
+            return hdr;
+
+        // A kept alive connection may have been closed by the server while
+        // it was idle.  Retry once on a new one.
+        disconnect();
+        if(!reused)
+            break;
+    }
+    return HTTPHeader();
 }
 
+// Reads and discards what is left of the last response body.
+bool HTTPSClient::skip_body()
+{
+    const char* body;
+    int length;
+
+    while((length = next_body(&body)) > 0)
+        body_done(length);
+    return length == 0;
+}
 
-HTTPHeader HTTPSClient::read_header()
+// Reads a line, without its CRLF, straight out of the TLS record buffer.  At
+// most size-1 bytes are kept, followed by a '\0'.
+// Returns the full length of the line, or -1 on failure.
+int HTTPSClient::read_line(char* line, int size)
 {
-    _ssl.bm_read_index = 0;
-    _ssl.bm_index = 0;
-    HTTPHeader hdr;
-    if(read_line())
-        return hdr;
-    
-    int status;
-    
-    if(sscanf(buf, "HTTP/%*d.%*d %d %*s", &status) == -1)
-        return hdr;
-    
+    int length = 0;
+    char last = '\0';
+
+    for(;;)
+    {
+        uint8_t* data;
+        int available = ssl_read_buf(&_ssl, &data);
+        if(available <= 0)
+            return -1;
+
+        uint8_t* newline = (uint8_t*)memchr(data, '\n', available);
+        int count = newline ? newline - data : available;
+        if(length < size - 1)
+            memcpy(line + length, data, count < size - 1 - length ? count : size - 1 - length);
+        if(count > 0)
+            last = data[count - 1];
+        length += count;
+        ssl_read_done(&_ssl, newline ? count + 1 : count);
+        if(newline)
+            break;
+    }
+    if(last == '\r')
+        length--;
+    if(size > 0)
+        line[length < size - 1 ? length : size - 1] = '\0';
+    return length;
+}
+
+bool HTTPSClient::read_header(HTTPHeader& hdr)
+{
+    int major, minor, status;
+    int length = read_line(hdr._fields, sizeof(hdr._fields));
+
+    if(length < 0 || sscanf(hdr._fields, "HTTP/%d.%d %d", &major, &minor, &status) != 3)
+        return false;
+    hdr._statusCode = status;
     if(status == 200)
         hdr._status = HTTP_OK;
-   if(read_line())
-        return hdr;
-    do
+
+    // The fields are read in place after the ones already kept.  Those which
+    // don't fit are dropped.
+    for(;;)
     {
-        string tmp(buf);
-        std::size_t sep = tmp.find(':');
-        string name = tmp.substr(0, sep);
-        string value = tmp.substr(sep+2, tmp.size());
-        hdr._fields[name] = value;
-        if(read_line())
-            return hdr;
-    }while(strlen(buf));
-    
-    return hdr;
+        int size = sizeof(hdr._fields) - hdr._size - 1;
+        length = read_line(hdr._fields + hdr._size, size);
+        if(length < 0)
+            return false;
+        if(length == 0)
+            break;
+        if(length < size)
+            hdr.addField(length);
+    }
+
+    // The connection can be reused when the end of the body is known and
+    // the server didn't ask for it to be closed.
+    const char* connection = hdr.findField("Connection");
+    if(connection && strcasecmp(connection, "close") == 0)
+        _keep_alive = false;
+    else
+        _keep_alive = major > 1 || minor >= 1 || (connection && strcasecmp(connection, "keep-alive") == 0);
+
+    const char* encoding = hdr.findField("Transfer-Encoding");
+    const char* content_length = hdr.findField("Content-Length");
+    std::size_t encoding_length = encoding ? strlen(encoding) : 0;
+
+    _chunked = false;
+    _chunk_crlf = false;
+    if(status == 204 || status == 304 || (status >= 100 && status < 200))
+        _body_left = 0;
+    else if(encoding_length >= 7 && strcasecmp(encoding + encoding_length - 7, "chunked") == 0)
+    {
+        // chunked is always the last coding applied.
+        _chunked = true;
+        _body_left = 0;
+    }
+    else if(content_length && (!encoding || strcasecmp(encoding, "identity") == 0))
+    {
+        // A length which isn't a plain decimal number fails the response,
+        // rather than leaving a kept alive body to end when the server closes.
+        char* end;
+        unsigned long length = strtoul(content_length, &end, 10);
+        if(*content_length < '0' || *content_length > '9' || *end != '\0' || length > 0x7FFFFFFF)
+        {
+            _keep_alive = false;
+            return false;
+        }
+        _body_left = length;
+    }
+    else
+    {
+        _body_left = -1;
+        _keep_alive = false;
+    }
+    return true;
 }
 
-uint8_t HTTPSClient::read_line()
+// Reads the size of the next chunk of a chunked body, skipping the CRLF after
+// the data of the last one, and the trailer after the final chunk.
+bool HTTPSClient::next_chunk()
 {
-    int index = 0;
-    do
+    char line[32];
+
+    if(_chunk_crlf && read_line(line, sizeof(line)) != 0)
+        return false;
+
+    char* end;
+    if(read_line(line, sizeof(line)) < 0)
+        return false;
+    unsigned long size = strtoul(line, &end, 16);
+    if(end == line || size > 0x7FFFFFFF)
+        return false;
+
+    if(size == 0)
     {
-        if(ssl_read(&_ssl, (uint8_t*)(&buf[index]), 1) != 1)
+        int length;
+        while((length = read_line(line, sizeof(line))) != 0)
         {
-            return 1;
+            if(length < 0)
+                return false;
         }
-        index++;
-    }while(buf[index-1] != '\r' && index < 256);
-    ssl_read(&_ssl, (uint8_t*)(&buf[index-1]), 1);  // skip '\n'
-    buf[index-1] = '\0';
-    
+        _chunked = false;
+        _body_left = 0;
+        return true;
+    }
+    _chunk_crlf = true;
+    _body_left = size;
+    return true;
+}
+
+// Moves on to the next chunk of a chunked body when the last one has been
+// read.  Returns 1 while there is more of the body, 0 at its end and -1 on
+// failure.
+int HTTPSClient::body_ready()
+{
+    if(!_is_connected)
+        return -1;
+    if(_chunked && _body_left == 0 && !next_chunk())
+    {
+        _keep_alive = false;
+        return -1;
+    }
+    return _body_left == 0 ? 0 : 1;
+}
+
+// Handles a failed, or zero length, TLS read of the body.
+int HTTPSClient::body_ended()
+{
+    _keep_alive = false;
+    if(_body_left > 0)
+        return -1;
+    // Without a length the body ends when the server closes.
+    _body_left = 0;
     return 0;
 }
 
+// Finds the next piece of the response body in the TLS record buffer.
+// Returns its length, 0 at the end of the body, or -1 on failure.  The piece
+// stays in the buffer until body_done().
+int HTTPSClient::next_body(const char** data)
+{
+    int ready = body_ready();
+    if(ready <= 0)
+        return ready;
+
+    uint8_t* buffer;
+    int length = ssl_read_buf(&_ssl, &buffer);
+    if(length <= 0)
+        return body_ended();
+    if(_body_left > 0 && length > _body_left)
+        length = _body_left;
+    *data = (const char*)buffer;
+    return length;
+}
+
+void HTTPSClient::body_done(int length)
+{
+    ssl_read_done(&_ssl, length);
+    if(_body_left > 0)
+        _body_left -= length;
+}
+
 // -1:error
 // otherwise return nb of characters read. Cannot be > than len
 int HTTPSClient::read(char *data, int len)
 {
-    return ssl_read(&_ssl, (uint8_t*)data, len);
+    int ready = body_ready();
+    if(ready <= 0)
+        return ready;
+
+    // ssl_read() decrypts a whole record straight into data when it fits,
+    // which it can't do beyond the end of the body.
+    if(_body_left > 0 && len > _body_left)
+        len = _body_left;
+    int length = ssl_read(&_ssl, (uint8_t*)data, len);
+    if(length <= 0)
+        return body_ended();
+    if(_body_left > 0)
+        _body_left -= length;
+    return length;
+}
+
+int HTTPSClient::read_to(mbed::FileHandle* sink)
+{
+    const char* body;
+    int length;
+    int total = 0;
+
+    while((length = next_body(&body)) > 0)
+    {
+        if(sink->write(body, length) != length)
+        {
+            _keep_alive = false;
+            return -1;
+        }
+        body_done(length);
+        total += length;
+    }
+    return length < 0 ? -1 : total;
 }
 /*
     0    : must close connection
@@ -146,18 +474,25 @@ int HTTPSClient::read(char *data, int len)
 int HTTPSClient::receive(char* data, int length) {
     if ((_sock_fd < 0) || !_is_connected)
         return -1;
-  
+
     if(read_record(&_ssl) < 0)
         return -1;
     return process_data(&_ssl, (uint8_t*)data, length);
 }
 */
-void HTTPSClient::close()
+
+// Ends the TLS session, which stays in the cache, and the TCP connection.
+void HTTPSClient::disconnect()
 {
     if(!_is_connected)
         return;
-    ssl_ctx_free(_ssl.ssl_ctx);
+    ssl_free(&_ssl);
     Socket::close();
     _is_connected = false;
+}
+
+void HTTPSClient::close()
+{
+    disconnect();
     _host.clear();
 }
@@ -1,56 +1,121 @@
 #ifndef HTTPSCLIENT_H
 #define HTTPSCLIENT_H
 
+#include "HTTPHeader.h"
 #include "Socket/Socket.h"
 #include "Socket/Endpoint.h"
 #include "axTLS/ssl/ssl.h"
-#include "HTTPHeader.h"
+
+namespace mbed {
+class FileHandle;
+}
+
+/** Number of servers, by host and port, whose TLS session is remembered so
+    that the next connection to them can resume it instead of making a full
+    handshake.  The cache is shared by all HTTPSClient objects.
+*/
+#ifndef HTTPS_SESSION_CACHE_SIZE
+#define HTTPS_SESSION_CACHE_SIZE 4
+#endif
 
 /**
 TCP socket connection
+
+The session cache and the axTLS SSL_CTX behind it are shared by every
+HTTPSClient without a lock, so all of them must be used from one thread.
 */
 class HTTPSClient : public Socket, public Endpoint {
-    
+
 public:
     /** TCP socket connection
     */
     HTTPSClient();
-    
-    
+
+
     virtual ~HTTPSClient();
-    
+
     /** Connects this TCP socket to the server
+    The TLS session of the last connection to the same host and port is
+    resumed when the server still knows it, which saves the RSA operations of
+    a full handshake.
     \param host The host to connect to. It can either be an IP Address or a hostname that will be resolved with DNS.
     \param port The host's port to connect to.
     \return 0 on success, -1 on failure.
     */
-    int connect(const char* host);
-    
+    int connect(const char* host, const int port = 443);
+
     /** Check if the socket is connected
     \return true if connected, false otherwise.
     */
     bool is_connected(void);
-    
-    // Returns the size of the body
-    HTTPHeader get(char *path);
-    
+
+    /** Send a GET request and read the response header
+    The connection is kept open between requests.  If the previous response
+    wasn't read to the end it is skipped, and if the server closed the
+    connection, or the previous response didn't allow it to be reused, a new
+    connection is made to the same host first.
+    \param path The path of the resource to request.
+    \return The response header.  Its body is then read with read() or read_to().
+    */
+    HTTPHeader get(const char *path);
+
+    /** Read the body of the response to the last get()
+    Both Content-Length and chunked bodies are read in pieces of at most one
+    TLS record.  A whole record is decrypted straight into data, without
+    going through the TLS record buffer, when it fits there and within the
+    body, so a buffer as large as the server's records saves a copy.
+    \param data The buffer to read into.
+    \param len The size of the buffer.
+    \return the number of bytes read, 0 at the end of the body, or -1 on failure.
+    */
     int read(char *data, int len);
 
+    /** Write the rest of the body of the response to the last get() to a file
+    The body is written straight from the TLS record buffer, without another
+    copy, one record at a time.
+    \param sink The file, or other FileHandle, to write the body to.
+    \return the number of bytes written, or -1 on failure.
+    */
+    int read_to(mbed::FileHandle* sink);
+
 
     void close();
-    
+
+    /** Number of TLS handshakes made by this client
+    \return handshakes made, including those which resumed a cached session.
+    */
+    unsigned int get_handshakes(void);
+
+    /** Number of TLS handshakes which resumed a cached session
+    \return abbreviated handshakes made by this client.
+    */
+    unsigned int get_resumed_handshakes(void);
+
 private:
+    int open();
+    void disconnect();
+    bool skip_body();
 
+    bool send_request(const char* path);
 
-    int send(char* data, int length);
-    
-    uint8_t read_line();
-    HTTPHeader read_header();
+    int read_line(char* line, int size);
+    bool read_header(HTTPHeader& hdr);
+    bool next_chunk();
+    int body_ready();
+    int body_ended();
+    int next_body(const char** data);
+    void body_done(int length);
 
     bool _is_connected;
-    SSL_CTX _ssl_ctx;
     SSL _ssl;
     std::string _host;
+    int _port;
+    bool _keep_alive;
+    int _body_left;
+    bool _chunked;
+    bool _chunk_crlf;
+    unsigned int _handshakes;
+    unsigned int _resumed_handshakes;
 };
 
 #endif
@@ -46,6 +46,8 @@
  * - Karatsuba multiplication
  * - Squaring
  * - Sliding window exponentiation
+ * - Word level Montgomery multiplication with fixed window exponentiation, 
+ *   for odd moduli (CONFIG_BIGINT_MONT_EXP).
  * - Chinese Remainder Theorem (implemented in rsa.c).
  *
  * All the algorithms used are pretty standard, and designed for different
@@ -79,10 +81,14 @@ static bigint *alloc(BI_CTX *ctx, int size);
 static bigint *trim(bigint *bi);
 static void more_comps(bigint *bi, int n);
 #if defined(CONFIG_BIGINT_KARATSUBA) || defined(CONFIG_BIGINT_BARRETT) || \
-    defined(CONFIG_BIGINT_MONTGOMERY)
+    defined(CONFIG_BIGINT_MONTGOMERY) || defined(CONFIG_BIGINT_MONT_EXP)
 static bigint *comp_right_shift(bigint *biR, int num_shifts);
 static bigint *comp_left_shift(bigint *biR, int num_shifts);
 #endif
+#ifdef CONFIG_BIGINT_MONT_EXP
+static comp mont_inverse(comp m0);
+static bigint *mont_mod_power(BI_CTX *ctx, bigint *bi, bigint *biexp);
+#endif
 
 #ifdef CONFIG_BIGINT_CHECK_ON
 static void check(const bigint *bi);
@@ -119,6 +125,9 @@ void bi_terminate(BI_CTX *ctx)
 {
     bi_depermanent(ctx->bi_radix); 
     bi_free(ctx, ctx->bi_radix);
+#ifdef CONFIG_BIGINT_MONT_EXP
+    free(ctx->arena);
+#endif
 
     if (ctx->active_count != 0)
     {
@@ -553,7 +562,7 @@ static comp modular_inverse(bigint *bim)
 #endif
 
 #if defined(CONFIG_BIGINT_KARATSUBA) || defined(CONFIG_BIGINT_BARRETT) || \
-    defined(CONFIG_BIGINT_MONTGOMERY)
+    defined(CONFIG_BIGINT_MONTGOMERY) || defined(CONFIG_BIGINT_MONT_EXP)
 /**
  * Take each component and shift down (in terms of components) 
  */
@@ -775,6 +784,23 @@ void bi_set_mod(BI_CTX *ctx, bigint *bim, int mod_offset)
             bi_clone(ctx, ctx->bi_radix), k*2-1), ctx->bi_mod[mod_offset], 0);
     bi_permanent(ctx->bi_mu[mod_offset]);
 #endif
+
+#ifdef CONFIG_BIGINT_MONT_EXP
+    ctx->bi_mont_RR[mod_offset] = NULL;
+    if (bim->comps[0] & 1)      /* Montgomery needs an odd modulus */
+    {
+        /* R^2 mod m, where R = radix^k.  bi_mod() reduces by the current
+         * mod_offset, so point it at the new modulus for the division. */
+        uint8_t old_offset = ctx->mod_offset;
+        ctx->mod_offset = mod_offset;
+        ctx->bi_mont_RR[mod_offset] = bi_mod(ctx, comp_left_shift(
+                    bi_clone(ctx, ctx->bi_radix), k*2-1));
+        ctx->mod_offset = old_offset;
+        more_comps(ctx->bi_mont_RR[mod_offset], k);
+        bi_permanent(ctx->bi_mont_RR[mod_offset]);
+        ctx->mont_n0[mod_offset] = mont_inverse(bim->comps[0]);
+    }
+#endif
 }
 
 /**
@@ -787,6 +813,14 @@ void bi_free_mod(BI_CTX *ctx, int mod_offset)
 {
     bi_depermanent(ctx->bi_mod[mod_offset]);
     bi_free(ctx, ctx->bi_mod[mod_offset]);
+#ifdef CONFIG_BIGINT_MONT_EXP
+    if (ctx->bi_mont_RR[mod_offset])
+    {
+        bi_depermanent(ctx->bi_mont_RR[mod_offset]);
+        bi_free(ctx, ctx->bi_mont_RR[mod_offset]);
+        ctx->bi_mont_RR[mod_offset] = NULL;
+    }
+#endif
 #if defined (CONFIG_BIGINT_MONTGOMERY)
     bi_depermanent(ctx->bi_RR_mod_m[mod_offset]);
     bi_depermanent(ctx->bi_R_mod_m[mod_offset]);
@@ -1303,6 +1337,223 @@ bigint *bi_barrett(BI_CTX *ctx, bigint *bi)
 }
 #endif /* CONFIG_BIGINT_BARRETT */
 
+#ifdef CONFIG_BIGINT_MONT_EXP
+/* The largest window used by mont_mod_power(). Its table takes 2^w entries
+ * the size of the modulus, so a 2048 bit modulus with w=5 needs 8kB. */
+#ifndef BIGINT_MONT_MAX_WINDOW
+#define BIGINT_MONT_MAX_WINDOW  5
+#endif
+
+/*
+ * t:c = a*b + t + c, which can't overflow a long_comp. Cortex-M4 has this as a
+ * single instruction; the Cortex-M3 lacks UMAAL and gets the C version.
+ */
+#if defined(__GNUC__) && defined(__ARM_ARCH_7EM__) && defined(CONFIG_INTEGER_32BIT)
+#define MONT_MAC(t, c, a, b) \
+    __asm__ ("umaal %0, %1, %2, %3" : "+r" (t), "+r" (c) : "r" (a), "r" (b))
+#else
+#define MONT_MAC(t, c, a, b)                                        \
+    do {                                                            \
+        long_comp mac = (long_comp)(a)*(b) + (t) + (c);             \
+        (t) = (comp)mac;                                            \
+        (c) = (comp)(mac >> COMP_BIT_SIZE);                         \
+    } while (0)
+#endif
+
+/*
+ * -1/m0 mod radix, by Newton iteration. Any odd m0 is its own inverse to 3
+ * bits and each step doubles that.
+ */
+static comp mont_inverse(comp m0)
+{
+    comp x = m0;
+    int i;
+
+    for (i = 3; i < COMP_BIT_SIZE; i *= 2)
+    {
+        x *= 2 - m0*x;
+    }
+
+    return (comp)0 - x;
+}
+
+/*
+ * t[0..n-1] += a[0..n-1]*b, returning the carry out of the top word.
+ */
+static comp mont_mac_row(comp *t, const comp *a, comp b, int n)
+{
+    comp c = 0;
+    int j;
+
+    for (j = 0; j < n; j++)
+    {
+        MONT_MAC(t[j], c, a[j], b);
+    }
+
+    return c;
+}
+
+/*
+ * r = a*b/R mod m, where R = radix^n and a, b < m. The product and its
+ * reduction are separate passes over t, which needs 2n+1 words.
+ */
+static void mont_mul(comp *r, const comp *a, const comp *b, 
+        const comp *m, comp n0, int n, comp *t)
+{
+    comp *res = &t[n];
+    comp c;
+    int i, k;
+
+    for (i = 0; i < n; i++)
+    {
+        t[i] = 0;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        t[i+n] = mont_mac_row(&t[i], a, b[i], n);
+    }
+
+    t[2*n] = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        c = mont_mac_row(&t[i], m, t[i]*n0, n);
+
+        for (k = i+n; c && k <= 2*n; k++)
+        {
+            t[k] += c;
+            c = t[k] < c;
+        }
+    }
+
+    /* the result is < 2m, so at most one subtraction brings it under m */
+    if (t[2*n] == 0)
+    {
+        for (i = n-1; i >= 0 && res[i] == m[i]; i--)
+            ;
+
+        if (i >= 0 && res[i] < m[i])
+        {
+            memcpy(r, res, n*COMP_BYTE_SIZE);
+            return;
+        }
+    }
+
+    c = 0;
+    for (i = 0; i < n; i++)
+    {
+        comp d = res[i] - m[i];
+        comp borrow = res[i] < m[i] || d < c;
+        r[i] = d - c;
+        c = borrow;
+    }
+}
+
+/*
+ * The value of the w exponent bits ending with bit i, padded with zeros
+ * below bit 0.
+ */
+static int mont_exp_window(bigint *biexp, int i, int w)
+{
+    int v = 0, j;
+
+    for (j = i; j > i-w; j--)
+    {
+        v <<= 1;
+
+        if (j >= 0 && exp_bit_is_one(biexp, j))
+            v |= 1;
+    }
+
+    return v;
+}
+
+/*
+ * Fixed window exponentiation with Montgomery multiplication. All of the 
+ * working values are flat arrays of n comps in ctx->arena, which is only
+ * reallocated when a larger modulus or window comes along.
+ */
+static bigint *mont_mod_power(BI_CTX *ctx, bigint *bi, bigint *biexp)
+{
+    uint8_t mod_offset = ctx->mod_offset;
+    bigint *bim = ctx->bi_mod[mod_offset];
+    const comp *m = bim->comps;
+    const comp *rr = ctx->bi_mont_RR[mod_offset]->comps;
+    comp n0 = ctx->mont_n0[mod_offset];
+    int n = bim->size;
+    int bits, w, i, v, need;
+    comp *table, *acc, *t;
+    bigint *biR;
+
+    biexp = trim(biexp);
+    bits = find_max_exp_index(biexp)+1;
+    w = bits > 256 ? 5 : bits > 64 ? 4 : bits > 24 ? 3 : 1;
+
+    if (w > BIGINT_MONT_MAX_WINDOW)
+        w = BIGINT_MONT_MAX_WINDOW;
+
+    /* the table (entry 0 holds the plain value one), acc and t */
+    need = (1 << w)*n + n + 2*n+1;
+
+    if (ctx->arena_size < need)
+    {
+        free(ctx->arena);
+        ctx->arena = (comp *)malloc(need*COMP_BYTE_SIZE);
+        ctx->arena_size = need;
+    }
+
+    table = ctx->arena;
+    acc = &table[(1 << w)*n];
+    t = &acc[n];
+
+    /* bring the base into range and pad it out to the modulus size */
+    bi = trim(bi_mod(ctx, bi));
+    memset(acc, 0, n*COMP_BYTE_SIZE);
+    memcpy(acc, bi->comps, min(bi->size, n)*COMP_BYTE_SIZE);
+    memset(table, 0, n*COMP_BYTE_SIZE);
+    table[0] = 1;
+
+    /* table[v] = bi^v in Montgomery form */
+    mont_mul(&table[n], acc, rr, m, n0, n, t);
+
+    for (v = 2; v < (1 << w); v++)
+    {
+        mont_mul(&table[v*n], &table[(v-1)*n], &table[n], m, n0, n, t);
+    }
+
+    /* start with the top window, which may be narrower than the rest */
+    i = bits-1;
+    v = bits % w ? bits % w : w;
+
+    if (bits == 0)
+        mont_mul(acc, table, rr, m, n0, n, t);      /* R mod m */
+    else
+        memcpy(acc, &table[mont_exp_window(biexp, i, v)*n], 
+                n*COMP_BYTE_SIZE);
+
+    for (i -= v; i >= 0; i -= w)
+    {
+        for (v = 0; v < w; v++)
+        {
+            mont_mul(acc, acc, acc, m, n0, n, t);
+        }
+
+        if ((v = mont_exp_window(biexp, i, w)) != 0)
+            mont_mul(acc, acc, &table[v*n], m, n0, n, t);
+    }
+
+    /* convert back by multiplying by one */
+    mont_mul(acc, acc, table, m, n0, n, t);
+
+    biR = alloc(ctx, n);
+    memcpy(biR->comps, acc, n*COMP_BYTE_SIZE);
+    bi_free(ctx, bi);
+    bi_free(ctx, biexp);
+    return trim(biR);
+}
+#endif /* CONFIG_BIGINT_MONT_EXP */
+
 #ifdef CONFIG_BIGINT_SLIDING_WINDOW
 /*
  * Work out g1, g3, g5, g7... etc for the sliding-window algorithm 
@@ -1346,9 +1597,16 @@ static void precompute_slide_window(BI_CTX *ctx, int window, bigint *g1)
  */
 bigint *bi_mod_power(BI_CTX *ctx, bigint *bi, bigint *biexp)
 {
-    int i = find_max_exp_index(biexp), j, window_size = 1;
-    bigint *biR = int_to_bi(ctx, 1);
+    int i, j, window_size = 1;
+    bigint *biR;
+
+#ifdef CONFIG_BIGINT_MONT_EXP
+    if (ctx->bi_mont_RR[ctx->mod_offset])
+        return mont_mod_power(ctx, bi, biexp);
+#endif
 
+    i = find_max_exp_index(biexp);
+    biR = int_to_bi(ctx, 1);
 
 #if defined(CONFIG_BIGINT_MONTGOMERY)
     uint8_t mod_offset = ctx->mod_offset;
@@ -119,6 +119,12 @@ typedef struct /**< A big integer "session" context. */
 
 #ifdef CONFIG_BIGINT_MONTGOMERY
     uint8_t use_classical;      /**< Use classical reduction. */
+#endif
+#ifdef CONFIG_BIGINT_MONT_EXP
+    bigint *bi_mont_RR[BIGINT_NUM_MODS]; /**< R^2 mod m, NULL if m is even */
+    comp mont_n0[BIGINT_NUM_MODS];  /**< -1/m mod radix */
+    comp *arena;                /**< Scratch words for bi_mod_power(). */
+    int arena_size;             /**< Number of comps in the arena. */
 #endif
     uint8_t mod_offset;         /**< The mod offset we are using */
 } BI_CTX;
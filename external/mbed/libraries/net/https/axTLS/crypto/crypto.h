@@ -52,11 +52,17 @@ extern "C" {
 
 /* enable features based on a 'super-set' capbaility. */
 #if defined(CONFIG_SSL_FULL_MODE) 
+#ifndef CONFIG_SSL_ENABLE_CLIENT
 #define CONFIG_SSL_ENABLE_CLIENT
+#endif
+#ifndef CONFIG_SSL_CERT_VERIFICATION
 #define CONFIG_SSL_CERT_VERIFICATION
+#endif
 #elif defined(CONFIG_SSL_ENABLE_CLIENT)
+#ifndef CONFIG_SSL_CERT_VERIFICATION
 #define CONFIG_SSL_CERT_VERIFICATION
 #endif
+#endif
 
 /**************************************************************************
  * AES declarations 
@@ -86,6 +92,38 @@ void AES_cbc_encrypt(AES_CTX *ctx, const uint8_t *msg,
         uint8_t *out, int length);
 void AES_cbc_decrypt(AES_CTX *ks, const uint8_t *in, uint8_t *out, int length);
 void AES_convert_key(AES_CTX *ctx);
+void AES_ecb_encrypt(const AES_CTX *ctx, const uint8_t *msg, uint8_t *out);
+void AES_ctr_encrypt(AES_CTX *ctx, const uint8_t *msg, 
+        uint8_t *out, int length);
+
+/**************************************************************************
+ * AES-GCM declarations 
+ **************************************************************************/
+
+#define AES_GCM_IV_SIZE         12
+#define AES_GCM_TAG_SIZE        16
+
+typedef struct
+{
+    AES_CTX aes;
+    uint64_t HL[16];            /* multiples of the hash key, low half */
+    uint64_t HH[16];            /* multiples of the hash key, high half */
+    uint8_t y[AES_BLOCKSIZE];   /* GHASH accumulator */
+    uint8_t ctr[AES_BLOCKSIZE];
+    uint8_t ek0[AES_BLOCKSIZE]; /* E(K, J0), which masks the tag */
+    uint8_t keystream[AES_BLOCKSIZE];
+    uint32_t aad_len;
+    uint32_t len;
+} AES_GCM_CTX;
+
+void AES_gcm_set_key(AES_GCM_CTX *ctx, const uint8_t *key, AES_MODE mode);
+void AES_gcm_start(AES_GCM_CTX *ctx, const uint8_t *iv, 
+        const uint8_t *aad, int aad_len);
+void AES_gcm_encrypt(AES_GCM_CTX *ctx, const uint8_t *msg, 
+        uint8_t *out, int length);
+void AES_gcm_decrypt(AES_GCM_CTX *ctx, const uint8_t *msg, 
+        uint8_t *out, int length);
+void AES_gcm_finish(AES_GCM_CTX *ctx, uint8_t *tag);
 
 /**************************************************************************
  * RC4 declarations 
@@ -122,6 +160,23 @@ void SHA1_Init(SHA1_CTX *);
 void SHA1_Update(SHA1_CTX *, const uint8_t * msg, int len);
 void SHA1_Final(uint8_t *digest, SHA1_CTX *);
 
+/**************************************************************************
+ * SHA256 declarations 
+ **************************************************************************/
+
+#define SHA256_SIZE   32
+
+typedef struct
+{
+    uint32_t state[8];          /* intermediate digest state */
+    uint32_t total[2];          /* number of bytes, low word first */
+    uint8_t buffer[64];         /* data block being processed */
+} SHA256_CTX;
+
+void SHA256_Init(SHA256_CTX *);
+void SHA256_Update(SHA256_CTX *, const uint8_t *msg, int len);
+void SHA256_Final(uint8_t *digest, SHA256_CTX *);
+
 /**************************************************************************
  * MD2 declarations 
  **************************************************************************/
@@ -160,10 +215,43 @@ EXP_FUNC void STDCALL MD5_Final(uint8_t *digest, MD5_CTX *);
 /**************************************************************************
  * HMAC declarations 
  **************************************************************************/
+
+/* A hash for the streaming HMAC functions below */
+typedef struct
+{
+    int digest_size;
+    void (*init)(void *ctx);
+    void (*update)(void *ctx, const uint8_t *msg, int len);
+    void (*final)(uint8_t *digest, void *ctx);
+} HASH_INFO;
+
+extern const HASH_INFO hash_md5;
+extern const HASH_INFO hash_sha1;
+extern const HASH_INFO hash_sha256;
+
+typedef struct
+{
+    const HASH_INFO *hash;
+    union
+    {
+        MD5_CTX md5;
+        SHA1_CTX sha1;
+        SHA256_CTX sha256;
+    } ctx;
+    uint8_t k_opad[64];
+} HMAC_CTX;
+
+void hmac_init(HMAC_CTX *ctx, const HASH_INFO *hash, 
+        const uint8_t *key, int key_len);
+void hmac_update(HMAC_CTX *ctx, const uint8_t *msg, int length);
+void hmac_final(HMAC_CTX *ctx, uint8_t *digest);
+
 void hmac_md5(const uint8_t *msg, int length, const uint8_t *key, 
         int key_len, uint8_t *digest);
 void hmac_sha1(const uint8_t *msg, int length, const uint8_t *key, 
         int key_len, uint8_t *digest);
+void hmac_sha256(const uint8_t *msg, int length, const uint8_t *key, 
+        int key_len, uint8_t *digest);
 
 /**************************************************************************
  * RSA declarations 
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2007, Cameron Rich
+ * 
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of the axTLS project nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * AES-GCM implementation - as defined in NIST SP 800-38D, for the 96 bit
+ * IVs used by TLS. GHASH uses Shoup's method with a 4 bit table of multiples
+ * of H, 256 bytes per key, which is built when the key is set.
+ */
+
+#include <string.h>
+#include "os_port.h"
+#include "crypto.h"
+
+/* all commented out in skeleton mode */
+#ifndef CONFIG_SSL_SKELETON_MODE
+
+/*
+ * The reduction of the four bits shifted out of the bottom of Z, for
+ * multiplying by x^4 modulo the GCM polynomial.
+ */
+static const uint16_t gcm_last4[16] =
+{
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+static uint64_t get_be64(const uint8_t *b)
+{
+    return ((uint64_t)b[0] << 56) | ((uint64_t)b[1] << 48) | 
+           ((uint64_t)b[2] << 40) | ((uint64_t)b[3] << 32) |
+           ((uint64_t)b[4] << 24) | ((uint64_t)b[5] << 16) | 
+           ((uint64_t)b[6] << 8) | b[7];
+}
+
+static void put_be64(uint8_t *b, uint64_t v)
+{
+    int i;
+
+    for (i = 7; i >= 0; i--)
+    {
+        b[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+/*
+ * x = x*H in GF(2^128), four bits at a time from the last byte.
+ */
+static void gcm_mult(const AES_GCM_CTX *ctx, uint8_t *x)
+{
+    uint64_t zh, zl;
+    int i, lo, hi, rem;
+
+    lo = x[15] & 0xf;
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for (i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+
+        if (i != 15)
+        {
+            rem = (int)zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ ((uint64_t)gcm_last4[rem] << 48);
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+
+        rem = (int)zl & 0xf;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ ((uint64_t)gcm_last4[rem] << 48);
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+
+    put_be64(x, zh);
+    put_be64(&x[8], zl);
+}
+
+/**
+ * Set the key, and work out the multiples of the hash key H = E(K, 0).
+ */
+void AES_gcm_set_key(AES_GCM_CTX *ctx, const uint8_t *key, AES_MODE mode)
+{
+    uint8_t h[AES_BLOCKSIZE];
+    uint64_t vh, vl;
+    int i, j;
+
+    memset(h, 0, sizeof(h));
+    AES_set_key(&ctx->aes, key, h, mode);
+    AES_ecb_encrypt(&ctx->aes, h, h);
+
+    vh = get_be64(h);
+    vl = get_be64(&h[8]);
+
+    /* 8 is H itself, as the bits are reflected */
+    ctx->HH[8] = vh;
+    ctx->HL[8] = vl;
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for (i = 4; i > 0; i >>= 1)
+    {
+        uint64_t t = (vl & 1) * 0xe1000000U;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ (t << 32);
+        ctx->HH[i] = vh;
+        ctx->HL[i] = vl;
+    }
+
+    /* and the rest are sums of those */
+    for (i = 2; i <= 8; i *= 2)
+    {
+        for (j = 1; j < i; j++)
+        {
+            ctx->HH[i+j] = ctx->HH[i] ^ ctx->HH[j];
+            ctx->HL[i+j] = ctx->HL[i] ^ ctx->HL[j];
+        }
+    }
+}
+
+/**
+ * Start a message with a 96 bit IV, hashing the additional authenticated
+ * data.
+ */
+void AES_gcm_start(AES_GCM_CTX *ctx, const uint8_t *iv, 
+        const uint8_t *aad, int aad_len)
+{
+    int i, n;
+
+    memcpy(ctx->ctr, iv, 12);
+    ctx->ctr[12] = 0;
+    ctx->ctr[13] = 0;
+    ctx->ctr[14] = 0;
+    ctx->ctr[15] = 1;
+    AES_ecb_encrypt(&ctx->aes, ctx->ctr, ctx->ek0);
+
+    memset(ctx->y, 0, AES_BLOCKSIZE);
+    ctx->aad_len = aad_len;
+    ctx->len = 0;
+
+    while (aad_len > 0)
+    {
+        n = aad_len < AES_BLOCKSIZE ? aad_len : AES_BLOCKSIZE;
+
+        for (i = 0; i < n; i++)
+            ctx->y[i] ^= aad[i];
+
+        gcm_mult(ctx, ctx->y);
+        aad += n;
+        aad_len -= n;
+    }
+}
+
+/*
+ * The next block of key stream, from the next value of the 32 bit counter.
+ */
+static void gcm_next_block(AES_GCM_CTX *ctx)
+{
+    int i;
+
+    for (i = AES_BLOCKSIZE-1; i >= 12; i--)
+    {
+        if (++ctx->ctr[i])
+            break;
+    }
+
+    AES_ecb_encrypt(&ctx->aes, ctx->ctr, ctx->keystream);
+}
+
+static void gcm_crypt(AES_GCM_CTX *ctx, const uint8_t *msg, uint8_t *out, 
+        int length, int is_decrypt)
+{
+    int used = ctx->len % AES_BLOCKSIZE;
+    int i;
+
+    ctx->len += length;
+
+    /* finish a block left partly done by the last call */
+    while (used && length > 0)
+    {
+        uint8_t c = *msg ^ ctx->keystream[used];
+        ctx->y[used] ^= is_decrypt ? *msg : c;
+        *out++ = c;
+        msg++;
+        length--;
+
+        if (++used == AES_BLOCKSIZE)
+        {
+            gcm_mult(ctx, ctx->y);
+            used = 0;
+        }
+    }
+
+    /* whole blocks a word at a time; msg is copied first as out may be 
+     * just below it in the same buffer */
+    while (length >= AES_BLOCKSIZE)
+    {
+        uint32_t in_32[4], ks_32[4], y_32[4];
+
+        gcm_next_block(ctx);
+        memcpy(in_32, msg, AES_BLOCKSIZE);
+        memcpy(ks_32, ctx->keystream, AES_BLOCKSIZE);
+        memcpy(y_32, ctx->y, AES_BLOCKSIZE);
+
+        for (i = 0; i < 4; i++)
+        {
+            ks_32[i] ^= in_32[i];
+            y_32[i] ^= is_decrypt ? in_32[i] : ks_32[i];
+        }
+
+        memcpy(out, ks_32, AES_BLOCKSIZE);
+        memcpy(ctx->y, y_32, AES_BLOCKSIZE);
+        gcm_mult(ctx, ctx->y);
+        msg += AES_BLOCKSIZE;
+        out += AES_BLOCKSIZE;
+        length -= AES_BLOCKSIZE;
+    }
+
+    /* the start of a partial block, which is hashed when it's completed */
+    if (length > 0)
+    {
+        gcm_next_block(ctx);
+
+        for (i = 0; i < length; i++)
+        {
+            uint8_t c = msg[i] ^ ctx->keystream[i];
+            ctx->y[i] ^= is_decrypt ? msg[i] : c;
+            out[i] = c;
+        }
+    }
+}
+
+/**
+ * Encrypt the next part of a message. The parts may be any length, and out
+ * may be the same as msg, or any distance before it in the same buffer.
+ */
+void AES_gcm_encrypt(AES_GCM_CTX *ctx, const uint8_t *msg, uint8_t *out, 
+        int length)
+{
+    gcm_crypt(ctx, msg, out, length, 0);
+}
+
+/**
+ * Decrypt the next part of a message, as for AES_gcm_encrypt().
+ */
+void AES_gcm_decrypt(AES_GCM_CTX *ctx, const uint8_t *msg, uint8_t *out, 
+        int length)
+{
+    gcm_crypt(ctx, msg, out, length, 1);
+}
+
+/**
+ * Work out the 16 byte authentication tag at the end of a message.
+ */
+void AES_gcm_finish(AES_GCM_CTX *ctx, uint8_t *tag)
+{
+    uint8_t len_block[AES_BLOCKSIZE];
+    int i;
+
+    if (ctx->len % AES_BLOCKSIZE)
+        gcm_mult(ctx, ctx->y);
+
+    put_be64(len_block, (uint64_t)ctx->aad_len * 8);
+    put_be64(&len_block[8], (uint64_t)ctx->len * 8);
+
+    for (i = 0; i < AES_BLOCKSIZE; i++)
+        ctx->y[i] ^= len_block[i];
+
+    gcm_mult(ctx, ctx->y);
+
+    for (i = 0; i < AES_BLOCKSIZE; i++)
+        tag[i] = ctx->y[i] ^ ctx->ek0[i];
+}
+
+#endif
@@ -38,68 +38,111 @@
 #include "os_port.h"
 #include "crypto.h"
 
+const HASH_INFO hash_md5 =
+{
+    MD5_SIZE,
+    (void (*)(void *))MD5_Init,
+    (void (*)(void *, const uint8_t *, int))MD5_Update,
+    (void (*)(uint8_t *, void *))MD5_Final
+};
+
+const HASH_INFO hash_sha1 =
+{
+    SHA1_SIZE,
+    (void (*)(void *))SHA1_Init,
+    (void (*)(void *, const uint8_t *, int))SHA1_Update,
+    (void (*)(uint8_t *, void *))SHA1_Final
+};
+
+const HASH_INFO hash_sha256 =
+{
+    SHA256_SIZE,
+    (void (*)(void *))SHA256_Init,
+    (void (*)(void *, const uint8_t *, int))SHA256_Update,
+    (void (*)(uint8_t *, void *))SHA256_Final
+};
+
 /**
- * Perform HMAC-MD5
+ * Start a HMAC, which is then fed with hmac_update() and completed by
+ * hmac_final(), so that a message in pieces needn't be copied together.
  * NOTE: does not handle keys larger than the block size.
  */
-void hmac_md5(const uint8_t *msg, int length, const uint8_t *key, 
-        int key_len, uint8_t *digest)
+void hmac_init(HMAC_CTX *ctx, const HASH_INFO *hash, 
+        const uint8_t *key, int key_len)
 {
-    MD5_CTX context;
     uint8_t k_ipad[64];
-    uint8_t k_opad[64];
     int i;
 
     memset(k_ipad, 0, sizeof k_ipad);
-    memset(k_opad, 0, sizeof k_opad);
+    memset(ctx->k_opad, 0, sizeof ctx->k_opad);
     memcpy(k_ipad, key, key_len);
-    memcpy(k_opad, key, key_len);
+    memcpy(ctx->k_opad, key, key_len);
 
     for (i = 0; i < 64; i++) 
     {
         k_ipad[i] ^= 0x36;
-        k_opad[i] ^= 0x5c;
+        ctx->k_opad[i] ^= 0x5c;
     }
 
-    MD5_Init(&context);
-    MD5_Update(&context, k_ipad, 64);
-    MD5_Update(&context, msg, length);
-    MD5_Final(digest, &context);
-    MD5_Init(&context);
-    MD5_Update(&context, k_opad, 64);
-    MD5_Update(&context, digest, MD5_SIZE);
-    MD5_Final(digest, &context);
+    ctx->hash = hash;
+    hash->init(&ctx->ctx);
+    hash->update(&ctx->ctx, k_ipad, 64);
+}
+
+void hmac_update(HMAC_CTX *ctx, const uint8_t *msg, int length)
+{
+    ctx->hash->update(&ctx->ctx, msg, length);
+}
+
+/**
+ * Write the hash's digest_size bytes of HMAC to digest.
+ */
+void hmac_final(HMAC_CTX *ctx, uint8_t *digest)
+{
+    const HASH_INFO *hash = ctx->hash;
+
+    hash->final(digest, &ctx->ctx);
+    hash->init(&ctx->ctx);
+    hash->update(&ctx->ctx, ctx->k_opad, 64);
+    hash->update(&ctx->ctx, digest, hash->digest_size);
+    hash->final(digest, &ctx->ctx);
+}
+
+/**
+ * Perform HMAC-MD5
+ */
+void hmac_md5(const uint8_t *msg, int length, const uint8_t *key, 
+        int key_len, uint8_t *digest)
+{
+    HMAC_CTX ctx;
+
+    hmac_init(&ctx, &hash_md5, key, key_len);
+    hmac_update(&ctx, msg, length);
+    hmac_final(&ctx, digest);
 }
 
 /**
  * Perform HMAC-SHA1
- * NOTE: does not handle keys larger than the block size.
  */
 void hmac_sha1(const uint8_t *msg, int length, const uint8_t *key, 
         int key_len, uint8_t *digest)
 {
-    SHA1_CTX context;
-    uint8_t k_ipad[64];
-    uint8_t k_opad[64];
-    int i;
+    HMAC_CTX ctx;
 
-    memset(k_ipad, 0, sizeof k_ipad);
-    memset(k_opad, 0, sizeof k_opad);
-    memcpy(k_ipad, key, key_len);
-    memcpy(k_opad, key, key_len);
+    hmac_init(&ctx, &hash_sha1, key, key_len);
+    hmac_update(&ctx, msg, length);
+    hmac_final(&ctx, digest);
+}
 
-    for (i = 0; i < 64; i++) 
-    {
-        k_ipad[i] ^= 0x36;
-        k_opad[i] ^= 0x5c;
-    }
+/**
+ * Perform HMAC-SHA256
+ */
+void hmac_sha256(const uint8_t *msg, int length, const uint8_t *key, 
+        int key_len, uint8_t *digest)
+{
+    HMAC_CTX ctx;
 
-    SHA1_Init(&context);
-    SHA1_Update(&context, k_ipad, 64);
-    SHA1_Update(&context, msg, length);
-    SHA1_Final(digest, &context);
-    SHA1_Init(&context);
-    SHA1_Update(&context, k_opad, 64);
-    SHA1_Update(&context, digest, SHA1_SIZE);
-    SHA1_Final(digest, &context);
+    hmac_init(&ctx, &hash_sha256, key, key_len);
+    hmac_update(&ctx, msg, length);
+    hmac_final(&ctx, digest);
 }
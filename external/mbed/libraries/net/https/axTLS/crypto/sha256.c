@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2007, Cameron Rich
+ * 
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, 
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice, 
+ *   this list of conditions and the following disclaimer in the documentation 
+ *   and/or other materials provided with the distribution.
+ * * Neither the name of the axTLS project nor the names of its contributors 
+ *   may be used to endorse or promote products derived from this software 
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * SHA256 implementation - as defined in FIPS PUB 180-4.
+ */
+
+#include <string.h>
+#include "os_port.h"
+#include "crypto.h"
+
+#define ROTR(x,n)       (((x) >> (n)) | ((x) << (32-(n))))
+#define CH(x,y,z)       (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x,y,z)      (((x) & (y)) | ((z) & ((x) | (y))))
+#define SIGMA0(x)       (ROTR(x,2) ^ ROTR(x,13) ^ ROTR(x,22))
+#define SIGMA1(x)       (ROTR(x,6) ^ ROTR(x,11) ^ ROTR(x,25))
+#define sigma0(x)       (ROTR(x,7) ^ ROTR(x,18) ^ ((x) >> 3))
+#define sigma1(x)       (ROTR(x,17) ^ ROTR(x,19) ^ ((x) >> 10))
+
+static const uint32_t sha256_k[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * Initialize the SHA256 context 
+ */
+void SHA256_Init(SHA256_CTX *ctx)
+{
+    ctx->total[0] = 0;
+    ctx->total[1] = 0;
+    ctx->state[0] = 0x6a09e667;
+    ctx->state[1] = 0xbb67ae85;
+    ctx->state[2] = 0x3c6ef372;
+    ctx->state[3] = 0xa54ff53a;
+    ctx->state[4] = 0x510e527f;
+    ctx->state[5] = 0x9b05688c;
+    ctx->state[6] = 0x1f83d9ab;
+    ctx->state[7] = 0x5be0cd19;
+}
+
+/*
+ * Process one 64 byte block. The message schedule is kept as a 16 word 
+ * window rather than all 64 words.
+ */
+static void SHA256_Process(SHA256_CTX *ctx, const uint8_t *data)
+{
+    uint32_t w[16];
+    uint32_t a, b, c, d, e, f, g, h, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)data[4*i] << 24) | ((uint32_t)data[4*i+1] << 16) |
+               ((uint32_t)data[4*i+2] << 8) | data[4*i+3];
+    }
+
+    a = ctx->state[0];
+    b = ctx->state[1];
+    c = ctx->state[2];
+    d = ctx->state[3];
+    e = ctx->state[4];
+    f = ctx->state[5];
+    g = ctx->state[6];
+    h = ctx->state[7];
+
+    for (i = 0; i < 64; i++)
+    {
+        if (i >= 16)
+        {
+            w[i & 15] += sigma1(w[(i-2) & 15]) + w[(i-7) & 15] + 
+                         sigma0(w[(i-15) & 15]);
+        }
+
+        t1 = h + SIGMA1(e) + CH(e, f, g) + sha256_k[i] + w[i & 15];
+        t2 = SIGMA0(a) + MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+    ctx->state[4] += e;
+    ctx->state[5] += f;
+    ctx->state[6] += g;
+    ctx->state[7] += h;
+}
+
+/**
+ * Accepts an array of octets as the next portion of the message.
+ */
+void SHA256_Update(SHA256_CTX *ctx, const uint8_t *msg, int len)
+{
+    uint32_t left = ctx->total[0] & 0x3F;
+    uint32_t fill = 64 - left;
+
+    ctx->total[0] += len;
+
+    if (ctx->total[0] < (uint32_t)len)
+        ctx->total[1]++;
+
+    if (left && (uint32_t)len >= fill)
+    {
+        memcpy(ctx->buffer + left, msg, fill);
+        SHA256_Process(ctx, ctx->buffer);
+        msg += fill;
+        len -= fill;
+        left = 0;
+    }
+
+    /* whole blocks are hashed straight from the message */
+    while (len >= 64)
+    {
+        SHA256_Process(ctx, msg);
+        msg += 64;
+        len -= 64;
+    }
+
+    if (len > 0)
+        memcpy(ctx->buffer + left, msg, len);
+}
+
+/**
+ * Return the 256-bit message digest into the user's array
+ */
+void SHA256_Final(uint8_t *digest, SHA256_CTX *ctx)
+{
+    static const uint8_t padding[64] = { 0x80 };
+    uint8_t msglen[8];
+    uint32_t high = (ctx->total[0] >> 29) | (ctx->total[1] << 3);
+    uint32_t low = ctx->total[0] << 3;
+    uint32_t last = ctx->total[0] & 0x3F;
+    uint32_t padn = (last < 56) ? (56 - last) : (120 - last);
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        msglen[i] = (uint8_t)(high >> (24 - 8*i));
+        msglen[i+4] = (uint8_t)(low >> (24 - 8*i));
+    }
+
+    SHA256_Update(ctx, padding, padn);
+    SHA256_Update(ctx, msglen, 8);
+
+    for (i = 0; i < 32; i++)
+        digest[i] = (uint8_t)(ctx->state[i >> 2] >> (24 - 8*(i & 3)));
+}
@@ -8,8 +8,14 @@
  */
 #define CONFIG_BIGINT_BARRETT 1
 #define CONFIG_BIGINT_CRT 1
+#define CONFIG_BIGINT_MONT_EXP 1
 #define CONFIG_INTEGER_32BIT 1
 
+/*
+ * AES Options
+ */
+#undef CONFIG_AES_COMPACT_TABLES
+
 /*
  * SSL Library
  */
@@ -32,6 +38,14 @@
 #define CONFIG_SSL_EXPIRY_TIME 24
 #define CONFIG_X509_MAX_CA_CERTS 1
 #define CONFIG_SSL_MAX_CERTS 1
+/* Bytes of plaintext in the record buffer of each SSL, which is most of its
+   RAM.  Below 16kB, the client asks servers for records which fit with the
+   max_fragment_length extension.  Records from a server which ignores it are
+   read into a 16kB buffer taken from the heap for the connection, and the
+   handshake fails when there isn't the memory for it. */
+#ifndef CONFIG_SSL_RECORD_BUFFER_SIZE
+#define CONFIG_SSL_RECORD_BUFFER_SIZE 2048
+#endif
 #undef CONFIG_SSL_CTX_MUTEXING
 #undef CONFIG_USE_DEV_URANDOM
 #undef CONFIG_WIN32_USE_CRYPTO_LIB
@@ -121,7 +121,7 @@ static void remove_entry(void *x, const char* f, const int l)
         printf("not found\n");
 }
 
-#ifdef MBED
+#if defined(MBED) && !defined(TARGET_HOST)
 /**
  * gettimeofday() not in mbed 
  */
@@ -34,9 +34,10 @@
  * @image html axolotl.jpg
  *
  * The axTLS library has features such as:
- * - The TLSv1 SSL client/server protocol
+ * - The TLSv1 SSL client/server protocol, up to TLSv1.2
  * - No requirement to use any openssl libraries.
- * - A choice between AES block (128/256 bit) and RC4 (128 bit) stream ciphers.
+ * - A choice between AES block (128/256 bit) and RC4 (128 bit) stream ciphers,
+ *   or AES-GCM (128 bit) authenticated encryption with TLSv1.2.
  * - RSA encryption/decryption with variable sized keys (up to 4096 bits).
  * - Certificate chaining and peer authentication.
  * - Session resumption, session renegotiation.
@@ -103,6 +104,8 @@ extern "C" {
 #define SSL_ERROR_NO_CERT_DEFINED               -272
 #define SSL_ERROR_NO_CLIENT_RENOG               -273
 #define SSL_ERROR_NOT_SUPPORTED                 -274
+#define SSL_ERROR_RECORD_OVERFLOW               -275
+#define SSL_ERROR_FRAGMENT_LENGTH_IGNORED       -276
 #define SSL_X509_OFFSET                         -512
 #define SSL_X509_ERROR(A)                       (SSL_X509_OFFSET+A)
 
@@ -114,6 +117,7 @@ extern "C" {
 #define SSL_ALERT_CLOSE_NOTIFY                  0
 #define SSL_ALERT_UNEXPECTED_MESSAGE            10
 #define SSL_ALERT_BAD_RECORD_MAC                20
+#define SSL_ALERT_RECORD_OVERFLOW               22
 #define SSL_ALERT_HANDSHAKE_FAILURE             40
 #define SSL_ALERT_BAD_CERTIFICATE               42
 #define SSL_ALERT_ILLEGAL_PARAMETER             47
@@ -127,6 +131,7 @@ extern "C" {
 #define SSL_AES256_SHA                          0x35
 #define SSL_RC4_128_SHA                         0x05
 #define SSL_RC4_128_MD5                         0x04
+#define SSL_AES128_GCM_SHA256                   0x9c
 
 /* build mode ids' */
 #define SSL_BUILD_SKELETON_MODE                 0x01
@@ -220,11 +225,12 @@ EXP_FUNC void STDCALL ssl_ctx_free(SSL_CTX *ssl_ctx);
  *
  * It is up to the application to establish the logical connection (whether it
  * is  a socket, serial connection etc).
- * @param ssl_ctx [in] The server context.
+ * @param ssl [in] The SSL object to use, with its ssl_ctx set to the server
+ * context.
  * @param client_fd [in] The client's file descriptor. 
  * @return An SSL object reference.
  */
-EXP_FUNC SSL * STDCALL ssl_server_new(SSL_CTX *ssl_ctx, int client_fd);
+EXP_FUNC SSL * STDCALL ssl_server_new(SSL *ssl, int client_fd);
 
 /**
  * @brief (client only) Establish a new SSL connection to an SSL server.
@@ -273,6 +279,27 @@ EXP_FUNC void STDCALL ssl_free(SSL *ssl);
  */
 //EXP_FUNC int STDCALL ssl_read(SSL *ssl, uint8_t **in_data);
 
+/**
+ * @brief Read the SSL data stream without copying it.
+ * Blocks until decrypted application data is available and then returns it
+ * from the record buffer.  The data stays there until ssl_read_done() is
+ * called, so it can be parsed in place or passed on to its destination.
+ * @param ssl [in] An SSL object reference.
+ * @param in_data [out] A pointer to the decrypted data, or null on error.
+ * Do NOT ever free this memory, and don't use it after other ssl calls.
+ * @return The number of decrypted bytes available, or < 0 if an error.
+ * @see ssl.h for the error code list.
+ */
+EXP_FUNC int STDCALL ssl_read_buf(SSL *ssl, uint8_t **in_data);
+
+/**
+ * @brief Consume data returned by ssl_read_buf().
+ * @param ssl [in] An SSL object reference.
+ * @param len [in] The number of bytes read, no more than ssl_read_buf()
+ * returned.
+ */
+EXP_FUNC void STDCALL ssl_read_done(SSL *ssl, int len);
+
 /**
  * @brief Write to the SSL data stream. 
  * if the socket is non-blocking and data is blocked then a check is made
@@ -285,6 +312,29 @@ EXP_FUNC void STDCALL ssl_free(SSL *ssl);
  */
 EXP_FUNC int STDCALL ssl_write(SSL *ssl, const uint8_t *out_data, int out_len);
 
+/**
+ * @brief Get room in the record buffer to write application data to.
+ *
+ * Data written there is encrypted in place and sent by ssl_write_done(), 
+ * without the copy made by ssl_write().  Only use it once the handshake is
+ * complete.
+ * @param ssl [in] An SSL object reference.
+ * @param out_data [out] Where to write the data.
+ * Do NOT ever free this memory, and don't use it after other ssl calls.
+ * @return The most bytes which can be written there.
+ */
+EXP_FUNC int STDCALL ssl_write_buf(SSL *ssl, uint8_t **out_data);
+
+/**
+ * @brief Send data written to the pointer returned by ssl_write_buf().
+ * @param ssl [in] An SSL object reference.
+ * @param len [in] The number of bytes written, no more than ssl_write_buf()
+ * returned.
+ * @return The number of bytes sent, or if < 0 if an error.
+ * @see ssl.h for the error code list.
+ */
+EXP_FUNC int STDCALL ssl_write_done(SSL *ssl, int len);
+
 /**
  * @brief Find an ssl object based on a file descriptor.
  *
@@ -325,6 +375,7 @@ EXP_FUNC uint8_t STDCALL ssl_get_session_id_size(const SSL *ssl);
  * - SSL_AES256_SHA (0x35)
  * - SSL_RC4_128_SHA (0x05)
  * - SSL_RC4_128_MD5 (0x04)
+ * - SSL_AES128_GCM_SHA256 (0x9c)
  */
 EXP_FUNC uint8_t STDCALL ssl_get_cipher_id(const SSL *ssl);
 
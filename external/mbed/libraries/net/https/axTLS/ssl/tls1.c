@@ -73,11 +73,14 @@ static void session_free(SSL_SESSION *ssl_sessions[], int sess_index);
 
 const uint8_t ssl_prot_prefs[NUM_PROTOCOLS] = 
 #ifdef CONFIG_SSL_PROT_LOW                  /* low security, fast speed */
-{ SSL_RC4_128_SHA, SSL_AES128_SHA, SSL_AES256_SHA, SSL_RC4_128_MD5 };
+{ SSL_RC4_128_SHA, SSL_AES128_GCM_SHA256, SSL_AES128_SHA, SSL_AES256_SHA, 
+  SSL_RC4_128_MD5 };
 #elif CONFIG_SSL_PROT_MEDIUM                /* medium security, medium speed */
-{ SSL_AES128_SHA, SSL_AES256_SHA, SSL_RC4_128_SHA, SSL_RC4_128_MD5 };    
+{ SSL_AES128_GCM_SHA256, SSL_AES128_SHA, SSL_AES256_SHA, SSL_RC4_128_SHA, 
+  SSL_RC4_128_MD5 };    
 #else /* CONFIG_SSL_PROT_HIGH */            /* high security, low speed */
-{ SSL_AES256_SHA, SSL_AES128_SHA, SSL_RC4_128_SHA, SSL_RC4_128_MD5 };
+{ SSL_AES128_GCM_SHA256, SSL_AES256_SHA, SSL_AES128_SHA, SSL_RC4_128_SHA, 
+  SSL_RC4_128_MD5 };
 #endif
 #endif /* CONFIG_SSL_SKELETON_MODE */
 
@@ -94,7 +97,7 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         2*(SHA1_SIZE+16),               /* key block size */
         0,                              /* no padding */
         SHA1_SIZE,                      /* digest size */
-        hmac_sha1,                      /* hmac algorithm */
+        &hash_sha1,                     /* hmac algorithm */
         (crypt_func)RC4_crypt,          /* encrypt */
         (crypt_func)RC4_crypt           /* decrypt */
     },
@@ -102,6 +105,21 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
 #else
 static const cipher_info_t cipher_info[NUM_PROTOCOLS] = 
 {
+    /*
+     * The "iv" of AES-GCM is the implicit part of the nonce, and its "digest"
+     * is the authentication tag, as there is no HMAC.
+     */
+    {   /* AES128-GCM-SHA256 */
+        SSL_AES128_GCM_SHA256,          /* AES128-GCM-SHA256 */
+        16,                             /* key size */
+        SSL_AEAD_SALT_SIZE,             /* iv size */ 
+        2*(16+SSL_AEAD_SALT_SIZE),      /* key block size */
+        0,                              /* no padding */
+        AES_GCM_TAG_SIZE,               /* digest size */
+        NULL,                           /* no hmac algorithm */
+        NULL,                           /* encrypt */
+        NULL                            /* decrypt */
+    },
     {   /* AES128-SHA */
         SSL_AES128_SHA,                 /* AES128-SHA */
         16,                             /* key size */
@@ -109,7 +127,7 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         2*(SHA1_SIZE+16+16),            /* key block size */
         16,                             /* block padding size */
         SHA1_SIZE,                      /* digest size */
-        hmac_sha1,                      /* hmac algorithm */
+        &hash_sha1,                     /* hmac algorithm */
         (crypt_func)AES_cbc_encrypt,    /* encrypt */
         (crypt_func)AES_cbc_decrypt     /* decrypt */
     },
@@ -120,7 +138,7 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         2*(SHA1_SIZE+32+16),            /* key block size */
         16,                             /* block padding size */
         SHA1_SIZE,                      /* digest size */
-        hmac_sha1,                      /* hmac algorithm */
+        &hash_sha1,                     /* hmac algorithm */
         (crypt_func)AES_cbc_encrypt,    /* encrypt */
         (crypt_func)AES_cbc_decrypt     /* decrypt */
     },       
@@ -131,7 +149,7 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         2*(SHA1_SIZE+16),               /* key block size */
         0,                              /* no padding */
         SHA1_SIZE,                      /* digest size */
-        hmac_sha1,                      /* hmac algorithm */
+        &hash_sha1,                     /* hmac algorithm */
         (crypt_func)RC4_crypt,          /* encrypt */
         (crypt_func)RC4_crypt           /* decrypt */
     },
@@ -146,20 +164,23 @@ static const cipher_info_t cipher_info[NUM_PROTOCOLS] =
         2*(MD5_SIZE+16),                /* key block size */
         0,                              /* no padding */
         MD5_SIZE,                       /* digest size */
-        hmac_md5,                       /* hmac algorithm */
+        &hash_md5,                      /* hmac algorithm */
         (crypt_func)RC4_crypt,          /* encrypt */
         (crypt_func)RC4_crypt           /* decrypt */
     },
 };
 #endif
 
-static void prf(const uint8_t *sec, int sec_len, uint8_t *seed, int seed_len,
-        uint8_t *out, int olen);
+static void prf(SSL *ssl, const uint8_t *sec, int sec_len, 
+        uint8_t *seed, int seed_len, uint8_t *out, int olen);
 static const cipher_info_t *get_cipher_info(uint8_t cipher);
 static void increment_read_sequence(SSL *ssl);
 static void increment_write_sequence(SSL *ssl);
-static void add_hmac_digest(SSL *ssl, int snd, uint8_t *hmac_header,
-        const uint8_t *buf, int buf_len, uint8_t *hmac_buf);
+static void hmac_start(SSL *ssl, int mode, HMAC_CTX *hmac_ctx, 
+        const uint8_t *record_hdr, int length);
+static int record_iv_size(const SSL *ssl);
+static int tx_data_offset(const SSL *ssl);
+static int send_record(SSL *ssl, uint8_t protocol, int length);
 
 /* win32 VC6.0 doesn't have variadic macros */
 #if defined(WIN32) && !defined(CONFIG_SSL_FULL_MODE)
@@ -280,10 +301,15 @@ EXP_FUNC void STDCALL ssl_free(SSL *ssl)
     /* may already be free - but be sure */
     free(ssl->encrypt_ctx);
     free(ssl->decrypt_ctx);
+    ssl->encrypt_ctx = NULL;
+    ssl->decrypt_ctx = NULL;
     disposable_free(ssl);
+    free(ssl->bm_big_data);
+    ssl->bm_big_data = NULL;
     
 #ifdef CONFIG_SSL_CERT_VERIFICATION
     x509_free(ssl->x509_ctx);
+    ssl->x509_ctx = NULL;
 #endif
     //free(ssl->ssl_ctx);
     //free(ssl);
@@ -301,8 +327,8 @@ EXP_FUNC int STDCALL ssl_write(SSL *ssl, const uint8_t *out_data, int out_len)
     {
         nw = n;
 
-        if (nw > RT_MAX_PLAIN_LENGTH)    /* fragment if necessary */
-            nw = RT_MAX_PLAIN_LENGTH;
+        if (nw > RT_MAX_WRITE_LENGTH)    /* fragment if necessary */
+            nw = RT_MAX_WRITE_LENGTH;
 
         if ((i = send_packet(ssl, PT_APP_PROTOCOL_DATA, 
                                             &out_data[tot], nw)) <= 0)
@@ -318,6 +344,29 @@ EXP_FUNC int STDCALL ssl_write(SSL *ssl, const uint8_t *out_data, int out_len)
     return out_len;
 }
 
+/*
+ * Get the room in bm_data for the plaintext of the next application data 
+ * record, so that it can be written there and then sent by ssl_write_done() 
+ * without being copied.
+ */
+EXP_FUNC int STDCALL ssl_write_buf(SSL *ssl, uint8_t **out_data)
+{
+    *out_data = &ssl->bm_data[tx_data_offset(ssl)];
+    return RT_MAX_WRITE_LENGTH;
+}
+
+/*
+ * Encrypt the first len bytes written at ssl_write_buf()'s pointer in place,
+ * and send them as a record.
+ */
+EXP_FUNC int STDCALL ssl_write_done(SSL *ssl, int len)
+{
+    if (len <= 0 || len > RT_MAX_WRITE_LENGTH)
+        return SSL_NOT_OK;
+
+    return send_record(ssl, PT_APP_PROTOCOL_DATA, len);
+}
+
 /**
  * Add a certificate to the certificate chain.
  */
@@ -549,9 +598,10 @@ SSL *ssl_new(SSL *ssl, int client_fd)
 {
     SSL_CTX* ssl_ctx = ssl->ssl_ctx;
     ssl->need_bytes = SSL_RECORD_SIZE;      /* need a record */
-    ssl->client_fd = 0;
+    ssl->client_fd = client_fd;
     ssl->flag = SSL_NEED_RECORD;
     ssl->bm_data = ssl->bm_all_data + BM_RECORD_OFFSET; 
+    ssl->bm_big_data = NULL;
     ssl->bm_read_index = 0;
     ssl->hs_status = SSL_NOT_OK;            /* not connected */
 #ifdef CONFIG_ENABLE_VERIFICATION
@@ -563,6 +613,10 @@ SSL *ssl_new(SSL *ssl, int client_fd)
     ssl->flag |= ssl_ctx->options;
     SSL_CTX_LOCK(ssl_ctx->mutex);
 
+    /* the SSL may be reused for another connection */
+    ssl->next = NULL;
+    ssl->prev = NULL;
+
     if (ssl_ctx->head == NULL)
     {
         ssl_ctx->head = ssl;
@@ -628,48 +682,26 @@ static void increment_write_sequence(SSL *ssl)
 }
 
 /**
- * Work out the HMAC digest in a packet.
+ * Start the HMAC of a record with its sequence number and header, which has
+ * the length of the plaintext.  The plaintext itself is then fed to 
+ * hmac_update() where it lies, without being copied behind the header.
  */
-static void add_hmac_digest(SSL *ssl, int mode, uint8_t *hmac_header,
-        const uint8_t *buf, int buf_len, uint8_t *hmac_buf)
+static void hmac_start(SSL *ssl, int mode, HMAC_CTX *hmac_ctx, 
+        const uint8_t *record_hdr, int length)
 {
-    int hmac_len = buf_len + 8 + SSL_RECORD_SIZE;
-    uint8_t *t_buf = (uint8_t *)alloca(hmac_len+10);
+    uint8_t hdr[8+SSL_RECORD_SIZE];
 
-    memcpy(t_buf, (mode == SSL_SERVER_WRITE || mode == SSL_CLIENT_WRITE) ? 
+    memcpy(hdr, (mode == SSL_SERVER_WRITE || mode == SSL_CLIENT_WRITE) ? 
                     ssl->write_sequence : ssl->read_sequence, 8);
-    memcpy(&t_buf[8], hmac_header, SSL_RECORD_SIZE);
-    memcpy(&t_buf[8+SSL_RECORD_SIZE], buf, buf_len);
+    memcpy(&hdr[8], record_hdr, 3);
+    hdr[11] = length >> 8;
+    hdr[12] = length & 0xff;
 
-    ssl->cipher_info->hmac(t_buf, hmac_len, 
+    hmac_init(hmac_ctx, ssl->cipher_info->hmac, 
             (mode == SSL_SERVER_WRITE || mode == SSL_CLIENT_READ) ? 
                 ssl->server_mac : ssl->client_mac, 
-            ssl->cipher_info->digest_size, hmac_buf);
-
-#if 0
-    print_blob("record", hmac_header, SSL_RECORD_SIZE);
-    print_blob("buf", buf, buf_len);
-    if (mode == SSL_SERVER_WRITE || mode == SSL_CLIENT_WRITE)
-    {
-        print_blob("write seq", ssl->write_sequence, 8);
-    }
-    else
-    {
-        print_blob("read seq", ssl->read_sequence, 8);
-    }
-
-    if (mode == SSL_SERVER_WRITE || mode == SSL_CLIENT_READ)
-    {
-        print_blob("server mac", 
-                ssl->server_mac, ssl->cipher_info->digest_size);
-    }
-    else
-    {
-        print_blob("client mac", 
-                ssl->client_mac, ssl->cipher_info->digest_size);
-    }
-    print_blob("hmac", hmac_buf, SHA1_SIZE);
-#endif
+            ssl->cipher_info->digest_size);
+    hmac_update(hmac_ctx, hdr, sizeof(hdr));
 }
 
 /**
@@ -677,6 +709,7 @@ static void add_hmac_digest(SSL *ssl, int mode, uint8_t *hmac_header,
  */
 static int verify_digest(SSL *ssl, int mode, const uint8_t *buf, int read_len)
 {   
+    HMAC_CTX hmac_ctx;
     uint8_t hmac_buf[SHA1_SIZE];
     int hmac_offset;
    
@@ -713,10 +746,9 @@ static int verify_digest(SSL *ssl, int mode, const uint8_t *buf, int read_len)
         }
     }
 
-    /* sanity check the offset */
-    ssl->hmac_header[3] = hmac_offset >> 8;      /* insert size */
-    ssl->hmac_header[4] = hmac_offset & 0xff;
-    add_hmac_digest(ssl, mode, ssl->hmac_header, buf, hmac_offset, hmac_buf);
+    hmac_start(ssl, mode, &hmac_ctx, ssl->hmac_header, hmac_offset);
+    hmac_update(&hmac_ctx, buf, hmac_offset);
+    hmac_final(&hmac_ctx, hmac_buf);
 
     if (memcmp(hmac_buf, &buf[hmac_offset], ssl->cipher_info->digest_size))
     {
@@ -734,6 +766,7 @@ void add_packet(SSL *ssl, const uint8_t *pkt, int len)
 {
     MD5_Update(&ssl->dc->md5_ctx, pkt, len);
     SHA1_Update(&ssl->dc->sha1_ctx, pkt, len);
+    SHA256_Update(&ssl->dc->sha256_ctx, pkt, len);
 }
 
 /**
@@ -793,16 +826,52 @@ static void p_hash_sha1(const uint8_t *sec, int sec_len,
 }
 
 /**
- * Work out the PRF.
+ * Work out the SHA256 PRF.
  */
-static void prf(const uint8_t *sec, int sec_len, uint8_t *seed, int seed_len,
-        uint8_t *out, int olen)
+static void p_hash_sha256(const uint8_t *sec, int sec_len, 
+        uint8_t *seed, int seed_len, uint8_t *out, int olen)
+{
+    uint8_t a1[128];
+    uint8_t buf[SHA256_SIZE];
+
+    /* A(1) */
+    hmac_sha256(seed, seed_len, sec, sec_len, a1);
+    memcpy(&a1[SHA256_SIZE], seed, seed_len);
+
+    while (olen > 0)
+    {
+        int len = olen < SHA256_SIZE ? olen : SHA256_SIZE;
+
+        /* work out the actual hash */
+        hmac_sha256(a1, SHA256_SIZE+seed_len, sec, sec_len, buf);
+        memcpy(out, buf, len);
+        out += len;
+        olen -= len;
+
+        /* A(N) */
+        hmac_sha256(a1, SHA256_SIZE, sec, sec_len, buf);
+        memcpy(a1, buf, SHA256_SIZE);
+    }
+}
+
+/**
+ * Work out the PRF. TLS v1.2 uses just SHA256, earlier versions split the 
+ * secret between MD5 and SHA1.
+ */
+static void prf(SSL *ssl, const uint8_t *sec, int sec_len, 
+        uint8_t *seed, int seed_len, uint8_t *out, int olen)
 {
     int len, i;
     const uint8_t *S1, *S2;
     uint8_t xbuf[256]; /* needs to be > the amount of key data */
     uint8_t ybuf[256]; /* needs to be > the amount of key data */
 
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        p_hash_sha256(sec, sec_len, seed, seed_len, out, olen);
+        return;
+    }
+
     len = sec_len/2;
     S1 = sec;
     S2 = &sec[len];
@@ -825,33 +894,43 @@ void generate_master_secret(SSL *ssl, const uint8_t *premaster_secret)
     strcpy((char *)buf, "master secret");
     memcpy(&buf[13], ssl->dc->client_random, SSL_RANDOM_SIZE);
     memcpy(&buf[45], ssl->dc->server_random, SSL_RANDOM_SIZE);
-    prf(premaster_secret, SSL_SECRET_SIZE, buf, 77, ssl->dc->master_secret,
-            SSL_SECRET_SIZE);
+    prf(ssl, premaster_secret, SSL_SECRET_SIZE, buf, 77, 
+            ssl->dc->master_secret, SSL_SECRET_SIZE);
 }
 
 /**
  * Generate a 'random' blob of data used for the generation of keys.
  */
-static void generate_key_block(uint8_t *client_random, uint8_t *server_random,
-        uint8_t *master_secret, uint8_t *key_block, int key_block_size)
+static void generate_key_block(SSL *ssl, uint8_t *client_random, 
+        uint8_t *server_random, uint8_t *master_secret, 
+        uint8_t *key_block, int key_block_size)
 {
     uint8_t buf[128];
     strcpy((char *)buf, "key expansion");
     memcpy(&buf[13], server_random, SSL_RANDOM_SIZE);
     memcpy(&buf[45], client_random, SSL_RANDOM_SIZE);
-    prf(master_secret, SSL_SECRET_SIZE, buf, 77, key_block, key_block_size);
+    prf(ssl, master_secret, SSL_SECRET_SIZE, buf, 77, 
+            key_block, key_block_size);
 }
 
+/**
+ * The DER encoded DigestInfo in front of a SHA256 hash in an RSA signature.
+ */
+static const uint8_t sha256_digest_info[] =
+{
+    0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 
+    0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+};
+
 /** 
  * Calculate the digest used in the finished message. This function also
- * doubles up as a certificate verify function.
+ * doubles up as a certificate verify function, when it returns the size of 
+ * the digest to be signed.
  */
-void finished_digest(SSL *ssl, const char *label, uint8_t *digest)
+int finished_digest(SSL *ssl, const char *label, uint8_t *digest)
 {
     uint8_t mac_buf[128]; 
     uint8_t *q = mac_buf;
-    MD5_CTX md5_ctx = ssl->dc->md5_ctx;
-    SHA1_CTX sha1_ctx = ssl->dc->sha1_ctx;
 
     if (label)
     {
@@ -859,20 +938,40 @@ void finished_digest(SSL *ssl, const char *label, uint8_t *digest)
         q += strlen(label);
     }
 
-    MD5_Final(q, &md5_ctx);
-    q += MD5_SIZE;
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        SHA256_CTX sha256_ctx = ssl->dc->sha256_ctx;
+
+        /* a certificate verify signs a DigestInfo, not just the hash */
+        if (label == NULL)
+        {
+            memcpy(q, sha256_digest_info, sizeof(sha256_digest_info));
+            q += sizeof(sha256_digest_info);
+        }
+
+        SHA256_Final(q, &sha256_ctx);
+        q += SHA256_SIZE;
+    }
+    else
+    {
+        MD5_CTX md5_ctx = ssl->dc->md5_ctx;
+        SHA1_CTX sha1_ctx = ssl->dc->sha1_ctx;
+
+        MD5_Final(q, &md5_ctx);
+        q += MD5_SIZE;
     
-    SHA1_Final(q, &sha1_ctx);
-    q += SHA1_SIZE;
+        SHA1_Final(q, &sha1_ctx);
+        q += SHA1_SIZE;
+    }
 
     if (label)
     {
-        prf(ssl->dc->master_secret, SSL_SECRET_SIZE, mac_buf, (int)(q-mac_buf),
-            digest, SSL_FINISHED_HASH_SIZE);
+        prf(ssl, ssl->dc->master_secret, SSL_SECRET_SIZE, 
+            mac_buf, (int)(q-mac_buf), digest, SSL_FINISHED_HASH_SIZE);
     }
     else    /* for use in a certificate verify */
     {
-        memcpy(digest, mac_buf, MD5_SIZE + SHA1_SIZE);
+        memcpy(digest, mac_buf, q-mac_buf);
     }
 
 #if 0
@@ -881,6 +980,8 @@ void finished_digest(SSL *ssl, const char *label, uint8_t *digest)
     print_blob("mac_buf", mac_buf, q-mac_buf);
     print_blob("finished digest", digest, SSL_FINISHED_HASH_SIZE);
 #endif
+
+    return label ? SSL_FINISHED_HASH_SIZE : (int)(q-mac_buf);
 }   
     
 /**
@@ -891,6 +992,14 @@ static void *crypt_new(SSL *ssl, uint8_t *key, uint8_t *iv, int is_decrypt)
     switch (ssl->cipher)
     {
 #ifndef CONFIG_SSL_SKELETON_MODE
+        case SSL_AES128_GCM_SHA256:
+            {
+                AEAD_CTX *aead_ctx = (AEAD_CTX *)malloc(sizeof(AEAD_CTX));
+                AES_gcm_set_key(&aead_ctx->gcm, key, AES_MODE_128);
+                memcpy(aead_ctx->salt, iv, SSL_AEAD_SALT_SIZE);
+                return (void *)aead_ctx;
+            }
+
         case SSL_AES128_SHA:
             {
                 AES_CTX *aes_ctx = (AES_CTX *)malloc(sizeof(AES_CTX));
@@ -931,6 +1040,87 @@ static void *crypt_new(SSL *ssl, uint8_t *key, uint8_t *iv, int is_decrypt)
 }
 
 
+#ifndef CONFIG_SSL_SKELETON_MODE
+/**
+ * Start an AEAD record. The nonce is the salt from the key block followed by
+ * the explicit part sent with the record, and the additional data is the 
+ * sequence number and the record header with the length of the plaintext.
+ */
+static void aead_start(AEAD_CTX *aead_ctx, const uint8_t *sequence, 
+        const uint8_t *explicit_nonce, const uint8_t *record_hdr, int length)
+{
+    uint8_t nonce[SSL_AEAD_SALT_SIZE+SSL_AEAD_NONCE_SIZE];
+    uint8_t aad[8+SSL_RECORD_SIZE];
+
+    memcpy(nonce, aead_ctx->salt, SSL_AEAD_SALT_SIZE);
+    memcpy(&nonce[SSL_AEAD_SALT_SIZE], explicit_nonce, SSL_AEAD_NONCE_SIZE);
+    memcpy(aad, sequence, 8);
+    memcpy(&aad[8], record_hdr, 3);
+    aad[11] = length >> 8;
+    aad[12] = length & 0xff;
+    AES_gcm_start(&aead_ctx->gcm, nonce, aad, sizeof(aad));
+}
+
+/**
+ * Check the tag at the end of an AEAD record, in constant time.
+ */
+static int aead_verify(AEAD_CTX *aead_ctx, const uint8_t *tag)
+{
+    uint8_t calc_tag[AES_GCM_TAG_SIZE];
+    uint8_t diff = 0;
+    int i;
+
+    AES_gcm_finish(&aead_ctx->gcm, calc_tag);
+
+    for (i = 0; i < AES_GCM_TAG_SIZE; i++)
+        diff |= calc_tag[i] ^ tag[i];
+
+    return diff ? SSL_ERROR_INVALID_HMAC : SSL_OK;
+}
+
+/**
+ * Encrypt the record in bm_data in place, filling in the explicit nonce in 
+ * front of the plaintext and adding the tag after it. The write sequence 
+ * number is used as the nonce, as it is never repeated with the same key.
+ */
+static int aead_encrypt(SSL *ssl, const uint8_t *record_hdr, int length)
+{
+    AEAD_CTX *aead_ctx = (AEAD_CTX *)ssl->encrypt_ctx;
+    uint8_t *buf = &ssl->bm_data[SSL_AEAD_NONCE_SIZE];
+
+    memcpy(ssl->bm_data, ssl->write_sequence, SSL_AEAD_NONCE_SIZE);
+    aead_start(aead_ctx, ssl->write_sequence, ssl->bm_data, 
+                                                record_hdr, length);
+    AES_gcm_encrypt(&aead_ctx->gcm, buf, buf, length);
+    AES_gcm_finish(&aead_ctx->gcm, &buf[length]);
+    increment_write_sequence(ssl);
+    return SSL_AEAD_NONCE_SIZE + length + AES_GCM_TAG_SIZE;
+}
+
+/**
+ * Decrypt a whole AEAD record in place, leaving the plaintext at the start 
+ * of buf.
+ */
+static int aead_decrypt(SSL *ssl, uint8_t *buf, int len)
+{
+    AEAD_CTX *aead_ctx = (AEAD_CTX *)ssl->decrypt_ctx;
+    int ret;
+
+    len -= SSL_AEAD_NONCE_SIZE + AES_GCM_TAG_SIZE;
+    if (len < 0)
+        return SSL_ERROR_INVALID_PROT_MSG;
+
+    aead_start(aead_ctx, ssl->read_sequence, buf, ssl->hmac_header, len);
+    AES_gcm_decrypt(&aead_ctx->gcm, &buf[SSL_AEAD_NONCE_SIZE], buf, len);
+
+    if ((ret = aead_verify(aead_ctx, &buf[SSL_AEAD_NONCE_SIZE+len])) < 0)
+        return ret;
+
+    increment_read_sequence(ssl);
+    return len;
+}
+#endif
+
 /**
  * Send a packet over the socket.
  */
@@ -1002,94 +1192,135 @@ static int send_raw_packet(SSL *ssl, uint8_t protocol)
 }
 
 /**
- * Send an encrypted packet with padding bytes if necessary.
+ * The bytes in front of the plaintext of an encrypted record, for the 
+ * explicit IV of a block cipher from TLS 1.1 on, or the explicit nonce of an 
+ * AEAD cipher.
  */
-int send_packet(SSL *ssl, uint8_t protocol, const uint8_t *in, int length)
+static int record_iv_size(const SSL *ssl)
 {
-    int ret, msg_length = 0;
+#ifndef CONFIG_SSL_SKELETON_MODE
+    if (ssl->cipher_info->hmac == NULL)
+        return SSL_AEAD_NONCE_SIZE;
+#endif
+    return ssl->version >= SSL_PROTOCOL_VERSION1_1 ? 
+                                    ssl->cipher_info->iv_size : 0;
+}
 
-    /* if our state is bad, don't bother */
-    if (ssl->hs_status == SSL_ERROR_DEAD)
-        return SSL_ERROR_CONN_LOST;
+/**
+ * Where the plaintext of the next record sent goes in bm_data.
+ */
+static int tx_data_offset(const SSL *ssl)
+{
+    return IS_SET_SSL_FLAG(SSL_TX_ENCRYPTED) ? record_iv_size(ssl) : 0;
+}
 
-    if (in) /* has the buffer already been initialised? */
+/**
+ * MAC, pad and encrypt the record in bm_data in place, in a single pass. 
+ * Each slice of the plaintext is encrypted as soon as it has been hashed, 
+ * while it is still in the cache, and the explicit IV of TLS 1.1 is made
+ * in front of the plaintext rather than by moving it.
+ */
+static int mac_encrypt(SSL *ssl, const uint8_t *record_hdr, int length)
+{
+    const cipher_info_t *ciph_info = ssl->cipher_info;
+    int block_size = ciph_info->padding_size ? ciph_info->padding_size : 1;
+    int iv_size = record_iv_size(ssl);
+    uint8_t *buf = &ssl->bm_data[iv_size];
+    int hashed = 0, encrypted = 0, msg_length;
+    HMAC_CTX hmac_ctx;
+
+    DISPLAY_BYTES(ssl, "unencrypted write", buf, length);
+    hmac_start(ssl, IS_SET_SSL_FLAG(SSL_IS_CLIENT) ? 
+            SSL_CLIENT_WRITE : SSL_SERVER_WRITE, &hmac_ctx, record_hdr, length);
+
+    if (iv_size)
     {
-        memcpy(ssl->bm_data, in, length);
+        get_random(iv_size, ssl->bm_data);
+        ciph_info->encrypt(ssl->encrypt_ctx, ssl->bm_data, 
+                                                ssl->bm_data, iv_size);
     }
 
-    msg_length += length;
-
-    if (IS_SET_SSL_FLAG(SSL_TX_ENCRYPTED))
+    while (hashed < length)
     {
-        int mode = IS_SET_SSL_FLAG(SSL_IS_CLIENT) ? 
-                            SSL_CLIENT_WRITE : SSL_SERVER_WRITE;
-        uint8_t hmac_header[SSL_RECORD_SIZE] = 
-        {
-            protocol, 
-            0x03, /* version = 3.1 or higher */
-            ssl->version & 0x0f,
-            msg_length >> 8,
-            msg_length & 0xff 
-        };
+        int n = length - hashed;
 
-        if (protocol == PT_HANDSHAKE_PROTOCOL)
-        {
-            DISPLAY_STATE(ssl, 1, ssl->bm_data[0], 0);
+        if (n > RT_SLICE_LENGTH)
+            n = RT_SLICE_LENGTH;
 
-            if (ssl->bm_data[0] != HS_HELLO_REQUEST)
-            {
-                add_packet(ssl, ssl->bm_data, msg_length);
-            }
-        }
+        hmac_update(&hmac_ctx, &buf[hashed], n);
+        hashed += n;
 
-        /* add the packet digest */
-        add_hmac_digest(ssl, mode, hmac_header, ssl->bm_data, msg_length, 
-                                                &ssl->bm_data[msg_length]);
-        msg_length += ssl->cipher_info->digest_size;
+        /* only whole blocks, the rest goes with the MAC and padding */
+        n = hashed - encrypted;
+        n -= n % block_size;
+        ciph_info->encrypt(ssl->encrypt_ctx, &buf[encrypted], 
+                                                &buf[encrypted], n);
+        encrypted += n;
+    }
 
-        /* add padding? */
-        if (ssl->cipher_info->padding_size)
-        {
-            int last_blk_size = msg_length%ssl->cipher_info->padding_size;
-            int pad_bytes = ssl->cipher_info->padding_size - last_blk_size;
+    hmac_final(&hmac_ctx, &buf[length]);
+    msg_length = length + ciph_info->digest_size;
 
-            /* ensure we always have at least 1 padding byte */
-            if (pad_bytes == 0)
-                pad_bytes += ssl->cipher_info->padding_size;
+    /* add padding? */
+    if (ciph_info->padding_size)
+    {
+        int last_blk_size = msg_length%ciph_info->padding_size;
+        int pad_bytes = ciph_info->padding_size - last_blk_size;
 
-            memset(&ssl->bm_data[msg_length], pad_bytes-1, pad_bytes);
-            msg_length += pad_bytes;
-        }
+        /* ensure we always have at least 1 padding byte */
+        if (pad_bytes == 0)
+            pad_bytes += ciph_info->padding_size;
 
-        DISPLAY_BYTES(ssl, "unencrypted write", ssl->bm_data, msg_length);
-        increment_write_sequence(ssl);
+        memset(&buf[msg_length], pad_bytes-1, pad_bytes);
+        msg_length += pad_bytes;
+    }
 
-        /* add the explicit IV for TLS1.1 */
-        if (ssl->version >= SSL_PROTOCOL_VERSION1_1 &&
-                        ssl->cipher_info->iv_size)
-        {
-            uint8_t iv_size = ssl->cipher_info->iv_size;
-            uint8_t *t_buf = alloca(msg_length + iv_size);
-            memcpy(t_buf + iv_size, ssl->bm_data, msg_length);
-            get_random(iv_size, t_buf);
-            msg_length += iv_size;
-            memcpy(ssl->bm_data, t_buf, msg_length);
-        }
+    ciph_info->encrypt(ssl->encrypt_ctx, &buf[encrypted], 
+                                &buf[encrypted], msg_length - encrypted);
+    increment_write_sequence(ssl);
+    return iv_size + msg_length;
+}
 
-        /* now encrypt the packet */
-        ssl->cipher_info->encrypt(ssl->encrypt_ctx, ssl->bm_data, 
-                                            ssl->bm_data, msg_length);
-    }
-    else if (protocol == PT_HANDSHAKE_PROTOCOL)
+/**
+ * Send the record whose plaintext is at tx_data_offset() in bm_data, 
+ * encrypting it in place.
+ */
+static int send_record(SSL *ssl, uint8_t protocol, int length)
+{
+    uint8_t *buf = &ssl->bm_data[tx_data_offset(ssl)];
+    int ret, msg_length = length;
+
+    /* if our state is bad, don't bother */
+    if (ssl->hs_status == SSL_ERROR_DEAD)
+        return SSL_ERROR_CONN_LOST;
+
+    if (protocol == PT_HANDSHAKE_PROTOCOL)
     {
-        DISPLAY_STATE(ssl, 1, ssl->bm_data[0], 0);
+        DISPLAY_STATE(ssl, 1, buf[0], 0);
 
-        if (ssl->bm_data[0] != HS_HELLO_REQUEST)
+        if (buf[0] != HS_HELLO_REQUEST)
         {
-            add_packet(ssl, ssl->bm_data, length);
+            add_packet(ssl, buf, length);
         }
     }
 
+    if (IS_SET_SSL_FLAG(SSL_TX_ENCRYPTED))
+    {
+        uint8_t record_hdr[3] = 
+        {
+            protocol, 
+            0x03, /* version = 3.1 or higher */
+            ssl->version & 0x0f
+        };
+
+#ifndef CONFIG_SSL_SKELETON_MODE
+        if (ssl->cipher_info->hmac == NULL)
+            msg_length = aead_encrypt(ssl, record_hdr, length);
+        else
+#endif
+            msg_length = mac_encrypt(ssl, record_hdr, length);
+    }
+
     ssl->bm_index = msg_length;
     if ((ret = send_raw_packet(ssl, protocol)) <= 0)
         return ret;
@@ -1097,6 +1328,27 @@ int send_packet(SSL *ssl, uint8_t protocol, const uint8_t *in, int length)
     return length;  /* just return what we wanted to send */
 }
 
+/**
+ * Send an encrypted packet with padding bytes if necessary.  Handshake 
+ * messages are built at the start of bm_data, so they are moved up past 
+ * the room for an explicit IV or nonce.
+ */
+int send_packet(SSL *ssl, uint8_t protocol, const uint8_t *in, int length)
+{
+    int offset = tx_data_offset(ssl);
+
+    if (in) /* has the buffer already been initialised? */
+    {
+        memcpy(&ssl->bm_data[offset], in, length);
+    }
+    else if (offset)
+    {
+        memmove(&ssl->bm_data[offset], ssl->bm_data, length);
+    }
+
+    return send_record(ssl, protocol, length);
+}
+
 /**
  * Work out the cipher keys we are going to use for this session based on the
  * master secret.
@@ -1121,7 +1373,7 @@ static int set_key_block(SSL *ssl, int is_write)
         print_blob("server", ssl->dc->server_random, 32);
         print_blob("master", ssl->dc->master_secret, SSL_SECRET_SIZE);
 #endif
-        generate_key_block(ssl->dc->client_random, ssl->dc->server_random,
+        generate_key_block(ssl, ssl->dc->client_random, ssl->dc->server_random,
             ssl->dc->master_secret, ssl->dc->key_block, 
             ciph_info->key_block_size);
 #if 0
@@ -1131,19 +1383,23 @@ static int set_key_block(SSL *ssl, int is_write)
 
     q = ssl->dc->key_block;
 
-    if ((is_client && is_write) || (!is_client && !is_write))
+    if (ciph_info->hmac)    /* AEAD ciphers have no MAC keys */
     {
-        memcpy(ssl->client_mac, q, ciph_info->digest_size);
-    }
+        if ((is_client && is_write) || (!is_client && !is_write))
+        {
+            memcpy(ssl->client_mac, q, ciph_info->digest_size);
+        }
 
-    q += ciph_info->digest_size;
+        q += ciph_info->digest_size;
 
-    if ((!is_client && is_write) || (is_client && !is_write))
-    {
-        memcpy(ssl->server_mac, q, ciph_info->digest_size);
+        if ((!is_client && is_write) || (is_client && !is_write))
+        {
+            memcpy(ssl->server_mac, q, ciph_info->digest_size);
+        }
+
+        q += ciph_info->digest_size;
     }
 
-    q += ciph_info->digest_size;
     memcpy(client_key, q, ciph_info->key_size);
     q += ciph_info->key_size;
     memcpy(server_key, q, ciph_info->key_size);
@@ -1244,6 +1500,8 @@ int read_record(SSL *ssl)
 {
     if(!IS_SET_SSL_FLAG(SSL_NEED_RECORD))
         return 0;
+    if (ssl->hs_status == SSL_ERROR_DEAD)
+        return SSL_ERROR_CONN_LOST;
     uint8_t record[SSL_RECORD_SIZE];
     int ret = basic_read2(ssl, record, SSL_RECORD_SIZE);
     if(ret != SSL_RECORD_SIZE)
@@ -1285,6 +1543,7 @@ int read_record(SSL *ssl)
 
     memcpy(ssl->hmac_header, record, 3);       /* store for hmac */
     ssl->record_type = record[0];
+    ssl->got_bytes = 0;
     CLR_SSL_FLAG(SSL_NEED_RECORD);
     return SSL_OK;
 }
@@ -1293,22 +1552,32 @@ int basic_decrypt(SSL *ssl, uint8_t *buf, int len)
 {
    if (IS_SET_SSL_FLAG(SSL_RX_ENCRYPTED))
     {
+#ifndef CONFIG_SSL_SKELETON_MODE
+        if (ssl->cipher_info->hmac == NULL)
+        {
+            len = aead_decrypt(ssl, buf, len);
+            DISPLAY_BYTES(ssl, "decrypted", buf, len);
+            return len;
+        }
+#endif
         ssl->cipher_info->decrypt(ssl->decrypt_ctx, buf, buf, len);
 
+        /* TLS 1.1 records start with an explicit IV, drop it */
         if (ssl->version >= SSL_PROTOCOL_VERSION1_1 &&
                         ssl->cipher_info->iv_size)
         {
-            buf += ssl->cipher_info->iv_size;
-            ssl->need_bytes -= ssl->cipher_info->iv_size;
+            if (len < ssl->cipher_info->iv_size)
+                return SSL_ERROR_INVALID_PROT_MSG;
+            len -= ssl->cipher_info->iv_size;
+            memmove(buf, buf + ssl->cipher_info->iv_size, len);
         }
-        if(ssl->record_type != PT_APP_PROTOCOL_DATA)
-            len = verify_digest(ssl, 
-                    IS_SET_SSL_FLAG(SSL_IS_CLIENT) ? SSL_CLIENT_READ : SSL_SERVER_READ, buf, len);
+        len = verify_digest(ssl, 
+                IS_SET_SSL_FLAG(SSL_IS_CLIENT) ? SSL_CLIENT_READ : SSL_SERVER_READ, buf, len);
 
         /* does the hmac work? */
-        if (ssl->need_bytes < 0)
+        if (len < 0)
         {
-            return ssl->need_bytes;
+            return len;
         }
 
         DISPLAY_BYTES(ssl, "decrypted", buf, len);
@@ -1317,17 +1586,191 @@ int basic_decrypt(SSL *ssl, uint8_t *buf, int len)
     return len;
 }
 
+/**
+ * Read a whole application data record and decrypt it into data, which has
+ * room for all of it but the explicit IV or nonce, so that its MAC or tag is
+ * checked before any of it is used.
+ */
+static int read_app_record(SSL *ssl, uint8_t *data)
+{
+    const cipher_info_t *ciph_info = ssl->cipher_info;
+    int iv_size = record_iv_size(ssl);
+    int len = ssl->need_bytes - iv_size;
+    uint8_t iv[AES_IV_SIZE];
+
+    if (len < ciph_info->digest_size)
+        return SSL_ERROR_INVALID_PROT_MSG;
+
+    if ((iv_size && basic_read2(ssl, iv, iv_size) != iv_size) ||
+                basic_read2(ssl, data, len) != len)
+        return SSL_ERROR_CONN_LOST;
+
+    ssl->need_bytes = 0;
+    SET_SSL_FLAG(SSL_NEED_RECORD);
+
+#ifndef CONFIG_SSL_SKELETON_MODE
+    if (ciph_info->hmac == NULL)
+    {
+        AEAD_CTX *aead_ctx = (AEAD_CTX *)ssl->decrypt_ctx;
+        int ret;
+
+        len -= AES_GCM_TAG_SIZE;
+        aead_start(aead_ctx, ssl->read_sequence, iv, ssl->hmac_header, len);
+        AES_gcm_decrypt(&aead_ctx->gcm, data, data, len);
+
+        if ((ret = aead_verify(aead_ctx, &data[len])) < 0)
+            return ret;
+    }
+    else
+#endif
+    {
+        /* the explicit IV only needs decrypting to chain CBC on to data */
+        if (iv_size)
+            ciph_info->decrypt(ssl->decrypt_ctx, iv, iv, iv_size);
+
+        ciph_info->decrypt(ssl->decrypt_ctx, data, data, len);
+        len = verify_digest(ssl, IS_SET_SSL_FLAG(SSL_IS_CLIENT) ? 
+                                SSL_CLIENT_READ : SSL_SERVER_READ, data, len);
+
+        if (len < 0)
+            return len;
+    }
+
+    DISPLAY_BYTES(ssl, "decrypted", data, len);
+    increment_read_sequence(ssl);
+    return len;
+}
+
+/*
+ * The buffer application data records are read into, bm_all_data unless the
+ * server ignored our max_fragment_length extension.
+ */
+static uint8_t *app_data_buf(SSL *ssl)
+{
+    return ssl->bm_big_data ? ssl->bm_big_data : ssl->bm_all_data;
+}
+
+/**
+ * Read and decrypt the next application data record into the record buffer.
+ * It is read whole so that its MAC, padding or tag are checked before any of
+ * it is used.  A record which doesn't fit is refused, which a server that 
+ * honours our max_fragment_length extension won't send, nor one that 
+ * ignores it and keeps to the 16kB limit of TLS.
+ */
+static int read_app_data(SSL *ssl)
+{
+    int buf_size = ssl->bm_big_data ? 
+                        RT_MAX_FULL_RECORD : (int)sizeof(ssl->bm_all_data);
+    int data_len;
+
+    if (!IS_SET_SSL_FLAG(SSL_RX_ENCRYPTED))
+        return SSL_ERROR_INVALID_PROT_MSG;
+
+    if (ssl->need_bytes - record_iv_size(ssl) > buf_size)
+        return SSL_ERROR_RECORD_OVERFLOW;
+
+    if ((data_len = read_app_record(ssl, app_data_buf(ssl))) < 0)
+        return data_len;
+
+    ssl->bm_index = 0;
+    ssl->bm_read_index = data_len;
+    return SSL_OK;
+}
+
+/**
+ * Give up on a connection whose application data couldn't be read, telling
+ * the peer why unless the connection is already gone.
+ */
+static int app_data_failed(SSL *ssl, int ret)
+{
+    if (ret != SSL_ERROR_CONN_LOST)
+        send_alert(ssl, ret);
+
+    ssl->hs_status = SSL_ERROR_DEAD;
+    return ret;
+}
+
+/*
+ * Get the decrypted application data which hasn't been read yet, reading
+ * more of the record, or the next record, when there isn't any.
+ */
+EXP_FUNC int STDCALL ssl_read_buf(SSL *ssl, uint8_t **in_data)
+{
+    int ret;
+
+    *in_data = NULL;
+    while (ssl->bm_read_index == 0)
+    {
+        if (IS_SET_SSL_FLAG(SSL_NEED_RECORD) && 
+                        (ret = read_record(ssl)) < SSL_OK)
+            return ret;
+
+        if (ssl->record_type != PT_APP_PROTOCOL_DATA)
+        {
+            if ((ret = process_data(ssl, NULL, 0)) < SSL_OK)
+                return ret;
+        }
+        else if (ssl->need_bytes == 0)  /* on to the next record */
+            SET_SSL_FLAG(SSL_NEED_RECORD);
+        else if ((ret = read_app_data(ssl)) < SSL_OK)
+            return app_data_failed(ssl, ret);
+    }
+
+    *in_data = app_data_buf(ssl) + ssl->bm_index;
+    return ssl->bm_read_index;
+}
+
+/*
+ * Mark the first len bytes returned by ssl_read_buf() as read.
+ */
+EXP_FUNC void STDCALL ssl_read_done(SSL *ssl, int len)
+{
+    ssl->bm_index += len;
+    ssl->bm_read_index -= len;
+
+    if (ssl->bm_read_index == 0 && ssl->need_bytes == 0)
+        SET_SSL_FLAG(SSL_NEED_RECORD);
+}
+
+/*
+ * Read application data into in_data.  A whole record is decrypted straight
+ * into in_data when it has room for it and nothing else is waiting to be 
+ * read, rather than into the record buffer and then copied.
+ */
 int ssl_read(SSL *ssl, uint8_t *in_data, int len)
 {
+    uint8_t *data;
+    int ret;
+
     if(len <= 0 || in_data == NULL)
         return 0;
-   
-    if(IS_SET_SSL_FLAG(SSL_NEED_RECORD))
+
+    while (ssl->bm_read_index == 0)
     {
-        read_record(ssl);
+        if (IS_SET_SSL_FLAG(SSL_NEED_RECORD) && 
+                        (ret = read_record(ssl)) < SSL_OK)
+            return ret;
+
+        if (ssl->record_type != PT_APP_PROTOCOL_DATA || 
+                !IS_SET_SSL_FLAG(SSL_RX_ENCRYPTED) || 
+                ssl->need_bytes - record_iv_size(ssl) > len)
+            break;
+
+        if ((ret = read_app_record(ssl, in_data)) < 0)
+            return app_data_failed(ssl, ret);
+
+        if (ret > 0)
+            return ret;
     }
-   
-    return process_data(ssl, in_data, len);
+
+    if ((ret = ssl_read_buf(ssl, &data)) <= 0)
+        return ret;
+
+    if (len > ret)
+        len = ret;
+    memcpy(in_data, data, len);
+    ssl_read_done(ssl, len);
+    return len;
 }
 
 int process_data(SSL* ssl, uint8_t *in_data, int len)
@@ -1354,9 +1797,9 @@ int process_data(SSL* ssl, uint8_t *in_data, int len)
         
             if(basic_read2(ssl, ssl->bm_data, ssl->need_bytes) != ssl->need_bytes)
                 return -1;
-            ssl->need_bytes = basic_decrypt(ssl, ssl->bm_data, ssl->need_bytes);
-            if(ssl->need_bytes < 0)
+            if(basic_decrypt(ssl, ssl->bm_data, ssl->need_bytes) < 0)
                 return -1;
+            ssl->need_bytes = 0;
 
             if (ssl->next_state != HS_FINISHED)
             {
@@ -1372,62 +1815,17 @@ int process_data(SSL* ssl, uint8_t *in_data, int len)
             
             memset(ssl->read_sequence, 0, 8);
             SET_SSL_FLAG(SSL_NEED_RECORD);
-            break;
+            return SSL_OK;
 
         case PT_APP_PROTOCOL_DATA:
-            if(len <= 0)
-                return 0;
-            if(ssl->need_bytes == 0)
-                return 0;
-            if (in_data)
-            {
-                uint16_t index = ssl->bm_index % 2048;
-                if(ssl->bm_read_index == 0)
-                {
-                    int read_len = len;
-                    if(read_len > 2048-index)
-                        read_len = 2048-index;
-                    if(read_len > ssl->need_bytes)
-                        read_len = ssl->need_bytes;
-                    read_len -= read_len % AES_BLOCKSIZE;
-
-                    if(read_len <= 0)
-                        read_len = AES_BLOCKSIZE;
-                    if(ssl->need_bytes < AES_BLOCKSIZE)
-                        read_len = AES_BLOCKSIZE;
-                    int ret = basic_read2(ssl, ssl->bm_all_data + index, read_len);
-                    if(ret != read_len)
-                        return 0;
-                    
-                    ssl->bm_read_index = basic_decrypt(ssl, ssl->bm_all_data + index, read_len);
-                    ssl->need_bytes -= ssl->bm_read_index;
-                    if(ssl->need_bytes == 0)
-                    {
-                        ssl->bm_read_index = 0;
-                        SET_SSL_FLAG(SSL_NEED_RECORD);
-                        return ssl_read(ssl, in_data, len);
-                    }
-                }
-                if(len > ssl->bm_read_index)
-                    len = ssl->bm_read_index;
-                memcpy(in_data, ssl->bm_all_data+index, len);
-                ssl->bm_index += len;
-                ssl->bm_read_index -= len;
-                
-                if(ssl->need_bytes == 0)
-                    SET_SSL_FLAG(SSL_NEED_RECORD);
-                if(ssl->bm_index >= 2048)
-                    ssl->bm_index = 0;
-                return len;
-            }
-            return 0;
+            return ssl_read(ssl, in_data, len);
             
         case PT_ALERT_PROTOCOL:
             if(basic_read2(ssl, ssl->bm_data, ssl->need_bytes) != ssl->need_bytes)
                 return -1;
-            ssl->need_bytes = basic_decrypt(ssl, ssl->bm_data, ssl->need_bytes);
-            if(ssl->need_bytes < 0)
+            if(basic_decrypt(ssl, ssl->bm_data, ssl->need_bytes) < 0)
                 return -1; 
+            ssl->need_bytes = 0;
             
             SET_SSL_FLAG(SSL_NEED_RECORD);
 
@@ -1463,9 +1861,9 @@ static int do_handshake(SSL *ssl, uint8_t *buf, int read_len)
     {
         if(basic_read2(ssl, ssl->bm_data, ssl->need_bytes) != ssl->need_bytes)
             return -1;
-        ssl->need_bytes = basic_decrypt(ssl, ssl->bm_data, ssl->need_bytes);
-        if(ssl->need_bytes < 0)
+        if(basic_decrypt(ssl, ssl->bm_data, ssl->need_bytes) < 0)
             return -1; 
+        ssl->need_bytes = 0;
         buf = ssl->bm_data;
     }
     else
@@ -1518,7 +1916,7 @@ static int do_handshake(SSL *ssl, uint8_t *buf, int read_len)
         }
     }
     else if (handshake_type != HS_CERT_VERIFY && handshake_type != HS_HELLO_REQUEST)
-        add_packet(ssl, ssl->bm_data+SSL_HS_HDR_SIZE, hs_len-SSL_HS_HDR_SIZE);
+        add_packet(ssl, ssl->bm_data+SSL_HS_HDR_SIZE, hs_len);
 
 #if defined(CONFIG_SSL_ENABLE_CLIENT)
     ret = is_client ? 
@@ -1612,6 +2010,7 @@ int send_alert(SSL *ssl, int error_code)
 
         case SSL_ERROR_INVALID_HANDSHAKE:
         case SSL_ERROR_INVALID_PROT_MSG:
+        case SSL_ERROR_FRAGMENT_LENGTH_IGNORED:
             alert_num = SSL_ALERT_HANDSHAKE_FAILURE;
             break;
 
@@ -1624,6 +2023,10 @@ int send_alert(SSL *ssl, int error_code)
             alert_num = SSL_ALERT_INVALID_VERSION;
             break;
 
+        case SSL_ERROR_RECORD_OVERFLOW:
+            alert_num = SSL_ALERT_RECORD_OVERFLOW;
+            break;
+
         case SSL_ERROR_INVALID_SESSION:
         case SSL_ERROR_NO_CIPHER:
         case SSL_ERROR_INVALID_KEY:
@@ -1729,6 +2132,7 @@ void disposable_new(SSL *ssl)
         memset(ssl->dc->key_block, 0, MAX_KEYBLOCK_SIZE);
         MD5_Init(&ssl->dc->md5_ctx);
         SHA1_Init(&ssl->dc->sha1_ctx);
+        SHA256_Init(&ssl->dc->sha256_ctx);
     }
 }
 
@@ -2199,6 +2603,14 @@ EXP_FUNC void STDCALL ssl_display_error(int error_code)
             printf("Option not supported");
             break;
 
+        case SSL_ERROR_RECORD_OVERFLOW:
+            printf("record too large for the buffer");
+            break;
+
+        case SSL_ERROR_FRAGMENT_LENGTH_IGNORED:
+            printf("max_fragment_length ignored, no memory for 16kB records");
+            break;
+
         default:
             printf("undefined as yet - %d", error_code);
             break;
@@ -2240,6 +2652,10 @@ void DISPLAY_ALERT(SSL *ssl, int alert)
             printf("bad record mac");
             break;
 
+        case SSL_ALERT_RECORD_OVERFLOW:
+            printf("record overflow");
+            break;
+
         case SSL_ALERT_HANDSHAKE_FAILURE:
             printf("handshake failure");
             break;
@@ -2290,7 +2706,7 @@ EXP_FUNC void STDCALL ssl_display_error(int error_code) {}
 
 #ifdef CONFIG_BINDINGS
 #if !defined(CONFIG_SSL_ENABLE_CLIENT)
-EXP_FUNC SSL * STDCALL ssl_client_new(SSL_CTX *ssl_ctx, int client_fd, const
+EXP_FUNC SSL * STDCALL ssl_client_new(SSL *ssl, int client_fd, const
         uint8_t *session_id, uint8_t sess_id_size)
 {
     printf(unsupported_str);
@@ -48,9 +48,10 @@ extern "C" {
 #include "config.h"
 
 #define SSL_PROTOCOL_MIN_VERSION    0x31   /* TLS v1.0 */
-#define SSL_PROTOCOL_MINOR_VERSION  0x02   /* TLS v1.1 */
-#define SSL_PROTOCOL_VERSION_MAX    0x32   /* TLS v1.1 */
+#define SSL_PROTOCOL_MINOR_VERSION  0x03   /* TLS v1.2 */
+#define SSL_PROTOCOL_VERSION_MAX    0x33   /* TLS v1.2 */
 #define SSL_PROTOCOL_VERSION1_1     0x32   /* TLS v1.1 */
+#define SSL_PROTOCOL_VERSION1_2     0x33   /* TLS v1.2 */
 #define SSL_RANDOM_SIZE             32
 #define SSL_SECRET_SIZE             48
 #define SSL_FINISHED_HASH_SIZE      12
@@ -60,6 +61,13 @@ extern "C" {
 #define SSL_CLIENT_READ             2
 #define SSL_CLIENT_WRITE            3
 #define SSL_HS_HDR_SIZE             4
+#define SSL_AEAD_SALT_SIZE          4      /* implicit part of the nonce */
+#define SSL_AEAD_NONCE_SIZE         8      /* explicit part, in each record */
+#define SSL_MAX_VERIFY_DIGEST_SIZE  (19+SHA256_SIZE)    /* DigestInfo */
+
+/* TLS v1.2 SignatureAndHashAlgorithm used in certificate verify messages */
+#define SSL_SIG_HASH_SHA256         4
+#define SSL_SIG_RSA                 1
 
 /* the flags we use while establishing a connection */
 #define SSL_NEED_RECORD             0x0001
@@ -76,17 +84,41 @@ extern "C" {
 #define IS_SET_SSL_FLAG(A)          (ssl->flag & A)
 
 #define MAX_KEY_BYTE_SIZE           512     /* for a 4096 bit key */
-#define RT_MAX_PLAIN_LENGTH         2048//16384
+#define RT_MAX_PLAIN_LENGTH         CONFIG_SSL_RECORD_BUFFER_SIZE
+/* the MAC and padding of AES-CBC, or the tag of AES-GCM, which follow the
+   plaintext of a record read into bm_all_data, when it is padded no more 
+   than it needs to be */
+#define RT_MAX_TRAILER              (SHA1_SIZE+AES_BLOCKSIZE)
 #define RT_EXTRA                    512//1024
 #define BM_RECORD_OFFSET            5
 #define BM_ALL_DATA_SIZE            (RT_MAX_PLAIN_LENGTH+RT_EXTRA-BM_RECORD_OFFSET)
 
+/* the most plaintext in a record we send, leaving room in bm_data for the 
+   explicit IV, MAC and padding of AES-CBC or the nonce and tag of AES-GCM */
+#define RT_MAX_WRITE_LENGTH         (RT_MAX_PLAIN_LENGTH-BM_RECORD_OFFSET-\
+                                        (16+SHA1_SIZE+16))
+
+/* the max_fragment_length extension of RFC 6066, with which a client asks
+   for records of no more than 2^(8+n) bytes of plaintext, for n of 1 to 4 */
+#define SSL_EXT_MAX_FRAGMENT_LENGTH 1
+#define SSL_MAX_FRAGMENT_CODE       4
+
+/* a full size record, with the MAC and padding after it, as read into 
+   bm_big_data from a server which ignores max_fragment_length */
+#define RT_MAX_FULL_RECORD          (16384+RT_MAX_TRAILER)
+
+/* the plaintext MAC'd and then encrypted at a time as a record is sent */
+#define RT_SLICE_LENGTH             256
+
 #ifdef CONFIG_SSL_SKELETON_MODE
 #define NUM_PROTOCOLS               1
 #else
-#define NUM_PROTOCOLS               4
+#define NUM_PROTOCOLS               5
 #endif
 
+/* AEAD ciphers have no HMAC, and can only be used from TLS v1.2 */
+#define IS_AEAD_CIPHER(A)           ((A) == SSL_AES128_GCM_SHA256)
+
 #define PARANOIA_CHECK(A, B)        if (A < B) { \
     ret = SSL_ERROR_INVALID_HANDSHAKE; goto error; }
 
@@ -122,11 +154,18 @@ typedef struct
     uint8_t key_block_size;
     uint8_t padding_size;
     uint8_t digest_size;
-    hmac_func hmac;
+    const HASH_INFO *hmac;      /* NULL for AEAD ciphers */
     crypt_func encrypt;
     crypt_func decrypt;
 } cipher_info_t;
 
+/* the encrypt_ctx/decrypt_ctx of an AEAD cipher */
+typedef struct
+{
+    AES_GCM_CTX gcm;
+    uint8_t salt[SSL_AEAD_SALT_SIZE];
+} AEAD_CTX;
+
 struct _SSLObjLoader 
 {
     uint8_t *buf;
@@ -152,6 +191,7 @@ typedef struct
 {
     MD5_CTX md5_ctx;
     SHA1_CTX sha1_ctx;
+    SHA256_CTX sha256_ctx;      /* for TLS v1.2 */
     uint8_t final_finish_mac[SSL_FINISHED_HASH_SIZE];
     uint8_t key_block[MAX_KEYBLOCK_SIZE];
     uint8_t master_secret[SSL_SECRET_SIZE];
@@ -178,7 +218,8 @@ struct _SSL
     const cipher_info_t *cipher_info;
     void *encrypt_ctx;
     void *decrypt_ctx;
-    uint8_t bm_all_data[RT_MAX_PLAIN_LENGTH];
+    uint8_t bm_all_data[RT_MAX_PLAIN_LENGTH+RT_MAX_TRAILER];
+    uint8_t *bm_big_data;   /* records larger than bm_all_data, or NULL */
     uint8_t *bm_data;
     uint16_t bm_index;
     uint16_t bm_read_index;
@@ -251,7 +292,7 @@ int basic_decrypt(SSL *ssl, uint8_t *buf, int len);
 int process_data(SSL* ssl, uint8_t *in_data, int len);
 int ssl_read(SSL *ssl, uint8_t *in_data, int len);
 int send_change_cipher_spec(SSL *ssl);
-void finished_digest(SSL *ssl, const char *label, uint8_t *digest);
+int finished_digest(SSL *ssl, const char *label, uint8_t *digest);
 void generate_master_secret(SSL *ssl, const uint8_t *premaster_secret);
 void add_packet(SSL *ssl, const uint8_t *pkt, int len);
 int add_cert(SSL_CTX *ssl_ctx, const uint8_t *buf, int len);
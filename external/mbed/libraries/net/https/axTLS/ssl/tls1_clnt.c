@@ -166,6 +166,25 @@ int do_client_connect(SSL *ssl)
     return ret;
 }
 
+/*
+ * The max_fragment_length to ask the server for, so that its records fit in
+ * bm_all_data, or 0 when they always do.
+ */
+static int max_fragment_code(void)
+{
+    int code;
+
+    if (RT_MAX_PLAIN_LENGTH >= 16384)
+        return 0;
+
+    for (code = SSL_MAX_FRAGMENT_CODE; code > 1; code--)
+    {
+        if ((256 << code) <= RT_MAX_PLAIN_LENGTH)
+            break;
+    }
+    return code;
+}
+
 static int compute_size_send_client_hello(SSL *ssl)
 {
     int size = 6 + SSL_RANDOM_SIZE;
@@ -180,6 +199,8 @@ static int compute_size_send_client_hello(SSL *ssl)
     for (i = 0; i < NUM_PROTOCOLS; i++)
         size += 2;
     size += 2;
+    if (max_fragment_code())
+        size += 7;
     return size+BM_RECORD_OFFSET;
 }
 
@@ -235,11 +256,71 @@ static int send_client_hello(SSL *ssl)
 
     buf[offset++] = 1;              /* no compression */
     buf[offset++] = 0;
+
+    /* ask for records which fit in bm_all_data */
+    if ((i = max_fragment_code()))
+    {
+        buf[offset++] = 0;          /* extensions length */
+        buf[offset++] = 5;
+        buf[offset++] = 0;
+        buf[offset++] = SSL_EXT_MAX_FRAGMENT_LENGTH;
+        buf[offset++] = 0;          /* extension data length */
+        buf[offset++] = 1;
+        buf[offset++] = i;
+    }
+
     buf[3] = offset - 4;            /* handshake size */
 
     return send_packet(ssl, PT_HANDSHAKE_PROTOCOL, NULL, offset);
 }
 
+/*
+ * Look through the server hello extensions, which take the len bytes at buf,
+ * for the echo of our max_fragment_length.  A server which leaves it out 
+ * sends records of up to 16kB, so those are read into bm_big_data from then
+ * on, or the handshake fails when there isn't the memory for it.
+ */
+static int process_server_extensions(SSL *ssl, const uint8_t *buf, int len)
+{
+    int code = max_fragment_code();
+    int echoed = 0;
+    int offset = 2;
+
+    if (len >= 2)
+    {
+        len = ((buf[0] << 8) + buf[1]) + 2;
+        while (offset + 4 <= len)
+        {
+            int ext_type = (buf[offset] << 8) + buf[offset+1];
+            int ext_len = (buf[offset+2] << 8) + buf[offset+3];
+
+            offset += 4;
+            if (offset + ext_len > len)
+                break;
+
+            if (ext_type == SSL_EXT_MAX_FRAGMENT_LENGTH)
+            {
+                /* the server may only agree to what we asked for */
+                if (ext_len != 1 || buf[offset] != code)
+                    return SSL_ERROR_INVALID_HANDSHAKE;
+
+                echoed = 1;
+            }
+
+            offset += ext_len;
+        }
+
+        if (offset != len)
+            return SSL_ERROR_INVALID_HANDSHAKE;
+    }
+
+    if (code == 0 || echoed || ssl->bm_big_data)
+        return SSL_OK;
+
+    ssl->bm_big_data = (uint8_t *)malloc(RT_MAX_FULL_RECORD);
+    return ssl->bm_big_data ? SSL_OK : SSL_ERROR_FRAGMENT_LENGTH_IGNORED;
+}
+
 /*
  * Process the server hello.
  */
@@ -297,6 +378,12 @@ static int process_server_hello(SSL *ssl)
 
     /* get the real cipher we are using */
     ssl->cipher = buf[++offset];
+
+    if (IS_AEAD_CIPHER(ssl->cipher) && ssl->version < SSL_PROTOCOL_VERSION1_2)
+    {
+        ret = SSL_ERROR_NO_CIPHER;
+        goto error;
+    }
     ssl->next_state = IS_SET_SSL_FLAG(SSL_SESSION_RESUME) ? 
                                         HS_FINISHED : HS_CERTIFICATE;
 
@@ -304,6 +391,15 @@ static int process_server_hello(SSL *ssl)
     PARANOIA_CHECK(pkt_size, offset);
     ssl->dc->bm_proc_index = offset+1; 
 
+    /* the extensions, if any, follow up to the end of the message */
+    ret = process_server_extensions(ssl, &buf[offset+1], 
+                                pkt_size-SSL_HS_HDR_SIZE-(offset+1));
+    if (ret == SSL_ERROR_FRAGMENT_LENGTH_IGNORED)
+    {
+        ssl_display_error(ret);
+        send_alert(ssl, ret);
+    }
+
 error:
     return ret;
 }
@@ -330,7 +426,7 @@ static int send_client_key_xchg(SSL *ssl)
     buf[1] = 0;
 
     premaster_secret[0] = 0x03; /* encode the version number */
-    premaster_secret[1] = SSL_PROTOCOL_MINOR_VERSION; /* must be TLS 1.1 */
+    premaster_secret[1] = SSL_PROTOCOL_MINOR_VERSION; /* as in client hello */
     get_random(SSL_SECRET_SIZE-2, &premaster_secret[2]);
     DISPLAY_RSA(ssl, ssl->x509_ctx->rsa_ctx);
 
@@ -375,22 +471,29 @@ error:
 static int send_cert_verify(SSL *ssl)
 {
     uint8_t *buf = ssl->bm_data;
-    uint8_t dgst[MD5_SIZE+SHA1_SIZE];
+    uint8_t dgst[SSL_MAX_VERIFY_DIGEST_SIZE];
     RSA_CTX *rsa_ctx = ssl->ssl_ctx->rsa_ctx;
-    int n = 0, ret;
+    int n = 0, ret, dgst_len, offset = 4;
 
     DISPLAY_RSA(ssl, rsa_ctx);
 
     buf[0] = HS_CERT_VERIFY;
     buf[1] = 0;
 
-    finished_digest(ssl, NULL, dgst);   /* calculate the digest */
+    /* TLS v1.2 says how the digest is signed */
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        buf[offset++] = SSL_SIG_HASH_SHA256;
+        buf[offset++] = SSL_SIG_RSA;
+    }
+
+    dgst_len = finished_digest(ssl, NULL, dgst);   /* calculate the digest */
 
     /* rsa_ctx->bi_ctx is not thread-safe */
     if (rsa_ctx)
     {
         SSL_CTX_LOCK(ssl->ssl_ctx->mutex);
-        n = RSA_encrypt(rsa_ctx, dgst, sizeof(dgst), &buf[6], 1);
+        n = RSA_encrypt(rsa_ctx, dgst, dgst_len, &buf[offset+2], 1);
         SSL_CTX_UNLOCK(ssl->ssl_ctx->mutex);
 
         if (n == 0)
@@ -400,9 +503,9 @@ static int send_cert_verify(SSL *ssl)
         }
     }
     
-    buf[4] = n >> 8;        /* add the RSA size (not officially documented) */
-    buf[5] = n & 0xff;
-    n += 2;
+    buf[offset] = n >> 8;   /* add the RSA size (not officially documented) */
+    buf[offset+1] = n & 0xff;
+    n += offset - 2;
     buf[2] = n >> 8;
     buf[3] = n & 0xff;
     ret = send_packet(ssl, PT_HANDSHAKE_PROTOCOL, NULL, n+4);
@@ -49,15 +49,13 @@ static int process_cert_verify(SSL *ssl);
 /*
  * Establish a new SSL connection to an SSL client.
  */
-EXP_FUNC SSL * STDCALL ssl_server_new(SSL_CTX *ssl_ctx, int client_fd)
+EXP_FUNC SSL * STDCALL ssl_server_new(SSL *ssl, int client_fd)
 {
-    SSL *ssl;
-
-    ssl = ssl_new(ssl_ctx, client_fd);
+    ssl_new(ssl, client_fd);
     ssl->next_state = HS_CLIENT_HELLO;
 
 #ifdef CONFIG_SSL_FULL_MODE
-    if (ssl_ctx->chain_length == 0)
+    if (ssl->ssl_ctx->chain_length == 0)
         printf("Warning - no server certificate defined\n"); TTY_FLUSH();
 #endif
 
@@ -163,7 +161,9 @@ static int process_client_hello(SSL *ssl)
     {
         for (j = 0; j < NUM_PROTOCOLS; j++)
         {
-            if (ssl_prot_prefs[j] == buf[offset+i])   /* got a match? */
+            if (ssl_prot_prefs[j] == buf[offset+i] &&   /* got a match? */
+                    (!IS_AEAD_CIPHER(ssl_prot_prefs[j]) ||
+                        ssl->version >= SSL_PROTOCOL_VERSION1_2))
             {
                 ssl->cipher = ssl_prot_prefs[j];
                 goto do_state;
@@ -212,7 +212,9 @@ int process_sslv23_client_hello(SSL *ssl)
     {
         for (i = 0; i < cs_len; i += 3)
         {
-            if (ssl_prot_prefs[j] == buf[offset+i])
+            if (ssl_prot_prefs[j] == buf[offset+i] &&
+                    (!IS_AEAD_CIPHER(ssl_prot_prefs[j]) ||
+                        ssl->version >= SSL_PROTOCOL_VERSION1_2))
             {
                 ssl->cipher = ssl_prot_prefs[j];
                 goto server_hello;
@@ -426,11 +428,21 @@ error:
 #ifdef CONFIG_SSL_CERT_VERIFICATION
 static const uint8_t g_cert_request[] = { HS_CERT_REQ, 0, 0, 4, 1, 0, 0, 0 };
 
+/* TLS v1.2 also lists the signature algorithms, only RSA with SHA256 here */
+static const uint8_t g_cert_request_v1_2[] = { HS_CERT_REQ, 0, 0, 8, 1, 1, 
+                        0, 2, SSL_SIG_HASH_SHA256, SSL_SIG_RSA, 0, 0 };
+
 /*
  * Send the certificate request message.
  */
 static int send_certificate_request(SSL *ssl)
 {
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        return send_packet(ssl, PT_HANDSHAKE_PROTOCOL, 
+                g_cert_request_v1_2, sizeof(g_cert_request_v1_2));
+    }
+
     return send_packet(ssl, PT_HANDSHAKE_PROTOCOL, 
             g_cert_request, sizeof(g_cert_request));
 }
@@ -444,27 +456,39 @@ static int process_cert_verify(SSL *ssl)
     uint8_t *buf = &ssl->bm_data[ssl->dc->bm_proc_index];
     int pkt_size = ssl->bm_index;
     uint8_t dgst_buf[MAX_KEY_BYTE_SIZE];
-    uint8_t dgst[MD5_SIZE+SHA1_SIZE];
+    uint8_t dgst[SSL_MAX_VERIFY_DIGEST_SIZE];
     X509_CTX *x509_ctx = ssl->x509_ctx;
     int ret = SSL_OK;
-    int n;
+    int n, dgst_len, offset = 6;
+
+    /* TLS v1.2 says how the digest was signed, which must be as we asked */
+    if (ssl->version >= SSL_PROTOCOL_VERSION1_2)
+    {
+        if (buf[4] != SSL_SIG_HASH_SHA256 || buf[5] != SSL_SIG_RSA)
+        {
+            ret = SSL_ERROR_INVALID_KEY;
+            goto end_cert_vfy;
+        }
+
+        offset += 2;
+    }
 
-    PARANOIA_CHECK(pkt_size, x509_ctx->rsa_ctx->num_octets+6);
+    PARANOIA_CHECK(pkt_size, x509_ctx->rsa_ctx->num_octets+offset);
     DISPLAY_RSA(ssl, x509_ctx->rsa_ctx);
 
     /* rsa_ctx->bi_ctx is not thread-safe */
     SSL_CTX_LOCK(ssl->ssl_ctx->mutex);
-    n = RSA_decrypt(x509_ctx->rsa_ctx, &buf[6], dgst_buf, 0);
+    n = RSA_decrypt(x509_ctx->rsa_ctx, &buf[offset], dgst_buf, 0);
     SSL_CTX_UNLOCK(ssl->ssl_ctx->mutex);
 
-    if (n != SHA1_SIZE + MD5_SIZE)
+    dgst_len = finished_digest(ssl, NULL, dgst);    /* calculate the digest */
+    if (n != dgst_len)
     {
         ret = SSL_ERROR_INVALID_KEY;
         goto end_cert_vfy;
     }
 
-    finished_digest(ssl, NULL, dgst);       /* calculate the digest */
-    if (memcmp(dgst_buf, dgst, MD5_SIZE + SHA1_SIZE))
+    if (memcmp(dgst_buf, dgst, dgst_len))
     {
         ret = SSL_ERROR_INVALID_KEY;
     }
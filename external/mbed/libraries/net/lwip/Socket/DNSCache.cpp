@@ -0,0 +1,329 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "Socket/DNSCache.h"
+#include "lwip/api.h"
+#include "lwip/dns.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include <cstring>
+#include <strings.h>
+
+enum {
+    ENTRY_UNUSED,
+    ENTRY_PENDING,      // Waiting for the DNS server.
+    ENTRY_FOUND,
+    ENTRY_FAILED
+};
+
+enum LookupResult {
+    LOOKUP_FOUND,
+    LOOKUP_FAILED,
+    LOOKUP_PENDING,     // request will be called with the answer.
+    LOOKUP_MISSED       // Not cached and no request to wait for the answer.
+};
+
+struct DNSCacheEntry {
+    char name[DNS_CACHE_NAME_LENGTH];
+    ip_addr_t address;
+    u32_t expires;          // sys_now() when a FOUND or FAILED entry goes stale.
+    u32_t started;          // sys_now() when the query of a PENDING entry was made.
+    DNSRequest* waiters;
+    u8_t state;
+    u8_t queued;            // PENDING but waiting for room in lwIP's table.
+};
+
+// Answer handed to the thread blocked in DNSCache::resolve().
+struct BlockingLookup {
+    sys_sem_t done;
+    ip_addr_t address;
+    bool found;
+};
+
+static DNSCacheEntry entries[DNS_CACHE_SIZE];
+static DNSCacheStats stats;
+
+// Queries that lwIP's resolver is working on.  Only used in the tcpip thread.
+static int queries_in_flight;
+
+static bool is_stale(const DNSCacheEntry* entry, u32_t now) {
+    return (s32_t)(now - entry->expires) >= 0;
+}
+
+// Records the answer to the query of a PENDING entry and passes it on to
+// each of the lookups waiting for it.  A failure is only cached when ttl
+// isn't 0, so that errors which weren't answers from the DNS server, such as
+// running out of memory, are retried by the next lookup.
+static void complete(DNSCacheEntry* entry, const ip_addr_t* address, u32_t ttl) {
+    u32_t now = sys_now();
+    ip_addr_t answer;
+    DNSRequest* waiters;
+    SYS_ARCH_DECL_PROTECT(level);
+    
+    if (ttl > DNS_CACHE_MAX_TTL)
+        ttl = DNS_CACHE_MAX_TTL;
+    if (address != NULL)
+        ip_addr_copy(answer, *address);
+    
+    SYS_ARCH_PROTECT(level);
+    u32_t elapsed = now - entry->started;
+    stats.query_ms_total += elapsed;
+    if (elapsed > stats.query_ms_max)
+        stats.query_ms_max = elapsed;
+    if (address != NULL) {
+        ip_addr_copy(entry->address, answer);
+        entry->state = ENTRY_FOUND;
+    } else {
+        stats.failures++;
+        entry->state = ttl ? ENTRY_FAILED : ENTRY_UNUSED;
+    }
+    entry->expires = now + ttl * 1000;
+    waiters = entry->waiters;
+    entry->waiters = NULL;
+    SYS_ARCH_UNPROTECT(level);
+    
+    // The next pointer is read first as the callback may reuse its request.
+    while (waiters != NULL) {
+        DNSRequest* next = waiters->next;
+        waiters->callback(address ? &answer : NULL, waiters->arg);
+        waiters = next;
+    }
+}
+
+static void start_query(void* arg);
+
+static void start_queued_query(void* arg) {
+    DNSCacheEntry* queued = NULL;
+    SYS_ARCH_DECL_PROTECT(level);
+    
+    SYS_ARCH_PROTECT(level);
+    for (int i = 0; i < DNS_CACHE_SIZE && queued == NULL; i++) {
+        if (entries[i].state == ENTRY_PENDING && entries[i].queued)
+            queued = &entries[i];
+    }
+    SYS_ARCH_UNPROTECT(level);
+    
+    if (queued != NULL)
+        start_query(queued);
+}
+
+static void query_done(const char *name, ip_addr_t *address, void *arg) {
+    u32_t ttl;
+    
+    queries_in_flight--;
+    if (address != NULL)
+        ttl = dns_lookup_ttl(name);
+    else
+        ttl = dns_failure_is_final(name) ? DNS_CACHE_NEGATIVE_TTL : 0;
+    complete((DNSCacheEntry*)arg, address, ttl);
+    
+    // lwIP only frees the entry of a failed query once this returns, so a
+    // queued query is started from the next message to the tcpip thread.
+    // Should the mailbox be full, the queued queries fail instead of waiting
+    // for an answer which may never come.
+    if (tcpip_callback_with_block(start_queued_query, NULL, 0) != ERR_OK) {
+        for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+            if (entries[i].state == ENTRY_PENDING && entries[i].queued)
+                complete(&entries[i], NULL, 0);
+        }
+    }
+}
+
+// Runs in the tcpip thread, which is the only one allowed to call into
+// lwIP's resolver.
+static void start_query(void* arg) {
+    DNSCacheEntry* entry = (DNSCacheEntry*)arg;
+    ip_addr_t address;
+    
+    entry->queued = 0;
+    switch (dns_gethostbyname(entry->name, &address, query_done, entry)) {
+        case ERR_OK:
+            // Still in lwIP's own table.
+            complete(entry, &address, dns_lookup_ttl(entry->name));
+            break;
+        case ERR_INPROGRESS:
+            queries_in_flight++;
+            break;
+        case ERR_MEM:
+            // lwIP's table is full of queries.  Wait for one of ours to be
+            // answered, unless they all belong to someone else.
+            if (queries_in_flight > 0) {
+                entry->queued = 1;
+                break;
+            }
+            complete(entry, NULL, 0);
+            break;
+        default:
+            complete(entry, NULL, 0);
+            break;
+    }
+}
+
+// Looks host up in the cache.  When it isn't there, request joins the query
+// for host that is already waiting for the DNS server or makes a new one,
+// unless request is NULL.
+static int lookup(const char* host, ip_addr_t* address, DNSRequest* request) {
+    u32_t now = sys_now();
+    DNSCacheEntry* entry = NULL;
+    DNSCacheEntry* victim = NULL;
+    bool start = false;
+    int result;
+    SYS_ARCH_DECL_PROTECT(level);
+    
+    SYS_ARCH_PROTECT(level);
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        DNSCacheEntry* e = &entries[i];
+        if (e->state == ENTRY_UNUSED) {
+            if (victim == NULL || victim->state != ENTRY_UNUSED)
+                victim = e;
+        } else if (strcasecmp(e->name, host) == 0) {
+            entry = e;
+            break;
+        } else if (e->state != ENTRY_PENDING) {
+            // Otherwise replace the entry which goes stale first.
+            if (victim == NULL || (victim->state != ENTRY_UNUSED && (s32_t)(e->expires - victim->expires) < 0))
+                victim = e;
+        }
+    }
+    
+    if (entry != NULL && entry->state == ENTRY_PENDING) {
+        result = LOOKUP_PENDING;
+        if (request != NULL) {
+            request->next = entry->waiters;
+            entry->waiters = request;
+            stats.coalesced++;
+        }
+    } else if (entry != NULL && !is_stale(entry, now)) {
+        if (entry->state == ENTRY_FOUND) {
+            ip_addr_copy(*address, entry->address);
+            result = LOOKUP_FOUND;
+            stats.hits++;
+        } else {
+            result = LOOKUP_FAILED;
+            stats.negative_hits++;
+        }
+    } else if (request == NULL) {
+        result = LOOKUP_MISSED;
+    } else {
+        if (entry == NULL)
+            entry = victim;
+        if (entry == NULL) {
+            // Every entry is waiting for the DNS server.
+            result = LOOKUP_FAILED;
+            stats.failures++;
+        } else {
+            std::strcpy(entry->name, host);
+            entry->state = ENTRY_PENDING;
+            entry->queued = 0;
+            entry->started = now;
+            request->next = NULL;
+            entry->waiters = request;
+            result = LOOKUP_PENDING;
+            start = true;
+            stats.queries++;
+        }
+    }
+    // A miss is counted by the lookup which follows it with a request.
+    if (result != LOOKUP_MISSED && (result != LOOKUP_PENDING || request != NULL))
+        stats.lookups++;
+    SYS_ARCH_UNPROTECT(level);
+    
+    if (start && tcpip_callback(start_query, entry) != ERR_OK)
+        complete(entry, NULL, 0);
+    return result;
+}
+
+static void blocking_done(const ip_addr_t* address, void* arg) {
+    BlockingLookup* blocking = (BlockingLookup*)arg;
+    
+    blocking->found = (address != NULL);
+    if (address != NULL)
+        ip_addr_copy(blocking->address, *address);
+    sys_sem_signal(&blocking->done);
+}
+
+int DNSCache::resolve(const char* host, ip_addr_t* address) {
+    if (ipaddr_aton(host, address))
+        return 0;
+    if (std::strlen(host) >= DNS_CACHE_NAME_LENGTH)
+        return (netconn_gethostbyname(host, address) == ERR_OK) ? 0 : -1;
+    
+    // Only make a semaphore to wait on when the answer isn't cached.
+    int result = lookup(host, address, NULL);
+    if (result == LOOKUP_FOUND)
+        return 0;
+    if (result == LOOKUP_FAILED)
+        return -1;
+    
+    BlockingLookup blocking;
+    DNSRequest request;
+    if (sys_sem_new(&blocking.done, 0) != ERR_OK)
+        return -1;
+    request.callback = blocking_done;
+    request.arg = &blocking;
+    result = lookup(host, address, &request);
+    if (result == LOOKUP_PENDING) {
+        sys_arch_sem_wait(&blocking.done, 0);
+        if (blocking.found)
+            ip_addr_copy(*address, blocking.address);
+        result = blocking.found ? LOOKUP_FOUND : LOOKUP_FAILED;
+    }
+    sys_sem_free(&blocking.done);
+    
+    return (result == LOOKUP_FOUND) ? 0 : -1;
+}
+
+bool DNSCache::resolve_async(const char* host, DNSRequest* request, DNSCallback callback, void* arg) {
+    ip_addr_t address;
+    int result;
+    
+    request->callback = callback;
+    request->arg = arg;
+    request->next = NULL;
+    if (ipaddr_aton(host, &address))
+        result = LOOKUP_FOUND;
+    else if (std::strlen(host) >= DNS_CACHE_NAME_LENGTH)
+        result = LOOKUP_FAILED;
+    else
+        result = lookup(host, &address, request);
+    if (result == LOOKUP_PENDING)
+        return false;
+    
+    callback((result == LOOKUP_FOUND) ? &address : NULL, arg);
+    return true;
+}
+
+void DNSCache::flush(void) {
+    SYS_ARCH_DECL_PROTECT(level);
+    
+    SYS_ARCH_PROTECT(level);
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (entries[i].state != ENTRY_PENDING)
+            entries[i].state = ENTRY_UNUSED;
+    }
+    SYS_ARCH_UNPROTECT(level);
+}
+
+void DNSCache::get_stats(DNSCacheStats* copy, bool reset) {
+    SYS_ARCH_DECL_PROTECT(level);
+    
+    SYS_ARCH_PROTECT(level);
+    *copy = stats;
+    if (reset)
+        std::memset(&stats, 0, sizeof(stats));
+    SYS_ARCH_UNPROTECT(level);
+}
@@ -0,0 +1,114 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef DNSCACHE_H
+#define DNSCACHE_H
+
+#include "lwip/ip_addr.h"
+
+/** Number of host names whose address, or failure to resolve, is cached.
+*/
+#ifndef DNS_CACHE_SIZE
+#define DNS_CACHE_SIZE 8
+#endif
+
+/** Size of the buffer for a cached host name.  Longer names are looked up by
+    lwIP each time.
+*/
+#ifndef DNS_CACHE_NAME_LENGTH
+#define DNS_CACHE_NAME_LENGTH 64
+#endif
+
+/** Seconds that a host name which couldn't be resolved is remembered for, so
+    that retries don't each wait for the DNS server.
+*/
+#ifndef DNS_CACHE_NEGATIVE_TTL
+#define DNS_CACHE_NEGATIVE_TTL 10
+#endif
+
+/** Most seconds that an address is cached for, whatever the TTL of its record.
+*/
+#ifndef DNS_CACHE_MAX_TTL
+#define DNS_CACHE_MAX_TTL 3600
+#endif
+
+/** Called with the address of a host, or NULL when it couldn't be resolved.
+*/
+typedef void (*DNSCallback)(const ip_addr_t* address, void* arg);
+
+/** A lookup waiting for an answer, which is owned by the caller of
+    DNSCache::resolve_async() and filled in by it.
+*/
+struct DNSRequest {
+    DNSCallback callback;
+    void* arg;
+    DNSRequest* next;
+};
+
+/** Counters kept by DNSCache
+*/
+struct DNSCacheStats {
+    unsigned int lookups;           ///< Calls to resolve() and resolve_async() for host names.
+    unsigned int hits;              ///< Lookups answered with a cached address.
+    unsigned int negative_hits;     ///< Lookups answered with a cached failure.
+    unsigned int coalesced;         ///< Lookups which joined one already waiting for the DNS server.
+    unsigned int queries;           ///< Lookups passed on to lwIP's resolver.
+    unsigned int failures;          ///< Queries which didn't resolve the name.
+    unsigned int query_ms_total;    ///< Time taken by all of the queries.
+    unsigned int query_ms_max;      ///< Time taken by the slowest query.
+};
+
+/**
+Cache of host name lookups, above lwIP's resolver, shared by all of the
+sockets.  Addresses are kept for the TTL of their DNS record and failures for
+DNS_CACHE_NEGATIVE_TTL.  Lookups of a name which is already being resolved
+wait for the same answer rather than sending their own query.
+*/
+class DNSCache {
+public:
+    /** Resolve a host name, blocking the calling thread until it is
+    \param host The host name, or an IP address in dot-decimal notation.
+    \param address Where to store the address of the host.
+    \return 0 on success, -1 when the host name couldn't be resolved.
+    */
+    static int resolve(const char* host, ip_addr_t* address);
+
+    /** Resolve a host name without blocking
+    The callback is called once, from this call when the answer is cached and
+    otherwise from lwIP's tcpip thread, where it must not block.  Names longer
+    than DNS_CACHE_NAME_LENGTH can't be resolved this way.
+    \param host The host name, or an IP address in dot-decimal notation.
+    \param request Storage for the lookup, which must stay valid until the
+    callback is called.
+    \param callback Called with the address of the host, or NULL on failure.
+    \param arg Passed to callback.
+    \return true if the callback has already been called.
+    */
+    static bool resolve_async(const char* host, DNSRequest* request, DNSCallback callback, void* arg);
+
+    /** Forget all of the cached addresses and failures
+    */
+    static void flush(void);
+
+    /** Get the counters of the cache
+    \param stats Where to copy the counters.
+    \param reset Whether to zero them afterwards.
+    */
+    static void get_stats(DNSCacheStats* stats, bool reset = false);
+};
+
+#endif
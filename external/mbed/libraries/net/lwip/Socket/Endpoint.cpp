@@ -17,6 +17,7 @@
  */
 #include "Socket/Socket.h"
 #include "Socket/Endpoint.h"
+#include "Socket/DNSCache.h"
 #include <cstring>
 #include <cstdio>
 
@@ -44,12 +45,12 @@ int Endpoint::set_address(const char* host, const int port) {
         (unsigned int*)&address[0], (unsigned int*)&address[1],
         (unsigned int*)&address[2], (unsigned int*)&address[3]);
     
+    ip_addr_t host_address;
     if (result != 4) {
-        // Resolve address with DNS
-        struct hostent *host_address = lwip_gethostbyname(host);
-        if (host_address == NULL)
+        // Resolve address with DNS, or from the answer to an earlier lookup
+        if (DNSCache::resolve(host, &host_address) != 0)
             return -1; //Could not resolve address
-        p_address = (char*)host_address->h_addr_list[0];
+        p_address = (char*)&host_address.addr;
     }
     std::memcpy((char*)&_remoteHost.sin_addr.s_addr, p_address, 4);
     
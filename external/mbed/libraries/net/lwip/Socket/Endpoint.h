@@ -38,6 +38,8 @@ public:
     void reset_address(void);
     
     /** Set the address of this endpoint
+    Host names are resolved through DNSCache, so connecting to the same host
+    again doesn't wait for the DNS server while its address is cached.
     \param host The endpoint address (it can either be an IP Address or a hostname that will be resolved with DNS).
     \param port The endpoint port
     \return 0 on success, -1 on failure (when an hostname cannot be resolved by DNS).
@@ -68,9 +68,9 @@ public:
     /** Close the socket
         \param shutdown   free the left-over data in message queues
      */
-    int close(bool shutdown=true);
+    virtual int close(bool shutdown=true);
     
-    ~Socket();
+    virtual ~Socket();
     
 protected:
     int _sock_fd;
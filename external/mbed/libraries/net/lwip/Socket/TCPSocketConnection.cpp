@@ -16,13 +16,25 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #include "TCPSocketConnection.h"
+#include "FileHandle.h"
+#include "lwip/pbuf.h"
 #include <cstring>
 
 using std::memset;
 using std::memcpy;
 
+// send_file() reads whole sectors so that FAT reads go straight from the disk
+// into its buffer.  There is one chunk more than needed to fill the TCP send
+// buffer so that the next read overlaps the transmission of the others.
+#define SEND_FILE_CHUNK     2048
+#define SEND_FILE_CHUNKS    ((TCP_SND_BUF + SEND_FILE_CHUNK - 1) / SEND_FILE_CHUNK + 1)
+
 TCPSocketConnection::TCPSocketConnection() :
-        _is_connected(false) {
+        _is_connected(false), _file_buffer(NULL) {
+}
+
+TCPSocketConnection::~TCPSocketConnection() {
+    close();
 }
 
 int TCPSocketConnection::connect(const char* host, const int port) {
@@ -89,6 +101,77 @@ int TCPSocketConnection::send_all(char* data, int length) {
     return writtenLen;
 }
 
+// Waits until no more than limit bytes written to the socket are still waiting
+// to be acknowledged.  -1 if the connection failed, or if use_timeout is set
+// and the socket timeout expired first.
+int TCPSocketConnection::wait_unacked(u32_t limit, bool use_timeout) {
+    return lwip_wait_unacked(_sock_fd, limit, use_timeout ? (int)_timeout : -1);
+}
+
+// -1 if unsuccessful, else number of bytes sent
+int TCPSocketConnection::send_file(mbed::FileHandle* file, int length) {
+    if ((_sock_fd < 0) || !_is_connected || (file == NULL))
+        return -1;
+    
+    if (_file_buffer == NULL) {
+        // Allocated from the lwIP heap so that it is also DMA safe for the
+        // EMAC.  Make do with fewer chunks if the heap is short.
+        for (int chunks = SEND_FILE_CHUNKS ; chunks > 0 && _file_buffer == NULL ; chunks--)
+            _file_buffer = pbuf_alloc(PBUF_RAW, chunks * SEND_FILE_CHUNK, PBUF_RAM);
+        if (_file_buffer == NULL)
+            return -1;
+    } else {
+        // Still holding data from the last call.
+        if (wait_unacked(0, !_blocking) != 0)
+            return -1;
+    }
+    
+    char* chunks[SEND_FILE_CHUNKS];
+    int   ends[SEND_FILE_CHUNKS];
+    int   count = _file_buffer->len / SEND_FILE_CHUNK;
+    for (int i = 0 ; i < count ; i++) {
+        chunks[i] = (char*)_file_buffer->payload + i * SEND_FILE_CHUNK;
+        ends[i] = -1;
+    }
+    
+    int sentLen = 0;
+    TimeInterval timeout(_timeout);
+    for (int i = 0 ; (length < 0) || (sentLen < length) ; i = (i + 1) % count) {
+        // lwIP references the data sent from a chunk until it has been
+        // acknowledged.  Data is acknowledged in order so the chunk is free
+        // once no more than the data sent after it is outstanding.
+        if ((ends[i] >= 0) && (wait_unacked(sentLen - ends[i], !_blocking) != 0))
+            return (_is_connected) ? sentLen : -1;
+        
+        int chunk = SEND_FILE_CHUNK;
+        if ((length >= 0) && (length - sentLen < chunk))
+            chunk = length - sentLen;
+        ssize_t readLen = file->read(chunks[i], chunk);
+        if (readLen < 0)
+            return (sentLen > 0) ? sentLen : -1;
+        else if (readLen == 0)
+            break;
+        
+        if (!_blocking) {
+            // Wait for socket to be writeable
+            if (wait_writable(timeout) != 0)
+                return sentLen;
+        }
+        
+        int ret = lwip_send(_sock_fd, chunks[i], readLen, MSG_NOCOPY);
+        if (ret > 0) {
+            sentLen += ret;
+            ends[i] = sentLen;
+        } else if (ret == 0) {
+            _is_connected = false;
+            return sentLen;
+        } else {
+            return -1; //Connnection error
+        }
+    }
+    return sentLen;
+}
+
 int TCPSocketConnection::receive(char* data, int length) {
     if ((_sock_fd < 0) || !_is_connected)
         return -1;
@@ -131,3 +214,25 @@ int TCPSocketConnection::receive_all(char* data, int length) {
     }
     return readLen;
 }
+
+int TCPSocketConnection::close(bool shutdown) {
+    if (_file_buffer == NULL)
+        return Socket::close(shutdown);
+    
+    // lwIP may still reference the buffer.  Sending the FIN first gets the
+    // remote host to acknowledge everything right away instead of after its
+    // delayed ACK timeout.  If it hasn't within the socket timeout then the
+    // connection is reset, which has lwIP free the segments, rather than
+    // waiting for TCP to give up on them.
+    if (_sock_fd >= 0) {
+        lwip_shutdown(_sock_fd, SHUT_WR);
+        if (wait_unacked(0, true) != 0) {
+            struct linger linger = {1, 0};
+            lwip_setsockopt(_sock_fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+        }
+    }
+    int ret = Socket::close(shutdown);
+    pbuf_free(_file_buffer);
+    _file_buffer = NULL;
+    return ret;
+}
@@ -22,6 +22,11 @@
 #include "Socket/Socket.h"
 #include "Socket/Endpoint.h"
 
+namespace mbed {
+class FileHandle;
+}
+struct pbuf;
+
 /**
 TCP socket connection
 */
@@ -59,6 +64,18 @@ public:
     */
     int send_all(char* data, int length);
     
+    /** Send the contents of a file to the remote host.
+    The file is read straight into buffers that lwIP transmits in place, without
+    copying the data into the stack, and the next read overlaps the transmission
+    of the previous buffer.  The buffers are kept until close() so that the call
+    doesn't have to wait for the remote host to acknowledge the last of the data.
+    They come from the lwIP heap, which they share with the stack's packets.
+    \param file The file to send, from its current position.
+    \param length The number of bytes to send, or -1 to send up to the end of the file.
+    \return the number of sent bytes on success (>=0) or -1 on failure
+    */
+    int send_file(mbed::FileHandle* file, int length = -1);
+    
     /** Receive data from the remote host.
     \param data The buffer in which to store the data received from the host.
     \param length The maximum length of the buffer.
@@ -72,9 +89,21 @@ public:
     \return the number of received bytes on success (>=0) or -1 on failure
     */
     int receive_all(char* data, int length);
+    
+    /** Close the connection once the remote host has acknowledged the data
+        sent with send_file(), or reset it if that takes longer than the
+        socket timeout
+        \param shutdown   free the left-over data in message queues
+     */
+    int close(bool shutdown=true);
+    
+    ~TCPSocketConnection();
 
 private:
     bool _is_connected;
+    struct pbuf* _file_buffer;
+    
+    int wait_unacked(u32_t limit, bool use_timeout);
 
 };
 
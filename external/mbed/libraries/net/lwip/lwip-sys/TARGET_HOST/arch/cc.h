@@ -0,0 +1,86 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/* Compiler/platform definitions used when lwIP is built for the host (Linux
+   or OS X) instead of an mbed device.  This is the host counterpart of
+   lwip-sys/arch/cc.h and is only placed on the include path by
+   build/host.mk.
+*/
+#ifndef __CC_H__
+#define __CC_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <sys/time.h>
+
+/* Types based on stdint.h */
+typedef uint8_t            u8_t;
+typedef int8_t             s8_t;
+typedef uint16_t           u16_t;
+typedef int16_t            s16_t;
+typedef uint32_t           u32_t;
+typedef int32_t            s32_t;
+typedef uintptr_t          mem_ptr_t;
+
+/* Define (sn)printf formatters for these lwIP types */
+#define U16_F "hu"
+#define S16_F "hd"
+#define X16_F "hx"
+#define U32_F "u"
+#define S32_F "d"
+#define X32_F "x"
+#define SZT_F "zu"
+
+/* x86 and x86-64 hosts are little endian like the Cortex-M targets. */
+#ifndef BYTE_ORDER
+#define BYTE_ORDER LITTLE_ENDIAN
+#endif
+
+/* The host C library already provides errno values and struct timeval.  Only
+   the resolver error used by lwIP's netdb.c is missing. */
+#define LWIP_TIMEVAL_PRIVATE 0
+#define ENSRNOTFOUND         163
+
+#define PACK_STRUCT_BEGIN
+#define PACK_STRUCT_STRUCT __attribute__ ((__packed__))
+#define PACK_STRUCT_END
+#define PACK_STRUCT_FIELD(fld) fld
+#define ALIGNED(n)  __attribute__((aligned (n)))
+
+/* Use the same C checksum algorithm as non Thumb-2 targets. */
+#define LWIP_CHKSUM_ALGORITHM   3
+
+
+#ifdef LWIP_DEBUG
+
+#include <stdio.h>
+
+void assert_printf(char *msg, int line, char *file);
+
+/* Plaform specific diagnostic output */
+#define LWIP_PLATFORM_DIAG(vars) printf vars
+#define LWIP_PLATFORM_ASSERT(flag) { assert_printf((flag), __LINE__, __FILE__); }
+#else
+#define LWIP_PLATFORM_DIAG(msg) { ; }
+#define LWIP_PLATFORM_ASSERT(flag) { ; }
+#endif
+
+#define LWIP_PLATFORM_HTONS(x)      __builtin_bswap16(x)
+#define LWIP_PLATFORM_HTONL(x)      __builtin_bswap32(x)
+
+#endif /* __CC_H__ */
@@ -0,0 +1,502 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* lwIP includes. */
+#include "lwip/opt.h"
+#include "lwip/debug.h"
+#include "lwip/def.h"
+#include "lwip/sys.h"
+#include "lwip/mem.h"
+#include "arch/sys_arch.h"
+
+/* pthreads implementation of the lwip operating system abstraction.  Used
+   when running the networking stack on the host for testing and
+   benchmarking. */
+
+static void host_error(const char* pMessage) {
+    fprintf(stderr, "%s", pMessage);
+    abort();
+}
+
+static struct timespec deadline_from_now(u32_t timeout) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout / 1000;
+    ts.tv_nsec += (timeout % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_new
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Creates a new mailbox
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      int queue_sz            -- Size of elements in the mailbox
+ * Outputs:
+ *      err_t                   -- ERR_OK if message posted, else ERR_MEM
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_new(sys_mbox_t *mbox, int queue_sz) {
+    if (queue_sz > MB_SIZE)
+        host_error("sys_mbox_new size error\n");
+
+    memset(mbox->queue, 0, sizeof(mbox->queue));
+    mbox->queue_sz = queue_sz;
+    mbox->head = 0;
+    mbox->count = 0;
+    pthread_mutex_init(&mbox->lock, NULL);
+    pthread_cond_init(&mbox->not_empty, NULL);
+    pthread_cond_init(&mbox->not_full, NULL);
+    mbox->valid = 1;
+    return ERR_OK;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_free
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Deallocates a mailbox. If there are messages still present in the
+ *      mailbox when the mailbox is deallocated, it is an indication of a
+ *      programming error in lwIP and the developer should be notified.
+ * Inputs:
+ *      sys_mbox_t *mbox         -- Handle of mailbox
+ *---------------------------------------------------------------------------*/
+void sys_mbox_free(sys_mbox_t *mbox) {
+    if (mbox->count != 0)
+        host_error("sys_mbox_free error\n");
+    pthread_cond_destroy(&mbox->not_full);
+    pthread_cond_destroy(&mbox->not_empty);
+    pthread_mutex_destroy(&mbox->lock);
+}
+
+static void mbox_put_locked(sys_mbox_t *mbox, void *msg) {
+    mbox->queue[(mbox->head + mbox->count) % mbox->queue_sz] = msg;
+    mbox->count++;
+    pthread_cond_signal(&mbox->not_empty);
+}
+
+static void* mbox_get_locked(sys_mbox_t *mbox) {
+    void* msg = mbox->queue[mbox->head];
+
+    mbox->head = (mbox->head + 1) % mbox->queue_sz;
+    mbox->count--;
+    pthread_cond_signal(&mbox->not_full);
+    return msg;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_post
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Post the "msg" to the mailbox, blocking while it is full.
+ * Inputs:
+ *      sys_mbox_t mbox        -- Handle of mailbox
+ *      void *msg              -- Pointer to data to post
+ *---------------------------------------------------------------------------*/
+void sys_mbox_post(sys_mbox_t *mbox, void *msg) {
+    pthread_mutex_lock(&mbox->lock);
+    while (mbox->count >= mbox->queue_sz)
+        pthread_cond_wait(&mbox->not_full, &mbox->lock);
+    mbox_put_locked(mbox, msg);
+    pthread_mutex_unlock(&mbox->lock);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_mbox_trypost
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Try to post the "msg" to the mailbox.  Returns immediately with
+ *      error if cannot.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void *msg               -- Pointer to data to post
+ * Outputs:
+ *      err_t                   -- ERR_OK if message posted, else ERR_MEM
+ *                                  if not.
+ *---------------------------------------------------------------------------*/
+err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg) {
+    err_t result = ERR_MEM;
+
+    pthread_mutex_lock(&mbox->lock);
+    if (mbox->count < mbox->queue_sz) {
+        mbox_put_locked(mbox, msg);
+        result = ERR_OK;
+    }
+    pthread_mutex_unlock(&mbox->lock);
+    return result;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_fetch
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Blocks the thread until a message arrives in the mailbox, but does
+ *      not block the thread longer than "timeout" milliseconds (similar to
+ *      the sys_arch_sem_wait() function).  A timeout of 0 waits forever.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msg              -- Pointer to pointer to msg received
+ *      u32_t timeout           -- Number of milliseconds until timeout
+ * Outputs:
+ *      u32_t                   -- SYS_ARCH_TIMEOUT if timeout, else number
+ *                                  of milliseconds until received.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout) {
+    u32_t           start = sys_now();
+    struct timespec deadline = deadline_from_now(timeout);
+    void*           value;
+
+    pthread_mutex_lock(&mbox->lock);
+    while (mbox->count == 0) {
+        if (timeout == 0) {
+            pthread_cond_wait(&mbox->not_empty, &mbox->lock);
+        } else if (pthread_cond_timedwait(&mbox->not_empty, &mbox->lock, &deadline) == ETIMEDOUT &&
+                   mbox->count == 0) {
+            pthread_mutex_unlock(&mbox->lock);
+            return SYS_ARCH_TIMEOUT;
+        }
+    }
+    value = mbox_get_locked(mbox);
+    pthread_mutex_unlock(&mbox->lock);
+
+    if (msg)
+        *msg = value;
+    return sys_now() - start;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_tryfetch
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Similar to sys_arch_mbox_fetch, but if message is not ready
+ *      immediately, we'll return with SYS_MBOX_EMPTY.  On success, 0 is
+ *      returned.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ *      void **msg              -- Pointer to pointer to msg received
+ * Outputs:
+ *      u32_t                   -- SYS_MBOX_EMPTY if no messages.  Otherwise,
+ *                                  return ERR_OK.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg) {
+    void* value;
+
+    pthread_mutex_lock(&mbox->lock);
+    if (mbox->count == 0) {
+        pthread_mutex_unlock(&mbox->lock);
+        return SYS_MBOX_EMPTY;
+    }
+    value = mbox_get_locked(mbox);
+    pthread_mutex_unlock(&mbox->lock);
+
+    if (msg)
+        *msg = value;
+    return ERR_OK;
+}
+
+#if TCPIP_STATS
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_depth
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Returns the number of messages currently waiting in the mailbox.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ * Outputs:
+ *      u32_t                   -- Number of messages in the mailbox.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_depth(sys_mbox_t *mbox) {
+    u32_t count;
+
+    pthread_mutex_lock(&mbox->lock);
+    count = mbox->count;
+    pthread_mutex_unlock(&mbox->lock);
+    return count;
+}
+#endif
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_sem_new
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Creates and returns a new semaphore. The "count" argument specifies
+ *      the initial state of the semaphore.
+ * Inputs:
+ *      sys_sem_t sem         -- Handle of semaphore
+ *      u8_t count            -- Initial count of semaphore
+ * Outputs:
+ *      err_t                 -- ERR_OK if semaphore created
+ *---------------------------------------------------------------------------*/
+err_t sys_sem_new(sys_sem_t *sem, u8_t count) {
+    sem->count = count;
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->valid = 1;
+    return ERR_OK;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_sem_wait
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Blocks the thread while waiting for the semaphore to be signaled.  If
+ *      the "timeout" argument is non-zero, the thread should only be blocked
+ *      for the specified time (measured in milliseconds).
+ * Inputs:
+ *      sys_sem_t sem           -- Semaphore to wait on
+ *      u32_t timeout           -- Number of milliseconds until timeout
+ * Outputs:
+ *      u32_t                   -- Time elapsed or SYS_ARCH_TIMEOUT.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout) {
+    u32_t           start = sys_now();
+    struct timespec deadline = deadline_from_now(timeout);
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0) {
+        if (timeout == 0) {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        } else if (pthread_cond_timedwait(&sem->cond, &sem->lock, &deadline) == ETIMEDOUT &&
+                   sem->count == 0) {
+            pthread_mutex_unlock(&sem->lock);
+            return SYS_ARCH_TIMEOUT;
+        }
+    }
+    sem->count--;
+    pthread_mutex_unlock(&sem->lock);
+
+    return sys_now() - start;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_sem_signal
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Signals (releases) a semaphore
+ * Inputs:
+ *      sys_sem_t sem           -- Semaphore to signal
+ *---------------------------------------------------------------------------*/
+void sys_sem_signal(sys_sem_t *data) {
+    pthread_mutex_lock(&data->lock);
+    data->count++;
+    pthread_cond_signal(&data->cond);
+    pthread_mutex_unlock(&data->lock);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_sem_free
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Deallocates a semaphore
+ * Inputs:
+ *      sys_sem_t sem           -- Semaphore to free
+ *---------------------------------------------------------------------------*/
+void sys_sem_free(sys_sem_t *sem) {
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+}
+
+static void recursive_mutex_init(pthread_mutex_t* pMutex) {
+    pthread_mutexattr_t attr;
+
+    /* RTX mutexes may be taken recursively by their owner. */
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(pMutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/** Create a new mutex
+ * @param mutex pointer to the mutex to create
+ * @return a new mutex */
+err_t sys_mutex_new(sys_mutex_t *mutex) {
+    recursive_mutex_init(&mutex->id);
+    return ERR_OK;
+}
+
+/** Lock a mutex
+ * @param mutex the mutex to lock */
+void sys_mutex_lock(sys_mutex_t *mutex) {
+    if (pthread_mutex_lock(&mutex->id) != 0)
+        host_error("sys_mutex_lock error\n");
+}
+
+/** Unlock a mutex
+ * @param mutex the mutex to unlock */
+void sys_mutex_unlock(sys_mutex_t *mutex) {
+    if (pthread_mutex_unlock(&mutex->id) != 0)
+        host_error("sys_mutex_unlock error\n");
+}
+
+/** Delete a mutex
+ * @param mutex the mutex to delete */
+void sys_mutex_free(sys_mutex_t *mutex) {
+    pthread_mutex_destroy(&mutex->id);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_init
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Initialize sys arch
+ *---------------------------------------------------------------------------*/
+static pthread_mutex_t lwip_sys_mutex;
+static struct timespec sys_start_time;
+
+void sys_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &sys_start_time);
+    recursive_mutex_init(&lwip_sys_mutex);
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_jiffies
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Used by PPP as a timestamp-ish value
+ *---------------------------------------------------------------------------*/
+u32_t sys_jiffies(void) {
+    static u32_t jiffies = 0;
+    jiffies += 1 + (sys_now() / 10);
+    return jiffies;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_protect
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      "Fast" critical region protection.  Implemented with a recursive
+ *      mutex, just like the CMSIS-RTOS port.
+ * Outputs:
+ *      sys_prot_t              -- Previous protection level (not used here)
+ *---------------------------------------------------------------------------*/
+sys_prot_t sys_arch_protect(void) {
+    if (pthread_mutex_lock(&lwip_sys_mutex) != 0)
+        host_error("sys_arch_protect error\n");
+    return (sys_prot_t) 1;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_unprotect
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Leave the critical region entered with sys_arch_protect().
+ * Inputs:
+ *      sys_prot_t              -- Previous protection level (not used here)
+ *---------------------------------------------------------------------------*/
+void sys_arch_unprotect(sys_prot_t p) {
+    if (pthread_mutex_unlock(&lwip_sys_mutex) != 0)
+        host_error("sys_arch_unprotect error\n");
+}
+
+u32_t sys_now(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u32_t)((now.tv_sec - sys_start_time.tv_sec) * 1000 +
+                   (now.tv_nsec - sys_start_time.tv_nsec) / 1000000);
+}
+
+u32_t sys_arch_now_us(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u32_t)((now.tv_sec - sys_start_time.tv_sec) * 1000000 +
+                   (now.tv_nsec - sys_start_time.tv_nsec) / 1000);
+}
+
+void sys_msleep(u32_t ms) {
+    struct timespec delay;
+
+    delay.tv_sec = ms / 1000;
+    delay.tv_nsec = (ms % 1000) * 1000000;
+    nanosleep(&delay, NULL);
+}
+
+// Keep a pool of thread structures
+static int thread_pool_index = 0;
+static sys_thread_data_t thread_pool[SYS_THREAD_POOL_N];
+
+static void* thread_entry(void* pv) {
+    sys_thread_t t = (sys_thread_t)pv;
+    t->thread(t->arg);
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_thread_new
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Starts a new thread with priority "prio" that will begin its
+ *      execution in the function "thread()". The "arg" argument will be
+ *      passed as an argument to the thread() function.  The priority is
+ *      ignored on the host.
+ * Inputs:
+ *      char *name                -- Name of thread
+ *      void (*thread)(void *arg) -- Pointer to function to run.
+ *      void *arg                 -- Argument passed into function
+ *      int stacksize             -- Required stack amount in bytes
+ *      int priority              -- Thread priority
+ * Outputs:
+ *      sys_thread_t              -- Pointer to thread handle.
+ *---------------------------------------------------------------------------*/
+sys_thread_t sys_thread_new(const char *pcName,
+                            void (*thread)(void *arg),
+                            void *arg, int stacksize, int priority) {
+    LWIP_DEBUGF(SYS_DEBUG, ("New Thread: %s\n", pcName));
+
+    if (thread_pool_index >= SYS_THREAD_POOL_N)
+        host_error("sys_thread_new number error\n");
+    sys_thread_t t = (sys_thread_t)&thread_pool[thread_pool_index];
+    thread_pool_index++;
+
+    t->thread = thread;
+    t->arg = arg;
+    if (pthread_create(&t->id, NULL, thread_entry, t) != 0)
+        host_error("sys_thread_new create error\n");
+    pthread_detach(t->id);
+
+    return t;
+}
+
+#ifdef LWIP_DEBUG
+
+/** \brief  Displays an error message on assertion
+
+    This function will display an error message on an assertion
+    to the debug output.
+
+    \param[in]    msg   Error message to display
+    \param[in]    line  Line number in file with error
+    \param[in]    file  Filename with error
+ */
+void assert_printf(char *msg, int line, char *file) {
+    fprintf(stderr, "%s:%d in file %s\n", msg ? msg : "LWIP ASSERT", line, file);
+    abort();
+}
+
+#endif /* LWIP_DEBUG */
@@ -0,0 +1,92 @@
+/* Copyright (C) 2012 mbed.org, MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __ARCH_SYS_ARCH_H__
+#define __ARCH_SYS_ARCH_H__
+
+#include <pthread.h>
+#include "lwip/opt.h"
+
+/* Host (pthreads) implementation of the lwIP operating system abstraction.
+   It keeps the same limits as the CMSIS-RTOS version in lwip-sys/arch so that
+   mailbox overflows and thread pool exhaustion show up on the host exactly
+   where they would on the device. */
+
+// === SEMAPHORE ===
+typedef struct {
+    int             valid;
+    u32_t           count;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+} sys_sem_t;
+
+#define sys_sem_valid(x)        ((*x).valid)
+#define sys_sem_set_invalid(x)  ( (*x).valid = 0)
+
+// === MUTEX ===
+typedef struct {
+    pthread_mutex_t id;
+} sys_mutex_t;
+
+// === MAIL BOX ===
+#define MB_SIZE      8
+
+typedef struct {
+    int             valid;
+    int             queue_sz;
+    int             head;
+    int             count;
+    void*           queue[MB_SIZE];
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+} sys_mbox_t;
+
+#define SYS_MBOX_NULL               ((uint32_t) NULL)
+#define sys_mbox_valid(x)           ((*x).valid)
+#define sys_mbox_set_invalid(x)     ( (*x).valid = 0 )
+
+#if ((DEFAULT_RAW_RECVMBOX_SIZE) > (MB_SIZE)) || \
+    ((DEFAULT_UDP_RECVMBOX_SIZE) > (MB_SIZE)) || \
+    ((DEFAULT_TCP_RECVMBOX_SIZE) > (MB_SIZE)) || \
+    ((DEFAULT_ACCEPTMBOX_SIZE)   > (MB_SIZE)) || \
+    ((TCPIP_MBOX_SIZE)           > (MB_SIZE))
+#   error Mailbox size not supported
+#endif
+
+// === THREAD ===
+typedef struct {
+    pthread_t  id;
+    void     (*thread)(void *arg);
+    void*      arg;
+} sys_thread_data_t;
+typedef sys_thread_data_t* sys_thread_t;
+
+#define SYS_THREAD_POOL_N                   6
+
+// === PROTECTION ===
+typedef int sys_prot_t;
+
+// Atomic like the CMSIS-RTOS version, where these are updated from interrupts
+#define SYS_ARCH_INC(var, val) ((void)__sync_fetch_and_add(&(var), (val)))
+#define SYS_ARCH_DEC(var, val) ((void)__sync_fetch_and_sub(&(var), (val)))
+
+// === STATISTICS ===
+// Microsecond timestamp used by TCPIP_STATS_TIME()
+u32_t sys_arch_now_us(void);
+
+#endif /* __ARCH_SYS_ARCH_H__ */
@@ -123,4 +123,122 @@ __attribute__((naked)) void /*uint16_t*/ thumb2_checksum(const void* pData, int
     );
 }
 
+
+/* This is a hand written Thumb-2 assembly language version of
+   lwip_chksum_copy() which copies the data and calculates its checksum in a
+   single pass, instead of the memcpy() followed by thumb2_checksum() which
+   lwIP would otherwise use for LWIP_CHKSUM_COPY.  It follows the structure
+   of thumb2_checksum() but aligns the destination pointer.  The Cortex-M3/M4
+   allow unaligned ldr/ldrh so the source can have any alignment.
+   
+   Returns:
+        16-bit 1's complement summation (not inversed) of the copied data.
+        
+   NOTE: This function does return a uint16_t from the assembly language code
+         but is marked as void so that GCC doesn't issue warning because it
+         doesn't know about this low level return.
+*/
+__attribute__((naked)) void /*uint16_t*/ thumb2_checksum_copy(void* pDest, const void* pSource, int length)
+{
+    __asm (
+        ".syntax unified\n"
+        ".thumb\n"
+
+        // Push non-volatile registers we use on stack.  Push r6 and link
+        // register too to keep stack 8-byte aligned and allow single pop to
+        // restore and return.
+        "    push        {r4, r5, r6, lr}\n"
+        // Initialize sum, r3, to 0.
+        "    movs    r3, #0\n"
+        // Remember whether pDest was at odd address in r12.  This is used later
+        // to know if it needs to swap the result since the summation will be
+        // done at an offset of 1, rather than 0.
+        "    ands    r12, r0, #1\n"
+        // Need to 2-byte align?  If not skip ahead.
+        "    beq     1$\n"
+        // We can return if there are no bytes to copy.
+        "    cbz     r2, 9$\n"
+
+        // 2-byte align.
+        // Place the first data byte in odd summation location since it needs to be
+        // swapped later.  It's ok to overwrite r3 here as it only had a value of 0
+        // up until now.  Advance pointers and decrement r2 length as we go.
+        "    ldrb    r3, [r1], #1\n"
+        "    strb    r3, [r0], #1\n"
+        "    lsls    r3, r3, #8\n"
+        "    subs    r2, r2, #1\n"
+
+        // Need to 4-byte align?  If not skip ahead.
+        "1$:\n"
+        "    ands    r4, r0, #3\n"
+        "    beq     2$\n"
+        // Have more than 1 byte left to align?  If not skip ahead to take care of
+        // trailing byte.
+        "    cmp     r2, #2\n"
+        "    blt     7$\n"
+
+        // 4-byte align.
+        "    ldrh    r4, [r1], #2\n"
+        "    strh    r4, [r0], #2\n"
+        "    adds    r3, r3, r4\n"
+        "    subs    r2, r2, #2\n"
+
+        // Main loop which copies and sums up data 2 words at a time.
+        // Make sure that we have more than 7 bytes left.
+        "2$:\n"
+        "    cmp     r2, #8\n"
+        "    blt     3$\n"
+        // Copy next two words and sum them, applying previous upper 16-bit
+        // carry to lower 16-bits.
+        "    ldr     r4, [r1], #4\n"
+        "    ldr     r5, [r1], #4\n"
+        "    str     r4, [r0], #4\n"
+        "    str     r5, [r0], #4\n"
+        "    adds    r3, r4\n"
+        "    adcs    r3, r5\n"
+        "    adc     r3, r3, #0\n"
+        "    subs    r2, r2, #8\n"
+        "    b       2$\n"
+
+        // Copy and sum up any remaining half-words.
+        "3$:\n"
+        // Make sure that we have more than 1 byte left.
+        "    cmp     r2, #2\n"
+        "    blt     7$\n"
+        // Copy and sum up next half word, continue to apply carry.
+        "    ldrh    r4, [r1], #2\n"
+        "    strh    r4, [r0], #2\n"
+        "    adds    r3, r4\n"
+        "    adc     r3, r3, #0\n"
+        "    subs    r2, r2, #2\n"
+        "    b       3$\n"
+
+        // Handle trailing byte, if it exists
+        "7$:\n"
+        "    cbz     r2, 8$\n"
+        "    ldrb    r4, [r1]\n"
+        "    strb    r4, [r0]\n"
+        "    adds    r3, r4\n"
+        "    adc     r3, r3, #0\n"
+
+        // Fold 32-bit checksum into 16-bit checksum.
+        "8$:\n"
+        "    ubfx    r4, r3, #16, #16\n"
+        "    ubfx    r3, r3, #0, #16\n"
+        "    adds    r3, r4\n"
+        "    ubfx    r4, r3, #16, #16\n"
+        "    ubfx    r3, r3, #0, #16\n"
+        "    adds    r3, r4\n"
+
+        // Swap bytes if started at odd address
+        "    cmp     r12, #0\n"
+        "    beq     9$\n"
+        "    rev16   r3, r3\n"
+
+        // Return final sum.
+        "9$: mov     r0, r3\n"
+        "    pop     {r4, r5, r6, pc}\n"
+    );
+}
+
 #endif
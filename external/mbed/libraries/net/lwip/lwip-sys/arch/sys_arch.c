@@ -66,6 +66,9 @@ u32_t sys_now(void) {
 #else
 /* CMSIS-RTOS implementation of the lwip operating system abstraction */
 #include "arch/sys_arch.h"
+#if TCPIP_STATS && defined(CMSIS_OS_RTX)
+#include "rt_TypeDef.h"
+#endif
 
 /*---------------------------------------------------------------------------*
  * Routine:  sys_mbox_new
@@ -200,6 +203,28 @@ u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg) {
     return ERR_OK;
 }
 
+#if TCPIP_STATS
+/*---------------------------------------------------------------------------*
+ * Routine:  sys_arch_mbox_depth
+ *---------------------------------------------------------------------------*
+ * Description:
+ *      Returns the number of messages currently waiting in the mailbox.
+ *      Only used for statistics so the value is read without locking.
+ * Inputs:
+ *      sys_mbox_t mbox         -- Handle of mailbox
+ * Outputs:
+ *      u32_t                   -- Number of messages in the mailbox.
+ *---------------------------------------------------------------------------*/
+u32_t sys_arch_mbox_depth(sys_mbox_t *mbox) {
+#ifdef CMSIS_OS_RTX
+    /* The queue storage starts with the RTX mailbox control block. */
+    return ((P_MCB)mbox->queue)->count;
+#else
+    return 0;
+#endif
+}
+#endif
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_sem_new
  *---------------------------------------------------------------------------*
@@ -386,6 +411,10 @@ u32_t sys_now(void) {
     return us_ticker_read() / 1000;
 }
 
+u32_t sys_arch_now_us(void) {
+    return us_ticker_read();
+}
+
 void sys_msleep(u32_t ms) {
     osDelay(ms);
 }
@@ -21,6 +21,7 @@
 #include "lwip/opt.h"
 
 #if NO_SYS == 0
+#include "cmsis.h"
 #include "cmsis_os.h"
 
 // === SEMAPHORE ===
@@ -80,6 +81,27 @@ typedef sys_thread_data_t* sys_thread_t;
 // === PROTECTION ===
 typedef int sys_prot_t;
 
+// sys_arch_protect() waits on a mutex, which cannot be done from an interrupt
+// handler.  SYS_ARCH_INC/SYS_ARCH_DEC are also used for counters that drivers
+// update from their interrupt handlers, so make them plain atomic adds (or
+// mask interrupts on ARMv6-M, which has no exclusive access instructions).
+#if defined(__CORTEX_M0) || defined(__CORTEX_M0PLUS)
+#define SYS_ARCH_ADD(var, val) do {               \
+            uint32_t primask = __get_PRIMASK();   \
+            __disable_irq();                      \
+            (var) += (val);                       \
+            __set_PRIMASK(primask);               \
+        } while (0)
+#else
+#define SYS_ARCH_ADD(var, val) ((void)__sync_fetch_and_add(&(var), (val)))
+#endif
+#define SYS_ARCH_INC(var, val) SYS_ARCH_ADD(var, val)
+#define SYS_ARCH_DEC(var, val) SYS_ARCH_ADD(var, -(val))
+
+// === STATISTICS ===
+// Microsecond timestamp used by TCPIP_STATS_TIME()
+u32_t sys_arch_now_us(void);
+
 #else
 #ifdef  __cplusplus
 extern "C" {
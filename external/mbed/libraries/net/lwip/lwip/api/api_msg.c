@@ -206,6 +206,26 @@ recv_udp(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 #endif /* LWIP_UDP */
 
 #if LWIP_TCP
+/**
+ * Let go of a pcb that was shut down for sending once it enters TIME_WAIT,
+ * as lwIP frees TIME_WAIT pcbs without calling back. Everything sent has
+ * been acknowledged by then.
+ *
+ * @param conn the TCP netconn of the pcb that called back
+ */
+static void
+release_time_wait(struct netconn *conn)
+{
+  if ((conn->pcb.tcp != NULL) && (conn->pcb.tcp->state == TIME_WAIT)) {
+    tcp_arg(conn->pcb.tcp, NULL);
+    tcp_recv(conn->pcb.tcp, NULL);
+    tcp_sent(conn->pcb.tcp, NULL);
+    tcp_poll(conn->pcb.tcp, NULL, 4);
+    tcp_err(conn->pcb.tcp, NULL);
+    conn->pcb.tcp = NULL;
+  }
+}
+
 /**
  * Receive callback function for TCP netconns.
  * Posts the packet to conn->recvmbox, but doesn't delete it on errors.
@@ -259,6 +279,9 @@ recv_tcp(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
     API_EVENT(conn, NETCONN_EVT_RCVPLUS, len);
   }
 
+  if (p == NULL) {
+    release_time_wait(conn);
+  }
   return ERR_OK;
 }
 
@@ -317,6 +340,9 @@ sent_tcp(void *arg, struct tcp_pcb *pcb, u16_t len)
   LWIP_UNUSED_ARG(pcb);
   LWIP_ASSERT("conn != NULL", (conn != NULL));
 
+  conn->acked += len;
+  API_EVENT(conn, NETCONN_EVT_ACKED, len);
+
   if (conn->state == NETCONN_WRITE) {
     do_writemore(conn);
   } else if (conn->state == NETCONN_CLOSE) {
@@ -331,6 +357,7 @@ sent_tcp(void *arg, struct tcp_pcb *pcb, u16_t len)
       conn->flags &= ~NETCONN_FLAG_CHECK_WRITESPACE;
       API_EVENT(conn, NETCONN_EVT_SENDPLUS, len);
     }
+    release_time_wait(conn);
   }
   
   return ERR_OK;
@@ -623,6 +650,8 @@ netconn_alloc(enum netconn_type t, netconn_callback callback)
 #if LWIP_TCP
   conn->current_msg  = NULL;
   conn->write_offset = 0;
+  conn->written      = 0;
+  conn->acked        = 0;
 #endif /* LWIP_TCP */
 #if LWIP_SO_RCVTIMEO
   conn->recv_timeout = 0;
@@ -761,16 +790,19 @@ do_close_internal(struct netconn *conn)
       tcp_recv(conn->pcb.tcp, NULL);
       tcp_accept(conn->pcb.tcp, NULL);
     }
-    if (shut_tx) {
-      tcp_sent(conn->pcb.tcp, NULL);
-    }
     if (close) {
+      tcp_sent(conn->pcb.tcp, NULL);
       tcp_poll(conn->pcb.tcp, NULL, 4);
       tcp_err(conn->pcb.tcp, NULL);
     }
   }
-  /* Try to close the connection */
-  if (shut == NETCONN_SHUT_RDWR) {
+  /* Try to close the connection.  With a linger time of 0 it is reset,
+     which frees the data still waiting to be sent or acknowledged. */
+  if (close && (conn->pcb.tcp->so_options & SOF_LINGER) &&
+      (conn->pcb.tcp->state != LISTEN)) {
+    tcp_abort(conn->pcb.tcp);
+    err = ERR_OK;
+  } else if (shut == NETCONN_SHUT_RDWR) {
     err = tcp_close(conn->pcb.tcp);
   } else {
     err = tcp_shutdown(conn->pcb.tcp, shut & NETCONN_SHUT_RD, shut & NETCONN_SHUT_WR);
@@ -780,13 +812,15 @@ do_close_internal(struct netconn *conn)
     conn->current_msg->err = ERR_OK;
     conn->current_msg = NULL;
     conn->state = NETCONN_NONE;
-    /* Set back some callback pointers as conn is going away */
-    conn->pcb.tcp = NULL;
-    /* Trigger select() in socket layer. Make sure everybody notices activity
-       on the connection, error first! */
     if (close) {
+      /* Set back some callback pointers as conn is going away */
+      conn->pcb.tcp = NULL;
+      /* Trigger select() in socket layer. Make sure everybody notices activity
+         on the connection, error first! */
       API_EVENT(conn, NETCONN_EVT_ERROR, 0);
     }
+    /* A pcb only shut down for sending stays with the conn, which keeps
+       counting the data acknowledged (FIONWRITE) and still closes it */
     if (shut_rx) {
       API_EVENT(conn, NETCONN_EVT_RCVPLUS, 0);
     }
@@ -1257,6 +1291,7 @@ do_writemore(struct netconn *conn)
     }
 
     if (err == ERR_OK) {
+      conn->written += len;
       conn->write_offset += len;
       if (conn->write_offset == conn->current_msg->msg.w.len) {
         /* everything was written */
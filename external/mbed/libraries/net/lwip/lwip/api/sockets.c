@@ -80,6 +80,12 @@ struct lwip_sock {
   int err;
   /** counter of how many threads are waiting for this socket using select */
   int select_waiting;
+#if LWIP_TCP
+  /** semaphore of the thread waiting in lwip_wait_unacked(), signalled by
+      event_callback() once no more than unacked_limit bytes are unacknowledged */
+  sys_sem_t *unacked_sem;
+  u32_t unacked_limit;
+#endif /* LWIP_TCP */
 };
 
 /** Description for a task waiting in select */
@@ -263,6 +269,9 @@ alloc_socket(struct netconn *newconn, int accepted)
       sockets[i].errevent   = 0;
       sockets[i].err        = 0;
       sockets[i].select_waiting = 0;
+#if LWIP_TCP
+      sockets[i].unacked_sem = NULL;
+#endif /* LWIP_TCP */
       return i;
     }
     SYS_ARCH_UNPROTECT(lev);
@@ -774,7 +783,7 @@ lwip_send(int s, const void *data, size_t size, int flags)
     }
   }
 
-  write_flags = NETCONN_COPY |
+  write_flags = ((flags & MSG_NOCOPY)   ? NETCONN_NOFLAG    : NETCONN_COPY) |
     ((flags & MSG_MORE)     ? NETCONN_MORE      : 0) |
     ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
   err = netconn_write(sock->conn, data, size, write_flags);
@@ -1288,11 +1297,26 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
     case NETCONN_EVT_ERROR:
       sock->errevent = 1;
       break;
+    case NETCONN_EVT_ACKED:
+      break;
     default:
       LWIP_ASSERT("unknown event", 0);
       break;
   }
 
+#if LWIP_TCP
+  /* Wake lwip_wait_unacked() once enough data has been acknowledged, or once
+     the pcb is gone and nothing will be acknowledged any more */
+  if ((sock->unacked_sem != NULL) &&
+      ((evt == NETCONN_EVT_ACKED) || (evt == NETCONN_EVT_ERROR))) {
+    if ((conn->pcb.tcp == NULL) ||
+        ((s32_t)(conn->written - conn->acked) <= (s32_t)sock->unacked_limit)) {
+      sys_sem_signal(sock->unacked_sem);
+      sock->unacked_sem = NULL;
+    }
+  }
+#endif /* LWIP_TCP */
+
   if (sock->select_waiting == 0) {
     /* noone is waiting for this socket, no need to check select_cb_list */
     SYS_ARCH_UNPROTECT(lev);
@@ -1887,6 +1911,21 @@ lwip_setsockopt(int s, int level, int optname, const void *optval, socklen_t opt
         err = EINVAL;
       }
       break;
+#if LWIP_TCP
+    /* mbed extension: only a linger time of 0 is supported, with which
+       close() resets the connection rather than waiting for its data to be
+       acknowledged. */
+    case SO_LINGER:
+      if (optlen < sizeof(struct linger)) {
+        err = EINVAL;
+      } else if (netconn_type(sock->conn) != NETCONN_TCP) {
+        err = ENOPROTOOPT;
+      } else if (((const struct linger*)optval)->l_onoff &&
+                 ((const struct linger*)optval)->l_linger != 0) {
+        err = EINVAL;
+      }
+      break;
+#endif /* LWIP_TCP */
     case SO_NO_CHECK:
       if (optlen < sizeof(int)) {
         err = EINVAL;
@@ -2098,6 +2137,17 @@ lwip_setsockopt_internal(void *arg)
       netconn_set_recvtimeout(sock->conn, *(int*)optval);
       break;
 #endif /* LWIP_SO_RCVTIMEO */
+#if LWIP_TCP
+    case SO_LINGER:
+      if (sock->conn->pcb.tcp == NULL) {
+        data->err = EINVAL;
+      } else if (((struct linger*)optval)->l_onoff) {
+        sock->conn->pcb.tcp->so_options |= SOF_LINGER;
+      } else {
+        sock->conn->pcb.tcp->so_options &= ~SOF_LINGER;
+      }
+      break;
+#endif /* LWIP_TCP */
 #if LWIP_SO_RCVBUF
     case SO_RCVBUF:
       netconn_set_recvbufsize(sock->conn, *(int*)optval);
@@ -2255,6 +2305,10 @@ lwip_ioctl(int s, long cmd, void *argp)
 {
   struct lwip_sock *sock = get_socket(s);
   u8_t val;
+#if LWIP_TCP
+  u32_t unacked;
+  SYS_ARCH_DECL_PROTECT(lev);
+#endif /* LWIP_TCP */
 #if LWIP_SO_RCVBUF
   u16_t buflen = 0;
   s16_t recv_avail;
@@ -2295,6 +2349,31 @@ lwip_ioctl(int s, long cmd, void *argp)
     return 0;
 #endif /* LWIP_SO_RCVBUF */
 
+#if LWIP_TCP
+  case FIONWRITE:
+    if (!argp || (netconn_type(sock->conn) != NETCONN_TCP)) {
+      sock_set_errno(sock, EINVAL);
+      return -1;
+    }
+    /* Once the pcb is gone lwIP no longer references any data written with
+       MSG_NOCOPY so report the error instead of a count that won't drain. */
+    if (sock->conn->pcb.tcp == NULL) {
+      sock_set_errno(sock, err_to_errno(sock->conn->last_err != ERR_OK ? sock->conn->last_err : ERR_CLSD));
+      return -1;
+    }
+    SYS_ARCH_PROTECT(lev);
+    unacked = sock->conn->written - sock->conn->acked;
+    SYS_ARCH_UNPROTECT(lev);
+    /* the acknowledgement of our FIN is counted as well */
+    if ((s32_t)unacked < 0) {
+      unacked = 0;
+    }
+    *((u32_t*)argp) = unacked;
+    LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_ioctl(%d, FIONWRITE, %p) = %"U32_F"\n", s, argp, unacked));
+    sock_set_errno(sock, 0);
+    return 0;
+#endif /* LWIP_TCP */
+
   case FIONBIO:
     val = 0;
     if (argp && *(u32_t*)argp) {
@@ -2312,6 +2391,94 @@ lwip_ioctl(int s, long cmd, void *argp)
   } /* switch (cmd) */
 }
 
+#if LWIP_TCP
+/**
+ * mbed extension: Wait until no more than limit bytes written to a TCP socket
+ * are unacknowledged (see FIONWRITE), which is when lwIP no longer references
+ * data sent with MSG_NOCOPY apart from the last limit bytes. Only one thread
+ * may wait on a socket at a time.
+ *
+ * @param s the socket
+ * @param limit the number of bytes that may still be unacknowledged
+ * @param timeout the maximum time to wait in milliseconds, 0 to only check
+ *        and -1 to wait forever
+ * @return 0 once no more than limit bytes are unacknowledged, -1 if the
+ *         timeout expired first (EWOULDBLOCK) or the connection failed
+ */
+int
+lwip_wait_unacked(int s, u32_t limit, int timeout)
+{
+  struct lwip_sock *sock = get_socket(s);
+  sys_sem_t sem;
+  u8_t have_sem = 0;
+  u8_t need_sem = 0;
+  u32_t waited;
+  err_t err;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (!sock) {
+    return -1;
+  }
+  if (netconn_type(sock->conn) != NETCONN_TCP) {
+    sock_set_errno(sock, EINVAL);
+    return -1;
+  }
+
+  for (;;) {
+    SYS_ARCH_PROTECT(lev);
+    if ((s32_t)(sock->conn->written - sock->conn->acked) <= (s32_t)limit) {
+      err = ERR_OK;
+    } else if (sock->conn->pcb.tcp == NULL) {
+      /* nothing more will be acknowledged */
+      err = (sock->conn->last_err != ERR_OK) ? sock->conn->last_err : ERR_CLSD;
+    } else if (timeout == 0) {
+      err = ERR_WOULDBLOCK;
+    } else if (have_sem) {
+      /* set while still protected so that event_callback() can't miss the
+         acknowledgement */
+      sock->unacked_limit = limit;
+      sock->unacked_sem = &sem;
+      err = ERR_INPROGRESS;
+    } else {
+      /* only create the semaphore once there is something to wait for */
+      err = ERR_OK;
+      need_sem = 1;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+
+    if (need_sem) {
+      need_sem = 0;
+      if (sys_sem_new(&sem, 0) != ERR_OK) {
+        err = ERR_MEM;
+        break;
+      }
+      have_sem = 1;
+      continue;
+    }
+    if (err != ERR_INPROGRESS) {
+      break;
+    }
+
+    waited = sys_arch_sem_wait(&sem, (timeout < 0) ? 0 : (u32_t)timeout);
+    SYS_ARCH_PROTECT(lev);
+    sock->unacked_sem = NULL;
+    SYS_ARCH_UNPROTECT(lev);
+    if (waited == SYS_ARCH_TIMEOUT) {
+      timeout = 0;
+    } else if (timeout > 0) {
+      timeout = (waited < (u32_t)timeout) ? timeout - (int)waited : 0;
+    }
+  }
+
+  if (have_sem) {
+    sys_sem_free(&sem);
+  }
+  LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_wait_unacked(%d, %"U32_F") = %d\n", s, limit, err));
+  sock_set_errno(sock, err_to_errno(err));
+  return (err == ERR_OK) ? 0 : -1;
+}
+#endif /* LWIP_TCP */
+
 /** A minimal implementation of fcntl.
  * Currently only the commands F_GETFL and F_SETFL are implemented.
  * Only the flag O_NONBLOCK is implemented.
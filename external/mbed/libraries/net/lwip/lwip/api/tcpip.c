@@ -46,6 +46,7 @@
 #include "lwip/pbuf.h"
 #include "lwip/tcpip.h"
 #include "lwip/init.h"
+#include "lwip/stats.h"
 #include "netif/etharp.h"
 #include "netif/ppp_oe.h"
 
@@ -59,6 +60,48 @@ static sys_mbox_t mbox;
 sys_mutex_t lock_tcpip_core;
 #endif /* LWIP_TCPIP_CORE_LOCKING */
 
+#if TCPIP_STATS
+/** Remember when a message was posted so that tcpip_thread can measure how
+ * long it waited in the mailbox. */
+#define TCPIP_MSG_STAMP(msg) (msg)->posted = TCPIP_STATS_TIME()
+
+/**
+ * Account for a message just fetched by tcpip_thread. Only tcpip_thread
+ * updates these counters so no protection is needed.
+ *
+ * @param msg the message fetched from the mailbox
+ */
+static void
+tcpip_stats_fetched(struct tcpip_msg *msg)
+{
+  u32_t waited = TCPIP_STATS_TIME() - msg->posted;
+  u32_t depth = sys_arch_mbox_depth(&mbox) + 1;
+
+  lwip_stats.tcpip.msgs++;
+  lwip_stats.tcpip.wait_us += waited;
+  if (waited > lwip_stats.tcpip.wait_us_max) {
+    lwip_stats.tcpip.wait_us_max = waited;
+  }
+  if (depth > lwip_stats.tcpip.depth_max) {
+    lwip_stats.tcpip.depth_max = (u16_t)depth;
+  }
+}
+
+/**
+ * Count a message dropped because the mailbox was full. Drivers may call
+ * tcpip_input() from interrupt handlers, where SYS_ARCH_PROTECT could have
+ * to block, so the port's SYS_ARCH_INC must be safe to use there.
+ */
+static void
+tcpip_stats_dropped(void)
+{
+  SYS_ARCH_INC(lwip_stats.tcpip.err, 1);
+}
+#else /* TCPIP_STATS */
+#define TCPIP_MSG_STAMP(msg)
+#define tcpip_stats_dropped()
+#endif /* TCPIP_STATS */
+
 
 /**
  * The main lwIP thread. This thread has exclusive access to lwIP core functions
@@ -87,6 +130,9 @@ tcpip_thread(void *arg)
     /* wait for a message, timeouts are processed while waiting */
     sys_timeouts_mbox_fetch(&mbox, (void **)&msg);
     LOCK_TCPIP_CORE();
+#if TCPIP_STATS
+    tcpip_stats_fetched(msg);
+#endif /* TCPIP_STATS */
     switch (msg->type) {
 #if LWIP_NETCONN
     case TCPIP_MSG_API:
@@ -175,13 +221,17 @@ tcpip_input(struct pbuf *p, struct netif *inp)
   if (sys_mbox_valid(&mbox)) {
     msg = (struct tcpip_msg *)memp_malloc(MEMP_TCPIP_MSG_INPKT);
     if (msg == NULL) {
+      NETIF_STATS_DROP(inp);
       return ERR_MEM;
     }
 
     msg->type = TCPIP_MSG_INPKT;
     msg->msg.inp.p = p;
     msg->msg.inp.netif = inp;
+    TCPIP_MSG_STAMP(msg);
     if (sys_mbox_trypost(&mbox, msg) != ERR_OK) {
+      tcpip_stats_dropped();
+      NETIF_STATS_DROP(inp);
       memp_free(MEMP_TCPIP_MSG_INPKT, msg);
       return ERR_MEM;
     }
@@ -216,10 +266,12 @@ tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block)
     msg->type = TCPIP_MSG_CALLBACK;
     msg->msg.cb.function = function;
     msg->msg.cb.ctx = ctx;
+    TCPIP_MSG_STAMP(msg);
     if (block) {
       sys_mbox_post(&mbox, msg);
     } else {
       if (sys_mbox_trypost(&mbox, msg) != ERR_OK) {
+        tcpip_stats_dropped();
         memp_free(MEMP_TCPIP_MSG_API, msg);
         return ERR_MEM;
       }
@@ -253,6 +305,7 @@ tcpip_timeout(u32_t msecs, sys_timeout_handler h, void *arg)
     msg->msg.tmo.msecs = msecs;
     msg->msg.tmo.h = h;
     msg->msg.tmo.arg = arg;
+    TCPIP_MSG_STAMP(msg);
     sys_mbox_post(&mbox, msg);
     return ERR_OK;
   }
@@ -281,6 +334,7 @@ tcpip_untimeout(sys_timeout_handler h, void *arg)
     msg->type = TCPIP_MSG_UNTIMEOUT;
     msg->msg.tmo.h = h;
     msg->msg.tmo.arg = arg;
+    TCPIP_MSG_STAMP(msg);
     sys_mbox_post(&mbox, msg);
     return ERR_OK;
   }
@@ -309,6 +363,7 @@ tcpip_apimsg(struct api_msg *apimsg)
   if (sys_mbox_valid(&mbox)) {
     msg.type = TCPIP_MSG_API;
     msg.msg.apimsg = apimsg;
+    TCPIP_MSG_STAMP(&msg);
     sys_mbox_post(&mbox, &msg);
     sys_arch_sem_wait(&apimsg->msg.conn->op_completed, 0);
     return apimsg->msg.err;
@@ -365,6 +420,7 @@ tcpip_netifapi(struct netifapi_msg* netifapimsg)
     
     msg.type = TCPIP_MSG_NETIFAPI;
     msg.msg.netifapimsg = netifapimsg;
+    TCPIP_MSG_STAMP(&msg);
     sys_mbox_post(&mbox, &msg);
     sys_sem_wait(&netifapimsg->msg.sem);
     sys_sem_free(&netifapimsg->msg.sem);
@@ -478,6 +478,59 @@ dns_lookup(const char *name)
   return IPADDR_NONE;
 }
 
+/**
+ * Look up the time to live left of a hostname in the array of known
+ * hostnames, so that a cache kept above lwIP, such as the one of the mbed
+ * Socket classes, can honour the TTL of the answer passed to its
+ * dns_found_callback.  Only call it from the tcpip thread.
+ *
+ * @param name the hostname to look up
+ * @return the hostname's time to live in seconds, or 0 if the hostname
+ *         was not found in the cached dns_table.
+ */
+u32_t
+dns_lookup_ttl(const char *name)
+{
+  u8_t i;
+
+  for (i = 0; i < DNS_TABLE_SIZE; ++i) {
+    if ((dns_table[i].state == DNS_STATE_DONE) &&
+        (strcmp(name, dns_table[i].name) == 0)) {
+      return dns_table[i].ttl;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Tell why the query for a hostname failed, from within the
+ * dns_found_callback which was passed NULL, so that a cache kept above lwIP
+ * only remembers failures that another query would run into too.
+ *
+ * @param name the hostname which couldn't be resolved
+ * @return 1 if the DNS server answered with an error, such as no such name,
+ *         or never answered; 0 if its answer was malformed or had no address
+ */
+u8_t
+dns_failure_is_final(const char *name)
+{
+  u8_t i;
+
+  for (i = 0; i < DNS_TABLE_SIZE; ++i) {
+    if (strcmp(name, dns_table[i].name) == 0) {
+      if (dns_table[i].state == DNS_STATE_ASKING) {
+        return 1;
+      }
+      if (dns_table[i].state == DNS_STATE_DONE) {
+        return (dns_table[i].err != 0);
+      }
+    }
+  }
+
+  return 0;
+}
+
 #if DNS_DOES_NAME_CHECK
 /**
  * Compare the "dotted" name "query" with the encoded name "response"
@@ -766,6 +819,16 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
     if (i < DNS_TABLE_SIZE) {
       pEntry = &dns_table[i];
       if(pEntry->state == DNS_STATE_ASKING) {
+#if DNS_DOES_NAME_CHECK
+        /* Check if the name in the "question" part match with the name in the entry.
+           The entry's ID is reused, so this may be a late answer to one of its
+           earlier queries, which is dropped rather than failing this one. */
+        if (dns_compare_name((unsigned char *)(pEntry->name), (unsigned char *)dns_payload + SIZEOF_DNS_HDR) != 0) {
+          LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": response not match to query\n", pEntry->name));
+          goto memerr;
+        }
+#endif /* DNS_DOES_NAME_CHECK */
+
         /* This entry is now completed. */
         pEntry->state = DNS_STATE_DONE;
         pEntry->err   = hdr->flags2 & DNS_FLAG2_ERR_MASK;
@@ -782,15 +845,6 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *addr, u16_t
           goto responseerr;
         }
 
-#if DNS_DOES_NAME_CHECK
-        /* Check if the name in the "question" part match with the name in the entry. */
-        if (dns_compare_name((unsigned char *)(pEntry->name), (unsigned char *)dns_payload + SIZEOF_DNS_HDR) != 0) {
-          LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": response not match to query\n", pEntry->name));
-          /* call callback to indicate error, clean up memory and return */
-          goto responseerr;
-        }
-#endif /* DNS_DOES_NAME_CHECK */
-
         /* Skip the name in the "question" part */
         pHostname = (char *) dns_parse_name((unsigned char *)dns_payload + SIZEOF_DNS_HDR) + SIZEOF_DNS_QUERY;
 
@@ -448,3 +448,104 @@ lwip_chksum_copy(void *dst, const void *src, u16_t len)
   return LWIP_CHKSUM(dst, len);
 }
 #endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2) /* Version #2 */
+/** Copy and checksum in a single pass over the data. Uses the same head/tail
+ * handling as LWIP_CHKSUM_ALGORITHM 3 and moves 8 bytes per loop iteration
+ * when src and dst share the same 32-bit alignment, 2 bytes otherwise. Falls
+ * back to version #1 when src and dst can't both be 16-bit aligned.
+ *
+ * @param dst destination of the copy, may be at any boundary
+ * @param src data to be copied and summed, may be at any boundary
+ * @param len number of bytes to copy
+ * @return host order (!) lwip checksum (non-inverted Internet sum) of src
+ */
+u16_t
+lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  const u8_t *pbs = (const u8_t *)src;
+  u8_t *pbd = (u8_t *)dst;
+  const u16_t *pss;
+  u16_t *psd, t = 0;
+  u32_t sum = 0, tmp, l1, l2;
+  int odd;
+
+  if (((mem_ptr_t)pbs ^ (mem_ptr_t)pbd) & 1) {
+    MEMCPY(dst, src, len);
+    return LWIP_CHKSUM(dst, len);
+  }
+
+  /* starts at odd byte address? */
+  odd = ((mem_ptr_t)pbd & 1);
+  if (odd && len > 0) {
+    *pbd++ = *pbs;
+    ((u8_t *)&t)[1] = *pbs++;
+    len--;
+  }
+
+  pss = (const u16_t *)(const void *)pbs;
+  psd = (u16_t *)(void *)pbd;
+
+  if ((((mem_ptr_t)pss ^ (mem_ptr_t)psd) & 3) == 0) {
+    const u32_t *pls;
+    u32_t *pld;
+
+    if (((mem_ptr_t)psd & 3) && len > 1) {
+      sum += *pss;
+      *psd++ = *pss++;
+      len -= 2;
+    }
+
+    pls = (const u32_t *)(const void *)pss;
+    pld = (u32_t *)(void *)psd;
+    while (len > 7) {
+      l1 = *pls++;
+      l2 = *pls++;
+      *pld++ = l1;
+      *pld++ = l2;
+
+      tmp = sum + l1;           /* ping */
+      if (tmp < l1) {
+        tmp++;                  /* add back carry */
+      }
+      sum = tmp + l2;           /* pong */
+      if (sum < l2) {
+        sum++;                  /* add back carry */
+      }
+      len -= 8;
+    }
+
+    /* make room in upper bits */
+    sum = FOLD_U32T(sum);
+
+    pss = (const u16_t *)(const void *)pls;
+    psd = (u16_t *)(void *)pld;
+  }
+
+  /* 16-bit aligned words remaining */
+  while (len > 1) {
+    sum += *pss;
+    *psd++ = *pss++;
+    len -= 2;
+  }
+
+  /* dangling tail byte remaining? */
+  if (len > 0) {
+    *(u8_t *)psd = *(const u8_t *)pss;
+    ((u8_t *)&t)[0] = *(const u8_t *)pss;
+  }
+
+  sum += t;                     /* add end bytes */
+
+  /* Fold 32-bit sum to 16 bits
+     calling this twice is propably faster than if statements... */
+  sum = FOLD_U32T(sum);
+  sum = FOLD_U32T(sum);
+
+  if (odd) {
+    sum = SWAP_BYTES_IN_WORD(sum);
+  }
+
+  return (u16_t)sum;
+}
+#endif /* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
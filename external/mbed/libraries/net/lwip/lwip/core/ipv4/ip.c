@@ -251,6 +251,8 @@ ip_input(struct pbuf *p, struct netif *inp)
 
   IP_STATS_INC(ip.recv);
   snmp_inc_ipinreceives();
+  NETIF_STATS_ADD(inp, rx_pkts, 1);
+  NETIF_STATS_ADD(inp, rx_bytes, p->tot_len);
 
   /* identify the IP header */
   iphdr = (struct ip_hdr *)p->payload;
@@ -700,6 +702,8 @@ err_t ip_output_if_opt(struct pbuf *p, ip_addr_t *src, ip_addr_t *dest,
   }
 
   IP_STATS_INC(ip.xmit);
+  NETIF_STATS_ADD(netif, tx_pkts, 1);
+  NETIF_STATS_ADD(netif, tx_bytes, p->tot_len);
 
   LWIP_DEBUGF(IP_DEBUG, ("ip_output_if: %c%c%"U16_F"\n", netif->name[0], netif->name[1], netif->num));
   ip_debug_print(p);
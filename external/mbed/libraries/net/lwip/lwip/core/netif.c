@@ -60,6 +60,8 @@
 #include "lwip/dhcp.h"
 #endif /* LWIP_DHCP */
 
+#include <string.h>
+
 #if LWIP_NETIF_STATUS_CALLBACK
 #define NETIF_STATUS_CALLBACK(n) do{ if (n->status_callback) { (n->status_callback)(n); }}while(0)
 #else
@@ -167,6 +169,9 @@ netif_add(struct netif *netif, ip_addr_t *ipaddr, ip_addr_t *netmask,
   netif->loop_first = NULL;
   netif->loop_last = NULL;
 #endif /* ENABLE_LOOPBACK */
+#if NETIF_STATS
+  memset(&netif->stats, 0, sizeof(netif->stats));
+#endif /* NETIF_STATS */
 
   /* remember netif specific state information data */
   netif->state = state;
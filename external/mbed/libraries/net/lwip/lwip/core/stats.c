@@ -151,6 +151,19 @@ stats_display_sys(struct stats_sys *sys)
 }
 #endif /* SYS_STATS */
 
+#if TCPIP_STATS
+void
+stats_display_tcpip(struct stats_tcpip *tcpip)
+{
+  LWIP_PLATFORM_DIAG(("\nTCPIP\n\t"));
+  LWIP_PLATFORM_DIAG(("msgs:        %"U32_F"\n\t", (u32_t)tcpip->msgs));
+  LWIP_PLATFORM_DIAG(("err:         %"U32_F"\n\t", (u32_t)tcpip->err));
+  LWIP_PLATFORM_DIAG(("depth_max:   %"U32_F"\n\t", (u32_t)tcpip->depth_max));
+  LWIP_PLATFORM_DIAG(("wait_us:     %"U32_F"\n\t", (u32_t)tcpip->wait_us));
+  LWIP_PLATFORM_DIAG(("wait_us_max: %"U32_F"\n", (u32_t)tcpip->wait_us_max));
+}
+#endif /* TCPIP_STATS */
+
 void
 stats_display(void)
 {
@@ -169,6 +182,7 @@ stats_display(void)
     MEMP_STATS_DISPLAY(i);
   }
   SYS_STATS_DISPLAY();
+  TCPIP_STATS_DISPLAY();
 }
 #endif /* LWIP_STATS_DISPLAY */
 
@@ -79,6 +79,10 @@ static void tcp_parseopt(struct tcp_pcb *pcb);
 static err_t tcp_listen_input(struct tcp_pcb_listen *pcb);
 static err_t tcp_timewait_input(struct tcp_pcb *pcb);
 
+#if TCP_QUEUE_OOSEQ && (TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS)
+static void tcp_oos_enforce_limits(struct tcp_pcb *pcb);
+#endif /* TCP_QUEUE_OOSEQ && (TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS) */
+
 /**
  * The initial input processing of TCP. It verifies the TCP header, demultiplexes
  * the segment between the PCBs and passes it on to tcp_process(), which implements
@@ -331,6 +335,12 @@ tcp_input(struct pbuf *p, struct netif *inp)
       } else if (recv_flags & TF_CLOSED) {
         /* The connection has been closed and we will deallocate the
            PCB. */
+        if (!(pcb->flags & TF_RXCLOSED)) {
+          /* Connection closed although the application has only shut down the
+             tx side: call the PCB's err callback and indicate the closure to
+             ensure the application doesn't continue using the PCB. */
+          TCP_EVENT_ERR(pcb->errf, pcb->callback_arg, ERR_CLSD);
+        }
         tcp_pcb_remove(&tcp_active_pcbs, pcb);
         memp_free(MEMP_TCP_PCB, pcb);
       } else {
@@ -828,6 +838,45 @@ tcp_oos_insert_segment(struct tcp_seg *cseg, struct tcp_seg *next)
 }
 #endif /* TCP_QUEUE_OOSEQ */
 
+#if TCP_QUEUE_OOSEQ && (TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS)
+/**
+ * Checks that the data on the ooseq queue of a pcb doesn't exceed
+ * TCP_OOSEQ_MAX_BYTES or TCP_OOSEQ_MAX_PBUFS and throws away every segment
+ * above that limit. This keeps one connection from holding on to the whole
+ * PBUF_POOL while it waits for a retransmission.
+ *
+ * @param pcb the tcp_pcb whose ooseq queue was just extended
+ */
+static void
+tcp_oos_enforce_limits(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *next, *prev;
+  u32_t ooseq_blen = 0;
+  u16_t ooseq_qlen = 0;
+
+  prev = NULL;
+  for (next = pcb->ooseq; next != NULL; prev = next, next = next->next) {
+    ooseq_blen += next->p->tot_len;
+    ooseq_qlen += pbuf_clen(next->p);
+    if ((TCP_OOSEQ_MAX_BYTES && ooseq_blen > TCP_OOSEQ_MAX_BYTES) ||
+        (TCP_OOSEQ_MAX_PBUFS && ooseq_qlen > TCP_OOSEQ_MAX_PBUFS)) {
+      /* too much ooseq data, dump this and everything after it */
+      LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_oos_enforce_limits: dropping ooseq data above "
+                                    "%"U32_F" bytes/%"U16_F" pbufs\n", ooseq_blen, ooseq_qlen));
+      tcp_segs_free(next);
+      if (prev == NULL) {
+        /* first ooseq segment is too much, dump the whole queue */
+        pcb->ooseq = NULL;
+      } else {
+        /* just dump 'next' and everything after it */
+        prev->next = NULL;
+      }
+      break;
+    }
+  }
+}
+#endif /* TCP_QUEUE_OOSEQ && (TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS) */
+
 /**
  * Called by tcp_process. Checks if the given segment is an ACK for outstanding
  * data, and if so frees the memory of the buffered data. Next, is places the
@@ -1460,6 +1509,9 @@ tcp_receive(struct tcp_pcb *pcb)
             prev = next;
           }
         }
+#if TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS
+        tcp_oos_enforce_limits(pcb);
+#endif /* TCP_OOSEQ_MAX_BYTES || TCP_OOSEQ_MAX_PBUFS */
 #endif /* TCP_QUEUE_OOSEQ */
 
       }
@@ -1028,7 +1028,11 @@ tcp_output(struct tcp_pcb *pcb)
   }
 #endif /* TCP_OVERSIZE */
 
-  if (seg != NULL && pcb->persist_backoff == 0 && 
+  /* Only start the persist timer when nothing is in flight (RFC 1122).  While
+     it runs the retransmission timer is stopped, so starting it just because
+     the next segment doesn't fit behind unacked data would leave a lost
+     segment waiting on the persist backoff instead of the RTO. */
+  if (seg != NULL && pcb->persist_backoff == 0 && pcb->unacked == NULL &&
       ntohl(seg->tcphdr->seqno) - pcb->lastack + seg->len > pcb->snd_wnd) {
     /* prepare for persist timer */
     pcb->persist_cnt = 0;
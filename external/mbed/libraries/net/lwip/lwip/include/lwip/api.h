@@ -108,7 +108,9 @@ enum netconn_evt {
   NETCONN_EVT_RCVMINUS,
   NETCONN_EVT_SENDPLUS,
   NETCONN_EVT_SENDMINUS,
-  NETCONN_EVT_ERROR
+  NETCONN_EVT_ERROR,
+  /** TCP data was acknowledged by the remote host (mbed extension) */
+  NETCONN_EVT_ACKED
 };
 
 #if LWIP_IGMP
@@ -183,6 +185,11 @@ struct netconn {
       this temporarily stores the message.
       Also used during connect and close. */
   struct api_msg_msg *current_msg;
+  /** TCP: total number of bytes queued by netconn_write and the number of
+      those acknowledged by the remote host, used for FIONWRITE to tell when
+      data written with NETCONN_NOCOPY is no longer referenced */
+  u32_t written;
+  u32_t acked;
 #endif /* LWIP_TCP */
   /** A callback function that is informed about events for this netconn */
   netconn_callback callback;
@@ -130,6 +130,20 @@ typedef void (*netif_status_callback_fn)(struct netif *netif);
 typedef err_t (*netif_igmp_mac_filter_fn)(struct netif *netif,
        ip_addr_t *group, u8_t action);
 
+#if NETIF_STATS
+/** Counters kept by the core for each interface (see NETIF_STATS) */
+struct stats_netif {
+  /** IP packets received, including the ones that were dropped later */
+  u32_t rx_pkts;
+  u32_t rx_bytes;
+  /** packets that could not be passed to tcpip_thread (no message or mailbox full) */
+  u32_t rx_drop;
+  /** IP packets sent, counted before fragmentation */
+  u32_t tx_pkts;
+  u32_t tx_bytes;
+};
+#endif /* NETIF_STATS */
+
 /** Generic data structure used for all lwIP network interfaces.
  *  The following fields should be filled in by the initialization
  *  function for the device driver: hwaddr_len, hwaddr[], mtu, flags */
@@ -207,6 +221,10 @@ struct netif {
   u32_t ifoutnucastpkts;
   u32_t ifoutdiscards;
 #endif /* LWIP_SNMP */
+#if NETIF_STATS
+  /** counters, updated in tcpip_thread except rx_drop */
+  struct stats_netif stats;
+#endif /* NETIF_STATS */
 #if LWIP_IGMP
   /** This function could be called to add or delete a entry in the multicast
       filter table of the ethernet MAC.*/
@@ -244,6 +262,15 @@ struct netif {
 #define NETIF_INIT_SNMP(netif, type, speed)
 #endif /* LWIP_SNMP */
 
+#if NETIF_STATS
+#define NETIF_STATS_ADD(netif, x, n) (netif)->stats.x += (n)
+/* Drivers may call tcpip_input() from interrupt handlers */
+#define NETIF_STATS_DROP(netif) SYS_ARCH_INC((netif)->stats.rx_drop, 1)
+#else /* NETIF_STATS */
+#define NETIF_STATS_ADD(netif, x, n)
+#define NETIF_STATS_DROP(netif)
+#endif /* NETIF_STATS */
+
 
 /** The list of network interfaces. */
 extern struct netif *netif_list;
@@ -921,6 +921,22 @@
 #define TCP_QUEUE_OOSEQ                 (LWIP_TCP)
 #endif
 
+/**
+ * TCP_OOSEQ_MAX_BYTES: The maximum number of bytes queued on ooseq per pcb.
+ * Default is 0 (no limit). Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#ifndef TCP_OOSEQ_MAX_BYTES
+#define TCP_OOSEQ_MAX_BYTES             0
+#endif
+
+/**
+ * TCP_OOSEQ_MAX_PBUFS: The maximum number of pbufs queued on ooseq per pcb.
+ * Default is 0 (no limit). Only valid for TCP_QUEUE_OOSEQ==1.
+ */
+#ifndef TCP_OOSEQ_MAX_PBUFS
+#define TCP_OOSEQ_MAX_PBUFS             0
+#endif
+
 /**
  * TCP_MSS: TCP Maximum segment size. (default is 536, a conservative default,
  * you might want to increase this.)
@@ -1544,6 +1560,24 @@
 #define SYS_STATS                       (NO_SYS == 0)
 #endif
 
+/**
+ * TCPIP_STATS==1: Enable tcpip_thread mailbox stats (messages handled,
+ * mailbox depth and time spent waiting in the mailbox). The port must
+ * provide sys_arch_mbox_depth() and TCPIP_STATS_TIME().
+ */
+#ifndef TCPIP_STATS
+#define TCPIP_STATS                     0
+#endif
+
+/**
+ * NETIF_STATS==1: Enable per interface counters of the IP packets and
+ * bytes received and sent, and of the packets the interface received but
+ * could not pass to tcpip_thread.
+ */
+#ifndef NETIF_STATS
+#define NETIF_STATS                     0
+#endif
+
 #else
 
 #define LINK_STATS                      0
@@ -1556,6 +1590,8 @@
 #define MEM_STATS                       0
 #define MEMP_STATS                      0
 #define SYS_STATS                       0
+#define TCPIP_STATS                     0
+#define NETIF_STATS                     0
 #define LWIP_STATS_DISPLAY              0
 
 #endif /* LWIP_STATS */
@@ -132,6 +132,7 @@ struct linger {
 #define MSG_OOB        0x04    /* Unimplemented: Requests out-of-band data. The significance and semantics of out-of-band data are protocol-specific */
 #define MSG_DONTWAIT   0x08    /* Nonblocking i/o for this operation only */
 #define MSG_MORE       0x10    /* Sender will send more */
+#define MSG_NOCOPY     0x20    /* mbed extension: TCP data is sent in place and must stay valid until FIONWRITE or lwip_wait_unacked() shows it acknowledged */
 
 
 /*
@@ -223,7 +224,7 @@ typedef struct ip_mreq {
 
 /*
  * Commands for ioctlsocket(),  taken from the BSD file fcntl.h.
- * lwip_ioctl only supports FIONREAD and FIONBIO, for now
+ * lwip_ioctl only supports FIONREAD, FIONBIO and FIONWRITE, for now
  *
  * Ioctl's have the command encoded in the lower word,
  * and the size of any in or out parameters in the upper
@@ -252,6 +253,9 @@ typedef struct ip_mreq {
 #ifndef FIONBIO
 #define FIONBIO     _IOW('f', 126, unsigned long) /* set/clear non-blocking i/o */
 #endif
+#ifndef FIONWRITE
+#define FIONWRITE   _IOR('f', 119, unsigned long) /* get # bytes in send queue, not yet acknowledged for TCP */
+#endif
 
 /* Socket I/O Controls: unimplemented */
 #ifndef SIOCSHIWAT
@@ -339,6 +343,9 @@ int lwip_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptse
                 struct timeval *timeout);
 int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
+#if LWIP_TCP
+int lwip_wait_unacked(int s, u32_t limit, int timeout);
+#endif /* LWIP_TCP */
 
 #if LWIP_COMPAT_SOCKETS
 #define accept(a,b,c)         lwip_accept(a,b,c)
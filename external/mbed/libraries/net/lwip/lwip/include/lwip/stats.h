@@ -110,6 +110,14 @@ struct stats_sys {
   struct stats_syselem mbox;
 };
 
+struct stats_tcpip {
+  u32_t msgs;                    /* Messages handled by tcpip_thread. */
+  STAT_COUNTER err;              /* Messages dropped because the mailbox was full. */
+  u16_t depth_max;               /* Most messages seen waiting in the mailbox. */
+  u32_t wait_us;                 /* Total time messages spent in the mailbox. */
+  u32_t wait_us_max;             /* Longest time a message spent in the mailbox. */
+};
+
 struct stats_ {
 #if LINK_STATS
   struct stats_proto link;
@@ -144,6 +152,9 @@ struct stats_ {
 #if SYS_STATS
   struct stats_sys sys;
 #endif
+#if TCPIP_STATS
+  struct stats_tcpip tcpip;
+#endif
 };
 
 extern struct stats_ lwip_stats;
@@ -268,6 +279,14 @@ void stats_init(void);
 #define SYS_STATS_DISPLAY()
 #endif
 
+#if TCPIP_STATS
+#define TCPIP_STATS_INC(x) STATS_INC(x)
+#define TCPIP_STATS_DISPLAY() stats_display_tcpip(&lwip_stats.tcpip)
+#else
+#define TCPIP_STATS_INC(x)
+#define TCPIP_STATS_DISPLAY()
+#endif
+
 /* Display of statistics */
 #if LWIP_STATS_DISPLAY
 void stats_display(void);
@@ -276,6 +295,7 @@ void stats_display_igmp(struct stats_igmp *igmp);
 void stats_display_mem(struct stats_mem *mem, char *name);
 void stats_display_memp(struct stats_mem *mem, int index);
 void stats_display_sys(struct stats_sys *sys);
+void stats_display_tcpip(struct stats_tcpip *tcpip);
 #else /* LWIP_STATS_DISPLAY */
 #define stats_display()
 #define stats_display_proto(proto, name)
@@ -283,6 +303,7 @@ void stats_display_sys(struct stats_sys *sys);
 #define stats_display_mem(mem, name)
 #define stats_display_memp(mem, index)
 #define stats_display_sys(sys)
+#define stats_display_tcpip(tcpip)
 #endif /* LWIP_STATS_DISPLAY */
 
 #ifdef __cplusplus
@@ -207,6 +207,12 @@ int sys_mbox_valid(sys_mbox_t *mbox);
 /** Set an mbox invalid so that sys_mbox_valid returns 0 */
 void sys_mbox_set_invalid(sys_mbox_t *mbox);
 #endif
+#if TCPIP_STATS
+/** Get the number of messages waiting in an mbox (only used for statistics)
+ * @param mbox mbox to inspect
+ * @return number of messages posted but not yet fetched */
+u32_t sys_arch_mbox_depth(sys_mbox_t *mbox);
+#endif /* TCPIP_STATS */
 
 /** The only thread function:
  * Creates a new thread
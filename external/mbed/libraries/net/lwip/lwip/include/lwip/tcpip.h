@@ -125,6 +125,10 @@ enum tcpip_msg_type {
 struct tcpip_msg {
   enum tcpip_msg_type type;
   sys_sem_t *sem;
+#if TCPIP_STATS
+  /** TCPIP_STATS_TIME() when the message was posted */
+  u32_t posted;
+#endif /* TCPIP_STATS */
   union {
 #if LWIP_NETCONN
     struct api_msg *apimsg;
@@ -86,6 +86,7 @@
 #include "lwip/ip.h" /* for ip_input() */
 
 #include "ppp.h"
+#include "pppframe.h"
 #include "pppdebug.h"
 
 #include "randm.h"
@@ -240,6 +241,7 @@ struct npioctl {
 static void pppInputThread(void *arg);
 #endif /* PPP_INPROC_OWNTHREAD */
 static void pppDrop(PPPControlRx *pcrx);
+static int pppInRoom(PPPControlRx *pcrx);
 static void pppInProc(PPPControlRx *pcrx, u_char *s, int l);
 #endif /* PPPOS_SUPPORT */
 
@@ -289,45 +291,6 @@ u_char outpacket_buf[NUM_PPP][PPP_MRU+PPP_HDRLEN] __attribute((section("AHBSRAM1
 /*****************************/
 
 #if PPPOS_SUPPORT
-/*
- * FCS lookup table as calculated by genfcstab.
- * @todo: smaller, slower implementation for lower memory footprint?
- */
-static const u_short fcstab[256] = {
-  0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
-  0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
-  0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
-  0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
-  0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
-  0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
-  0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
-  0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
-  0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
-  0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
-  0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
-  0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
-  0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
-  0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
-  0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
-  0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
-  0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
-  0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
-  0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
-  0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
-  0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
-  0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
-  0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
-  0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
-  0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
-  0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
-  0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
-  0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
-  0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
-  0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
-  0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
-  0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
-};
-
 /* PPP's Asynchronous-Control-Character-Map.  The mask array is used
  * to select the specific bit for a character. */
 static u_char pppACCMMask[] = {
@@ -752,6 +715,38 @@ pppAppend(u_char c, struct pbuf *nb, ext_accm *outACCM)
 
   return tb;
 }
+
+/*
+ * pppAppendBuf - append n characters to the end of the given pbuf chain,
+ * escaping those set in outACCM, and allocating pool pbufs as needed.
+ * Return the current pbuf, or NULL if a pbuf couldn't be allocated.
+ */
+static struct pbuf *
+pppAppendBuf(const u_char *s, int n, struct pbuf *nb, ext_accm *outACCM)
+{
+  while (nb && n > 0) {
+    int written, consumed;
+
+    if ((PBUF_POOL_BUFSIZE - nb->len) < 2) {
+      struct pbuf *tb = pbuf_alloc(PBUF_RAW, 0, PBUF_POOL);
+      if (tb) {
+        nb->next = tb;
+      } else {
+        LINK_STATS_INC(link.memerr);
+      }
+      nb = tb;
+      continue;
+    }
+
+    written = pppframe_escape((u_char*)nb->payload + nb->len, PBUF_POOL_BUFSIZE - nb->len,
+                              s, n, *outACCM, &consumed);
+    nb->len += written;
+    s += consumed;
+    n -= consumed;
+  }
+
+  return nb;
+}
 #endif /* PPPOS_SUPPORT */
 
 #if PPPOE_SUPPORT
@@ -904,20 +899,11 @@ pppifOutput(struct netif *netif, struct pbuf *pb, ip_addr_t *ipaddr)
 
   /* Load packet. */
   for(p = pb; p; p = p->next) {
-    int n;
-    u_char *sPtr;
-
-    sPtr = (u_char*)p->payload;
-    n = p->len;
-    while (n-- > 0) {
-      c = *sPtr++;
-
-      /* Update FCS before checking for special characters. */
-      fcsOut = PPP_FCS(fcsOut, c);
-      
-      /* Copy to output buffer escaping special characters. */
-      tailMB = pppAppend(c, tailMB, &pc->outACCM);
-    }
+    /* Update FCS before escaping special characters. */
+    fcsOut = pppfcs16(fcsOut, (u_char*)p->payload, p->len);
+
+    /* Copy to output buffer escaping special characters. */
+    tailMB = pppAppendBuf((u_char*)p->payload, p->len, tailMB, &pc->outACCM);
   }
 
   /* Add FCS and trailing flag. */
@@ -1096,18 +1082,10 @@ pppWrite(int pd, const u_char *s, int n)
   }
   pc->lastXMit = sys_jiffies();
 
-  fcsOut = PPP_INITFCS;
-  /* Load output buffer. */
-  while (n-- > 0) {
-    c = *s++;
-
-    /* Update FCS before checking for special characters. */
-    fcsOut = PPP_FCS(fcsOut, c);
+  /* Load output buffer, updating the FCS before escaping special characters. */
+  fcsOut = pppfcs16(PPP_INITFCS, s, n);
+  tailMB = pppAppendBuf(s, n, tailMB, &pc->outACCM);
 
-    /* Copy to output buffer escaping special characters. */
-    tailMB = pppAppend(c, tailMB, &pc->outACCM);
-  }
-    
   /* Add FCS and trailing flag. */
   c = ~fcsOut & 0xFF;
   tailMB = pppAppend(c, tailMB, &pc->outACCM);
@@ -1759,24 +1737,99 @@ pppos_input(int pd, u_char* data, int len)
   pppInProc(&pppControl[pd].rx, data, len);
 }
 
+/**
+ * Make sure the input packet has space for more data and return how much.
+ * Returns 0, having dropped the packet, if no pbuf could be allocated.
+ */
+static int
+pppInRoom(PPPControlRx *pcrx)
+{
+  struct pbuf *nextNBuf;
+
+  if (pcrx->inTail == NULL || pcrx->inTail->len == PBUF_POOL_BUFSIZE) {
+    if (pcrx->inTail != NULL) {
+      pcrx->inTail->tot_len = pcrx->inTail->len;
+      if (pcrx->inTail != pcrx->inHead) {
+        pbuf_cat(pcrx->inHead, pcrx->inTail);
+        /* give up the inTail reference now */
+        pcrx->inTail = NULL;
+      }
+    }
+    /* If we haven't started a packet, we need a packet header. */
+    nextNBuf = pbuf_alloc(PBUF_RAW, 0, PBUF_POOL);
+    if (nextNBuf == NULL) {
+      /* No free buffers.  Drop the input packet and let the
+       * higher layers deal with it.  Continue processing
+       * the received pbuf chain in case a new packet starts. */
+      PPPDEBUG(LOG_ERR, ("pppInProc[%d]: NO FREE MBUFS!\n", pcrx->pd));
+      LINK_STATS_INC(link.memerr);
+      pppDrop(pcrx);
+      pcrx->inState = PDSTART;  /* Wait for flag sequence. */
+      return 0;
+    }
+    if (pcrx->inHead == NULL) {
+      struct pppInputHeader *pih = nextNBuf->payload;
+
+      pih->unit = pcrx->pd;
+      pih->proto = pcrx->inProtocol;
+
+      nextNBuf->len += sizeof(*pih);
+
+      pcrx->inHead = nextNBuf;
+    }
+    pcrx->inTail = nextNBuf;
+  }
+
+  return PBUF_POOL_BUFSIZE - pcrx->inTail->len;
+}
+
 /**
  * Process a received octet string.
  */
 static void
 pppInProc(PPPControlRx *pcrx, u_char *s, int l)
 {
-  struct pbuf *nextNBuf;
   u_char curChar;
   u_char escaped;
+  ext_accm accm;
   SYS_ARCH_DECL_PROTECT(lev);
 
   PPPDEBUG(LOG_DEBUG, ("pppInProc[%d]: got %d bytes\n", pcrx->pd, l));
-  while (l-- > 0) {
+
+  /* Work from a copy of the ACCM rather than locking it for every character. */
+  SYS_ARCH_PROTECT(lev);
+  SMEMCPY(accm, pcrx->inACCM, sizeof(accm));
+  SYS_ARCH_UNPROTECT(lev);
+
+  while (l > 0) {
+    /* Unescape runs of packet data straight into the input pbuf, leaving
+     * the flag which ends the packet to be handled below. */
+    if (pcrx->inState == PDDATA && *s != PPP_FLAG) {
+      int room = pppInRoom(pcrx);
+      if (room > 0) {
+        u_char *dPtr = (u_char*)pcrx->inTail->payload + pcrx->inTail->len;
+        u8_t inEscaped = pcrx->inEscaped;
+        int consumed;
+        int n;
+
+        n = pppframe_unescape(dPtr, room, s, l, accm, &inEscaped, &consumed);
+        pcrx->inEscaped = inEscaped;
+        pcrx->inTail->len += n;
+        pcrx->inFCS = pppfcs16(pcrx->inFCS, dPtr, n);
+        s += consumed;
+        l -= consumed;
+      } else {
+        /* Out of pbufs, so skip the character as before. */
+        s++;
+        l--;
+      }
+      continue;
+    }
+
     curChar = *s++;
+    l--;
 
-    SYS_ARCH_PROTECT(lev);
-    escaped = ESCAPE_P(pcrx->inACCM, curChar);
-    SYS_ARCH_UNPROTECT(lev);
+    escaped = ESCAPE_P(accm, curChar);
     /* Handle special characters. */
     if (escaped) {
       /* Check for escape sequences. */
@@ -1913,38 +1966,8 @@ pppInProc(PPPControlRx *pcrx, u_char *s, int l)
           break;
         case PDDATA:                    /* Process data byte. */
           /* Make space to receive processed data. */
-          if (pcrx->inTail == NULL || pcrx->inTail->len == PBUF_POOL_BUFSIZE) {
-            if (pcrx->inTail != NULL) {
-              pcrx->inTail->tot_len = pcrx->inTail->len;
-              if (pcrx->inTail != pcrx->inHead) {
-                pbuf_cat(pcrx->inHead, pcrx->inTail);
-                /* give up the inTail reference now */
-                pcrx->inTail = NULL;
-              }
-            }
-            /* If we haven't started a packet, we need a packet header. */
-            nextNBuf = pbuf_alloc(PBUF_RAW, 0, PBUF_POOL);
-            if (nextNBuf == NULL) {
-              /* No free buffers.  Drop the input packet and let the
-               * higher layers deal with it.  Continue processing
-               * the received pbuf chain in case a new packet starts. */
-              PPPDEBUG(LOG_ERR, ("pppInProc[%d]: NO FREE MBUFS!\n", pcrx->pd));
-              LINK_STATS_INC(link.memerr);
-              pppDrop(pcrx);
-              pcrx->inState = PDSTART;  /* Wait for flag sequence. */
-              break;
-            }
-            if (pcrx->inHead == NULL) {
-              struct pppInputHeader *pih = nextNBuf->payload;
-
-              pih->unit = pcrx->pd;
-              pih->proto = pcrx->inProtocol;
-
-              nextNBuf->len += sizeof(*pih);
-
-              pcrx->inHead = nextNBuf;
-            }
-            pcrx->inTail = nextNBuf;
+          if (pppInRoom(pcrx) == 0) {
+            break;
           }
           /* Load character into buffer. */
           ((u_char*)pcrx->inTail->payload)[pcrx->inTail->len++] = curChar;
@@ -1954,7 +1977,7 @@ pppInProc(PPPControlRx *pcrx, u_char *s, int l)
       /* update the frame check sequence number. */
       pcrx->inFCS = PPP_FCS(pcrx->inFCS, curChar);
     }
-  } /* while (l-- > 0), all bytes processed */
+  } /* while (l > 0), all bytes processed */
 
   avRandomize();
 }
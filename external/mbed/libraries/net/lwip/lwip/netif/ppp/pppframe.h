@@ -0,0 +1,75 @@
+/*****************************************************************************
+* pppframe.h - Bulk HDLC-like framing for PPP over serial.
+*
+* Copyright (c) 2014 by Adam Green.
+*
+* The authors hereby grant permission to use, copy, modify, distribute,
+* and license this software and its documentation for any purpose, provided
+* that existing copyright notices are retained in all copies and that this
+* notice and the following disclaimer are included verbatim in any
+* distributions. No written agreement, license, or royalty fee is required
+* for any of the authorized uses.
+*
+* THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS *AS IS* AND ANY EXPRESS OR
+* IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+* IN NO EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+* NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+* DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+* THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+* THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*****************************************************************************/
+
+#ifndef PPPFRAME_H
+#define PPPFRAME_H
+
+#include "lwip/opt.h"
+
+#if PPPOS_SUPPORT /* don't build if not configured for use in lwipopts.h */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * FCS-16 tables for slicing by 4 bytes.  pppfcstab[0] is the classic
+ * byte at a time table of RFC 1662, used by PPP_FCS().
+ */
+extern const u16_t pppfcstab[4][256];
+
+/*
+ * Update the FCS fcs with len bytes of data.
+ */
+u16_t pppfcs16(u16_t fcs, const u8_t *data, int len);
+
+/*
+ * Escape src into dst, a byte at a time, for each byte whose bit is set in
+ * the 256 bit accm.  Stops when src is exhausted or the next byte, escaped
+ * if need be, doesn't fit in dst.
+ * Returns the number of bytes written to dst and sets *consumed to the
+ * number of bytes taken from src.
+ */
+int pppframe_escape(u8_t *dst, int dstlen, const u8_t *src, int srclen,
+                    const u8_t *accm, int *consumed);
+
+/*
+ * Unescape src into dst.  Bytes set in accm other than the flag and escape
+ * are dropped, as the physical layer may insert them.  *escaped carries a
+ * trailing escape over to the next call.  Stops before a flag, which is
+ * left for the caller, or when src is exhausted or dst is full.
+ * Returns the number of bytes written to dst and sets *consumed to the
+ * number of bytes taken from src.
+ */
+int pppframe_unescape(u8_t *dst, int dstlen, const u8_t *src, int srclen,
+                      const u8_t *accm, u8_t *escaped, int *consumed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPPOS_SUPPORT */
+
+#endif /* PPPFRAME_H */
@@ -24,6 +24,7 @@ Arguments::Arguments(const char* rqs) {
     obj_name = NULL;
     method_name = NULL;
     argc = 0;
+    memset(argt, RPC_TYPE_STRING, sizeof(argt));
 
     // This copy can be removed if we can assume the request string is
     // persistent and writable for the duration of the call
@@ -53,6 +54,82 @@ Arguments::Arguments(const char* rqs) {
     index = -1;
 }
 
+Arguments::Arguments(const uint8_t* call, int length, int* consumed) {
+    obj_name = NULL;
+    method_name = NULL;
+    argc = 0;
+    index = -1;
+    *consumed = 0;
+
+    // Names and strings are copied with a terminating null byte, and the
+    // other values as they are, to request.
+    const uint8_t* p = call;
+    const uint8_t* call_end = call + length;
+    char* q = request;
+    char* request_end = request + sizeof(request);
+
+    char** names[2] = {&obj_name, &method_name};
+    for (int i = 0; i < 2; i++) {
+        if (p >= call_end || p + 1 + *p > call_end || q + *p + 1 > request_end) return;
+        int size = *p++;
+        memcpy(q, p, size);
+        q[size] = '\0';
+        // An empty name asks for the names, as when it is left out of a text request
+        *names[i] = size ? q : NULL;
+        p += size;
+        q += size + 1;
+    }
+
+    if (p >= call_end || *p > RPC_MAX_ARGS) {
+        obj_name = NULL;
+        return;
+    }
+    int count = *p++;
+    for (argc = 0; argc < count; argc++) {
+        int size;
+        int copy;
+        if (p >= call_end) break;
+        argt[argc] = *p++;
+        switch (argt[argc]) {
+            case RPC_TYPE_INT:
+            case RPC_TYPE_FLOAT:  size = 4; copy = 4; break;
+            case RPC_TYPE_CHAR:   size = 1; copy = 1; break;
+            case RPC_TYPE_STRING: size = (p < call_end) ? 1 + *p : 1; copy = size; break;
+            default:              size = -1; copy = 0; break;
+        }
+        if (size < 0 || p + size > call_end || q + copy > request_end) break;
+        if (argt[argc] == RPC_TYPE_STRING) {
+            // Replace the length with the terminating null byte.
+            memcpy(q, p + 1, size - 1);
+            q[size - 1] = '\0';
+        } else {
+            memcpy(q, p, copy);
+        }
+        argv[argc] = q;
+        p += size;
+        q += copy;
+    }
+    if (argc < count) {
+        obj_name = NULL;
+        argc = 0;
+        return;
+    }
+
+    *consumed = p - call;
+}
+
+static int32_t read_int(const char* p) {
+    const uint8_t* b = (const uint8_t*)p;
+    return (int32_t)(b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24));
+}
+
+static float read_float(const char* p) {
+    int32_t i = read_int(p);
+    float f;
+    memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
 char* Arguments::search_arg(char **arg, char *p, char next_sep) {
     char *s = p;
     while (true) {
@@ -69,11 +146,17 @@ char* Arguments::search_arg(char **arg, char *p, char next_sep) {
 
 template<> PinName Arguments::getArg<PinName>(void) {
     index++;
+    if (argt[index] == RPC_TYPE_INT) return (PinName)read_int(argv[index]);
     return parse_pins(argv[index]);
 }
 
 template<> int Arguments::getArg<int>(void) {
     index++;
+    switch (argt[index]) {
+        case RPC_TYPE_INT:   return read_int(argv[index]);
+        case RPC_TYPE_FLOAT: return (int)read_float(argv[index]);
+        case RPC_TYPE_CHAR:  return *argv[index];
+    }
     char *pEnd;
     return strtol(argv[index], &pEnd, 10);
 }
@@ -90,18 +173,43 @@ template<> char Arguments::getArg<char>(void) {
 
 template<> double Arguments::getArg<double>(void) {
     index++;
+    switch (argt[index]) {
+        case RPC_TYPE_INT:   return read_int(argv[index]);
+        case RPC_TYPE_FLOAT: return read_float(argv[index]);
+        case RPC_TYPE_CHAR:  return *argv[index];
+    }
     return atof(argv[index]);
 }
 
 template<> float Arguments::getArg<float>(void) {
     index++;
+    switch (argt[index]) {
+        case RPC_TYPE_INT:   return read_int(argv[index]);
+        case RPC_TYPE_FLOAT: return read_float(argv[index]);
+        case RPC_TYPE_CHAR:  return *argv[index];
+    }
     return atof(argv[index]);
 }
 
 Reply::Reply(char* r) {
     first = true;
+    overflow = false;
     *r = '\0';
     reply = r;
+    start = r;
+    end = NULL;
+}
+
+Reply::Reply(uint8_t* r, int size) {
+    first = true;
+    overflow = false;
+    reply = (char*)r;
+    start = reply;
+    end = reply + size;
+}
+
+int Reply::length(void) {
+    return reply - start;
 }
 
 void Reply::separator(void) {
@@ -112,27 +220,70 @@ void Reply::separator(void) {
     }
 }
 
+void Reply::put_value(char type, const void* value, int size) {
+    if (end - reply < 1 + size) {
+        overflow = true;
+        return;
+    }
+    *reply++ = type;
+    memcpy(reply, value, size);
+    reply += size;
+}
+
+static void write_int(uint8_t* b, uint32_t v) {
+    b[0] = v;
+    b[1] = v >> 8;
+    b[2] = v >> 16;
+    b[3] = v >> 24;
+}
+
 template<> void Reply::putData<const char*>(const char* s) {
+    if (end) {
+        uint8_t value[1 + 255];
+        size_t size = strlen(s);
+        if (size > 255) size = 255;
+        value[0] = size;
+        memcpy(value + 1, s, size);
+        put_value(RPC_TYPE_STRING, value, 1 + size);
+        return;
+    }
     separator();
     reply += sprintf(reply, "%s", s);
 }
 
 template<> void Reply::putData<char*>(char* s) {
-    separator();
-    reply += sprintf(reply, "%s", s);
+    putData<const char*>(s);
 }
 
 template<> void Reply::putData<char>(char c) {
+    if (end) {
+        put_value(RPC_TYPE_CHAR, &c, 1);
+        return;
+    }
     separator();
     reply += sprintf(reply, "%c", c);
 }
 
 template<> void Reply::putData<int>(int v) {
+    if (end) {
+        uint8_t value[4];
+        write_int(value, v);
+        put_value(RPC_TYPE_INT, value, sizeof(value));
+        return;
+    }
     separator();
     reply += sprintf(reply, "%d", v);
 }
 
 template<> void Reply::putData<float>(float f) {
+    if (end) {
+        uint32_t i;
+        uint8_t value[4];
+        memcpy(&i, &f, sizeof(i));
+        write_int(value, i);
+        put_value(RPC_TYPE_FLOAT, value, sizeof(value));
+        return;
+    }
     separator();
     reply += sprintf(reply, "%.17g", f);
 }
@@ -24,10 +24,30 @@ namespace mbed {
 #define RPC_MAX_STRING  128
 #define RPC_MAX_ARGS     16
 
+/* Types of the values in binary requests and replies, each of which is
+ * the type byte followed by:
+ *  RPC_TYPE_INT    - 4 byte little endian integer.
+ *  RPC_TYPE_FLOAT  - 4 byte little endian IEEE 754 float.
+ *  RPC_TYPE_CHAR   - 1 byte character.
+ *  RPC_TYPE_STRING - 1 byte length and then that many characters.
+ */
+#define RPC_TYPE_INT    'i'
+#define RPC_TYPE_FLOAT  'f'
+#define RPC_TYPE_CHAR   'c'
+#define RPC_TYPE_STRING 's'
+
 class Arguments {
 public:
     Arguments(const char* rqs);
 
+    /* Parse one call from a binary request, which is the object name and
+     * the method name, each as a 1 byte length and then the characters,
+     * followed by a 1 byte count of arguments and then the typed values.
+     * Sets *consumed to the number of bytes parsed, or 0 if the call is
+     * malformed, in which case obj_name is NULL.
+     */
+    Arguments(const uint8_t* call, int length, int* consumed);
+
     template<typename Arg>
     Arg   getArg(void);
 
@@ -36,6 +56,8 @@ public:
 
     int   argc;
     char* argv[RPC_MAX_ARGS];
+    // RPC_TYPE_* of each argument, which is RPC_TYPE_STRING for text requests
+    char  argt[RPC_MAX_ARGS];
 
 private:
     // This copy can be removed if we can assume the request string is
@@ -49,13 +71,26 @@ class Reply {
 public:
     Reply(char* r);
 
+    /* Reply with typed values, as in binary requests, into the size bytes
+     * at r.  Values which don't fit are dropped and set overflow.
+     */
+    Reply(uint8_t* r, int size);
+
     template<typename Data>
     void putData(Data d);
 
+    /* Number of characters, or bytes, written so far */
+    int length(void);
+
+    bool overflow;
+
 private:
     void separator(void);
+    void put_value(char type, const void* value, int size);
     bool first;
     char* reply;
+    char* start;
+    char* end;      // NULL for text replies
 };
 
 
@@ -0,0 +1,272 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "RPCStream.h"
+
+namespace mbed {
+
+// FNV-1a of a reply, to tell when a subscribed value changes.
+static uint32_t hash_bytes(const uint8_t *p, int length) {
+    uint32_t h = 2166136261U;
+    while (length-- > 0) {
+        h = (h ^ *p++) * 16777619U;
+    }
+    return h;
+}
+
+RPCStream::RPCStream(Stream &stream, const char *name) : RPC(name), _stream(stream) {
+    _state = STATE_TEXT;
+    _binary = false;
+    _length = 0;
+    _frame_length = 0;
+    memset(_subscriptions, 0, sizeof(_subscriptions));
+    _timer.start();
+}
+
+void RPCStream::receive(int c) {
+    switch (_state) {
+        case STATE_TEXT:
+            if (c == RPC_FRAME_REQUEST && _length == 0) {
+                _state = STATE_LENGTH_LOW;
+            } else if (c == '\n') {
+                if (_length > 0) {
+                    serve_text();
+                }
+                _length = 0;
+            } else if (c == '\r') {
+                // Lines may end with "\r\n".
+            } else if (_length < (int)sizeof(_buffer) - 1) {
+                _buffer[_length++] = c;
+            } else {
+                _state = STATE_SKIP_TEXT;
+            }
+            break;
+
+        case STATE_SKIP_TEXT:
+            // The line is too long to serve.
+            if (c == '\n') {
+                _stream.puts("!\n");
+                _length = 0;
+                _state = STATE_TEXT;
+            }
+            break;
+
+        case STATE_LENGTH_LOW:
+            _frame_length = c & 0xFF;
+            _state = STATE_LENGTH_HIGH;
+            break;
+
+        case STATE_LENGTH_HIGH:
+            _frame_length |= (c & 0xFF) << 8;
+            _length = 0;
+            if (_frame_length > (int)sizeof(_buffer)) {
+                _state = STATE_SKIP_PAYLOAD;
+            } else if (_frame_length == 0) {
+                serve_binary();
+                _state = STATE_TEXT;
+            } else {
+                _state = STATE_PAYLOAD;
+            }
+            break;
+
+        case STATE_PAYLOAD:
+            _buffer[_length++] = c;
+            if (_length == _frame_length) {
+                serve_binary();
+                _length = 0;
+                _state = STATE_TEXT;
+            }
+            break;
+
+        case STATE_SKIP_PAYLOAD:
+            // The frame is too large to serve.
+            if (++_length == _frame_length) {
+                uint8_t status[2] = {RPC_STATUS_MALFORMED, 0};
+                send_frame(RPC_FRAME_REPLY, status, sizeof(status));
+                _length = 0;
+                _state = STATE_TEXT;
+            }
+            break;
+    }
+}
+
+void RPCStream::serve_text() {
+    char reply[RPC_MAX_STRING];
+    char *request = (char*)_buffer;
+
+    _binary = false;
+    _buffer[_length] = '\0';
+    while (true) {
+        char *next = strchr(request, ';');
+        if (next != NULL) {
+            *next = '\0';
+        }
+        if (strlen(request) < RPC_MAX_STRING && RPC::call(request, reply)) {
+            _stream.puts(reply);
+        } else {
+            _stream.putc('!');
+        }
+        if (next == NULL) {
+            break;
+        }
+        _stream.putc(';');
+        request = next + 1;
+    }
+    _stream.putc('\n');
+}
+
+void RPCStream::serve_binary() {
+    int offset = 0;
+    int length = 0;
+
+    _binary = true;
+    while (offset < _length && length + 2 <= (int)sizeof(_reply)) {
+        int consumed;
+        Arguments args(_buffer + offset, _length - offset, &consumed);
+        if (consumed == 0) {
+            _reply[length++] = RPC_STATUS_MALFORMED;
+            _reply[length++] = 0;
+            break;
+        }
+        offset += consumed;
+
+        // Each call's reply is at most 255 bytes, as its length is one byte.
+        int room = sizeof(_reply) - length - 2;
+        Reply r(_reply + length + 2, (room < 255) ? room : 255);
+        if (!RPC::call(&args, &r)) {
+            _reply[length] = RPC_STATUS_FAILED;
+        } else if (r.overflow) {
+            _reply[length] = RPC_STATUS_OVERFLOW;
+        } else {
+            _reply[length] = RPC_STATUS_OK;
+        }
+        _reply[length + 1] = r.length();
+        length += 2 + r.length();
+    }
+    send_frame(RPC_FRAME_REPLY, _reply, length);
+}
+
+void RPCStream::send_frame(int type, const uint8_t *payload, int length) {
+    _stream.putc(type);
+    _stream.putc(length & 0xFF);
+    _stream.putc(length >> 8);
+    for (int i = 0; i < length; i++) {
+        _stream.putc(payload[i]);
+    }
+}
+
+int RPCStream::subscribe(const char *name, int period_ms) {
+    Subscription *free = NULL;
+
+    if (name == NULL || RPC::lookup(name) == NULL || period_ms < 0) {
+        return 0;
+    }
+    for (int i = 0; i < RPC_MAX_SUBSCRIPTIONS; i++) {
+        Subscription *s = &_subscriptions[i];
+        if (s->name[0] == '\0') {
+            if (free == NULL) {
+                free = s;
+            }
+        } else if (strncmp(s->name, name, sizeof(s->name) - 1) == 0) {
+            // Already subscribed, so just change how
+            free = s;
+            break;
+        }
+    }
+    if (free == NULL) {
+        return 0;
+    }
+
+    strncpy(free->name, name, sizeof(free->name) - 1);
+    free->name[sizeof(free->name) - 1] = '\0';
+    free->period_ms = period_ms;
+    free->binary = _binary;
+    free->pushed = false;
+    return 1;
+}
+
+void RPCStream::unsubscribe(const char *name) {
+    for (int i = 0; i < RPC_MAX_SUBSCRIPTIONS; i++) {
+        Subscription *s = &_subscriptions[i];
+        if (s->name[0] != '\0' && strncmp(s->name, name, sizeof(s->name) - 1) == 0) {
+            s->name[0] = '\0';
+        }
+    }
+}
+
+void RPCStream::poll() {
+    int now = _timer.read_ms();
+
+    for (int i = 0; i < RPC_MAX_SUBSCRIPTIONS; i++) {
+        Subscription *s = &_subscriptions[i];
+        if (s->name[0] == '\0') {
+            continue;
+        }
+        if (s->period_ms > 0 && s->pushed && now - s->last_ms < s->period_ms) {
+            continue;
+        }
+        if (!push(s)) {
+            // The object has been deleted.
+            s->name[0] = '\0';
+            continue;
+        }
+        s->last_ms = now;
+    }
+}
+
+bool RPCStream::push(Subscription *s) {
+    char request[1 + MBED_OBJECT_NAME_MAX + 5];
+    uint8_t value[RPC_MAX_STRING];
+    int name_length = strlen(s->name);
+
+    snprintf(request, sizeof(request), "/%s/read", s->name);
+    Arguments args(request);
+    Reply r = s->binary ? Reply(value, sizeof(value)) : Reply((char*)value);
+    if (!RPC::call(&args, &r)) {
+        return false;
+    }
+
+    uint32_t value_hash = hash_bytes(value, r.length());
+    if (s->period_ms == 0 && s->pushed && value_hash == s->value_hash) {
+        return true;
+    }
+    s->value_hash = value_hash;
+    s->pushed = true;
+
+    if (s->binary) {
+        _reply[0] = name_length;
+        memcpy(_reply + 1, s->name, name_length);
+        memcpy(_reply + 1 + name_length, value, r.length());
+        send_frame(RPC_FRAME_PUSH, _reply, 1 + name_length + r.length());
+    } else {
+        _stream.putc('+');
+        _stream.puts(s->name);
+        _stream.putc(' ');
+        _stream.puts((char*)value);
+        _stream.putc('\n');
+    }
+    return true;
+}
+
+const rpc_method *RPCStream::get_rpc_methods() {
+    static const rpc_method rpc_methods[] = {
+        {"subscribe", rpc_method_caller<int, RPCStream, const char*, int, &RPCStream::subscribe> },
+        {"unsubscribe", rpc_method_caller<RPCStream, const char*, &RPCStream::unsubscribe> },
+        RPC_METHOD_SUPER(RPC)
+    };
+    return rpc_methods;
+}
+
+}
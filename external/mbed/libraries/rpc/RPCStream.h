@@ -0,0 +1,165 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef RPCSTREAM_H
+#define RPCSTREAM_H
+
+#include "rpc.h"
+
+namespace mbed {
+
+/* Macro RPC_MAX_FRAME
+ *  The size of the largest text line or binary frame that is received,
+ *  and of the largest binary reply that is sent.
+ */
+#ifndef RPC_MAX_FRAME
+#define RPC_MAX_FRAME           512
+#endif
+
+/* Macro RPC_MAX_SUBSCRIPTIONS
+ *  The number of objects that can be subscribed to on each stream.
+ */
+#ifndef RPC_MAX_SUBSCRIPTIONS
+#define RPC_MAX_SUBSCRIPTIONS   8
+#endif
+
+/* The first byte of a binary frame, which is then followed by the 2 byte
+ * little endian length of the payload and the payload itself.
+ */
+#define RPC_FRAME_REQUEST   0xC0
+#define RPC_FRAME_REPLY     0xC1
+#define RPC_FRAME_PUSH      0xC2
+
+/* The status of each call in a binary reply */
+#define RPC_STATUS_OK           0
+#define RPC_STATUS_FAILED       1
+#define RPC_STATUS_OVERFLOW     2
+#define RPC_STATUS_MALFORMED    3
+
+/**
+ *Class to serve RPC requests received over a Stream, such as Serial
+ *
+ *Text requests are lines of the usual /obj/method args form, and a line
+ *may hold a batch of them separated by ';'.  The reply is one line with
+ *the replies to each separated by ';', where a failed call replies '!'.
+ *
+ *Binary requests are RPC_FRAME_REQUEST frames, whose payload is any number
+ *of calls as parsed by Arguments, with typed values in place of text.  The
+ *RPC_FRAME_REPLY frame sent back holds, for each call, its RPC_STATUS_*
+ *byte, the length of its reply and the RPC_TYPE_* values it returned.  A
+ *call is not made if its status doesn't fit in the reply.
+ *
+ *The object can be subscribed to over rpc, so that the result of calling
+ *read on another object is pushed each period, or whenever it changes.  In
+ *text it is pushed as a line with '+', the object's name, a space and the
+ *reply.  In binary it is pushed as an RPC_FRAME_PUSH frame holding the
+ *name, as a 1 byte length and the characters, followed by the values.
+ *
+ *Example
+ *@code
+ * Serial pc(USBTX, USBRX);
+ * RPCStream rpc(pc, "rpc");
+ *
+ * int main() {
+ *     while (true) {
+ *         while (pc.readable()) {
+ *             rpc.receive(pc.getc());
+ *         }
+ *         rpc.poll();
+ *     }
+ * }
+ *@endcode
+ *and then, from the host: "/rpc/subscribe f 100" or "/a/read;/b/read;/c/write 1"
+ */
+class RPCStream: public RPC {
+public:
+    /**
+     * Constructor
+     *
+     *@param stream The stream which replies and pushes are written to.
+     *@param name The name of this object over RPC.
+     */
+    RPCStream(Stream &stream, const char *name = NULL);
+
+    /**
+     *Handle a character read from the stream, serving a request once it is complete
+     *
+     *@param c The character.
+     */
+    void receive(int c);
+
+    /**
+     *Push the values of the subscribed objects that are due
+     *
+     *Should be called regularly from the same thread as receive().
+     */
+    void poll();
+
+    /**
+     *Push the result of calling read on an object
+     *
+     *@param name The object's name.
+     *@param period_ms How often to push, or 0 to push whenever it changes.
+     *@return 1 if subscribed, or 0 if there is no such object or no free subscription
+     */
+    int subscribe(const char *name, int period_ms);
+
+    /**
+     *Stop pushing an object
+     *
+     *@param name The object's name.
+     */
+    void unsubscribe(const char *name);
+
+    virtual const struct rpc_method *get_rpc_methods();
+
+private:
+    enum State {
+        STATE_TEXT,
+        STATE_SKIP_TEXT,
+        STATE_LENGTH_LOW,
+        STATE_LENGTH_HIGH,
+        STATE_PAYLOAD,
+        STATE_SKIP_PAYLOAD
+    };
+
+    struct Subscription {
+        char name[MBED_OBJECT_NAME_MAX];    // empty when free
+        int period_ms;
+        int last_ms;
+        bool binary;
+        bool pushed;
+        uint32_t value_hash;
+    };
+
+    void serve_text();
+    void serve_binary();
+    void send_frame(int type, const uint8_t *payload, int length);
+    bool push(Subscription *s);
+
+    Stream &_stream;
+    Timer _timer;
+    State _state;
+    bool _binary;
+    int _length;
+    int _frame_length;
+    uint8_t _buffer[RPC_MAX_FRAME];
+    uint8_t _reply[RPC_MAX_FRAME];
+    Subscription _subscriptions[RPC_MAX_SUBSCRIPTIONS];
+};
+
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include "rpc.h"
 #include "RPCVariable.h"
 #include "RPCFunction.h"
+#include "RPCStream.h"
 #include "RpcClasses.h"
 #include "Arguments.h"
 
@@ -17,20 +17,52 @@
 
 using namespace std;
 
+namespace {
+
+void barrier() {
+    __sync_synchronize();
+}
+
+bool compare_and_swap(volatile uint32_t* value, uint32_t expected, uint32_t desired) {
+#if defined(__CORTEX_M0) || defined(__CORTEX_M0PLUS)
+    // No exclusive access on ARMv6-M: mask interrupts around the update.
+    uint32_t primask = __get_PRIMASK();
+    bool swapped = false;
+
+    __disable_irq();
+    if (*value == expected) {
+        *value = desired;
+        swapped = true;
+    }
+    __set_PRIMASK(primask);
+    return swapped;
+#else
+    return __sync_bool_compare_and_swap(value, expected, desired);
+#endif
+}
+
+}
+
 namespace mbed {
 
 RPC::RPC(const char *name) {
     _from_construct = false;
+    // Names are kept in the object, so that those of objects created
+    // over rpc are not allocated on the heap.
     if (name != NULL) {
-        _name = new char[strlen(name) + 1];
-        strcpy(_name, name);
+        strncpy(_name, name, sizeof(_name) - 1);
+        _name[sizeof(_name) - 1] = '\0';
     } else {
-        _name = new char[12];
-        sprintf(_name, "obj%p", this);
+        snprintf(_name, sizeof(_name), "obj%p", this);
     }
     // put this object at head of the list
     _next = _head;
     _head = this;
+    // and at the head of its bucket in the index
+    _hash = hash(_name);
+    RPC **bucket = &_buckets[_hash & (RPC_OBJECT_BUCKETS - 1)];
+    _bucket_next = *bucket;
+    *bucket = this;
 }
 
 RPC::~RPC() {
@@ -44,6 +76,12 @@ RPC::~RPC() {
         }
         p->_next = _next;
     }
+    // and from its bucket
+    RPC **link = &_buckets[_hash & (RPC_OBJECT_BUCKETS - 1)];
+    while (*link != this) {
+        link = &(*link)->_bucket_next;
+    }
+    *link = _bucket_next;
 }
 
 const rpc_method *RPC::get_rpc_methods() {
@@ -54,19 +92,74 @@ const rpc_method *RPC::get_rpc_methods() {
     return methods;
 }
 
+uint32_t RPC::hash(const char *name) {
+    // FNV-1a
+    uint32_t h = 2166136261U;
+    for (int i = 0; i < MBED_OBJECT_NAME_MAX - 1 && name[i] != '\0'; i++) {
+        h = (h ^ (uint8_t)name[i]) * 16777619U;
+    }
+    return h;
+}
+
 RPC *RPC::lookup(const char *name) {
-    size_t len = strlen(name);
-    for (RPC *p = _head; p != NULL; p = p->_next) {
-        /* Check that p->_name matches name and is the correct length */
-        if (strncmp(p->_name, name, len) == 0 && (strlen(p->_name) == len)) {
+    uint32_t h = hash(name);
+    for (RPC *p = _buckets[h & (RPC_OBJECT_BUCKETS - 1)]; p != NULL; p = p->_bucket_next) {
+        /* Names are only significant up to the size they are kept at */
+        if (p->_hash == h && strncmp(p->_name, name, sizeof(p->_name) - 1) == 0) {
             return p;
         }
     }
     return NULL;
 }
 
+const rpc_method *RPC::find_method(RPC *p, const char *name, uint32_t h) {
+    /* The methods found from an object's table, through its super tables,
+     * are the same for every object which returns that table, so a match
+     * is cached against the table and the hash of the method name.  Calls
+     * may come from several threads, so an entry is only used when its
+     * sequence shows that it wasn't being written while it was read.
+     */
+    const rpc_method *methods = p->get_rpc_methods();
+    method_cache_entry *entry = &_method_cache[(h ^ ((uintptr_t)methods >> 2)) & (RPC_METHOD_CACHE_SIZE - 1)];
+    uint32_t sequence = entry->sequence;
+    barrier();
+    if (!(sequence & 1) && entry->methods == methods && entry->hash == h) {
+        const rpc_method *method = entry->method;
+        barrier();
+        if (entry->sequence == sequence && strcmp(method->name, name) == 0) {
+            return method;
+        }
+    }
+
+    /* Look through the methods for the one whose name matches */
+    const rpc_method *cur_method = methods;
+    while (true) {
+        for (; cur_method->name != NULL; cur_method++) {
+            if (strcmp(cur_method->name, name) == 0) {
+                /* Leave the entry to another thread already writing it */
+                sequence = entry->sequence;
+                if (!(sequence & 1) && compare_and_swap(&entry->sequence, sequence, sequence + 1)) {
+                    barrier();
+                    entry->methods = methods;
+                    entry->hash = h;
+                    entry->method = cur_method;
+                    barrier();
+                    entry->sequence = sequence + 2;
+                }
+                return cur_method;
+            }
+        }
+
+        if (cur_method->super != 0) {
+            cur_method = cur_method->super(p);
+        } else {
+            /* end of methods and no match */
+            return NULL;
+        }
+    }
+}
+
 void RPC::delete_self() {
-    delete[] _name;
     if (_from_construct) {
         delete this;
     }
@@ -85,7 +178,6 @@ void RPC::clear(Arguments*, Reply*) {
     while (ptr != NULL) {
         RPC *tmp = ptr;
         ptr = ptr->_next;
-        delete[] tmp->_name;
         if (tmp->_from_construct) {
             delete tmp;
         }
@@ -102,6 +194,10 @@ rpc_class RPC::_RPC_class = { "RPC", _RPC_funcs, NULL };
 
 RPC *RPC::_head = NULL;
 
+RPC *RPC::_buckets[RPC_OBJECT_BUCKETS];
+
+RPC::method_cache_entry RPC::_method_cache[RPC_METHOD_CACHE_SIZE];
+
 rpc_class *RPC::_classes = &_RPC_class;
 
 bool RPC::call(const char *request, char *reply) {
@@ -110,28 +206,31 @@ bool RPC::call(const char *request, char *reply) {
     Arguments args(request);
     Reply r(reply);
 
+    return call(&args, &r);
+}
+
+bool RPC::call(Arguments *args, Reply *r) {
     /* If there's no name print object and class names to result */
-    if (args.obj_name == NULL) {
+    if (args->obj_name == NULL) {
         for (RPC *p = RPC::_head; p != NULL; p = p->_next) {
-            r.putData<const char*>(p->_name);
+            r->putData<const char*>(p->_name);
         }
         for (rpc_class *c = RPC::_classes; c != NULL; c = c->next) {
-            r.putData<const char*>(c->name);
+            r->putData<const char*>(c->name);
         }
         return true;
     }
 
     /* First try matching an instance */
-    RPC *p = lookup(args.obj_name);
+    RPC *p = lookup(args->obj_name);
     if (p != NULL) {
-        /* Get the list of methods we support */
-        const rpc_method *cur_method = p->get_rpc_methods();
-
         /* When there's no method print method names to result */
-        if (args.method_name == NULL) {
+        if (args->method_name == NULL) {
+            /* Get the list of methods we support */
+            const rpc_method *cur_method = p->get_rpc_methods();
             while (true) {
                 for (; cur_method->name != NULL; cur_method++) {
-                    r.putData<const char*>(cur_method->name);
+                    r->putData<const char*>(cur_method->name);
                 }
 
                 /* write_name_arr's args are references, so result and cur_method will have changed */
@@ -143,40 +242,29 @@ bool RPC::call(const char *request, char *reply) {
             }
         }
 
-        /* Look through the methods for the one whose name matches */
-        while (true) {
-            for (; cur_method->name != NULL; cur_method++) {
-                if (strcmp(cur_method->name, args.method_name) == 0) {
-                    (cur_method->method_caller)(p, &args, &r);
-                    return true;
-                }
-            }
-
-            if (cur_method->super != 0) {
-                cur_method = cur_method->super(p);
-            } else {
-                /* end of methods and no match */
-                return false;
-            }
-
+        const rpc_method *method = find_method(p, args->method_name, hash(args->method_name));
+        if (method == NULL) {
+            return false;
         }
+        (method->method_caller)(p, args, r);
+        return true;
     }
 
     /* Then try a class */
     for (const rpc_class *q = _classes; q != NULL; q = q->next) {
-        if (strcmp(q->name, args.obj_name) == 0) {
+        if (strcmp(q->name, args->obj_name) == 0) {
             /* Matched the class name, so get its functions */
             const rpc_function *cur_func = q->static_functions;
-            if (args.method_name == NULL) {
+            if (args->method_name == NULL) {
                 for (; cur_func->name != NULL; cur_func++) {
-                    r.putData<const char*>(cur_func->name);
+                    r->putData<const char*>(cur_func->name);
                 }
                 return true;
             } else {
                 /* Otherwise call the appropriate function */
                 for (; cur_func->name != NULL; cur_func++) {
-                    if (strcmp(cur_func->name, args.method_name) == 0) {
-                        (cur_func->function_caller)(&args, &r);
+                    if (strcmp(cur_func->name, args->method_name) == 0) {
+                        (cur_func->function_caller)(args, r);
                         return true;
                     }
                 }
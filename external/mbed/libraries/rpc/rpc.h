@@ -23,6 +23,35 @@ namespace mbed {
 
 #define RPC_MAX_STRING      128
 
+/* Macro MBED_OBJECT_NAME_MAX
+ *  The maximum size of object name (including terminating null byte)
+ *  that will be recognised when using fopen to open a FileLike
+ *  object, or when using the rpc function.
+ */
+#define MBED_OBJECT_NAME_MAX 32
+
+/* Macro MBED_METHOD_NAME_MAX
+ *  The maximum size of rpc method name (including terminating null
+ *  byte) that will be recognised by the rpc function (in rpc.h).
+ */
+#define MBED_METHOD_NAME_MAX 32
+
+/* Macro RPC_OBJECT_BUCKETS
+ *  The number of hash buckets, a power of two, that objects are indexed
+ *  in by name.
+ */
+#ifndef RPC_OBJECT_BUCKETS
+#define RPC_OBJECT_BUCKETS  64
+#endif
+
+/* Macro RPC_METHOD_CACHE_SIZE
+ *  The number of entries, a power of two, in the cache of methods which
+ *  have been looked up by name.
+ */
+#ifndef RPC_METHOD_CACHE_SIZE
+#define RPC_METHOD_CACHE_SIZE 64
+#endif
+
 struct rpc_function {
     const char *name;
     void (*function_caller)(Arguments*, Reply*);
@@ -66,22 +95,54 @@ public:
 
     static bool call(const char *buf, char *result);
 
+    /* Function call
+     *  Call the method of an object, or the function of a class, given by
+     *  already parsed arguments, text or binary, and put its results in
+     *  reply.
+     */
+    static bool call(Arguments *args, Reply *reply);
+
     /* Function lookup
-     *  Lookup and return the object that has the given name.
+     *  Lookup and return the object that has the given name, through
+     *  the hash of its name rather than by comparing it with every name.
      *
      * Variables
      *  name - the name to lookup.
      */
     static RPC *lookup(const char *name);
 
+    /* Function hash
+     *  Return the hash of a name, which is significant up to
+     *  MBED_OBJECT_NAME_MAX - 1 characters, that objects and methods are
+     *  indexed by.
+     *
+     * Variables
+     *  name - the name to hash.
+     */
+    static uint32_t hash(const char *name);
+
 protected:
     static RPC *_head;
     RPC *_next;
-    char *_name;
+    char _name[MBED_OBJECT_NAME_MAX];
     bool _from_construct;
 
 private:
+    struct method_cache_entry {
+        volatile uint32_t sequence; /* odd while the entry is being written */
+        const struct rpc_method *methods;
+        uint32_t hash;
+        const struct rpc_method *method;
+    };
+
     static rpc_class *_classes;
+    static RPC *_buckets[RPC_OBJECT_BUCKETS];
+    static method_cache_entry _method_cache[RPC_METHOD_CACHE_SIZE];
+
+    RPC *_bucket_next;
+    uint32_t _hash;
+
+    static const struct rpc_method *find_method(RPC *p, const char *name, uint32_t hash);
 
     static const rpc_function _RPC_funcs[];
     static rpc_class _RPC_class;
@@ -139,19 +200,6 @@ public:
     }
 };
 
-/* Macro MBED_OBJECT_NAME_MAX
- *  The maximum size of object name (including terminating null byte)
- *  that will be recognised when using fopen to open a FileLike
- *  object, or when using the rpc function.
- */
-#define MBED_OBJECT_NAME_MAX 32
-
-/* Macro MBED_METHOD_NAME_MAX
- *  The maximum size of rpc method name (including terminating null
- *  byte) that will be recognised by the rpc function (in rpc.h).
- */
-#define MBED_METHOD_NAME_MAX 32
-
 /* Function rpc_method_caller
  */
 template<class T, void(T::*member)(const char *, char *)>
@@ -306,7 +354,7 @@ const struct rpc_method *rpc_super(RPC *this_ptr) {
 }
 
 #define RPC_METHOD_END      { NULL, NULL }
-#define RPC_METHOD_SUPER(C) { NULL, (rpc_method::method_caller_t)rpc_super<C> }
+#define RPC_METHOD_SUPER(C) { NULL, (rpc_method::method_caller_t)(void (*)())rpc_super<C> }
 
 } // namespace mbed
 
@@ -0,0 +1,220 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <stdint.h>
+
+#include "cmsis_os.h"
+#if defined(__CORTEX_M0) || defined(__CORTEX_M0PLUS)
+#include "cmsis.h"
+#endif
+
+namespace rtos {
+
+/** The Channel class passes messages by value to one receiving thread.
+ Messages are copied into a ring inside the Channel, so that no memory pool is
+ needed, and any number of threads and interrupt service routines may send
+ without a lock or a service call.  The receiver only asks the kernel to be
+ woken, with a thread signal, when it finds the Channel empty; senders only
+ set the signal when the receiver is actually waiting for it.
+ @code
+ // Interrupt service routine                // Receiving thread
+ Sample sample = { adc.read_u16() };         Sample samples[16];
+ if (!channel.try_send(sample))              uint32_t count = channel.receive_n(samples, 16);
+     overruns++;
+ @endcode
+  @tparam  T           data type of a single message, copied by assignment.
+  @tparam  channel_sz  maximum number of messages in the Channel, a power of two.
+*/
+template<typename T, uint32_t channel_sz>
+class Channel {
+public:
+    /** Create an empty Channel.
+      @param   signal  thread signal flag set to wake the receiver. (default: 0x8000)
+    */
+    Channel(int32_t signal=0x8000) : _signal(signal) {
+        // The positions run freely and are masked, so must wrap with the size.
+        (void)sizeof(char[(channel_sz && !(channel_sz & (channel_sz - 1))) ? 1 : -1]);
+        for (uint32_t i = 0; i < channel_sz; i++) {
+            _slots[i].sequence = i;
+        }
+        _head = 0;
+        _tail = 0;
+        _receiver = NULL;
+        _sleeping = 0;
+    }
+
+    /** Send a message without waiting, from a thread or an interrupt service routine.
+      @param   message  message to copy into the Channel.
+      @return  true if sent, false if the Channel is full.
+    */
+    bool try_send(const T& message) {
+        Slot* slot;
+        uint32_t head;
+
+        // A slot whose sequence equals the head is free for the sender which
+        // moves the head past it; one a lap behind is still to be received.
+        for (;;) {
+            head = _head;
+            slot = &_slots[head & (channel_sz - 1)];
+            int32_t lag = (int32_t)(slot->sequence - head);
+            if (lag < 0) {
+                return false;
+            }
+            if (lag == 0 && compare_and_swap(&_head, head, head + 1)) {
+                break;
+            }
+        }
+        slot->message = message;
+        barrier();
+        slot->sequence = head + 1;
+        barrier();
+        if (_sleeping && compare_and_swap(&_sleeping, 1, 0)) {
+            osSignalSet(_receiver, _signal);
+        }
+        return true;
+    }
+
+    /** Receive a message without waiting, from the receiving thread.
+      @param   message  set to the message received.
+      @return  true if received, false if the Channel is empty.
+    */
+    bool try_receive(T& message) {
+        uint32_t tail = _tail;
+        Slot* slot = &_slots[tail & (channel_sz - 1)];
+
+        // A sender interrupted between taking a slot and filling it holds
+        // back the messages behind it until it resumes.
+        if (slot->sequence != tail + 1) {
+            return false;
+        }
+        barrier();
+        message = slot->message;
+        barrier();
+        slot->sequence = tail + channel_sz;
+        _tail = tail + 1;
+        return true;
+    }
+
+    /** Receive a message, waiting for one if needed, from the receiving thread.
+      @param   message   set to the message received.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever)
+      @return  true if received, false on a timeout.
+    */
+    bool receive(T& message, uint32_t millisec=osWaitForever) {
+        while (!try_receive(message)) {
+            if (!wait(millisec)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Receive up to count messages, waiting for the first if needed, from
+      the receiving thread.
+      @param   messages  array filled with the messages received.
+      @param   count     number of messages the array holds.
+      @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever)
+      @return  number of messages received, 0 on a timeout.
+    */
+    uint32_t receive_n(T* messages, uint32_t count, uint32_t millisec=osWaitForever) {
+        uint32_t received = 0;
+
+        if (count == 0 || !receive(messages[0], millisec)) {
+            return 0;
+        }
+        for (received = 1; received < count; received++) {
+            if (!try_receive(messages[received])) {
+                break;
+            }
+        }
+        return received;
+    }
+
+    /** Check whether a message can be received, from the receiving thread. */
+    bool empty() const {
+        return _slots[_tail & (channel_sz - 1)].sequence != _tail + 1;
+    }
+
+private:
+    struct Slot {
+        volatile uint32_t sequence;
+        T                 message;
+    };
+
+    static void barrier() {
+        __sync_synchronize();
+    }
+
+    static bool compare_and_swap(volatile uint32_t* value, uint32_t expected, uint32_t desired) {
+    #if defined(__CORTEX_M0) || defined(__CORTEX_M0PLUS)
+        // No exclusive access on ARMv6-M: mask interrupts around the update.
+        uint32_t primask = __get_PRIMASK();
+        bool swapped = false;
+
+        __disable_irq();
+        if (*value == expected) {
+            *value = desired;
+            swapped = true;
+        }
+        __set_PRIMASK(primask);
+        return swapped;
+    #else
+        return __sync_bool_compare_and_swap(value, expected, desired);
+    #endif
+    }
+
+    // Ask to be woken by the next sender and sleep, unless a message arrived
+    // in the meantime.  A sender only signals after taking _sleeping back to
+    // 0, so a signal left from a wakeup which came after a timeout is
+    // cleared before the next sleep.
+    bool wait(uint32_t millisec) {
+        if (millisec == 0) {
+            return false;
+        }
+        _receiver = osThreadGetId();
+        osSignalClear(_receiver, _signal);
+        _sleeping = 1;
+        barrier();
+        if (!empty()) {
+            compare_and_swap(&_sleeping, 1, 0);
+            return true;
+        }
+        osEvent evt = osSignalWait(_signal, millisec);
+        if (evt.status == osEventSignal) {
+            return true;
+        }
+        compare_and_swap(&_sleeping, 1, 0);
+        return !empty();
+    }
+
+    Slot              _slots[channel_sz];
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+    osThreadId        _receiver;
+    volatile uint32_t _sleeping;
+    int32_t           _signal;
+};
+
+}
+#endif
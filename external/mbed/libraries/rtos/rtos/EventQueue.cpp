@@ -0,0 +1,410 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "EventQueue.h"
+
+#include <string.h>
+#include <new>
+
+#include "mbed_error.h"
+#if defined(__CORTEX_M0) || defined(__CORTEX_M0PLUS)
+#include "cmsis.h"
+#endif
+
+#ifndef TARGET_HOST
+extern "C" {
+extern uint32_t const os_clockrate;
+uint32_t rt_time_get(void);
+}
+#endif
+
+namespace {
+
+// Set in the state of a timed event by cancel().  The state is otherwise 0
+// while the timed event is free, or the identifier of its current use.
+const uint32_t cancelled = 0x80000000;
+
+void barrier() {
+    __sync_synchronize();
+}
+
+bool compare_and_swap(volatile uint32_t* value, uint32_t expected, uint32_t desired) {
+#if defined(__CORTEX_M0) || defined(__CORTEX_M0PLUS)
+    // No exclusive access on ARMv6-M: mask interrupts around the update.
+    uint32_t primask = __get_PRIMASK();
+    bool swapped = false;
+
+    __disable_irq();
+    if (*value == expected) {
+        *value = desired;
+        swapped = true;
+    }
+    __set_PRIMASK(primask);
+    return swapped;
+#else
+    return __sync_bool_compare_and_swap(value, expected, desired);
+#endif
+}
+
+uint32_t increment(volatile uint32_t* value) {
+    uint32_t old;
+
+    do {
+        old = *value;
+    } while (!compare_and_swap(value, old, old + 1));
+    return old + 1;
+}
+
+// Timed events are kept in kernel ticks, which may be read from an ISR.
+uint32_t now() {
+#ifdef TARGET_HOST
+    return os_host_time();
+#else
+    return rt_time_get();
+#endif
+}
+
+uint32_t to_ticks(uint32_t millisec) {
+#ifdef TARGET_HOST
+    return millisec;
+#else
+    return (uint32_t)(((uint64_t)millisec * 1000 + os_clockrate - 1) / os_clockrate);
+#endif
+}
+
+uint32_t to_millisec(uint32_t ticks) {
+#ifdef TARGET_HOST
+    return ticks;
+#else
+    return (uint32_t)(((uint64_t)ticks * os_clockrate + 999) / 1000);
+#endif
+}
+
+}
+
+namespace rtos {
+
+EventQueue::EventQueue(uint32_t event_count, uint32_t timed_count, int32_t signal) {
+    // The positions run freely and are masked, so must wrap with the size,
+    // and identifiers keep the index of their timed event in the low byte.
+    if (event_count == 0 || (event_count & (event_count - 1)) || timed_count > 255)
+        error("Error creating an EventQueue of %lu events\n", (unsigned long)event_count);
+
+    _slots = new Slot[event_count];
+    _timed = new Timed[timed_count];
+    if (_slots == NULL || _timed == NULL)
+        error("Error allocating the EventQueue memory\n");
+    for (uint32_t i = 0; i < event_count; i++) {
+        _slots[i].sequence = i;
+    }
+    for (uint32_t i = 0; i < timed_count; i++) {
+        _timed[i].state = 0;
+        _timed[i].armed = false;
+    }
+    _event_count = event_count;
+    _timed_count = timed_count;
+    _head = 0;
+    _tail = 0;
+    _generation = 0;
+    _dispatcher = NULL;
+    _sleeping = 0;
+    _break = 0;
+    _dropped = 0;
+    _signal = signal;
+}
+
+EventQueue::~EventQueue() {
+    delete[] _slots;
+    delete[] _timed;
+}
+
+bool EventQueue::post(Handler handler, void *argument) {
+    Event event;
+
+    event.handler = handler;
+    event.argument = argument;
+    event.size = 0;
+    if (!push(event)) {
+        increment(&_dropped);
+        return false;
+    }
+    return true;
+}
+
+bool EventQueue::post(Handler handler, const void *payload, uint32_t size) {
+    Event event;
+
+    if (size > payload_size)
+        return false;
+    event.handler = handler;
+    event.argument = NULL;
+    event.size = size;
+    memcpy(event.payload, payload, size);
+    if (!push(event)) {
+        increment(&_dropped);
+        return false;
+    }
+    return true;
+}
+
+int32_t EventQueue::post_in(uint32_t millisec, Handler handler, void *argument) {
+    return post_timed(millisec, 0, handler, argument);
+}
+
+int32_t EventQueue::post_every(uint32_t millisec, Handler handler, void *argument) {
+    return post_timed(millisec, millisec ? millisec : 1, handler, argument);
+}
+
+bool EventQueue::cancel(int32_t id) {
+    uint32_t index = (id & 0xff) - 1;
+
+    if (id <= 0 || index >= _timed_count)
+        return false;
+    return compare_and_swap(&_timed[index].state, id, id | cancelled);
+}
+
+uint32_t EventQueue::dispatch(uint32_t millisec) {
+    uint32_t start = now();
+    uint32_t limit = (millisec == osWaitForever) ? osWaitForever : to_ticks(millisec);
+    uint32_t count = 0;
+    Event event;
+
+    _dispatcher = osThreadGetId();
+    _break = 0;
+    for (;;) {
+        // Run what was posted, a ring's worth at most before looking at the
+        // timed events, without a service call between events.
+        for (uint32_t i = 0; i < _event_count && pop(event); i++) {
+            if (event.handler == NULL) {
+                arm((Timed *)event.argument);
+            } else {
+                event.handler(event.size ? (void *)event.payload : event.argument);
+                count++;
+            }
+        }
+
+        uint32_t ticks = osWaitForever;
+        count += run_timed(&ticks);
+        if (_break)
+            break;
+        if (limit != osWaitForever) {
+            uint32_t elapsed = now() - start;
+            if (elapsed >= limit)
+                break;
+            if (limit - elapsed < ticks)
+                ticks = limit - elapsed;
+        }
+        wait(ticks);
+    }
+    return count;
+}
+
+void EventQueue::break_dispatch() {
+    _break = 1;
+    barrier();
+    wake();
+}
+
+void EventQueue::worker(void const *queue) {
+    for (;;) {
+        ((EventQueue *)queue)->dispatch();
+    }
+}
+
+// The ring is the one of Channel, but sized when the queue is created.
+bool EventQueue::push(const Event &event) {
+    Slot* slot;
+    uint32_t head;
+
+    for (;;) {
+        head = _head;
+        slot = &_slots[head & (_event_count - 1)];
+        int32_t lag = (int32_t)(slot->sequence - head);
+        if (lag < 0) {
+            return false;
+        }
+        if (lag == 0 && compare_and_swap(&_head, head, head + 1)) {
+            break;
+        }
+    }
+    slot->event = event;
+    barrier();
+    slot->sequence = head + 1;
+    barrier();
+    wake();
+    return true;
+}
+
+bool EventQueue::pop(Event &event) {
+    uint32_t tail = _tail;
+    Slot* slot = &_slots[tail & (_event_count - 1)];
+
+    if (slot->sequence != tail + 1) {
+        return false;
+    }
+    barrier();
+    event = slot->event;
+    barrier();
+    slot->sequence = tail + _event_count;
+    _tail = tail + 1;
+    return true;
+}
+
+bool EventQueue::empty() const {
+    return _slots[_tail & (_event_count - 1)].sequence != _tail + 1;
+}
+
+// A free timed event is claimed by the poster, then handed to the dispatching
+// thread through the ring, so that only that thread arms and runs it.
+int32_t EventQueue::post_timed(uint32_t millisec, uint32_t period, Handler handler, void *argument) {
+    uint32_t deadline = now() + to_ticks(millisec);
+
+    for (uint32_t i = 0; i < _timed_count; i++) {
+        Timed *timed = &_timed[i];
+
+        if (timed->state != 0)
+            continue;
+        uint32_t id = ((increment(&_generation) << 8) | (i + 1)) & ~cancelled;
+        if (!compare_and_swap(&timed->state, 0, id))
+            continue;
+        timed->deadline = deadline;
+        timed->period = to_ticks(period);
+        timed->handler = handler;
+        timed->argument = argument;
+
+        Event event;
+        event.handler = NULL;
+        event.argument = timed;
+        event.size = 0;
+        if (!push(event)) {
+            increment(&_dropped);
+            barrier();
+            timed->state = 0;
+            return 0;
+        }
+        return (int32_t)id;
+    }
+    return 0;
+}
+
+void EventQueue::arm(Timed *timed) {
+    timed->armed = true;
+}
+
+// Run the timed events which are due, and lower ticks to the time until the
+// next one is.
+uint32_t EventQueue::run_timed(uint32_t *ticks) {
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < _timed_count; i++) {
+        Timed *timed = &_timed[i];
+        uint32_t state = timed->state;
+
+        if (!timed->armed)
+            continue;
+        if (state & cancelled) {
+            timed->armed = false;
+            barrier();
+            timed->state = 0;
+            continue;
+        }
+        int32_t remaining = (int32_t)(timed->deadline - now());
+        if (remaining > 0) {
+            if ((uint32_t)remaining < *ticks)
+                *ticks = remaining;
+            continue;
+        }
+
+        Handler handler = timed->handler;
+        void *argument = timed->argument;
+        if (timed->period == 0) {
+            // Freed before it runs, so that it can't be cancelled once started.
+            timed->armed = false;
+            if (!compare_and_swap(&timed->state, state, 0)) {
+                timed->state = 0;
+                continue;
+            }
+            handler(argument);
+            count++;
+            continue;
+        }
+
+        handler(argument);
+        count++;
+        // A period missed while other events ran is skipped, not run late.
+        timed->deadline += timed->period;
+        if ((int32_t)(timed->deadline - now()) <= 0)
+            timed->deadline = now() + timed->period;
+        remaining = (int32_t)(timed->deadline - now());
+        if ((uint32_t)remaining < *ticks)
+            *ticks = remaining;
+    }
+    return count;
+}
+
+// Ask to be woken by the next poster and sleep until the next timed event,
+// unless an event arrived in the meantime.  As in Channel, a signal left
+// from a wakeup which came after a timeout is cleared before the next sleep.
+void EventQueue::wait(uint32_t ticks) {
+    osSignalClear(_dispatcher, _signal);
+    _sleeping = 1;
+    barrier();
+    if (empty() && !_break) {
+        osSignalWait(_signal, ticks == osWaitForever ? osWaitForever : to_millisec(ticks));
+    }
+    compare_and_swap(&_sleeping, 1, 0);
+}
+
+void EventQueue::wake() {
+    if (_sleeping && compare_and_swap(&_sleeping, 1, 0)) {
+        osSignalSet(_dispatcher, _signal);
+    }
+}
+
+}
+
+extern "C" {
+
+void *event_queue_create(uint32_t event_count, uint32_t timed_count) {
+    return new (std::nothrow) rtos::EventQueue(event_count, timed_count);
+}
+
+int event_queue_post(void *queue, event_handler_t handler, void *argument) {
+    return ((rtos::EventQueue *)queue)->post(handler, argument);
+}
+
+int32_t event_queue_post_in(void *queue, uint32_t millisec, event_handler_t handler, void *argument) {
+    return ((rtos::EventQueue *)queue)->post_in(millisec, handler, argument);
+}
+
+int32_t event_queue_post_every(void *queue, uint32_t millisec, event_handler_t handler, void *argument) {
+    return ((rtos::EventQueue *)queue)->post_every(millisec, handler, argument);
+}
+
+int event_queue_cancel(void *queue, int32_t id) {
+    return ((rtos::EventQueue *)queue)->cancel(id);
+}
+
+uint32_t event_queue_dispatch(void *queue, uint32_t millisec) {
+    return ((rtos::EventQueue *)queue)->dispatch(millisec);
+}
+
+}
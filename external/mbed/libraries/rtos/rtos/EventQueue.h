@@ -0,0 +1,189 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <stdint.h>
+
+#include "cmsis_os.h"
+
+#ifdef __cplusplus
+namespace rtos {
+
+/** The EventQueue class defers work from interrupt service routines, and
+ from other threads, to the thread which dispatches the queue.  An event is a
+ function with an argument, or with a small payload copied into the queue,
+ which may also be run after a delay or periodically.  Posting takes no lock
+ and makes no service call unless the dispatching thread is asleep, so many
+ drivers can share one thread, and its stack, in place of one thread each.
+ Events run one after the other in the order posted, in batches, and queues
+ dispatched by threads of different priorities give events priorities.
+ @code
+ // Interrupt service routine                // Worker thread
+ queue.post(handle_rx, &driver);             Thread worker(EventQueue::worker, &queue,
+                                                           osPriorityAboveNormal, 1024);
+ @endcode
+*/
+class EventQueue {
+public:
+    /** Function run for an event, with its argument or a pointer to its payload. */
+    typedef void (*Handler)(void const *argument);
+
+    /** Largest payload in bytes which an event can carry. */
+    static const uint32_t payload_size = 8;
+
+    /** Create an empty EventQueue.
+      @param   event_count  events which may wait in the queue, a power of two. (default: 16)
+      @param   timed_count  delayed and periodic events which may be pending at once. (default: 4)
+      @param   signal       thread signal flag set to wake the dispatching thread. (default: 0x4000)
+    */
+    EventQueue(uint32_t event_count=16, uint32_t timed_count=4, int32_t signal=0x4000);
+
+    ~EventQueue();
+
+    /** Post an event without waiting, from a thread or an interrupt service routine.
+      @param   handler   function to run.
+      @param   argument  pointer passed to the function. (default: NULL)
+      @return  true if posted, false if the queue is full.
+    */
+    bool post(Handler handler, void *argument=NULL);
+
+    /** Post an event with a payload copied into the queue, without waiting,
+      from a thread or an interrupt service routine.
+      @param   handler   function to run, passed a pointer to its copy of the payload.
+      @param   payload   payload to copy.
+      @param   size      size of the payload, at most payload_size bytes.
+      @return  true if posted, false if the queue is full or the payload too big.
+    */
+    bool post(Handler handler, const void *payload, uint32_t size);
+
+    /** Post an event to run once, after a delay, from a thread or an ISR.
+      @param   millisec  delay in milliseconds.
+      @param   handler   function to run.
+      @param   argument  pointer passed to the function. (default: NULL)
+      @return  identifier for cancel(), or 0 if no timed event or queue entry was free.
+    */
+    int32_t post_in(uint32_t millisec, Handler handler, void *argument=NULL);
+
+    /** Post an event to run every period, first after one period, from a thread or an ISR.
+      @param   millisec  period in milliseconds.
+      @param   handler   function to run.
+      @param   argument  pointer passed to the function. (default: NULL)
+      @return  identifier for cancel(), or 0 if no timed event or queue entry was free.
+    */
+    int32_t post_every(uint32_t millisec, Handler handler, void *argument=NULL);
+
+    /** Stop a delayed or periodic event, from a thread or an ISR.
+      @param   id  identifier returned by post_in() or post_every().
+      @return  true if the event was still pending, false if it had run or was cancelled.
+    */
+    bool cancel(int32_t id);
+
+    /** Run events as they are posted, from the one thread which dispatches the queue.
+      @param   millisec  time to dispatch for, or osWaitForever. (default: osWaitForever)
+      @return  number of events run.
+    */
+    uint32_t dispatch(uint32_t millisec=osWaitForever);
+
+    /** Make dispatch() return once the event it runs, if any, is done. */
+    void break_dispatch();
+
+    /** Events lost because the queue was full. */
+    uint32_t dropped() const {
+        return _dropped;
+    }
+
+    /** Thread function which dispatches a queue forever.
+      @param   queue  the EventQueue to dispatch.
+    */
+    static void worker(void const *queue);
+
+private:
+    struct Event {
+        Handler  handler;
+        void    *argument;
+        uint32_t size;
+        uint32_t payload[payload_size / sizeof(uint32_t)];
+    };
+
+    struct Slot {
+        volatile uint32_t sequence;
+        Event             event;
+    };
+
+    struct Timed {
+        volatile uint32_t state;
+        uint32_t          deadline;
+        uint32_t          period;
+        Handler           handler;
+        void             *argument;
+        bool              armed;
+    };
+
+    bool push(const Event &event);
+    bool pop(Event &event);
+    bool empty() const;
+    int32_t post_timed(uint32_t millisec, uint32_t period, Handler handler, void *argument);
+    void arm(Timed *timed);
+    uint32_t run_timed(uint32_t *ticks);
+    void wait(uint32_t ticks);
+    void wake();
+
+    Slot             *_slots;
+    uint32_t          _event_count;
+    volatile uint32_t _head;
+    volatile uint32_t _tail;
+    Timed            *_timed;
+    uint32_t          _timed_count;
+    volatile uint32_t _generation;
+    osThreadId        _dispatcher;
+    volatile uint32_t _sleeping;
+    volatile uint32_t _break;
+    volatile uint32_t _dropped;
+    int32_t           _signal;
+
+    /* disallow copy constructor and assignment operators */
+    EventQueue(const EventQueue&);
+    EventQueue& operator=(const EventQueue&);
+};
+
+}
+
+extern "C" {
+#endif
+
+/* Binding of EventQueue for drivers written in C.  event_queue_create()
+   returns NULL when there isn't the memory for the queue. */
+typedef void (*event_handler_t)(void const *argument);
+
+void    *event_queue_create(uint32_t event_count, uint32_t timed_count);
+int      event_queue_post(void *queue, event_handler_t handler, void *argument);
+int32_t  event_queue_post_in(void *queue, uint32_t millisec, event_handler_t handler, void *argument);
+int32_t  event_queue_post_every(void *queue, uint32_t millisec, event_handler_t handler, void *argument);
+int      event_queue_cancel(void *queue, int32_t id);
+uint32_t event_queue_dispatch(void *queue, uint32_t millisec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
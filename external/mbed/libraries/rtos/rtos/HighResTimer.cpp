@@ -0,0 +1,204 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "HighResTimer.h"
+
+#include <string.h>
+
+#include "cmsis.h"
+#include "Thread.h"
+#include "mbed_error.h"
+
+namespace {
+
+const int32_t TIMER_SIGNAL = 0x1;
+
+}
+
+namespace rtos {
+
+static Thread *timer_thread_object;
+
+// Timers which expired and wait for the timer thread, oldest first.  The
+// us_ticker interrupt appends to the list, the timer thread takes from it
+// with interrupts masked.
+static HighResTimer *queue_head;
+static HighResTimer *queue_tail;
+
+HighResTimer::HighResTimer(void (*task)(void const *argument), os_timer_type type, void *argument) {
+    _task = task;
+    _argument = argument;
+    _type = type;
+    _period = 0;
+    _deadline = 0;
+    _active = false;
+    _next = NULL;
+    _due = 0;
+    _expirations = 0;
+    reset_stats();
+}
+
+osStatus HighResTimer::start(uint32_t microsec) {
+    if (microsec == 0) {
+        return osErrorParameter;
+    }
+    if (timer_thread_object == NULL) {
+        start_thread();
+    }
+    stop();
+
+    _period = microsec;
+    _deadline = us_ticker_read() + microsec;
+    _active = true;
+    insert(_deadline);
+    return osOK;
+}
+
+osStatus HighResTimer::stop(void) {
+    remove();
+
+    __disable_irq();
+    bool active = _active;
+    _active = false;
+    if (_expirations) {
+        // Unlink it from the queue of the timer thread.
+        HighResTimer *prev = NULL;
+        for (HighResTimer *p = queue_head; p != NULL; prev = p, p = p->_next) {
+            if (p == this) {
+                if (prev == NULL) {
+                    queue_head = _next;
+                } else {
+                    prev->_next = _next;
+                }
+                if (queue_tail == this) {
+                    queue_tail = prev;
+                }
+                break;
+            }
+        }
+        _expirations = 0;
+    }
+    __enable_irq();
+
+    return active ? osOK : osErrorResource;
+}
+
+void HighResTimer::stats(HighResTimerStats *stats) {
+    __disable_irq();
+    *stats = _stats;
+    __enable_irq();
+    stats->jitter_us = stats->runs ? stats->max_late_us - stats->min_late_us : 0;
+}
+
+void HighResTimer::reset_stats(void) {
+    __disable_irq();
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.min_late_us = 0xFFFFFFFF;
+    __enable_irq();
+}
+
+osStatus HighResTimer::start_thread(osPriority priority, uint32_t stack_size) {
+    if (timer_thread_object != NULL) {
+        return timer_thread_object->set_priority(priority);
+    }
+    timer_thread_object = new Thread(timer_thread, NULL, priority, stack_size);
+    if (timer_thread_object == NULL) {
+        error("Error creating the HighResTimer thread\n");
+    }
+    return osOK;
+}
+
+HighResTimer::~HighResTimer() {
+    stop();
+}
+
+// Called from the us_ticker interrupt.  A periodic timer is due again a period
+// after its last deadline, not after now, so that it doesn't drift; should the
+// interrupt run that late, us_ticker calls it again straight away.
+void HighResTimer::handler() {
+    if (_expirations++ == 0) {
+        _due = _deadline;
+        _next = NULL;
+        if (queue_tail == NULL) {
+            queue_head = this;
+            osSignalSet(timer_thread_object->gettid(), TIMER_SIGNAL);
+        } else {
+            queue_tail->_next = this;
+        }
+        queue_tail = this;
+    }
+
+    if (_type == osTimerPeriodic) {
+        _deadline += _period;
+        insert(_deadline);
+    } else {
+        _active = false;
+    }
+}
+
+// Called from the timer thread once the timer was taken off the queue, with
+// the deadline and count of the expirations it was queued for.
+void HighResTimer::run(timestamp_t due, uint32_t expirations) {
+    uint32_t late_us = us_ticker_read() - due;
+    _stats.runs++;
+    _stats.overruns += expirations - 1;
+    _stats.late_us = late_us;
+    if (late_us < _stats.min_late_us) {
+        _stats.min_late_us = late_us;
+    }
+    if (late_us > _stats.max_late_us) {
+        _stats.max_late_us = late_us;
+    }
+
+    _task(_argument);
+}
+
+void HighResTimer::timer_thread(void const *argument) {
+    for (;;) {
+        Thread::signal_wait(TIMER_SIGNAL);
+
+        for (;;) {
+            timestamp_t due = 0;
+            uint32_t expirations = 0;
+
+            // Expirations from now on queue the timer again.
+            __disable_irq();
+            HighResTimer *timer = queue_head;
+            if (timer != NULL) {
+                queue_head = timer->_next;
+                if (queue_head == NULL) {
+                    queue_tail = NULL;
+                }
+                due = timer->_due;
+                expirations = timer->_expirations;
+                timer->_expirations = 0;
+            }
+            __enable_irq();
+
+            if (timer == NULL) {
+                break;
+            }
+            timer->run(due, expirations);
+        }
+    }
+}
+
+}
@@ -0,0 +1,117 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RTOS_HIGHRESTIMER_H
+#define RTOS_HIGHRESTIMER_H
+
+#include <stdint.h>
+#include "cmsis_os.h"
+#include "TimerEvent.h"
+
+namespace rtos {
+
+/** Counters kept for each HighResTimer by the timer thread. */
+typedef struct {
+    uint32_t runs;          /**< Callbacks run */
+    uint32_t overruns;      /**< Expirations merged into one still waiting for the thread */
+    uint32_t late_us;       /**< How late the last callback started, in microseconds */
+    uint32_t min_late_us;   /**< Earliest callback start so far, in microseconds */
+    uint32_t max_late_us;   /**< Latest callback start so far, in microseconds */
+    uint32_t jitter_us;     /**< Spread from the earliest to the latest start, in microseconds */
+} HighResTimerStats;
+
+/** The HighResTimer class is an RtosTimer with microsecond deadlines.
+ Its deadlines are kept by us_ticker rather than by the kernel tick, and its
+ callbacks run in a timer thread of its own, whose priority can be chosen,
+ so they may use CMSIS-RTOS API calls.
+
+ A timer which expires is queued for the timer thread once: when it expires
+ again before its callback has run, the callback still runs once and the
+ expiration is counted as an overrun.  The queue therefore never holds more
+ than one entry per timer and never drops a callback, where the callback
+ queue of osTimerThread, OS_TIMERCBQS entries long, can fill up.
+*/
+class HighResTimer : private mbed::TimerEvent {
+public:
+    /** Create a timer, stopped.
+      @param   task      timer call back function.
+      @param   type      osTimerOnce for one-shot or osTimerPeriodic for periodic behaviour. (default: osTimerPeriodic)
+      @param   argument  argument to the timer call back function. (default: NULL)
+    */
+    HighResTimer(void (*task)(void const *argument),
+                 os_timer_type type=osTimerPeriodic,
+                 void *argument=NULL);
+
+    /** Start or restart the timer, starting the timer thread if needed.
+      @param   microsec  period, or delay of a one-shot timer, in microseconds.
+      @return  osOK, or osErrorParameter for a period of 0.
+    */
+    osStatus start(uint32_t microsec);
+
+    /** Stop the timer, dropping a callback which is waiting to run.
+      @return  osOK, or osErrorResource if the timer wasn't running.
+    */
+    osStatus stop(void);
+
+    /** Get a copy of the counters of the timer.
+      @param   stats  set to the counters.
+    */
+    void stats(HighResTimerStats *stats);
+
+    /** Clear the counters of the timer. */
+    void reset_stats(void);
+
+    /** Start the timer thread, or change its priority if it is running.
+      The first timer started starts it at osPriorityHigh otherwise.
+      @param   priority    priority of the timer thread. (default: osPriorityHigh)
+      @param   stack_size  stack size of the timer thread in bytes. (default: DEFAULT_STACK_SIZE)
+      @return  status code that indicates the execution status of the function.
+    */
+    static osStatus start_thread(osPriority priority=osPriorityHigh,
+                                 uint32_t stack_size=DEFAULT_STACK_SIZE);
+
+    /** Stops the timer.  Its callback must not be running meanwhile. */
+    virtual ~HighResTimer();
+
+private:
+    virtual void handler();
+    void run(timestamp_t due, uint32_t expirations);
+
+    static void timer_thread(void const *argument);
+
+    void (*_task)(void const *argument);
+    void *_argument;
+    os_timer_type _type;
+    uint32_t _period;
+    timestamp_t _deadline;
+    volatile bool _active;
+
+    // Set by the us_ticker interrupt while queued for the timer thread.
+    HighResTimer *_next;
+    timestamp_t _due;
+    uint32_t _expirations;
+
+    HighResTimerStats _stats;
+};
+
+}
+
+#endif
@@ -29,6 +29,8 @@ namespace rtos {
 
 /** The Mutex class is used to synchronise the execution of threads.
  This is for example used to protect access to a shared resource.
+ Locking a free mutex, and unlocking it before another thread waits for it,
+ doesn't enter the kernel.
 */
 class Mutex {
 public:
@@ -33,6 +33,7 @@ namespace rtos {
 
  Timers are handled in the thread osTimerThread.
  Callback functions run under control of this thread and may use CMSIS-RTOS API calls.
+ For periods shorter or finer than the kernel tick, see HighResTimer.
 */
 class RtosTimer {
 public:
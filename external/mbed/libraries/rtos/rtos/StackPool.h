@@ -0,0 +1,71 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef STACKPOOL_H
+#define STACKPOOL_H
+
+#include <stdint.h>
+
+#include "Thread.h"
+#include "MemoryPool.h"
+
+namespace rtos {
+
+/** A pool of thread stacks in static memory, for Threads which shouldn't
+ take their stacks from the heap. A stack is taken when a Thread is created
+ from the pool and given back when it is destroyed.
+ @code
+ StackPool<1024, 4> workers;                 // 4 stacks of 1 KB
+ Thread thread(worker_task, workers);
+ @endcode
+  @tparam  stack_sz  size of each stack in bytes, a multiple of 8.
+  @tparam  pool_sz   number of stacks in the pool.
+*/
+template<uint32_t stack_sz, uint32_t pool_sz>
+class StackPool : public ThreadStackPool {
+public:
+    /** Take a stack from the pool.
+      @return  the stack, or NULL if every stack is in use.
+    */
+    virtual unsigned char *alloc_stack() {
+        return (unsigned char*)_pool.alloc();
+    }
+
+    /** Give a stack back to the pool. */
+    virtual void free_stack(unsigned char *stack) {
+        _pool.free((Stack*)stack);
+    }
+
+    /** Size of each stack in bytes. */
+    virtual uint32_t stack_size() {
+        return stack_sz;
+    }
+
+private:
+    typedef struct {
+        uint64_t words[stack_sz / 8];
+    } Stack;
+
+    MemoryPool<Stack, pool_sz> _pool;
+};
+
+}
+#endif
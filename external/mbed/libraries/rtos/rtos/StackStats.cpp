@@ -0,0 +1,90 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "StackStats.h"
+
+#include "cmsis.h"
+
+extern "C" {
+extern void *os_active_TCB[];
+extern uint16_t const os_maxtaskrun;
+extern uint8_t const os_stkpaint;
+extern struct OS_TCB os_idle_TCB;
+extern uint32_t *const os_main_stack;
+uint32_t *os_main_stack_free(void);
+uint32_t rt_stk_max(uint32_t *stack, uint32_t size);
+}
+
+namespace rtos {
+
+static void read_stats(StackStats *stats, P_TCB tcb, osThreadId id) {
+    stats->id = id;
+    stats->task = (os_pthread)tcb->ptask;
+    stats->max_used = rt_stk_max((uint32_t*)tcb->stack, tcb->priv_stack);
+    if (tcb->stack == os_main_stack) {
+        stats->size = (char*)&tcb->stack[tcb->priv_stack / 4] - (char*)os_main_stack_free();
+    } else {
+        stats->size = tcb->priv_stack;
+    }
+}
+
+uint32_t stack_stats(StackStats *stats, uint32_t count) {
+    uint32_t found = 0;
+
+    // Active threads are in os_active_TCB by task ID, main first.  The scan
+    // of a stack is long, so only the lookup of the thread is locked.
+    for (uint32_t i = 0; i < os_maxtaskrun && found < count; i++) {
+        __disable_irq();
+        P_TCB tcb = (P_TCB)os_active_TCB[i];
+        __enable_irq();
+        if (tcb != NULL) {
+            read_stats(&stats[found++], tcb, (osThreadId)tcb);
+        }
+    }
+    if (found < count) {
+        read_stats(&stats[found++], &os_idle_TCB, NULL);
+    }
+    return found;
+}
+
+uint32_t stack_suggest(uint32_t max_used) {
+    return (max_used + max_used / 4 + 64 + 7) & ~7;
+}
+
+void stack_report(FILE *file) {
+    StackStats stats[16];
+    uint32_t count = stack_stats(stats, sizeof(stats) / sizeof(stats[0]));
+
+    if (!os_stkpaint) {
+        fprintf(file, "Stacks aren't painted, build RTX with OS_STKPAINT=1\r\n");
+        return;
+    }
+    fprintf(file, "thread      task        size   used  suggested\r\n");
+    for (uint32_t i = 0; i < count; i++) {
+        fprintf(file, "0x%08lx  0x%08lx  %5lu  %5lu  %5lu%s\r\n",
+                (unsigned long)stats[i].id, (unsigned long)stats[i].task,
+                (unsigned long)stats[i].size, (unsigned long)stats[i].max_used,
+                (unsigned long)stack_suggest(stats[i].max_used),
+                stats[i].max_used >= stats[i].size ? "  overflowed" : "");
+    }
+}
+
+}
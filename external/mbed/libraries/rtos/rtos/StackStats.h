@@ -0,0 +1,66 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RTOS_STACKSTATS_H
+#define RTOS_STACKSTATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "cmsis_os.h"
+
+namespace rtos {
+
+/** Stack use of a thread. RTX measures it when built with OS_STKPAINT=1: each
+ stack is filled with a pattern when its thread is created, and the deepest
+ use is where the pattern stops.  The stack of main starts at the top of the
+ heap, so its size is what the heap has left of it.
+*/
+typedef struct {
+    osThreadId id;          /**< Thread ID, NULL for the idle thread */
+    os_pthread task;        /**< Function run by the thread */
+    uint32_t   size;        /**< Stack size in bytes */
+    uint32_t   max_used;    /**< Most bytes of stack ever used, 0 unless OS_STKPAINT is set */
+} StackStats;
+
+/** Get the stack use of every thread: main and the other active threads,
+ the timer thread and the idle thread. Call it from a thread.
+  @param   stats  set to the stack use of up to count threads.
+  @param   count  number of entries in stats.
+  @return  number of entries set.
+*/
+uint32_t stack_stats(StackStats *stats, uint32_t count);
+
+/** Stack size to give a thread which has used at most max_used bytes: a
+ quarter more, plus 64 bytes for an exception frame, in multiples of 8.
+  @param   max_used  most bytes of stack used, from StackStats.
+  @return  suggested stack size in bytes.
+*/
+uint32_t stack_suggest(uint32_t max_used);
+
+/** Print a line for each thread with its stack size, the most it used and
+ the suggested size.
+  @param   file  file to print to. (default: stdout)
+*/
+void stack_report(FILE *file=stdout);
+
+}
+
+#endif
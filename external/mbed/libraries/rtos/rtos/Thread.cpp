@@ -23,10 +23,29 @@
 
 #include "mbed_error.h"
 
+#if defined(CMSIS_OS_RTX) && !defined(__MBED_CMSIS_RTOS_CA9) && !defined(TARGET_HOST)
+extern "C" uint32_t rt_stk_max(uint32_t *stack, uint32_t size);
+#endif
+
 namespace rtos {
 
 Thread::Thread(void (*task)(void const *argument), void *argument,
         osPriority priority, uint32_t stack_size, unsigned char *stack_pointer) {
+    _stack_pool = NULL;
+    start(task, argument, priority, stack_size, stack_pointer);
+}
+
+Thread::Thread(void (*task)(void const *argument), ThreadStackPool &pool,
+        void *argument, osPriority priority) {
+    unsigned char *stack_pointer = pool.alloc_stack();
+    if (stack_pointer == NULL)
+        error("Error taking a stack from the pool\n");
+    _stack_pool = &pool;
+    start(task, argument, priority, pool.stack_size(), stack_pointer);
+}
+
+void Thread::start(void (*task)(void const *argument), void *argument,
+        osPriority priority, uint32_t stack_size, unsigned char *stack_pointer) {
 #ifdef CMSIS_OS_RTX
     _thread_def.pthread = task;
     _thread_def.tpriority = priority;
@@ -72,6 +91,22 @@ Thread::State Thread::get_state() {
 #endif
 }
 
+uint32_t Thread::stack_size() {
+#ifdef CMSIS_OS_RTX
+    return _thread_def.stacksize;
+#else
+    return 0;
+#endif
+}
+
+uint32_t Thread::max_stack() {
+#if defined(CMSIS_OS_RTX) && !defined(__MBED_CMSIS_RTOS_CA9) && !defined(TARGET_HOST)
+    return rt_stk_max((uint32_t*)_thread_def.stack_pointer, _thread_def.stacksize);
+#else
+    return 0;
+#endif
+}
+
 osEvent Thread::signal_wait(int32_t signals, uint32_t millisec) {
     return osSignalWait(signals, millisec);
 }
@@ -95,6 +130,9 @@ Thread::~Thread() {
         delete[] (_thread_def.stack_pointer);
     }
 #endif
+    if (_stack_pool) {
+        _stack_pool->free_stack(_thread_def.stack_pointer);
+    }
 }
 
 }
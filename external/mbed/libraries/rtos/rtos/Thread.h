@@ -27,6 +27,26 @@
 
 namespace rtos {
 
+/** Source of thread stacks in static memory, such as a StackPool, so that
+ Threads created from it don't allocate their stacks on the heap.
+*/
+class ThreadStackPool {
+public:
+    /** Take a stack from the pool.
+      @return  the stack, or NULL if the pool is empty.
+    */
+    virtual unsigned char *alloc_stack() = 0;
+
+    /** Give a stack taken with alloc_stack() back to the pool. */
+    virtual void free_stack(unsigned char *stack) = 0;
+
+    /** Size of each stack of the pool in bytes. */
+    virtual uint32_t stack_size() = 0;
+
+protected:
+    ~ThreadStackPool() {}
+};
+
 /** The Thread class allow defining, creating, and controlling thread functions in the system. */
 class Thread {
 public:
@@ -42,6 +62,16 @@ public:
            uint32_t stack_size=DEFAULT_STACK_SIZE,
            unsigned char *stack_pointer=NULL);
 
+    /** Create a new thread on a stack taken from a pool, and start it executing the specified function.
+      The stack is given back to the pool when the Thread is destroyed.
+      @param   task           function to be executed by this thread.
+      @param   pool           pool to take the stack from, such as a StackPool.
+      @param   argument       pointer that is passed to the thread function as start argument. (default: NULL).
+      @param   priority       initial priority of the thread function. (default: osPriorityNormal).
+    */
+    Thread(void (*task)(void const *argument), ThreadStackPool &pool,
+           void *argument=NULL, osPriority priority=osPriorityNormal);
+
     /** Terminate execution of a thread and remove it from Active Threads
       @return  status code that indicates the execution status of the function.
     */
@@ -83,6 +113,16 @@ public:
     */
     State get_state();
 
+    /** Size of the stack of this Thread
+      @return  stack size in bytes.
+    */
+    uint32_t stack_size();
+
+    /** Most stack this Thread has used so far, measured when RTX is built with OS_STKPAINT=1
+      @return  bytes of stack ever used, or 0 if stacks aren't painted.
+    */
+    uint32_t max_stack();
+
     /** Wait for one or more Signal Flags to become signaled for the current RUNNING thread.
       @param   signals   wait until all specified signal flags set or 0 for any single signal flag.
       @param   millisec  timeout value or 0 in case of no time-out. (default: osWaitForever).
@@ -109,9 +149,13 @@ public:
     virtual ~Thread();
 
 private:
+    void start(void (*task)(void const *argument), void *argument,
+               osPriority priority, uint32_t stack_size, unsigned char *stack_pointer);
+
     osThreadId _tid;
     osThreadDef_t _thread_def;
     bool _dynamic_stack;
+    ThreadStackPool *_stack_pool;
 };
 
 }
@@ -0,0 +1,128 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Tickless.h"
+
+#include "cmsis.h"
+#include "cmsis_os.h"
+#include "TimerEvent.h"
+#include "us_ticker_api.h"
+
+extern "C" {
+extern uint32_t const os_clockrate;
+void os_tickless_idle(void);
+}
+
+namespace rtos {
+
+static TicklessStats counters;
+
+void tickless_stats(TicklessStats *stats) {
+    __disable_irq();
+    *stats = counters;
+    __enable_irq();
+}
+
+}
+
+#ifdef __CORTEX_M
+
+namespace {
+
+// The us_ticker interrupt only has to wake the core up.
+class TicklessWakeup : public mbed::TimerEvent {
+public:
+    void set(timestamp_t timestamp) {
+        insert(timestamp);
+    }
+
+    void cancel() {
+        remove();
+    }
+
+protected:
+    virtual void handler() {
+    }
+};
+
+}
+
+using namespace rtos;
+
+// Called over and over by the idle thread when OS_TICKLESS is set.  The system
+// tick is SysTick, which keeps counting while the scheduler is suspended, so
+// the part of the current tick already gone is read from it, and the ticks
+// which passed while asleep follow from us_ticker.
+void os_tickless_idle(void) {
+    static TicklessWakeup wakeup;
+    uint32_t tick_us = os_clockrate;
+    uint32_t ticks = os_suspend();
+
+    if (ticks < 2) {
+        // The next tick is due anyway.
+        os_resume(0);
+        __WFI();
+        return;
+    }
+    if (ticks > 0x7FFFFFFF / tick_us) {
+        ticks = 0x7FFFFFFF / tick_us;
+    }
+
+    uint32_t cycles_per_us = (SysTick->LOAD + 1) / tick_us;
+    uint32_t start = us_ticker_read();
+    uint32_t phase = (SysTick->LOAD - SysTick->VAL) / cycles_per_us;
+    // Wake at the tick which expires the first timeout.
+    uint32_t due = ticks * tick_us - phase;
+
+    wakeup.set(start + due);
+
+    // An interrupt between os_suspend() and here only leaves a request for
+    // the scheduler, so check for one with interrupts off; __WFI() still
+    // returns once any interrupt is pending.
+    __disable_irq();
+    if (os_suspend_pending()) {
+        __enable_irq();
+        wakeup.cancel();
+        os_resume(0);
+        return;
+    }
+    __DSB();
+    __WFI();
+    uint32_t elapsed = us_ticker_read() - start;
+    __enable_irq();
+    wakeup.cancel();
+
+    uint32_t skipped = (phase + elapsed) / tick_us;
+
+    counters.sleeps++;
+    counters.skipped += skipped;
+    if (elapsed < due) {
+        counters.early++;
+    } else {
+        counters.late_us = elapsed - due;
+        if (counters.late_us > counters.max_late_us) {
+            counters.max_late_us = counters.late_us;
+        }
+    }
+    os_resume(skipped);
+}
+
+#endif
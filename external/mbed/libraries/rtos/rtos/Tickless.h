@@ -0,0 +1,48 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RTOS_TICKLESS_H
+#define RTOS_TICKLESS_H
+
+#include <stdint.h>
+
+namespace rtos {
+
+/** Counters kept by the idle thread when RTX is built with OS_TICKLESS=1.
+ In that mode the idle thread stops the system tick while every thread waits,
+ and sleeps until the next thread or timer timeout, woken by us_ticker.
+*/
+typedef struct {
+    uint32_t sleeps;        /**< Sleeps across more than one tick */
+    uint32_t skipped;       /**< System ticks skipped while asleep */
+    uint32_t early;         /**< Sleeps ended before their timeout by another interrupt */
+    uint32_t late_us;       /**< How late the last timed wake-up was, in microseconds */
+    uint32_t max_late_us;   /**< Latest timed wake-up so far, in microseconds */
+} TicklessStats;
+
+/** Get a copy of the tickless idle counters.
+  @param   stats  set to the counters, all 0 unless OS_TICKLESS is set.
+*/
+void tickless_stats(TicklessStats *stats);
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Trace.h"
+
+#include "cmsis_os.h"
+
+namespace rtos {
+
+static void put_stream(void *context, const void *data, uint32_t size) {
+    mbed::Stream *stream = (mbed::Stream *)context;
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (size--) {
+        stream->putc(*p++);
+    }
+}
+
+static void put_file(void *context, const void *data, uint32_t size) {
+    fwrite(data, 1, size, (FILE *)context);
+}
+
+void Trace::marker(uint16_t id, uint32_t value) {
+    os_trace_marker(id, value);
+}
+
+void Trace::isr_enter() {
+    os_trace_isr_enter();
+}
+
+void Trace::isr_exit() {
+    os_trace_isr_exit();
+}
+
+uint32_t Trace::dump(mbed::Stream &stream) {
+    return os_trace_dump(put_stream, &stream);
+}
+
+uint32_t Trace::dump(FILE *file) {
+    uint32_t size = os_trace_dump(put_file, file);
+    fflush(file);
+    return size;
+}
+
+}
@@ -0,0 +1,67 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef RTOS_TRACE_H
+#define RTOS_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "Stream.h"
+
+namespace rtos {
+
+/** Trace of thread switches, waits, interrupts and markers, kept by RTX in a
+ ring of the latest records when it is built with OS_TRACE=1. The dump is
+ decoded on the host by host/RtxTrace into a timeline.
+*/
+class Trace {
+public:
+    /** Record a marker, from a thread or an ISR.
+      @param   id     marker identifier.
+      @param   value  value recorded with the marker (default: 0).
+    */
+    static void marker(uint16_t id, uint32_t value=0);
+
+    /** Record entry to the active interrupt handler, first thing in the ISR.
+    */
+    static void isr_enter();
+
+    /** Record exit from the active interrupt handler, last thing in the ISR.
+    */
+    static void isr_exit();
+
+    /** Write the binary trace to a stream, such as a Serial port. Other text
+      may come before or after it, the decoder looks for the start.
+      @param   stream  stream to write the trace to.
+      @return  number of bytes written.
+    */
+    static uint32_t dump(mbed::Stream &stream);
+
+    /** Write the binary trace to a file, opened in binary mode.
+      @param   file  file to write the trace to.
+      @return  number of bytes written.
+    */
+    static uint32_t dump(FILE *file);
+};
+
+}
+
+#endif
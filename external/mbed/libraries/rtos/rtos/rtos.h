@@ -23,12 +23,21 @@
 #define RTOS_H
 
 #include "Thread.h"
+#include "StackPool.h"
 #include "Mutex.h"
 #include "RtosTimer.h"
 #include "Semaphore.h"
 #include "Mail.h"
 #include "MemoryPool.h"
 #include "Queue.h"
+#include "Channel.h"
+#include "EventQueue.h"
+#ifndef TARGET_HOST
+#include "Tickless.h"
+#include "Trace.h"
+#include "StackStats.h"
+#include "HighResTimer.h"
+#endif
 
 using namespace rtos;
 
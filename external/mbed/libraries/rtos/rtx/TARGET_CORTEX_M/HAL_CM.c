@@ -88,12 +88,53 @@ void rt_init_stack (P_TCB p_TCB, FUNCP task_body) {
   p_TCB->ptask = task_body;
 
   /* Set a magic word for checking of stack overflow.
-   For the main thread (ID: 0x01) the stack is in a memory area shared with the
+   For the main thread the stack is in a memory area shared with the
    heap, therefore the last word of the stack is a moving target.
    We want to do stack/heap collision detection instead.
+   The task ID isn't assigned yet, so main is known by its stack.
   */
-  if (p_TCB->task_id != 0x01)
+  if (p_TCB->stack != os_main_stack) {
       p_TCB->stack[0] = MAGIC_WORD;
+      if (os_stkpaint) {
+          rt_stk_paint (&p_TCB->stack[1], stk);
+      }
+  }
+}
+
+
+/*--------------------------- rt_stk_paint ----------------------------------*/
+
+void rt_stk_paint (U32 *stk, U32 *top) {
+  /* Fill a stack from "stk" up to "top" with a pattern, for rt_stk_max. */
+  while (stk < top) {
+    *stk++ = MAGIC_PATTERN;
+  }
+}
+
+
+/*--------------------------- rt_stk_max ------------------------------------*/
+
+U32 rt_stk_max (U32 *stack, U32 size) {
+  /* Return the most bytes of a task stack of "size" bytes which were ever
+     used: the stack was painted when created, so this is from the lowest word
+     which doesn't hold the pattern any more up to the top.  It can still be
+     read once the task has ended.  0 when stacks aren't painted.  The stack
+     of main is only checked above the top of the heap. */
+  U32 *stk, *top;
+
+  if (!os_stkpaint || stack == NULL) {
+    return (0);
+  }
+  top = &stack[size >> 2];
+  if (stack == os_main_stack) {
+    stk = os_main_stack_free ();
+  } else {
+    stk = &stack[1];
+  }
+  while (stk < top && *stk == MAGIC_PATTERN) {
+    stk++;
+  }
+  return ((U32)top - (U32)stk);
 }
 
 
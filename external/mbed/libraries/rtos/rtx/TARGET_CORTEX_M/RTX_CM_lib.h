@@ -94,6 +94,7 @@ uint16_t const os_maxtaskrun = OS_TASK_CNT;
 uint32_t const os_rrobin     = (OS_ROBIN << 16) | OS_ROBINTOUT;
 uint32_t const os_trv        = OS_TRV;
 uint8_t  const os_flags      = OS_RUNPRIV;
+uint8_t  const os_stkpaint   = OS_STKPAINT;
 
 /* Export following defines to uVision debugger. */
 __USED uint32_t const os_clockrate = OS_TICK;
@@ -296,12 +297,32 @@ extern unsigned char     __end__[];
 #define HEAP_START      (__end__)
 #endif
 
+// The stack of main starts at the bottom of the heap
+uint32_t *const os_main_stack = (uint32_t *)HEAP_START;
+
+// Lowest word of the stack of main which the heap hasn't grown into yet
+uint32_t *os_main_stack_free(void) {
+#if defined(TOOLCHAIN_GCC_ARM)
+    extern void *_sbrk(int incr);
+    return (uint32_t *)(((uint32_t)_sbrk(0) + 3) & ~3);
+#else
+    return os_main_stack;
+#endif
+}
+
 void set_main_stack(void) {
     // That is the bottom of the main stack block: no collision detection
     os_thread_def_main.stack_pointer = HEAP_START;
 
     // Leave OS_SCHEDULERSTKSIZE words for the scheduler and interrupts
     os_thread_def_main.stacksize = (INITIAL_SP - (unsigned int)HEAP_START) - (OS_SCHEDULERSTKSIZE * 4);
+
+#if OS_STKPAINT
+    extern void rt_stk_paint(uint32_t *stk, uint32_t *top);
+
+    // Only paint above the heap, which global constructors may have used
+    rt_stk_paint(os_main_stack_free(), (uint32_t *)(INITIAL_SP - (OS_SCHEDULERSTKSIZE * 4)));
+#endif
 }
 
 #if defined (__CC_ARM)
@@ -53,6 +53,8 @@ extern void *os_active_TCB[];
 extern U16 const os_maxtaskrun;
 extern U32 const os_trv;
 extern U8  const os_flags;
+extern U8  const os_stkpaint;
+extern U32 *const os_main_stack;
 extern U32 const os_rrobin;
 extern U32 const os_clockrate;
 extern U32 const os_timernum;
@@ -66,6 +68,7 @@ extern int  os_tick_init    (void);
 extern void os_tick_irqack  (void);
 extern void os_tmr_call     (U16  info);
 extern void os_error        (U32 err_code);
+extern U32 *os_main_stack_free (void);
 
 /*----------------------------------------------------------------------------
  * end of file
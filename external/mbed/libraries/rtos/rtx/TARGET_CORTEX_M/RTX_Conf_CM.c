@@ -97,6 +97,15 @@
  #define OS_STKCHECK    1
 #endif
 
+// <q>Paint thread stacks
+// <i> Fills each stack with a pattern when its thread is created, so that
+// <i> the deepest use of each stack can be read back and reported.
+// <i> Note that creating threads takes longer.
+// <i> Default: 0  (disabled)
+#ifndef OS_STKPAINT
+ #define OS_STKPAINT    0
+#endif
+
 // <o>Processor mode for thread execution
 //   <0=> Unprivileged mode
 //   <1=> Privileged mode
@@ -164,6 +173,15 @@
  #define OS_TICK        1000
 #endif
 
+//   <q>Tickless idle
+//   <i> Stops the timer tick while all threads wait, waking from us_ticker
+//   <i> for the next thread or timer timeout.
+//   <i> Sleeping may upset a debugger or the LocalFileSystem.
+//   <i> Default: 0  (disabled)
+#ifndef OS_TICKLESS
+ #define OS_TICKLESS    0
+#endif
+
 // </h>
 
 // <h>System Configuration
@@ -249,16 +267,25 @@
 /*----------------------------------------------------------------------------
  *      OS Idle daemon
  *---------------------------------------------------------------------------*/
+#if OS_TICKLESS
+extern void os_tickless_idle (void);
+#endif
+
 void os_idle_demon (void) {
   /* The idle demon is a system thread, running when no other thread is      */
   /* ready to run.                                                           */
 
   /* Sleep: ideally, we should put the chip to sleep.
      Unfortunately, this usually requires disconnecting the interface chip (debugger).
-     This can be done, but it would break the local file system.
+     This can be done, but it would break the local file system, so it is
+     only done when OS_TICKLESS is set.
   */
   for (;;) {
+#if OS_TICKLESS
+      os_tickless_idle();
+#else
       // sleep();
+#endif
   }
 }
 
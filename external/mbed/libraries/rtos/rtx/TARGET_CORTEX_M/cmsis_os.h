@@ -321,6 +321,42 @@ osStatus osKernelStart (void);
 /// \return 0 RTOS is not started, 1 RTOS is started.
 int32_t osKernelRunning(void);
 
+/// Suspend the RTX task scheduler, from the idle thread, for a tickless sleep.
+/// \return number of system ticks until the next thread or timer timeout, 0xFFFF if none.
+/// \note RTX specific, the scheduler stays suspended until \ref os_resume is called.
+uint32_t os_suspend (void);
+
+/// Resume the RTX task scheduler after a tickless sleep.
+/// \param[in]     sleep_time    number of system ticks which passed while suspended.
+/// \note RTX specific.
+void os_resume (uint32_t sleep_time);
+
+/// Check whether an ISR made a thread ready while the task scheduler is suspended.
+/// \return 1 if the idle thread should not go to sleep.
+/// \note RTX specific, may be called with interrupts disabled.
+int32_t os_suspend_pending (void);
+
+/// Record a marker in the RTX trace, from a thread or an ISR.
+/// \param[in]     id            marker identifier, shown by the trace decoder.
+/// \param[in]     value         value recorded with the marker.
+/// \note RTX specific, does nothing unless RTX is built with OS_TRACE set.
+void os_trace_marker (uint16_t id, uint32_t value);
+
+/// Record entry to the active interrupt handler in the RTX trace.
+/// \note RTX specific, call first thing in the ISR.
+void os_trace_isr_enter (void);
+
+/// Record exit from the active interrupt handler in the RTX trace.
+/// \note RTX specific, call last thing in the ISR.
+void os_trace_isr_exit (void);
+
+/// Write the RTX trace, with the threads and the latest records oldest first, from a thread.
+/// \param[in]     put           function called with context to write each piece of the dump.
+/// \param[in]     context       passed on to put.
+/// \return number of bytes written.
+/// \note RTX specific, recording is paused while dumping.
+uint32_t os_trace_dump (void (*put)(void *context, const void *data, uint32_t size), void *context);
+
 
 //  ==== Thread Management ====
 
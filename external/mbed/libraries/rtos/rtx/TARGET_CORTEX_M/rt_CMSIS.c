@@ -456,6 +456,8 @@ uint8_t os_running;                             // Kernel Running flag
 SVC_0_1(svcKernelInitialize, osStatus, RET_osStatus)
 SVC_0_1(svcKernelStart,      osStatus, RET_osStatus)
 SVC_0_1(svcKernelRunning,    int32_t,  RET_int32_t)
+SVC_0_1(svcKernelSuspend,    int32_t,  RET_int32_t)
+SVC_1_1(svcKernelResume,     osStatus, uint32_t, RET_osStatus)
 
 extern void  sysThreadError   (osStatus status);
 osThreadId   svcThreadCreate  (osThreadDef_t *thread_def, void *argument);
@@ -469,6 +471,7 @@ osStatus svcKernelInitialize (void) {
 
   rt_sys_init();                                // RTX System Initialization
   os_tsk.run->prio = 255;                       // Highest priority
+  os_tsk.run->prio_base = 255;
 
   sysThreadError(osOK);
 
@@ -502,6 +505,17 @@ int32_t svcKernelRunning(void) {
   return os_running;
 }
 
+/// Suspend the RTX task scheduler
+int32_t svcKernelSuspend (void) {
+  return rt_suspend();
+}
+
+/// Resume the RTX task scheduler
+osStatus svcKernelResume (uint32_t sleep_time) {
+  rt_resume(sleep_time);
+  return osOK;
+}
+
 // Kernel Control Public API
 
 /// Initialize the RTOS Kernel for creating objects
@@ -556,6 +570,23 @@ int32_t osKernelRunning(void) {
   }
 }
 
+/// Suspend the RTX task scheduler, from the idle thread
+uint32_t os_suspend (void) {
+  if (__get_IPSR() != 0) return 0;              // Not allowed in ISR
+  return __svcKernelSuspend();
+}
+
+/// Resume the RTX task scheduler, after sleeping for sleep_time ticks
+void os_resume (uint32_t sleep_time) {
+  if (__get_IPSR() != 0) return;                // Not allowed in ISR
+  __svcKernelResume(sleep_time);
+}
+
+/// Check whether an ISR made a thread ready while the scheduler is suspended
+int32_t os_suspend_pending (void) {
+  return rt_psh_pending();
+}
+
 
 // ==== Thread Management ====
 
@@ -1021,6 +1052,32 @@ void sysTimerTick (void) {
 }
 
 
+/// Ticks until the first timer expires, at most 0xFFFF (called by rt_suspend)
+uint32_t sysTimerNext (void) {
+  if (os_timer_head == NULL) return 0xFFFF;
+  return os_timer_head->tcnt;
+}
+
+/// Advance the timers by the ticks skipped while suspended (called by rt_resume)
+void sysTimerResume (uint32_t sleep_time) {
+  os_timer_cb *p;
+
+  p = os_timer_head;
+  if (p == NULL) return;
+  if (sleep_time < p->tcnt) {
+    p->tcnt -= sleep_time;
+    return;
+  }
+  sleep_time -= p->tcnt;
+  p->tcnt = 1;
+  for (;;) {
+    sysTimerTick();
+    if ((os_timer_head == NULL) || (sleep_time == 0)) break;
+    sleep_time--;
+  }
+}
+
+
 // Timer Management Public API
 
 /// Create timer
@@ -1299,6 +1356,85 @@ osStatus svcMutexDelete (osMutexId mutex_id) {
 }
 
 
+// Mutex Fast Calls, run by the calling thread without a service call
+
+// A free mutex has no owner.  The running thread takes one by storing itself
+// as the owner with an exclusive access, and gives it back the same way while
+// its nesting level is still 0.  Any exception, so any service call by
+// another thread, clears the exclusive monitor on the way and makes the store
+// fail.  The kernel accounts for such an owner in rt_mut_wait() when another
+// thread waits for the mutex, which raises its level to 1; from then on the
+// owner releases it with a service call, and priority inheritance works as
+// before.  rt_mut_wait() then records the owner's base priority as the one to
+// restore, since its priority may have been raised through another mutex in
+// the meantime.  A thread whose priority is raised at the time it locks takes
+// the kernel path, which records that priority as before.  Cortex-M0 has no
+// exclusive access, so there the checks and store are made with interrupts
+// disabled instead.
+
+/// Take a free Mutex, returns osOK when taken
+static __INLINE osStatus fastMutexWait (osMutexId mutex_id) {
+  P_MUCB mut = rt_id2obj(mutex_id);
+  P_TCB  run = os_tsk.run;
+#if (__TARGET_ARCH_6S_M)
+  uint32_t primask;
+  osStatus res = osErrorResource;
+#endif
+
+  if (mut == NULL || mut->cb_type != MUCB || os_running == 0) return osErrorResource;
+
+#if (__TARGET_ARCH_6S_M)
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (mut->owner == NULL && run->prio == run->prio_base) {
+    mut->owner = run;
+    res = osOK;
+  }
+  __set_PRIMASK(primask);
+  return res;
+#else
+  do {
+    if (__LDREXW((uint32_t *)&mut->owner) != 0 || run->prio != run->prio_base) {
+      __CLREX();
+      return osErrorResource;
+    }
+  } while (__STREXW((uint32_t)run, (uint32_t *)&mut->owner));
+  return osOK;
+#endif
+}
+
+/// Give back a Mutex taken by fastMutexWait, returns osOK when released
+static __INLINE osStatus fastMutexRelease (osMutexId mutex_id) {
+  P_MUCB mut = rt_id2obj(mutex_id);
+  P_TCB  run = os_tsk.run;
+#if (__TARGET_ARCH_6S_M)
+  uint32_t primask;
+  osStatus res = osErrorResource;
+#endif
+
+  if (mut == NULL || mut->cb_type != MUCB || os_running == 0) return osErrorResource;
+
+#if (__TARGET_ARCH_6S_M)
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (mut->owner == run && mut->level == 0) {
+    mut->owner = NULL;
+    res = osOK;
+  }
+  __set_PRIMASK(primask);
+  return res;
+#else
+  do {
+    if ((P_TCB)__LDREXW((uint32_t *)&mut->owner) != run || mut->level != 0) {
+      __CLREX();
+      return osErrorResource;
+    }
+  } while (__STREXW(0, (uint32_t *)&mut->owner));
+  return osOK;
+#endif
+}
+
+
 // Mutex Public API
 
 /// Create and Initialize a Mutex object
@@ -1315,12 +1451,14 @@ osMutexId osMutexCreate (osMutexDef_t *mutex_def) {
 /// Wait until a Mutex becomes available
 osStatus osMutexWait (osMutexId mutex_id, uint32_t millisec) {
   if (__get_IPSR() != 0) return osErrorISR;     // Not allowed in ISR
+  if (fastMutexWait(mutex_id) == osOK) return osOK;
   return __svcMutexWait(mutex_id, millisec);
 }
 
 /// Release a Mutex that was obtained with osMutexWait
 osStatus osMutexRelease (osMutexId mutex_id) {
   if (__get_IPSR() != 0) return osErrorISR;     // Not allowed in ISR
+  if (fastMutexRelease(mutex_id) == osOK) return osOK;
   return __svcMutexRelease(mutex_id);
 }
 
@@ -1438,6 +1576,83 @@ static __INLINE osStatus isrSemaphoreRelease (osSemaphoreId semaphore_id) {
 }
 
 
+// Semaphore Fast Calls, run by the calling thread without a service call
+
+// The token count shares the first word of the control block with its type.
+// A thread takes an available token, or returns one while no thread waits,
+// by rewriting that word with an exclusive access.  The kernel only changes
+// the count from exceptions, which clear the exclusive monitor, so that a
+// token given in the meantime by an interrupt, or a thread starting to wait,
+// makes the store fail and the check is made again.  Cortex-M0 does the same
+// with interrupts disabled.
+
+#define SCB_TOKEN       0x10000                 // Token count in the first word
+
+/// Take an available token, returns the number of tokens before or 0 if none
+static __INLINE int32_t fastSemaphoreWait (osSemaphoreId semaphore_id) {
+  P_SCB    sem = rt_id2obj(semaphore_id);
+  uint32_t val;
+#if (__TARGET_ARCH_6S_M)
+  uint32_t primask;
+#endif
+
+  if (sem == NULL || os_running == 0) return 0;
+
+#if (__TARGET_ARCH_6S_M)
+  primask = __get_PRIMASK();
+  __disable_irq();
+  val = *(uint32_t *)sem;
+  if ((val & 0xFF) == SCB && val >= SCB_TOKEN) {
+    *(uint32_t *)sem = val - SCB_TOKEN;
+  }
+  __set_PRIMASK(primask);
+#else
+  do {
+    val = __LDREXW((uint32_t *)sem);
+    if ((val & 0xFF) != SCB || val < SCB_TOKEN) {
+      __CLREX();
+      return 0;
+    }
+  } while (__STREXW(val - SCB_TOKEN, (uint32_t *)sem));
+#endif
+  if ((val & 0xFF) != SCB) return 0;
+  return (val / SCB_TOKEN);
+}
+
+/// Return a token while no thread waits for one, returns osOK when returned
+static __INLINE osStatus fastSemaphoreRelease (osSemaphoreId semaphore_id) {
+  P_SCB    sem = rt_id2obj(semaphore_id);
+  uint32_t val;
+#if (__TARGET_ARCH_6S_M)
+  uint32_t primask;
+  osStatus res = osErrorResource;
+#endif
+
+  if (sem == NULL || os_running == 0) return osErrorResource;
+
+#if (__TARGET_ARCH_6S_M)
+  primask = __get_PRIMASK();
+  __disable_irq();
+  val = *(uint32_t *)sem;
+  if ((val & 0xFF) == SCB && sem->p_lnk == NULL && (val / SCB_TOKEN) < osFeature_Semaphore) {
+    *(uint32_t *)sem = val + SCB_TOKEN;
+    res = osOK;
+  }
+  __set_PRIMASK(primask);
+  return res;
+#else
+  do {
+    val = __LDREXW((uint32_t *)sem);
+    if ((val & 0xFF) != SCB || sem->p_lnk != NULL || (val / SCB_TOKEN) == osFeature_Semaphore) {
+      __CLREX();
+      return osErrorResource;
+    }
+  } while (__STREXW(val + SCB_TOKEN, (uint32_t *)sem));
+  return osOK;
+#endif
+}
+
+
 // Semaphore Public API
 
 /// Create and Initialize a Semaphore object
@@ -1453,7 +1668,11 @@ osSemaphoreId osSemaphoreCreate (osSemaphoreDef_t *semaphore_def, int32_t count)
 
 /// Wait until a Semaphore becomes available
 int32_t osSemaphoreWait (osSemaphoreId semaphore_id, uint32_t millisec) {
+  int32_t tokens;
+
   if (__get_IPSR() != 0) return -1;             // Not allowed in ISR
+  tokens = fastSemaphoreWait(semaphore_id);
+  if (tokens != 0) return tokens;
   return __svcSemaphoreWait(semaphore_id, millisec);
 }
 
@@ -1462,6 +1681,7 @@ osStatus osSemaphoreRelease (osSemaphoreId semaphore_id) {
   if (__get_IPSR() != 0) {                      // in ISR
     return   isrSemaphoreRelease(semaphore_id);
   } else {                                      // in Thread
+    if (fastSemaphoreRelease(semaphore_id) == osOK) return osOK;
     return __svcSemaphoreRelease(semaphore_id);
   }
 }
@@ -37,6 +37,7 @@
 #define DEMCR_TRCENA    0x01000000
 #define ITM_ITMENA      0x00000001
 #define MAGIC_WORD      0xE25A2EA5
+#define MAGIC_PATTERN   0xCCCCCCCC
 
 #if defined (__CC_ARM)          /* ARM Compiler */
 
@@ -252,6 +253,8 @@ extern void *_alloc_box (void *box_mem);
 extern int  _free_box (void *box_mem, void *box);
 
 extern void rt_init_stack (P_TCB p_TCB, FUNCP task_body);
+extern void rt_stk_paint  (U32 *stk, U32 *top);
+extern U32  rt_stk_max    (U32 *stack, U32 size);
 extern void rt_ret_val  (P_TCB p_TCB, U32 v0);
 extern void rt_ret_val2 (P_TCB p_TCB, U32 v0, U32 v1);
 
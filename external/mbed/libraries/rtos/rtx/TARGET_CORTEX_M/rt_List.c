@@ -49,12 +49,74 @@ struct OS_XCB  os_rdy;
 /* List head of chained delay tasks */
 struct OS_XCB  os_dly;
 
+/* Ready tasks are chained into one FIFO for each priority level. A bit is */
+/* set in 'os_rdy_map' for each level which is not empty, and 'os_rdy.p_lnk'*/
+/* always points to the first task of the highest level, if any.          */
+static P_TCB   os_rdy_head[OS_RDY_LEVELS];
+static P_TCB   os_rdy_tail[OS_RDY_LEVELS];
+static U32     os_rdy_map;
+
+#if (__TARGET_ARCH_6S_M)
+/* Highest bit set in a nibble, for cores without a CLZ instruction */
+static const U8 os_rdy_msb[16] = {
+  0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3
+};
+#endif
+
 
 /*----------------------------------------------------------------------------
  *      Functions
  *---------------------------------------------------------------------------*/
 
 
+/*--------------------------- rt_rdy_level ----------------------------------*/
+
+__inline static U32 rt_rdy_level (U32 prio) {
+  /* Return the ready list level of priority "prio". CMSIS-RTOS priorities  */
+  /* are 1..7 and the idle task is 0, anything higher shares the top level. */
+  return ((prio < OS_RDY_LEVELS) ? prio : OS_RDY_LEVELS - 1);
+}
+
+
+/*--------------------------- rt_rdy_top ------------------------------------*/
+
+__inline static U32 rt_rdy_top (void) {
+  /* Return the highest level with ready tasks; 'os_rdy_map' must not be 0. */
+#if (__TARGET_ARCH_6S_M)
+  if (os_rdy_map & 0xF0) {
+    return (os_rdy_msb[os_rdy_map >> 4] + 4);
+  }
+  return (os_rdy_msb[os_rdy_map]);
+#else
+  return (31 - __clz (os_rdy_map));
+#endif
+}
+
+
+/*--------------------------- rt_rdy_sync -----------------------------------*/
+
+__inline static void rt_rdy_sync (void) {
+  /* Point the ready list head at the task which is to run next. */
+  os_rdy.p_lnk = (os_rdy_map != 0) ? os_rdy_head[rt_rdy_top ()] : NULL;
+}
+
+
+/*--------------------------- rt_init_rdy -----------------------------------*/
+
+void rt_init_rdy (void) {
+  /* Set up the ready list: initially empty. */
+  U32 i;
+
+  os_rdy.cb_type = HCB;
+  os_rdy.p_lnk   = NULL;
+  for (i = 0; i < OS_RDY_LEVELS; i++) {
+    os_rdy_head[i] = NULL;
+    os_rdy_tail[i] = NULL;
+  }
+  os_rdy_map = 0;
+}
+
+
 /*--------------------------- rt_put_prio -----------------------------------*/
 
 void rt_put_prio (P_XCB p_CB, P_TCB p_task) {
@@ -65,6 +127,22 @@ void rt_put_prio (P_XCB p_CB, P_TCB p_task) {
   U32 prio;
   BOOL sem_mbx = __FALSE;
 
+  if (p_CB == &os_rdy) {
+    /* Ready list: append to the tail of the task's priority level. */
+    prio = rt_rdy_level (p_task->prio);
+    p_task->p_lnk  = NULL;
+    p_task->p_rlnk = NULL;
+    if (os_rdy_map & (1U << prio)) {
+      os_rdy_tail[prio]->p_lnk = p_task;
+    }
+    else {
+      os_rdy_head[prio] = p_task;
+      os_rdy_map |= (1U << prio);
+    }
+    os_rdy_tail[prio] = p_task;
+    rt_rdy_sync ();
+    return;
+  }
   if (p_CB->cb_type == SCB || p_CB->cb_type == MCB || p_CB->cb_type == MUCB) {
     sem_mbx = __TRUE;
   }
@@ -96,7 +174,20 @@ P_TCB rt_get_first (P_XCB p_CB) {
   /* Get task at head of list: it is the task with highest priority. */
   /* "p_CB" points to head of list. */
   P_TCB p_first;
+  U32 prio;
 
+  if (p_CB == &os_rdy) {
+    /* Ready list: take the first task of the highest priority level. */
+    prio = rt_rdy_top ();
+    p_first = os_rdy_head[prio];
+    os_rdy_head[prio] = p_first->p_lnk;
+    if (p_first->p_lnk == NULL) {
+      os_rdy_map &= ~(1U << prio);
+    }
+    p_first->p_lnk = NULL;
+    rt_rdy_sync ();
+    return (p_first);
+  }
   p_first = p_CB->p_lnk;
   p_CB->p_lnk = p_first->p_lnk;
   if (p_CB->cb_type == SCB || p_CB->cb_type == MCB || p_CB->cb_type == MUCB) {
@@ -118,9 +209,20 @@ P_TCB rt_get_first (P_XCB p_CB) {
 void rt_put_rdy_first (P_TCB p_task) {
   /* Put task identified with "p_task" at the head of the ready list. The   */
   /* task must have at least a priority equal to highest priority in list.  */
-  p_task->p_lnk = os_rdy.p_lnk;
+  U32 prio;
+
+  prio = rt_rdy_level (p_task->prio);
   p_task->p_rlnk = NULL;
-  os_rdy.p_lnk = p_task;
+  if (os_rdy_map & (1U << prio)) {
+    p_task->p_lnk = os_rdy_head[prio];
+  }
+  else {
+    p_task->p_lnk = NULL;
+    os_rdy_tail[prio] = p_task;
+    os_rdy_map |= (1U << prio);
+  }
+  os_rdy_head[prio] = p_task;
+  rt_rdy_sync ();
 }
 
 
@@ -133,8 +235,7 @@ P_TCB rt_get_same_rdy_prio (void) {
 
   p_first = os_rdy.p_lnk;
   if (p_first->prio == os_tsk.run->prio) {
-    os_rdy.p_lnk = os_rdy.p_lnk->p_lnk;
-    return (p_first);
+    return (rt_get_first (&os_rdy));
   }
   return (NULL);
 }
@@ -250,6 +351,7 @@ void rt_rmv_list (P_TCB p_task) {
   /* Remove task identified with "p_task" from ready, semaphore or mailbox  */
   /* waiting list if enqueued.                                              */
   P_TCB p_b;
+  U32 map,prio;
 
   if (p_task->p_rlnk != NULL) {
     /* A task is enqueued in semaphore / mailbox waiting list. */
@@ -260,15 +362,34 @@ void rt_rmv_list (P_TCB p_task) {
     return;
   }
 
-  p_b = (P_TCB)&os_rdy;
-  while (p_b != NULL) {
-    /* Search the ready list for task "p_task" */
-    if (p_b->p_lnk == p_task) {
-      p_b->p_lnk = p_task->p_lnk;
-      return;
+  /* Search the ready levels for task "p_task": its priority may already */
+  /* have been changed, so that it is not necessarily in its own level.  */
+  for (map = os_rdy_map, prio = 0; map != 0; map >>= 1, prio++) {
+    if ((map & 1) == 0) {
+      continue;
+    }
+    if (os_rdy_head[prio] == p_task) {
+      os_rdy_head[prio] = p_task->p_lnk;
+      if (p_task->p_lnk == NULL) {
+        os_rdy_map &= ~(1U << prio);
+      }
+      goto rmv;
+    }
+    for (p_b = os_rdy_head[prio]; p_b->p_lnk != NULL; p_b = p_b->p_lnk) {
+      if (p_b->p_lnk == p_task) {
+        p_b->p_lnk = p_task->p_lnk;
+        if (os_rdy_tail[prio] == p_task) {
+          os_rdy_tail[prio] = p_b;
+        }
+        goto rmv;
+      }
     }
-    p_b = p_b->p_lnk;
   }
+  return;
+
+rmv:
+  p_task->p_lnk = NULL;
+  rt_rdy_sync ();
 }
 
 
@@ -41,11 +41,15 @@
 #define MUCB            3
 #define HCB             4
 
+/* Number of ready list priority levels, at most 8 */
+#define OS_RDY_LEVELS   8
+
 /* Variables */
 extern struct OS_XCB os_rdy;
 extern struct OS_XCB os_dly;
 
 /* Functions */
+extern void  rt_init_rdy      (void);
 extern void  rt_put_prio      (P_XCB p_CB, P_TCB p_task);
 extern P_TCB rt_get_first     (P_XCB p_CB);
 extern void  rt_put_rdy_first (P_TCB p_task);
@@ -105,10 +105,15 @@ OS_RESULT rt_mut_release (OS_ID mutex) {
   P_MUCB p_MCB = mutex;
   P_TCB  p_TCB;
 
-  if (p_MCB->level == 0 || p_MCB->owner != os_tsk.run) {
+  if (p_MCB->owner != os_tsk.run) {
     /* Unbalanced mutex release or task is not the owner */
     return (OS_R_NOK);
   }
+  if (p_MCB->level == 0) {
+    /* Taken without the kernel, and no task has waited for it since. */
+    p_MCB->owner = NULL;
+    return (OS_R_OK);
+  }
   if (--p_MCB->level != 0) {
     return (OS_R_OK);
   }
@@ -141,6 +146,7 @@ OS_RESULT rt_mut_release (OS_ID mutex) {
     }
   }
   else {
+    p_MCB->owner = NULL;
     /* Check if own priority raised by priority inversion. */
     if (rt_rdy_prio() > os_tsk.run->prio) {
       rt_put_prio (&os_rdy, os_tsk.run);
@@ -158,11 +164,18 @@ OS_RESULT rt_mut_wait (OS_ID mutex, U16 timeout) {
   /* Wait for a mutex, continue when mutex is free. */
   P_MUCB p_MCB = mutex;
 
-  if (p_MCB->level == 0) {
+  if (p_MCB->owner == NULL) {
     p_MCB->owner = os_tsk.run;
     p_MCB->prio  = os_tsk.run->prio;
     goto inc;
   }
+  if (p_MCB->level == 0) {
+    /* The owner took the mutex without the kernel: account for it now.  */
+    /* Its priority may have been raised through another mutex since, so */
+    /* restore the one it had when it took this mutex, its base priority. */
+    p_MCB->prio  = p_MCB->owner->prio_base;
+    p_MCB->level = 1;
+  }
   if (p_MCB->owner == os_tsk.run) {
     /* OK, running task is the owner of this mutex. */
 inc:p_MCB->level++;
@@ -42,6 +42,7 @@
 #include "rt_Semaphore.h"
 #include "rt_Time.h"
 #include "rt_Robin.h"
+#include "rt_Trace.h"
 #include "rt_HAL_CM.h"
 
 /*----------------------------------------------------------------------------
@@ -73,6 +74,11 @@ __RL_RTX_VER    EQU     0x450
 #endif
 
 
+#ifdef __CMSIS_RTOS
+extern U32  sysTimerNext   (void);
+extern void sysTimerResume (U32 sleep_time);
+#endif
+
 /*--------------------------- rt_suspend ------------------------------------*/
 U32 rt_suspend (void) {
   /* Suspend OS scheduler */
@@ -83,7 +89,9 @@ U32 rt_suspend (void) {
   if (os_dly.p_dlnk) {
     delta = os_dly.delta_time;
   }
-#ifndef __CMSIS_RTOS
+#ifdef __CMSIS_RTOS
+  if (sysTimerNext () < delta) delta = sysTimerNext ();
+#else
   if (os_tmr.next) {
     if (os_tmr.tcnt < delta) delta = os_tmr.tcnt;
   }
@@ -125,7 +133,10 @@ void rt_resume (U32 sleep_time) {
     os_time += sleep_time;
   }
 
-#ifndef __CMSIS_RTOS
+#ifdef __CMSIS_RTOS
+  /* Check the user timers. */
+  sysTimerResume (sleep_time);
+#else
   /* Check the user timers. */
   if (os_tmr.next) {
     delta = sleep_time;
@@ -151,6 +162,14 @@ void rt_resume (U32 sleep_time) {
 }
 
 
+/*--------------------------- rt_psh_pending --------------------------------*/
+
+U32 rt_psh_pending (void) {
+  /* Check for ISR post service requests held back by a locked scheduler. */
+  return (os_psh_flag);
+}
+
+
 /*--------------------------- rt_tsk_lock -----------------------------------*/
 
 void rt_tsk_lock (void) {
@@ -206,6 +225,7 @@ void rt_pop_req (void) {
   P_TCB next;
   U32  idx;
 
+  OS_TRACE_ISR(OS_TRACE_ISR_ENTER, -2);
   os_tsk.run->state = READY;
   rt_put_rdy_first (os_tsk.run);
 
@@ -231,6 +251,7 @@ void rt_pop_req (void) {
 
   next = rt_get_first (&os_rdy);
   rt_switch_req (next);
+  OS_TRACE_ISR(OS_TRACE_ISR_EXIT, -2);
 }
 
 
@@ -258,6 +279,7 @@ void rt_systick (void) {
   /* Check for system clock update, suspend running task. */
   P_TCB next;
 
+  OS_TRACE_ISR(OS_TRACE_ISR_ENTER, -1);
   os_tsk.run->state = READY;
   rt_put_rdy_first (os_tsk.run);
 
@@ -278,6 +300,7 @@ void rt_systick (void) {
   /* Switch back to highest ready task */
   next = rt_get_first (&os_rdy);
   rt_switch_req (next);
+  OS_TRACE_ISR(OS_TRACE_ISR_EXIT, -1);
 }
 
 /*--------------------------- rt_stk_check ----------------------------------*/
@@ -39,6 +39,7 @@
 #include "rt_List.h"
 #include "rt_MemBox.h"
 #include "rt_Robin.h"
+#include "rt_Trace.h"
 #include "rt_HAL_CM.h"
 
 /*----------------------------------------------------------------------------
@@ -88,6 +89,7 @@ void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
   p_TCB->cb_type = TCB;
   p_TCB->state   = READY;
   p_TCB->prio    = priority;
+  p_TCB->prio_base = priority;
   p_TCB->p_lnk   = NULL;
   p_TCB->p_rlnk  = NULL;
   p_TCB->p_dlnk  = NULL;
@@ -106,6 +108,7 @@ void rt_init_context (P_TCB p_TCB, U8 priority, FUNCP task_body) {
 
 void rt_switch_req (P_TCB p_new) {
   /* Switch to next task (identified by "p_new"). */
+  OS_TRACE_TASK_SWITCH(p_new);
   os_tsk.new_tsk   = p_new;
   p_new->state = RUNNING;
   DBG_TASK_SWITCH(p_new->task_id);
@@ -148,6 +151,7 @@ void rt_block (U16 timeout, U8 block_state) {
   P_TCB next_TCB;
 
   if (timeout) {
+    OS_TRACE_BLOCK(timeout);
     if (timeout < 0xffff) {
       rt_put_dly (os_tsk.run, timeout);
     }
@@ -192,7 +196,8 @@ OS_RESULT rt_tsk_prio (OS_TID task_id, U8 new_prio) {
 
   if (task_id == 0) {
     /* Change execution priority of calling task. */
-    os_tsk.run->prio = new_prio;
+    os_tsk.run->prio      = new_prio;
+    os_tsk.run->prio_base = new_prio;
 run:if (rt_rdy_prio() > new_prio) {
       rt_put_prio (&os_rdy, os_tsk.run);
       os_tsk.run->state   = READY;
@@ -207,7 +212,8 @@ run:if (rt_rdy_prio() > new_prio) {
     return (OS_R_NOK);
   }
   p_task = os_active_TCB[task_id-1];
-  p_task->prio = new_prio;
+  p_task->prio      = new_prio;
+  p_task->prio_base = new_prio;
   if (p_task == os_tsk.run) {
     goto run;
   }
@@ -268,6 +274,7 @@ void rt_sys_init (FUNCP first_task, U32 prio_stksz, void *stk) {
   U32 i;
 
   DBG_INIT();
+  OS_TRACE_INIT();
 
   /* Initialize dynamic memory and task TCB pointers to NULL. */
   for (i = 0; i < os_maxtaskrun; i++) {
@@ -281,8 +288,7 @@ void rt_sys_init (FUNCP first_task, U32 prio_stksz, void *stk) {
   rt_init_context (&os_idle_TCB, 0, os_idle_demon);
 
   /* Set up ready list: initially empty */
-  os_rdy.cb_type = HCB;
-  os_rdy.p_lnk   = NULL;
+  rt_init_rdy ();
   /* Set up delay list: initially empty */
   os_dly.cb_type = HCB;
   os_dly.p_dlnk  = NULL;
@@ -0,0 +1,289 @@
+/*----------------------------------------------------------------------------
+ *      RL-ARM - RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_TRACE.C
+ *      Purpose: Trace of task switches, waits and interrupts
+ *      Rev.:    V4.60
+ *----------------------------------------------------------------------------
+ * Copyright (c) 1999-2009 KEIL, 2009-2012 ARM Germany GmbH
+ * Copyright (c) 2014 Adam Green
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+
+#define __CMSIS_GENERIC
+
+#if defined (__CORTEX_M4) || defined (__CORTEX_M4F)
+  #include "core_cm4.h"
+#elif defined (__CORTEX_M3)
+  #include "core_cm3.h"
+#elif defined (__CORTEX_M0)
+  #include "core_cm0.h"
+#elif defined (__CORTEX_M0PLUS)
+  #include "core_cm0plus.h"
+#else
+  #error "Missing __CORTEX_Mx definition"
+#endif
+
+#include "rt_TypeDef.h"
+#include "RTX_Conf.h"
+#include "rt_Task.h"
+#include "rt_List.h"
+#include "rt_Time.h"
+#include "rt_Trace.h"
+#include "rt_HAL_CM.h"
+
+#if OS_TRACE
+
+/* DWT registers */
+#define DWT_CTRL        (*((volatile U32 *)0xE0001000))
+#define DWT_CYCCNT      (*((volatile U32 *)0xE0001004))
+
+/*----------------------------------------------------------------------------
+ *      Local Variables
+ *---------------------------------------------------------------------------*/
+
+/* Ring of the latest records; 'os_trace_head' counts all records written. */
+static struct OS_TRACE_REC os_trace_buf[OS_TRACE_SIZE];
+static volatile U32 os_trace_head;
+static volatile BIT os_trace_paused;
+
+
+/*----------------------------------------------------------------------------
+ *      Local Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_trace_time ---------------------------------*/
+
+__inline static U32 rt_trace_time (void) {
+  /* Return the current time in CPU cycles. */
+#if (__TARGET_ARCH_6S_M)
+  /* No cycle counter: count from the system tick, SysTick runs at CPU clock */
+  return (os_time * (os_trv + 1) + (os_trv - NVIC_ST_CURRENT));
+#else
+  return (DWT_CYCCNT);
+#endif
+}
+
+
+/*--------------------------- rt_trace_reserve ------------------------------*/
+
+__inline static U32 rt_trace_reserve (void) {
+  /* Claim the next record, from a task or an interrupt of any priority. */
+  U32 idx;
+#if (__TARGET_ARCH_6S_M)
+  U32 primask;
+
+  primask = __get_PRIMASK ();
+  __disable_irq ();
+  idx = os_trace_head++;
+  __set_PRIMASK (primask);
+#else
+  do {
+    idx = __LDREXW ((U32 *)&os_trace_head);
+  } while (__STREXW (idx + 1, (U32 *)&os_trace_head));
+#endif
+  return (idx);
+}
+
+
+/*--------------------------- rt_trace_put ----------------------------------*/
+
+static void rt_trace_put (U32 type, U32 task, U32 data, U32 arg) {
+  /* Fill the next record. Its type is written last, to mark it complete. */
+  P_TRACE_REC p_rec;
+
+  if (os_trace_paused) {
+    return;
+  }
+  p_rec = &os_trace_buf[rt_trace_reserve () & (OS_TRACE_SIZE - 1)];
+  p_rec->type = 0;
+  __DMB ();
+  p_rec->time = rt_trace_time ();
+  p_rec->task = (U8)task;
+  p_rec->data = (U16)data;
+  p_rec->arg  = arg;
+  __DMB ();
+  p_rec->type = (U8)type;
+}
+
+
+/*----------------------------------------------------------------------------
+ *      Global Functions
+ *---------------------------------------------------------------------------*/
+
+/*--------------------------- rt_trace_init ---------------------------------*/
+
+void rt_trace_init (void) {
+  /* Start the cycle counter and an empty trace. */
+#if !(__TARGET_ARCH_6S_M)
+  DEMCR    |= 1 << 24;            /* TRCENA    */
+  DWT_CTRL |= 1;                  /* CYCCNTENA */
+#endif
+  os_trace_head = 0;
+  os_trace_paused = __FALSE;
+}
+
+
+/*--------------------------- rt_trace --------------------------------------*/
+
+void rt_trace (U32 type, U32 data, U32 arg) {
+  /* Record an event of "type" for the running task. */
+  rt_trace_put (type, (os_tsk.run != NULL) ? os_tsk.run->task_id : 0,
+                data, arg);
+}
+
+
+/*--------------------------- rt_trace_switch -------------------------------*/
+
+void rt_trace_switch (P_TCB p_new) {
+  /* Record a switch from the running task to "p_new". */
+  P_TCB p_old = os_tsk.run;
+  U32 data = 0;
+
+  if (p_new == p_old) {
+    return;
+  }
+  if (p_old != NULL) {
+    data = p_old->task_id | (p_old->state << 8);
+  }
+  rt_trace_put (OS_TRACE_SWITCH, p_new->task_id, data, (U32)p_new->ptask);
+}
+
+
+/*--------------------------- rt_trace_block --------------------------------*/
+
+void rt_trace_block (U32 timeout) {
+  /* Record the running task starting to wait, and what for. */
+  P_TCB p_CB;
+
+  p_CB = os_tsk.run->p_rlnk;
+  if (p_CB != NULL) {
+    /* Enqueued on a semaphore, mailbox or mutex: find the list header. */
+    while (p_CB->cb_type == TCB) {
+      p_CB = p_CB->p_rlnk;
+    }
+  }
+  rt_trace (OS_TRACE_WAIT, timeout, (U32)p_CB);
+}
+
+#endif
+
+
+/*--------------------------- os_trace_marker -------------------------------*/
+
+void os_trace_marker (U16 id, U32 value) {
+  /* Record a user marker, from a thread or an ISR. */
+#if OS_TRACE
+  rt_trace (OS_TRACE_MARKER, id, value);
+#endif
+}
+
+
+/*--------------------------- os_trace_isr_enter ----------------------------*/
+
+void os_trace_isr_enter (void) {
+  /* Record entry to the active interrupt handler. */
+#if OS_TRACE
+  rt_trace (OS_TRACE_ISR_ENTER, (U16)(__get_IPSR () - 16), 0);
+#endif
+}
+
+
+/*--------------------------- os_trace_isr_exit -----------------------------*/
+
+void os_trace_isr_exit (void) {
+  /* Record exit from the active interrupt handler. */
+#if OS_TRACE
+  rt_trace (OS_TRACE_ISR_EXIT, (U16)(__get_IPSR () - 16), 0);
+#endif
+}
+
+
+/*--------------------------- os_trace_dump ---------------------------------*/
+
+U32 os_trace_dump (void (*put)(void *context, const void *data, U32 size),
+                   void *context) {
+  /* Write a header, the tasks and the trace records, oldest first, through */
+  /* "put". Recording is paused meanwhile. Returns the bytes written.        */
+  struct OS_TRACE_HDR  hdr;
+  struct OS_TRACE_TASK task;
+  P_TCB p_TCB;
+  U32 i,size;
+#if OS_TRACE
+  U32 head,first;
+#endif
+
+  hdr.magic       = OS_TRACE_MAGIC;
+  hdr.version     = OS_TRACE_VERSION;
+  hdr.rec_size    = sizeof(struct OS_TRACE_REC);
+  hdr.tick_cycles = os_trv + 1;
+  hdr.tick_us     = os_clockrate;
+  hdr.written     = 0;
+  hdr.count       = 0;
+  hdr.tasks       = 1;
+  for (i = 0; i < os_maxtaskrun; i++) {
+    if (os_active_TCB[i] != NULL) {
+      hdr.tasks++;
+    }
+  }
+#if OS_TRACE
+  os_trace_paused = __TRUE;
+  head = os_trace_head;
+  hdr.written = head;
+  hdr.count   = (head < OS_TRACE_SIZE) ? head : OS_TRACE_SIZE;
+#endif
+  put (context, &hdr, sizeof(hdr));
+  size = sizeof(hdr);
+
+  for (i = 0; i <= os_maxtaskrun; i++) {
+    p_TCB = (i < os_maxtaskrun) ? os_active_TCB[i] : &os_idle_TCB;
+    if (p_TCB == NULL) {
+      continue;
+    }
+    task.task_id  = p_TCB->task_id;
+    task.prio     = p_TCB->prio;
+    task.state    = p_TCB->state;
+    task.reserved = 0;
+    task.ptask    = (U32)p_TCB->ptask;
+    put (context, &task, sizeof(task));
+    size += sizeof(task);
+  }
+
+#if OS_TRACE
+  first = head - hdr.count;
+  for (i = 0; i < hdr.count; i++) {
+    put (context, &os_trace_buf[(first + i) & (OS_TRACE_SIZE - 1)],
+         sizeof(struct OS_TRACE_REC));
+    size += sizeof(struct OS_TRACE_REC);
+  }
+  os_trace_paused = __FALSE;
+#endif
+  return (size);
+}
+
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
@@ -0,0 +1,105 @@
+/*----------------------------------------------------------------------------
+ *      RL-ARM - RTX
+ *----------------------------------------------------------------------------
+ *      Name:    RT_TRACE.H
+ *      Purpose: Trace of task switches, waits and interrupts definitions
+ *      Rev.:    V4.60
+ *----------------------------------------------------------------------------
+ * Copyright (c) 1999-2009 KEIL, 2009-2012 ARM Germany GmbH
+ * Copyright (c) 2014 Adam Green
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  - Neither the name of ARM  nor the names of its contributors may be used
+ *    to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL COPYRIGHT HOLDERS AND CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *---------------------------------------------------------------------------*/
+
+
+/* Definitions */
+
+/* Set OS_TRACE to 1 to record the trace, in a ring of OS_TRACE_SIZE records */
+#ifndef OS_TRACE
+ #define OS_TRACE       0
+#endif
+#ifndef OS_TRACE_SIZE
+ #define OS_TRACE_SIZE  128
+#endif
+
+/* Values for 'type' of a trace record */
+#define OS_TRACE_SWITCH     1   /* task: new task, data: old task | state<<8 */
+                                /* arg: entry address of the new task       */
+#define OS_TRACE_ISR_ENTER  2   /* data: IRQ number                         */
+#define OS_TRACE_ISR_EXIT   3   /* data: IRQ number                         */
+#define OS_TRACE_WAIT       4   /* data: timeout, arg: object waited for    */
+#define OS_TRACE_MARKER     5   /* data: marker id, arg: marker value       */
+
+#define OS_TRACE_MAGIC      0x54585452  /* "RTXT" */
+#define OS_TRACE_VERSION    1
+
+/* Trace record, timed in CPU cycles */
+typedef struct OS_TRACE_REC {
+  U32    time;                    /* DWT cycle counter, or SysTick based     */
+  U8     type;                    /* Record type, 0 while being written      */
+  U8     task;                    /* Running task ID                         */
+  U16    data;                    /* Type specific                           */
+  U32    arg;                     /* Type specific                           */
+} *P_TRACE_REC;
+
+/* Dump header, followed by 'tasks' OS_TRACE_TASK and 'count' records */
+typedef struct OS_TRACE_HDR {
+  U32    magic;                   /* OS_TRACE_MAGIC                          */
+  U16    version;                 /* OS_TRACE_VERSION                        */
+  U16    rec_size;                /* Size of a record                        */
+  U32    tick_cycles;             /* CPU cycles per system tick              */
+  U32    tick_us;                 /* System tick in microseconds             */
+  U32    written;                 /* Records written since start            */
+  U16    count;                   /* Records in the dump, oldest first       */
+  U16    tasks;                   /* Tasks in the dump                       */
+} *P_TRACE_HDR;
+
+typedef struct OS_TRACE_TASK {
+  U8     task_id;                 /* Task ID                                 */
+  U8     prio;                    /* Execution priority                      */
+  U8     state;                   /* Task state                              */
+  U8     reserved;
+  U32    ptask;                   /* Task entry address                      */
+} *P_TRACE_TASK;
+
+/* Functions */
+extern void rt_trace_init   (void);
+extern void rt_trace        (U32 type, U32 data, U32 arg);
+extern void rt_trace_switch (P_TCB p_new);
+extern void rt_trace_block  (U32 timeout);
+
+#if OS_TRACE
+ #define OS_TRACE_INIT()           rt_trace_init ()
+ #define OS_TRACE_TASK_SWITCH(p)   rt_trace_switch (p)
+ #define OS_TRACE_BLOCK(timeout)   rt_trace_block (timeout)
+ #define OS_TRACE_ISR(type,irqn)   rt_trace (type, (U16)(irqn), 0)
+#else
+ #define OS_TRACE_INIT()
+ #define OS_TRACE_TASK_SWITCH(p)
+ #define OS_TRACE_BLOCK(timeout)
+ #define OS_TRACE_ISR(type,irqn)
+#endif
+
+/*----------------------------------------------------------------------------
+ * end of file
+ *---------------------------------------------------------------------------*/
@@ -100,7 +100,7 @@ typedef struct OS_MUCB {
   U8     prio;                    /* Owner task default priority             */
   U16    level;                   /* Call nesting level                      */
   struct OS_TCB *p_lnk;           /* Chain of tasks waiting for mutex        */
-  struct OS_TCB *owner;           /* Mutex owner task                        */
+  struct OS_TCB *owner;           /* Mutex owner task, NULL when free        */
 } *P_MUCB;
 
 typedef struct OS_XTMR {
@@ -0,0 +1,1335 @@
+/* mbed Microcontroller Library
+ * Copyright (c) 2006-2012 ARM Limited
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cmsis_os.h"
+
+/* Host simulation of the RTX kernel behind the CMSIS-RTOS API, so that the
+   rtos:: classes and the code built on them can be tested and benchmarked on
+   the host.
+
+   Each thread is a pthread, but only the one in os_run may run; the others
+   wait on their own condition variable until they are handed the CPU.  The
+   running thread is chosen as RTX would: the first ready thread of the
+   highest priority, which preempts the running thread as soon as it is made
+   ready by that thread.  Threads of the same priority take turns only when
+   they block or yield, as time does not pass while a thread runs.
+
+   Timeouts, delays and timers run on a virtual clock, counted in system ticks
+   of a millisecond.  It moves on to the next deadline once every thread
+   waits, so that tests which sleep for seconds take no time and always run
+   the same way.
+
+   Calls made from os_host_interrupt() handlers, and from any pthread which
+   isn't an RTOS thread, are in ISR context.  As the host can't interrupt the
+   running thread, a thread made ready from another pthread only preempts it
+   at its next call into the kernel. */
+
+/* RTX task states, as rtos::Thread::State numbers them. */
+enum {
+    INACTIVE,
+    READY,
+    RUNNING,
+    WAIT_DLY,
+    WAIT_ITV,
+    WAIT_OR,
+    WAIT_AND,
+    WAIT_SEM,
+    WAIT_MBX,
+    WAIT_MUT
+};
+
+#define PRIO_LEVELS     (osPriorityRealtime - osPriorityIdle + 1)
+#define SIGNAL_MASK     ((1 << osFeature_Signals) - 1)
+#define TIMER_QUEUE_SZ  16
+
+struct os_wait_list {
+    struct os_thread_cb *first;
+};
+
+struct os_thread_cb {
+    pthread_cond_t       wakeup;
+    os_pthread           pthread;
+    void                *argument;
+    struct os_host_tcb  *tcb;           /* Where the state is kept for Thread */
+    struct os_host_tcb   own_tcb;
+    uint8_t              state;
+    uint8_t              killed;
+    uint8_t              woken;         /* Woken rather than timed out */
+    osPriority           base_prio;
+    osPriority           prio;          /* Raised by the mutexes it holds */
+    struct os_thread_cb *next;          /* In the ready list or a wait list */
+    struct os_wait_list *wait_list;
+    struct os_thread_cb *dly_next;      /* In the delay list */
+    uint32_t             deadline;
+    uint8_t              timed;
+    int32_t              signals;
+    int32_t              wait_signals;
+    uintptr_t            message;       /* Handed to or from a waiting thread */
+    struct os_mutex_cb  *mutexes;       /* Mutexes it holds */
+};
+
+struct os_mutex_cb {
+    struct os_thread_cb *owner;
+    uint32_t             level;
+    struct os_wait_list  waiters;
+    struct os_mutex_cb  *next;          /* In the owner's list */
+};
+
+struct os_semaphore_cb {
+    int32_t              tokens;
+    struct os_wait_list  waiters;
+};
+
+struct os_pool_cb {
+    uint32_t             item_sz;
+    uint32_t             pool_sz;
+    uint8_t             *blocks;
+    void                *free;
+    struct os_wait_list  waiters;
+};
+
+struct os_messageQ_cb {
+    uint32_t             queue_sz;
+    uint32_t             count;
+    uint32_t             first;
+    uintptr_t           *queue;
+    struct os_wait_list  getters;
+    struct os_wait_list  putters;
+};
+
+struct os_mailQ_cb {
+    struct os_pool_cb     pool;
+    struct os_messageQ_cb queue;
+};
+
+struct os_timer_cb {
+    os_ptimer            ptimer;
+    void                *argument;
+    os_timer_type        type;
+    uint32_t             period;
+    uint32_t             deadline;
+    uint8_t              running;
+    uint8_t              deleted;
+    uint32_t             queued;        /* Expiries waiting for the timer thread */
+    struct os_timer_cb  *next;
+};
+
+struct os_interrupt {
+    os_ptimer            isr;
+    void                *argument;
+    uint32_t             deadline;
+    struct os_interrupt *next;
+};
+
+
+static pthread_mutex_t         os_lock = PTHREAD_MUTEX_INITIALIZER;
+static int                     os_running;
+static uint32_t                os_time;
+static struct os_thread_cb    *os_run;
+static struct os_thread_cb    *os_rdy_head[PRIO_LEVELS];
+static struct os_thread_cb    *os_rdy_tail[PRIO_LEVELS];
+static struct os_thread_cb    *os_dly;
+static struct os_timer_cb     *os_timers;
+static struct os_interrupt    *os_interrupts;
+static int                     os_idle_busy;
+static struct os_thread_cb     os_main_thread;
+static struct os_messageQ_cb  *os_timer_queue;
+static __thread struct os_thread_cb *os_self;
+static __thread int            os_isr_nest;
+
+
+static void os_thread_exit(void) __attribute__((noreturn));
+static void os_timer_thread(void const *argument);
+static osThreadDef_t os_timer_thread_def = {os_timer_thread, osPriorityHigh, DEFAULT_STACK_SIZE, NULL, {INACTIVE}};
+static struct os_thread_cb *os_thread_create(osThreadDef_t *thread_def, void *argument);
+
+
+__attribute__((weak)) void error(const char* format, ...) {
+    va_list arg;
+
+    va_start(arg, format);
+    vfprintf(stderr, format, arg);
+    va_end(arg);
+    exit(1);
+}
+
+static void os_init(void);
+
+static int os_in_isr(void) {
+    if (!os_running) {
+        pthread_mutex_lock(&os_lock);
+        os_init();
+        pthread_mutex_unlock(&os_lock);
+    }
+    return os_isr_nest > 0 || os_self == NULL;
+}
+
+static int os_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static void os_set_state(struct os_thread_cb *p, uint8_t state) {
+    p->state = state;
+    p->tcb->state = state;
+}
+
+
+/* Ready list: a FIFO for each priority. */
+static int os_rdy_top(void) {
+    int level;
+
+    for (level = PRIO_LEVELS - 1 ; level >= 0 ; level--) {
+        if (os_rdy_head[level])
+            return level;
+    }
+    return -1;
+}
+
+static void os_rdy_put(struct os_thread_cb *p) {
+    int level = p->prio - osPriorityIdle;
+
+    p->next = NULL;
+    if (os_rdy_tail[level])
+        os_rdy_tail[level]->next = p;
+    else
+        os_rdy_head[level] = p;
+    os_rdy_tail[level] = p;
+    os_set_state(p, READY);
+}
+
+static void os_rdy_put_first(struct os_thread_cb *p) {
+    int level = p->prio - osPriorityIdle;
+
+    p->next = os_rdy_head[level];
+    os_rdy_head[level] = p;
+    if (!os_rdy_tail[level])
+        os_rdy_tail[level] = p;
+    os_set_state(p, READY);
+}
+
+static void os_rdy_remove(struct os_thread_cb *p) {
+    int level = p->prio - osPriorityIdle;
+    struct os_thread_cb **pp = &os_rdy_head[level];
+    struct os_thread_cb *prev = NULL;
+
+    while (*pp && *pp != p) {
+        prev = *pp;
+        pp = &(*pp)->next;
+    }
+    if (*pp) {
+        *pp = p->next;
+        if (os_rdy_tail[level] == p)
+            os_rdy_tail[level] = prev;
+    }
+}
+
+
+/* Wait lists: by priority, then first come first served, as rt_put_prio(). */
+static void os_wait_put(struct os_wait_list *list, struct os_thread_cb *p) {
+    struct os_thread_cb **pp = &list->first;
+
+    while (*pp && (*pp)->prio >= p->prio)
+        pp = &(*pp)->next;
+    p->next = *pp;
+    *pp = p;
+    p->wait_list = list;
+}
+
+static void os_wait_remove(struct os_thread_cb *p) {
+    struct os_thread_cb **pp;
+
+    if (!p->wait_list)
+        return;
+    for (pp = &p->wait_list->first ; *pp ; pp = &(*pp)->next) {
+        if (*pp == p) {
+            *pp = p->next;
+            break;
+        }
+    }
+    p->wait_list = NULL;
+}
+
+
+/* Delay list: by deadline, then first come first served. */
+static void os_dly_put(struct os_thread_cb *p, uint32_t millisec) {
+    struct os_thread_cb **pp = &os_dly;
+
+    p->deadline = os_time + millisec;
+    p->timed = 1;
+    while (*pp && !os_before(p->deadline, (*pp)->deadline))
+        pp = &(*pp)->dly_next;
+    p->dly_next = *pp;
+    *pp = p;
+}
+
+static void os_dly_remove(struct os_thread_cb *p) {
+    struct os_thread_cb **pp;
+
+    if (!p->timed)
+        return;
+    for (pp = &os_dly ; *pp ; pp = &(*pp)->dly_next) {
+        if (*pp == p) {
+            *pp = p->dly_next;
+            break;
+        }
+    }
+    p->timed = 0;
+}
+
+
+/* Make a waiting thread ready, with "woken" set unless it timed out. */
+static void os_ready(struct os_thread_cb *p, int woken) {
+    os_wait_remove(p);
+    os_dly_remove(p);
+    p->woken = woken;
+    os_rdy_put(p);
+}
+
+static void os_change_prio(struct os_thread_cb *p, osPriority prio) {
+    if (p->prio == prio)
+        return;
+    if (p->state == READY) {
+        os_rdy_remove(p);
+        p->prio = prio;
+        os_rdy_put(p);
+    }
+    else if (p->wait_list) {
+        struct os_wait_list *list = p->wait_list;
+
+        os_wait_remove(p);
+        p->prio = prio;
+        os_wait_put(list, p);
+    }
+    else {
+        p->prio = prio;
+    }
+}
+
+
+static void os_timer_insert(struct os_timer_cb *t) {
+    struct os_timer_cb **pp = &os_timers;
+
+    while (*pp && !os_before(t->deadline, (*pp)->deadline))
+        pp = &(*pp)->next;
+    t->next = *pp;
+    *pp = t;
+}
+
+static void os_timer_remove(struct os_timer_cb *t) {
+    struct os_timer_cb **pp;
+
+    for (pp = &os_timers ; *pp ; pp = &(*pp)->next) {
+        if (*pp == t) {
+            *pp = t->next;
+            break;
+        }
+    }
+}
+
+static osStatus os_message_put(struct os_messageQ_cb *q, uintptr_t info, uint32_t millisec);
+
+/* Move the virtual clock on to the next deadline and expire everything due
+   then, as rt_systick() does.  Returns 0 if nothing is waiting for the clock. */
+static int os_clock_next(void) {
+    uint32_t next;
+    int      found = 0;
+
+    if (os_dly) {
+        next = os_dly->deadline;
+        found = 1;
+    }
+    if (os_timers && (!found || os_before(os_timers->deadline, next))) {
+        next = os_timers->deadline;
+        found = 1;
+    }
+    if (os_interrupts && (!found || os_before(os_interrupts->deadline, next))) {
+        next = os_interrupts->deadline;
+        found = 1;
+    }
+    if (!found)
+        return 0;
+    if (os_before(os_time, next))
+        os_time = next;
+
+    while (os_dly && !os_before(os_time, os_dly->deadline))
+        os_ready(os_dly, 0);
+
+    while (os_timers && !os_before(os_time, os_timers->deadline)) {
+        struct os_timer_cb *t = os_timers;
+
+        os_timers = t->next;
+        if (t->type == osTimerPeriodic) {
+            t->deadline += t->period;
+            os_timer_insert(t);
+        }
+        else {
+            t->running = 0;
+        }
+        if (os_message_put(os_timer_queue, (uintptr_t)t, 0) == osOK)
+            t->queued++;
+    }
+
+    /* Interrupt handlers call into the kernel, so run without the lock. */
+    while (os_interrupts && !os_before(os_time, os_interrupts->deadline)) {
+        struct os_interrupt *irq = os_interrupts;
+
+        os_interrupts = irq->next;
+        os_isr_nest++;
+        pthread_mutex_unlock(&os_lock);
+        irq->isr(irq->argument);
+        pthread_mutex_lock(&os_lock);
+        os_isr_nest--;
+        free(irq);
+    }
+    return 1;
+}
+
+/* Hand the CPU to the highest ready thread, once the running one has given
+   it up, moving the virtual clock on while there is none. */
+static void os_dispatch(void) {
+    int level;
+
+    if (os_idle_busy)
+        return;
+    os_run = NULL;
+    os_idle_busy = 1;
+    for (;;) {
+        level = os_rdy_top();
+        if (level >= 0) {
+            struct os_thread_cb *next = os_rdy_head[level];
+
+            os_rdy_remove(next);
+            os_set_state(next, RUNNING);
+            os_run = next;
+            pthread_cond_signal(&next->wakeup);
+            break;
+        }
+        if (!os_clock_next())
+            break;
+    }
+    os_idle_busy = 0;
+}
+
+/* Wait, with the lock held, until the calling thread has the CPU again. */
+static void os_wait_cpu(struct os_thread_cb *self) {
+    while (os_run != self && !self->killed)
+        pthread_cond_wait(&self->wakeup, &os_lock);
+    if (self->killed)
+        os_thread_exit();
+}
+
+/* Let a higher priority thread, made ready by the running thread or by an
+   ISR since, take over. */
+static void os_reschedule(void) {
+    struct os_thread_cb *self = os_run;
+    int level = os_rdy_top();
+
+    if (self && level > self->prio - osPriorityIdle) {
+        os_rdy_put_first(self);
+        os_dispatch();
+        os_wait_cpu(self);
+    }
+}
+
+/* Block the running thread with "state", on "list" if not NULL, for up to
+   "millisec".  Returns 1 if it was woken and 0 if it timed out. */
+static int os_block(struct os_wait_list *list, uint8_t state, uint32_t millisec) {
+    struct os_thread_cb *self = os_run;
+
+    if (list)
+        os_wait_put(list, self);
+    if (millisec != osWaitForever)
+        os_dly_put(self, millisec);
+    self->woken = 0;
+    os_set_state(self, state);
+    os_dispatch();
+    os_wait_cpu(self);
+    return self->woken;
+}
+
+
+static void os_init(void) {
+    if (os_running)
+        return;
+    os_running = 1;
+    pthread_cond_init(&os_main_thread.wakeup, NULL);
+    os_main_thread.tcb = &os_main_thread.own_tcb;
+    os_main_thread.base_prio = osPriorityNormal;
+    os_main_thread.prio = osPriorityNormal;
+    os_set_state(&os_main_thread, RUNNING);
+    os_self = &os_main_thread;
+    os_run = &os_main_thread;
+
+    /* Timers run in their own thread, as with RTX. */
+    os_timer_queue = calloc(1, sizeof(*os_timer_queue));
+    os_timer_queue->queue_sz = TIMER_QUEUE_SZ;
+    os_timer_queue->queue = calloc(TIMER_QUEUE_SZ, sizeof(uintptr_t));
+    os_thread_create(&os_timer_thread_def, NULL);
+}
+
+/* Enter the kernel, making the first pthread to call the main thread. */
+static void os_enter(void) {
+    pthread_mutex_lock(&os_lock);
+    os_init();
+}
+
+/* Leave the kernel, from a thread giving way to any higher priority thread,
+   or from an ISR starting one if the CPU was idle. */
+static void os_leave(void) {
+    if (!os_in_isr())
+        os_reschedule();
+    else if (!os_run)
+        os_dispatch();
+    pthread_mutex_unlock(&os_lock);
+}
+
+
+//  ==== Kernel Control Functions ====
+
+osStatus osKernelInitialize(void) {
+    os_enter();
+    pthread_mutex_unlock(&os_lock);
+    return osOK;
+}
+
+osStatus osKernelStart(void) {
+    os_enter();
+    pthread_mutex_unlock(&os_lock);
+    return osOK;
+}
+
+int32_t osKernelRunning(void) {
+    /* Started by the first call into it. */
+    return 1;
+}
+
+uint32_t os_host_time(void) {
+    uint32_t time;
+
+    os_enter();
+    time = os_time;
+    pthread_mutex_unlock(&os_lock);
+    return time;
+}
+
+osStatus os_host_interrupt(uint32_t millisec, os_ptimer isr, void *argument) {
+    struct os_interrupt **pp;
+    struct os_interrupt *irq;
+
+    if (isr == NULL)
+        return osErrorParameter;
+    irq = malloc(sizeof(*irq));
+    if (irq == NULL)
+        return osErrorNoMemory;
+    os_enter();
+    irq->isr = isr;
+    irq->argument = argument;
+    irq->deadline = os_time + millisec;
+    for (pp = &os_interrupts ; *pp && !os_before(irq->deadline, (*pp)->deadline) ; pp = &(*pp)->next) {
+    }
+    irq->next = *pp;
+    *pp = irq;
+    os_leave();
+    return osOK;
+}
+
+
+//  ==== Thread Management ====
+
+static void os_release_mutexes(struct os_thread_cb *p);
+
+static void os_terminate(struct os_thread_cb *p) {
+    if (p->state == READY)
+        os_rdy_remove(p);
+    os_wait_remove(p);
+    os_dly_remove(p);
+    os_set_state(p, INACTIVE);
+    os_release_mutexes(p);
+}
+
+static void os_thread_exit(void) {
+    struct os_thread_cb *self = os_self;
+
+    if (!self->killed) {
+        os_terminate(self);
+        os_dispatch();
+    }
+    pthread_mutex_unlock(&os_lock);
+    pthread_exit(NULL);
+}
+
+static void *os_thread_start(void *argument) {
+    struct os_thread_cb *self = argument;
+
+    pthread_mutex_lock(&os_lock);
+    os_self = self;
+    os_wait_cpu(self);
+    pthread_mutex_unlock(&os_lock);
+
+    self->pthread(self->argument);
+
+    pthread_mutex_lock(&os_lock);
+    os_thread_exit();
+}
+
+static int os_valid_prio(osPriority priority) {
+    return priority >= osPriorityIdle && priority <= osPriorityRealtime;
+}
+
+static struct os_thread_cb *os_thread_create(osThreadDef_t *thread_def, void *argument) {
+    struct os_thread_cb *p;
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    p = calloc(1, sizeof(*p));
+    if (p == NULL)
+        return NULL;
+    pthread_cond_init(&p->wakeup, NULL);
+    p->pthread = thread_def->pthread;
+    p->argument = argument;
+    p->tcb = &thread_def->tcb;
+    p->base_prio = thread_def->tpriority;
+    p->prio = thread_def->tpriority;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, os_thread_start, p) != 0) {
+        pthread_attr_destroy(&attr);
+        pthread_cond_destroy(&p->wakeup);
+        free(p);
+        return NULL;
+    }
+    pthread_attr_destroy(&attr);
+    os_rdy_put(p);
+    return p;
+}
+
+osThreadId osThreadCreate(osThreadDef_t *thread_def, void *argument) {
+    struct os_thread_cb *p;
+
+    if (thread_def == NULL || thread_def->pthread == NULL || !os_valid_prio(thread_def->tpriority))
+        return NULL;
+    os_enter();
+    if (os_in_isr()) {
+        pthread_mutex_unlock(&os_lock);
+        return NULL;
+    }
+    p = os_thread_create(thread_def, argument);
+    os_leave();
+    return p;
+}
+
+osThreadId osThreadGetId(void) {
+    if (os_in_isr())
+        return NULL;
+    return os_self;
+}
+
+osStatus osThreadTerminate(osThreadId thread_id) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (thread_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    if (thread_id->state == INACTIVE) {
+        pthread_mutex_unlock(&os_lock);
+        return osErrorResource;
+    }
+    if (thread_id == os_self)
+        os_thread_exit();
+    os_terminate(thread_id);
+    thread_id->killed = 1;
+    pthread_cond_signal(&thread_id->wakeup);
+    os_leave();
+    return osOK;
+}
+
+osStatus osThreadYield(void) {
+    struct os_thread_cb *self;
+
+    if (os_in_isr())
+        return osErrorISR;
+    os_enter();
+    self = os_run;
+    os_rdy_put(self);
+    os_dispatch();
+    os_wait_cpu(self);
+    os_leave();
+    return osOK;
+}
+
+osStatus osThreadSetPriority(osThreadId thread_id, osPriority priority) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (thread_id == NULL || !os_valid_prio(priority))
+        return osErrorValue;
+    os_enter();
+    if (thread_id->state == INACTIVE) {
+        pthread_mutex_unlock(&os_lock);
+        return osErrorResource;
+    }
+    thread_id->base_prio = priority;
+    os_change_prio(thread_id, priority);
+    os_leave();
+    return osOK;
+}
+
+osPriority osThreadGetPriority(osThreadId thread_id) {
+    if (os_in_isr() || thread_id == NULL || thread_id->state == INACTIVE)
+        return osPriorityError;
+    return thread_id->prio;
+}
+
+
+//  ==== Generic Wait Functions ====
+
+osStatus osDelay(uint32_t millisec) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (millisec != 0) {
+        os_enter();
+        os_block(NULL, WAIT_DLY, millisec);
+        os_leave();
+    }
+    return osEventTimeout;
+}
+
+
+//  ==== Timer Management Functions ====
+
+static void os_timer_thread(void const *argument) {
+    for (;;) {
+        osEvent evt = osMessageGet(os_timer_queue, osWaitForever);
+        struct os_timer_cb *t = evt.value.p;
+        int call;
+
+        pthread_mutex_lock(&os_lock);
+        t->queued--;
+        call = !t->deleted;
+        if (t->deleted && t->queued == 0)
+            free(t);
+        pthread_mutex_unlock(&os_lock);
+        if (call)
+            t->ptimer(t->argument);
+    }
+}
+
+osTimerId osTimerCreate(osTimerDef_t *timer_def, os_timer_type type, void *argument) {
+    struct os_timer_cb *t;
+
+    if (os_in_isr() || timer_def == NULL || timer_def->ptimer == NULL)
+        return NULL;
+    t = calloc(1, sizeof(*t));
+    if (t == NULL)
+        return NULL;
+    t->ptimer = timer_def->ptimer;
+    t->argument = argument;
+    t->type = type;
+    return t;
+}
+
+osStatus osTimerStart(osTimerId timer_id, uint32_t millisec) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (timer_id == NULL || millisec == 0)
+        return osErrorParameter;
+    os_enter();
+    if (timer_id->running)
+        os_timer_remove(timer_id);
+    timer_id->period = millisec;
+    timer_id->deadline = os_time + millisec;
+    timer_id->running = 1;
+    os_timer_insert(timer_id);
+    os_leave();
+    return osOK;
+}
+
+osStatus osTimerStop(osTimerId timer_id) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (timer_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    if (!timer_id->running) {
+        pthread_mutex_unlock(&os_lock);
+        return osErrorResource;
+    }
+    os_timer_remove(timer_id);
+    timer_id->running = 0;
+    os_leave();
+    return osOK;
+}
+
+osStatus osTimerDelete(osTimerId timer_id) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (timer_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    if (timer_id->running)
+        os_timer_remove(timer_id);
+    timer_id->running = 0;
+    timer_id->deleted = 1;
+    if (timer_id->queued == 0)
+        free(timer_id);
+    os_leave();
+    return osOK;
+}
+
+
+//  ==== Signal Management ====
+
+/* Take the signals which the thread waits for, if they are all set or, when
+   it waits for any, if one is.  Returns 0 if they aren't. */
+static int32_t os_signal_take(struct os_thread_cb *p, int32_t signals, int all) {
+    int32_t matched = p->signals & signals;
+
+    if (matched == 0 || (all && matched != signals))
+        return 0;
+    p->signals &= ~matched;
+    return matched;
+}
+
+int32_t osSignalSet(osThreadId thread_id, int32_t signals) {
+    int32_t previous;
+
+    if (thread_id == NULL || (signals & ~SIGNAL_MASK))
+        return 0x80000000;
+    os_enter();
+    if (thread_id->state == INACTIVE) {
+        pthread_mutex_unlock(&os_lock);
+        return 0x80000000;
+    }
+    previous = thread_id->signals;
+    thread_id->signals |= signals;
+    if (thread_id->state == WAIT_OR || thread_id->state == WAIT_AND) {
+        int32_t matched = os_signal_take(thread_id, thread_id->wait_signals, thread_id->state == WAIT_AND);
+
+        if (matched) {
+            thread_id->message = matched;
+            os_ready(thread_id, 1);
+        }
+    }
+    os_leave();
+    return previous;
+}
+
+int32_t osSignalClear(osThreadId thread_id, int32_t signals) {
+    int32_t previous;
+
+    if (os_in_isr())
+        return 0x80000000;
+    if (thread_id == NULL || (signals & ~SIGNAL_MASK))
+        return 0x80000000;
+    os_enter();
+    previous = thread_id->signals;
+    thread_id->signals &= ~signals;
+    pthread_mutex_unlock(&os_lock);
+    return previous;
+}
+
+int32_t osSignalGet(osThreadId thread_id) {
+    if (thread_id == NULL)
+        return 0x80000000;
+    return thread_id->signals;
+}
+
+osEvent osSignalWait(int32_t signals, uint32_t millisec) {
+    struct os_thread_cb *self;
+    int     all = signals != 0;
+    int32_t mask = all ? signals : SIGNAL_MASK;
+    int32_t matched;
+    osEvent ret;
+
+    memset(&ret, 0, sizeof(ret));
+    if (os_in_isr()) {
+        ret.status = osErrorISR;
+        return ret;
+    }
+    if (signals & ~SIGNAL_MASK) {
+        ret.status = osErrorValue;
+        return ret;
+    }
+    os_enter();
+    self = os_run;
+    matched = os_signal_take(self, mask, all);
+    if (matched) {
+        ret.status = osEventSignal;
+        ret.value.signals = matched;
+    }
+    else if (millisec == 0) {
+        ret.status = osOK;
+    }
+    else {
+        self->wait_signals = mask;
+        if (os_block(NULL, all ? WAIT_AND : WAIT_OR, millisec)) {
+            ret.status = osEventSignal;
+            ret.value.signals = self->message;
+        }
+        else {
+            ret.status = osEventTimeout;
+        }
+    }
+    os_leave();
+    return ret;
+}
+
+
+//  ==== Mutex Management ====
+
+static osPriority os_inherited_prio(struct os_thread_cb *p) {
+    osPriority prio = p->base_prio;
+    struct os_mutex_cb *m;
+
+    for (m = p->mutexes ; m ; m = m->next) {
+        if (m->waiters.first && m->waiters.first->prio > prio)
+            prio = m->waiters.first->prio;
+    }
+    return prio;
+}
+
+static void os_mutex_own(struct os_mutex_cb *m, struct os_thread_cb *p) {
+    m->owner = p;
+    m->level = 1;
+    m->next = p->mutexes;
+    p->mutexes = m;
+}
+
+static void os_mutex_release(struct os_mutex_cb *m) {
+    struct os_thread_cb *owner = m->owner;
+    struct os_mutex_cb **pp;
+
+    for (pp = &owner->mutexes ; *pp ; pp = &(*pp)->next) {
+        if (*pp == m) {
+            *pp = m->next;
+            break;
+        }
+    }
+    m->owner = NULL;
+    m->level = 0;
+    if (m->waiters.first) {
+        struct os_thread_cb *next = m->waiters.first;
+
+        os_mutex_own(m, next);
+        os_ready(next, 1);
+    }
+    os_change_prio(owner, os_inherited_prio(owner));
+}
+
+static void os_release_mutexes(struct os_thread_cb *p) {
+    while (p->mutexes)
+        os_mutex_release(p->mutexes);
+}
+
+osMutexId osMutexCreate(osMutexDef_t *mutex_def) {
+    if (os_in_isr() || mutex_def == NULL)
+        return NULL;
+    return calloc(1, sizeof(struct os_mutex_cb));
+}
+
+osStatus osMutexWait(osMutexId mutex_id, uint32_t millisec) {
+    struct os_thread_cb *self;
+    osStatus status = osOK;
+
+    if (os_in_isr())
+        return osErrorISR;
+    if (mutex_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    self = os_run;
+    if (mutex_id->owner == NULL) {
+        os_mutex_own(mutex_id, self);
+    }
+    else if (mutex_id->owner == self) {
+        mutex_id->level++;
+    }
+    else if (millisec == 0) {
+        status = osErrorResource;
+    }
+    else {
+        /* Priority inheritance, so that the owner isn't held up by threads
+           of a priority between the two. */
+        if (mutex_id->owner->prio < self->prio)
+            os_change_prio(mutex_id->owner, self->prio);
+        if (!os_block(&mutex_id->waiters, WAIT_MUT, millisec))
+            status = osErrorTimeoutResource;
+    }
+    os_leave();
+    return status;
+}
+
+osStatus osMutexRelease(osMutexId mutex_id) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (mutex_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    if (mutex_id->owner != os_run) {
+        pthread_mutex_unlock(&os_lock);
+        return osErrorResource;
+    }
+    if (--mutex_id->level == 0)
+        os_mutex_release(mutex_id);
+    os_leave();
+    return osOK;
+}
+
+osStatus osMutexDelete(osMutexId mutex_id) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (mutex_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    while (mutex_id->waiters.first)
+        os_ready(mutex_id->waiters.first, 0);
+    if (mutex_id->owner)
+        os_mutex_release(mutex_id);
+    free(mutex_id);
+    os_leave();
+    return osOK;
+}
+
+
+//  ==== Semaphore Management Functions ====
+
+osSemaphoreId osSemaphoreCreate(osSemaphoreDef_t *semaphore_def, int32_t count) {
+    struct os_semaphore_cb *s;
+
+    if (os_in_isr() || semaphore_def == NULL || count < 0 || count > osFeature_Semaphore)
+        return NULL;
+    s = calloc(1, sizeof(*s));
+    if (s)
+        s->tokens = count;
+    return s;
+}
+
+int32_t osSemaphoreWait(osSemaphoreId semaphore_id, uint32_t millisec) {
+    int32_t ret = 0;
+
+    if (os_in_isr() || semaphore_id == NULL)
+        return -1;
+    os_enter();
+    if (semaphore_id->tokens > 0) {
+        semaphore_id->tokens--;
+        ret = semaphore_id->tokens + 1;
+    }
+    else if (millisec != 0 && os_block(&semaphore_id->waiters, WAIT_SEM, millisec)) {
+        ret = semaphore_id->tokens + 1;
+    }
+    os_leave();
+    return ret;
+}
+
+osStatus osSemaphoreRelease(osSemaphoreId semaphore_id) {
+    osStatus status = osOK;
+
+    if (semaphore_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    if (semaphore_id->waiters.first)
+        os_ready(semaphore_id->waiters.first, 1);
+    else if (semaphore_id->tokens == osFeature_Semaphore)
+        status = osErrorResource;
+    else
+        semaphore_id->tokens++;
+    os_leave();
+    return status;
+}
+
+osStatus osSemaphoreDelete(osSemaphoreId semaphore_id) {
+    if (os_in_isr())
+        return osErrorISR;
+    if (semaphore_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    while (semaphore_id->waiters.first)
+        os_ready(semaphore_id->waiters.first, 0);
+    free(semaphore_id);
+    os_leave();
+    return osOK;
+}
+
+
+//  ==== Memory Pool Management Functions ====
+
+static int os_pool_init(struct os_pool_cb *pool, uint32_t pool_sz, uint32_t item_sz) {
+    uint32_t i;
+
+    pool->item_sz = (item_sz + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    pool->pool_sz = pool_sz;
+    pool->blocks = malloc(pool_sz * pool->item_sz);
+    if (pool->blocks == NULL)
+        return 0;
+    for (i = pool_sz ; i-- > 0 ; ) {
+        void **block = (void **)(pool->blocks + i * pool->item_sz);
+
+        *block = pool->free;
+        pool->free = block;
+    }
+    return 1;
+}
+
+static void *os_pool_alloc(struct os_pool_cb *pool) {
+    void **block = pool->free;
+
+    if (block)
+        pool->free = *block;
+    return block;
+}
+
+static osStatus os_pool_free(struct os_pool_cb *pool, void *block) {
+    uintptr_t offset = (uint8_t *)block - pool->blocks;
+
+    if (block == NULL || (uint8_t *)block < pool->blocks || offset >= pool->pool_sz * pool->item_sz ||
+        offset % pool->item_sz)
+        return osErrorValue;
+    if (pool->waiters.first) {
+        /* Straight to a thread waiting in osMailAlloc. */
+        pool->waiters.first->message = (uintptr_t)block;
+        os_ready(pool->waiters.first, 1);
+    }
+    else {
+        *(void **)block = pool->free;
+        pool->free = block;
+    }
+    return osOK;
+}
+
+osPoolId osPoolCreate(osPoolDef_t *pool_def) {
+    struct os_pool_cb *pool;
+
+    if (os_in_isr() || pool_def == NULL || pool_def->pool_sz == 0 || pool_def->item_sz == 0)
+        return NULL;
+    pool = calloc(1, sizeof(*pool));
+    if (pool && !os_pool_init(pool, pool_def->pool_sz, pool_def->item_sz)) {
+        free(pool);
+        pool = NULL;
+    }
+    return pool;
+}
+
+void *osPoolAlloc(osPoolId pool_id) {
+    void *block;
+
+    if (pool_id == NULL)
+        return NULL;
+    os_enter();
+    block = os_pool_alloc(pool_id);
+    pthread_mutex_unlock(&os_lock);
+    return block;
+}
+
+void *osPoolCAlloc(osPoolId pool_id) {
+    void *block = osPoolAlloc(pool_id);
+
+    if (block)
+        memset(block, 0, pool_id->item_sz);
+    return block;
+}
+
+osStatus osPoolFree(osPoolId pool_id, void *block) {
+    osStatus status;
+
+    if (pool_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    status = os_pool_free(pool_id, block);
+    os_leave();
+    return status;
+}
+
+
+//  ==== Message Queue Management Functions ====
+
+static osStatus os_message_put(struct os_messageQ_cb *q, uintptr_t info, uint32_t millisec) {
+    if (q->getters.first) {
+        q->getters.first->message = info;
+        os_ready(q->getters.first, 1);
+    }
+    else if (q->count < q->queue_sz) {
+        q->queue[(q->first + q->count++) % q->queue_sz] = info;
+    }
+    else if (millisec == 0 || os_in_isr()) {
+        return osErrorResource;
+    }
+    else {
+        os_run->message = info;
+        if (!os_block(&q->putters, WAIT_MBX, millisec))
+            return osErrorTimeoutResource;
+    }
+    return osOK;
+}
+
+static osStatus os_message_get(struct os_messageQ_cb *q, uint32_t millisec, uintptr_t *info) {
+    if (q->count) {
+        *info = q->queue[q->first];
+        q->first = (q->first + 1) % q->queue_sz;
+        q->count--;
+        if (q->putters.first) {
+            q->queue[(q->first + q->count++) % q->queue_sz] = q->putters.first->message;
+            os_ready(q->putters.first, 1);
+        }
+        return osEventMessage;
+    }
+    if (millisec == 0 || os_in_isr())
+        return osOK;
+    if (!os_block(&q->getters, WAIT_MBX, millisec))
+        return osEventTimeout;
+    *info = os_run->message;
+    return osEventMessage;
+}
+
+static int os_message_init(struct os_messageQ_cb *q, uint32_t queue_sz) {
+    q->queue_sz = queue_sz;
+    q->queue = calloc(queue_sz, sizeof(uintptr_t));
+    return q->queue != NULL;
+}
+
+osMessageQId osMessageCreate(osMessageQDef_t *queue_def, osThreadId thread_id) {
+    struct os_messageQ_cb *q;
+
+    if (os_in_isr() || queue_def == NULL || queue_def->queue_sz == 0)
+        return NULL;
+    q = calloc(1, sizeof(*q));
+    if (q && !os_message_init(q, queue_def->queue_sz)) {
+        free(q);
+        q = NULL;
+    }
+    return q;
+}
+
+osStatus osMessagePut(osMessageQId queue_id, uintptr_t info, uint32_t millisec) {
+    osStatus status;
+
+    if (queue_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    status = os_message_put(queue_id, info, millisec);
+    os_leave();
+    return status;
+}
+
+osEvent osMessageGet(osMessageQId queue_id, uint32_t millisec) {
+    uintptr_t info = 0;
+    osEvent ret;
+
+    memset(&ret, 0, sizeof(ret));
+    if (queue_id == NULL) {
+        ret.status = osErrorParameter;
+        return ret;
+    }
+    os_enter();
+    ret.status = os_message_get(queue_id, millisec, &info);
+    os_leave();
+    ret.value.p = (void *)info;
+    ret.def.message_id = queue_id;
+    return ret;
+}
+
+
+//  ==== Mail Queue Management Functions ====
+
+osMailQId osMailCreate(osMailQDef_t *queue_def, osThreadId thread_id) {
+    struct os_mailQ_cb *m;
+
+    if (os_in_isr() || queue_def == NULL || queue_def->queue_sz == 0 || queue_def->item_sz == 0)
+        return NULL;
+    m = calloc(1, sizeof(*m));
+    if (m == NULL)
+        return NULL;
+    if (!os_pool_init(&m->pool, queue_def->queue_sz, queue_def->item_sz) ||
+        !os_message_init(&m->queue, queue_def->queue_sz)) {
+        free(m->pool.blocks);
+        free(m);
+        return NULL;
+    }
+    return m;
+}
+
+void *osMailAlloc(osMailQId queue_id, uint32_t millisec) {
+    void *block;
+
+    if (queue_id == NULL)
+        return NULL;
+    os_enter();
+    block = os_pool_alloc(&queue_id->pool);
+    if (block == NULL && millisec != 0 && !os_in_isr()) {
+        if (os_block(&queue_id->pool.waiters, WAIT_MBX, millisec))
+            block = (void *)os_run->message;
+    }
+    os_leave();
+    return block;
+}
+
+void *osMailCAlloc(osMailQId queue_id, uint32_t millisec) {
+    void *block = osMailAlloc(queue_id, millisec);
+
+    if (block)
+        memset(block, 0, queue_id->pool.item_sz);
+    return block;
+}
+
+osStatus osMailPut(osMailQId queue_id, void *mail) {
+    osStatus status;
+
+    if (queue_id == NULL || mail == NULL)
+        return osErrorParameter;
+    os_enter();
+    status = os_message_put(&queue_id->queue, (uintptr_t)mail, 0);
+    os_leave();
+    return status;
+}
+
+osEvent osMailGet(osMailQId queue_id, uint32_t millisec) {
+    uintptr_t info = 0;
+    osEvent ret;
+
+    memset(&ret, 0, sizeof(ret));
+    if (queue_id == NULL) {
+        ret.status = osErrorParameter;
+        return ret;
+    }
+    os_enter();
+    ret.status = os_message_get(&queue_id->queue, millisec, &info);
+    os_leave();
+    if (ret.status == osEventMessage)
+        ret.status = osEventMail;
+    ret.value.p = (void *)info;
+    ret.def.mail_id = queue_id;
+    return ret;
+}
+
+osStatus osMailFree(osMailQId queue_id, void *mail) {
+    osStatus status;
+
+    if (queue_id == NULL)
+        return osErrorParameter;
+    os_enter();
+    status = os_pool_free(&queue_id->pool, mail);
+    os_leave();
+    return status;
+}
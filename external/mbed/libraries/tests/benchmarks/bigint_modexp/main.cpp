@@ -0,0 +1,104 @@
+#include "mbed.h"
+#include "test_env.h"
+#include "axTLS/ssl/os_port.h"
+#include "axTLS/crypto/crypto.h"
+
+// Compares axTLS's Barrett bi_mod_power() with the Montgomery and fixed window
+// path it takes for odd moduli, in CPU cycles per modular exponentiation.
+#if !defined(TOOLCHAIN_GCC) || !defined(__thumb2__)
+#error This benchmark measures the Cortex-M bigint routines
+#endif
+
+namespace {
+    const int ITERATIONS = 3;
+    // The RSA public key operation, a CRT half and a full private key operation.
+    const int SIZES[][2] = { { 1024, 17 }, { 512, 512 }, { 1024, 1024 }, { 2048, 17 }, { 2048, 2048 } };
+}
+
+static uint8_t expected[256];
+static uint8_t actual[256];
+
+static bigint* random_bigint(BI_CTX* ctx, int bytes, bool odd) {
+    uint8_t buffer[256];
+    
+    for (int i = 0; i < bytes; i++) {
+        buffer[i] = rand();
+    }
+    buffer[0] |= 0x80;
+    buffer[bytes - 1] = odd ? (buffer[bytes - 1] | 1) : (buffer[bytes - 1] & ~1);
+    return bi_import(ctx, buffer, bytes);
+}
+
+// Without R^2 for the modulus bi_mod_power() takes the Barrett path.
+static bigint* mod_power(BI_CTX* ctx, bigint* base, bigint* exp, bool barrett) {
+    bigint* rr = ctx->bi_mont_RR[ctx->mod_offset];
+    
+    if (barrett) {
+        ctx->bi_mont_RR[ctx->mod_offset] = NULL;
+    }
+    bigint* result = bi_mod_power(ctx, bi_copy(base), bi_copy(exp));
+    ctx->bi_mont_RR[ctx->mod_offset] = rr;
+    return result;
+}
+
+static bool benchmark(int bits, int exp_bits) {
+    BI_CTX* ctx = bi_initialize();
+    int bytes = bits / 8;
+    uint64_t cycles[2];
+    
+    bi_set_mod(ctx, random_bigint(ctx, bytes, true), BIGINT_M_OFFSET);
+    ctx->mod_offset = BIGINT_M_OFFSET;
+    bigint* base = random_bigint(ctx, bytes - 1, false);
+    bigint* exp = exp_bits == 17 ? int_to_bi(ctx, 65537) : random_bigint(ctx, exp_bits / 8, true);
+    bi_permanent(base);
+    bi_permanent(exp);
+    
+    for (int barrett = 0; barrett < 2; barrett++) {
+        bigint* result = NULL;
+        
+        // Timed one at a time, since a 2048 bit private key operation can
+        // take long enough for the 32-bit cycle counter to wrap over several.
+        cycles[barrett] = 0;
+        for (int i = 0; i < ITERATIONS; i++) {
+            if (result) {
+                bi_free(ctx, result);
+            }
+            uint32_t start = DWT->CYCCNT;
+            result = mod_power(ctx, base, exp, barrett);
+            cycles[barrett] += DWT->CYCCNT - start;
+        }
+        cycles[barrett] /= ITERATIONS;
+        
+        bi_export(ctx, result, barrett ? expected : actual, bytes);
+    }
+    
+    printf("%4d bit modulus, %4d bit exponent: Barrett %10lu cycles, Montgomery %10lu cycles\r\n",
+           bits, exp_bits, (unsigned long)cycles[1], (unsigned long)cycles[0]);
+    
+    bi_depermanent(base);
+    bi_depermanent(exp);
+    bi_free(ctx, base);
+    bi_free(ctx, exp);
+    bi_free_mod(ctx, BIGINT_M_OFFSET);
+    bi_terminate(ctx);
+    
+    return memcmp(expected, actual, bytes) == 0;
+}
+
+int main() {
+    bool result = true;
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    disable_memory_buf();
+    
+    for (unsigned int i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); i++) {
+        if (!benchmark(SIZES[i][0], SIZES[i][1])) {
+            printf("Mismatch for %d bit modulus\r\n", SIZES[i][0]);
+            result = false;
+        }
+    }
+    
+    notify_completion(result);
+}
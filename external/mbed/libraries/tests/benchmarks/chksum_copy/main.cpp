@@ -0,0 +1,67 @@
+#include "mbed.h"
+#include "test_env.h"
+#include "lwip/inet_chksum.h"
+
+// Compares lwIP's old two pass LWIP_CHKSUM_COPY (MEMCPY then LWIP_CHKSUM)
+// with the fused copy and checksum, in bytes per CPU cycle.
+#if !defined(TOOLCHAIN_GCC) || !defined(__thumb2__)
+#error This benchmark measures the Thumb-2 checksum routines
+#endif
+
+namespace {
+    const int ITERATIONS = 1000;
+    const int LENGTHS[] = { 64, 536, 1460 };
+}
+
+static char source[1460 + 4];
+static char dest[1460 + 4];
+
+static u16_t copy_then_checksum(void* dst, const void* src, int len) {
+    MEMCPY(dst, src, len);
+    return LWIP_CHKSUM(dst, len);
+}
+
+static void benchmark(const char* name, u16_t (*copy)(void*, const void*, int), int offset, int len) {
+    volatile u16_t result = 0;
+    
+    uint32_t start = DWT->CYCCNT;
+    for (int i = 0; i < ITERATIONS; i++) {
+        result += copy(dest, source + offset, len);
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    
+    printf("%-20s src+%d %4d bytes: %.3f bytes/cycle\r\n", name, offset, len, ((float)len * ITERATIONS) / cycles);
+}
+
+int main() {
+    bool result = true;
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
+    for (unsigned int i = 0; i < sizeof(source); i++) {
+        source[i] = rand();
+    }
+    
+    // The fused version must match the two pass version for every alignment.
+    for (int offset = 0; offset < 4; offset++) {
+        for (int len = 0; len < 64; len++) {
+            u16_t expected = copy_then_checksum(dest + offset, source, len);
+            if (thumb2_checksum_copy(dest + offset, source, len) != expected ||
+                thumb2_checksum_copy(dest, source + offset, len) != copy_then_checksum(dest, source + offset, len)) {
+                printf("Mismatch at offset %d length %d\r\n", offset, len);
+                result = false;
+            }
+        }
+    }
+    
+    for (unsigned int i = 0; i < sizeof(LENGTHS) / sizeof(LENGTHS[0]); i++) {
+        for (int offset = 0; offset < 2; offset++) {
+            benchmark("memcpy + checksum", copy_then_checksum, offset, LENGTHS[i]);
+            benchmark("checksum_copy", thumb2_checksum_copy, offset, LENGTHS[i]);
+        }
+    }
+    
+    notify_completion(result);
+}
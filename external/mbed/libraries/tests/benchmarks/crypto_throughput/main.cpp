@@ -0,0 +1,150 @@
+#include "mbed.h"
+#include "test_env.h"
+#include "axTLS/ssl/os_port.h"
+#include "axTLS/crypto/crypto.h"
+
+// Bulk throughput of the ciphers and digests used by axTLS's TLS records, in
+// CPU cycles per byte, after checking them against known answers.
+#if !defined(TOOLCHAIN_GCC) || !defined(__thumb2__)
+#error This benchmark measures the Cortex-M crypto routines
+#endif
+
+namespace {
+    const int ITERATIONS = 16;
+    const int BUFFER_SIZE = 1024;
+}
+
+static uint8_t in[BUFFER_SIZE];
+static uint8_t out[BUFFER_SIZE];
+static AES_CTX aes;
+static AES_GCM_CTX gcm;
+static RC4_CTX rc4;
+
+// FIPS-197 appendix C.1, GCM test case 2 and the FIPS 180-2 "abc" example.
+static bool known_answers() {
+    static const uint8_t aes_key[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                         0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    static const uint8_t aes_plain[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                           0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+    static const uint8_t aes_cipher[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+                                            0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+    static const uint8_t gcm_cipher[16] = { 0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92,
+                                            0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78 };
+    static const uint8_t gcm_tag[16] = { 0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd,
+                                         0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf };
+    static const uint8_t sha256_abc[32] = { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+                                            0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+                                            0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+                                            0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+    uint8_t zero[16] = { 0 };
+    uint8_t block[32];
+    uint8_t tag[16];
+    SHA256_CTX sha256;
+    bool result = true;
+    
+    AES_set_key(&aes, aes_key, zero, AES_MODE_128);
+    AES_ecb_encrypt(&aes, aes_plain, block);
+    result = result && memcmp(block, aes_cipher, 16) == 0;
+    
+    AES_gcm_set_key(&gcm, zero, AES_MODE_128);
+    AES_gcm_start(&gcm, zero, NULL, 0);
+    AES_gcm_encrypt(&gcm, zero, block, 16);
+    AES_gcm_finish(&gcm, tag);
+    result = result && memcmp(block, gcm_cipher, 16) == 0 && memcmp(tag, gcm_tag, 16) == 0;
+    
+    SHA256_Init(&sha256);
+    SHA256_Update(&sha256, (const uint8_t*)"abc", 3);
+    SHA256_Final(block, &sha256);
+    result = result && memcmp(block, sha256_abc, 32) == 0;
+    
+    return result;
+}
+
+static void aes_cbc_encrypt() {
+    AES_cbc_encrypt(&aes, in, out, BUFFER_SIZE);
+}
+
+static void aes_cbc_decrypt() {
+    AES_cbc_decrypt(&aes, in, out, BUFFER_SIZE);
+}
+
+static void aes_ctr() {
+    AES_ctr_encrypt(&aes, in, out, BUFFER_SIZE);
+}
+
+static void aes_gcm() {
+    uint8_t tag[AES_GCM_TAG_SIZE];
+    
+    AES_gcm_start(&gcm, in, in, 13);
+    AES_gcm_encrypt(&gcm, in, out, BUFFER_SIZE);
+    AES_gcm_finish(&gcm, tag);
+}
+
+static void rc4_crypt() {
+    RC4_crypt(&rc4, in, out, BUFFER_SIZE);
+}
+
+static void sha1() {
+    SHA1_CTX ctx;
+    
+    SHA1_Init(&ctx);
+    SHA1_Update(&ctx, in, BUFFER_SIZE);
+    SHA1_Final(out, &ctx);
+}
+
+static void sha256() {
+    SHA256_CTX ctx;
+    
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, in, BUFFER_SIZE);
+    SHA256_Final(out, &ctx);
+}
+
+static void benchmark(const char* name, void (*function)()) {
+    uint32_t start = DWT->CYCCNT;
+    for (int i = 0; i < ITERATIONS; i++) {
+        function();
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    
+    printf("%-16s %6lu.%02lu cycles/byte\r\n", name,
+           (unsigned long)(cycles / (ITERATIONS * BUFFER_SIZE)),
+           (unsigned long)(cycles * 100ULL / (ITERATIONS * BUFFER_SIZE) % 100));
+}
+
+int main() {
+    uint8_t key[32];
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    disable_memory_buf();
+    
+    bool result = known_answers();
+    if (!result) {
+        printf("Known answer tests failed\r\n");
+    }
+    
+    for (unsigned int i = 0; i < sizeof(in); i++) {
+        in[i] = rand();
+    }
+    for (unsigned int i = 0; i < sizeof(key); i++) {
+        key[i] = rand();
+    }
+    
+    AES_set_key(&aes, key, in, AES_MODE_128);
+    benchmark("AES-128-CBC enc", aes_cbc_encrypt);
+    benchmark("AES-128-CTR", aes_ctr);
+    AES_convert_key(&aes);
+    benchmark("AES-128-CBC dec", aes_cbc_decrypt);
+    AES_set_key(&aes, key, in, AES_MODE_256);
+    benchmark("AES-256-CBC enc", aes_cbc_encrypt);
+    AES_gcm_set_key(&gcm, key, AES_MODE_128);
+    benchmark("AES-128-GCM", aes_gcm);
+    RC4_setup(&rc4, key, 16);
+    benchmark("RC4", rc4_crypt);
+    benchmark("SHA-1", sha1);
+    benchmark("SHA-256", sha256);
+    
+    notify_completion(result);
+}
@@ -0,0 +1,128 @@
+#include "mbed.h"
+#include "rtos.h"
+#include "test_env.h"
+
+// Messages per second passed from a sending thread to a receiving thread of
+// lower priority through a Queue, a Mail and a Channel, which the receiver
+// drains in batches of up to 16.  Then the same for a Channel filled from a
+// Ticker interrupt, checking that no message is lost or reordered.
+#if !defined(__CORTEX_M3) && !defined(__CORTEX_M4)
+#error This benchmark needs the DWT cycle counter
+#endif
+
+namespace {
+    const int MESSAGES = 10000;
+    const int BATCH = 16;
+    const int ISR_PERIOD_US = 20;
+    const uint32_t STACK_SIZE = 512;
+}
+
+struct Sample {
+    uint32_t sequence;
+    uint32_t value;
+};
+
+static Queue<Sample, 16> queue;
+static Mail<Sample, 16> mail;
+static Channel<Sample, 16> channel;
+static Sample queued[MESSAGES];
+static volatile uint32_t isr_sequence;
+static volatile uint32_t isr_overruns;
+
+static void queue_sender(void const *argument) {
+    for (int i = 0; i < MESSAGES; i++) {
+        queued[i].sequence = i;
+        queue.put(&queued[i], osWaitForever);
+    }
+}
+
+static void mail_sender(void const *argument) {
+    for (int i = 0; i < MESSAGES; i++) {
+        Sample *sample = mail.alloc(osWaitForever);
+        sample->sequence = i;
+        mail.put(sample);
+    }
+}
+
+static void channel_sender(void const *argument) {
+    for (int i = 0; i < MESSAGES; i++) {
+        Sample sample = { (uint32_t)i, 0 };
+        while (!channel.try_send(sample)) {
+            Thread::yield();
+        }
+    }
+}
+
+static void isr_sender() {
+    Sample sample = { isr_sequence, 0 };
+    
+    if (channel.try_send(sample)) {
+        isr_sequence++;
+    } else {
+        isr_overruns++;
+    }
+}
+
+static void report(const char *name, uint32_t cycles) {
+    printf("%-16s %9lu  %6lu\r\n", name, (uint32_t)((uint64_t)MESSAGES * SystemCoreClock / cycles), cycles / MESSAGES);
+}
+
+int main() {
+    bool result = true;
+    uint32_t begin;
+    Sample samples[BATCH];
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
+    printf("path              msgs/s  cycles\r\n");
+    {
+        begin = DWT->CYCCNT;
+        Thread sender(queue_sender, NULL, osPriorityAboveNormal, STACK_SIZE);
+        for (int i = 0; i < MESSAGES; i++) {
+            osEvent evt = queue.get();
+            result = result && ((Sample *)evt.value.p)->sequence == (uint32_t)i;
+        }
+        report("Queue", DWT->CYCCNT - begin);
+    }
+    {
+        begin = DWT->CYCCNT;
+        Thread sender(mail_sender, NULL, osPriorityAboveNormal, STACK_SIZE);
+        for (int i = 0; i < MESSAGES; i++) {
+            osEvent evt = mail.get();
+            Sample *sample = (Sample *)evt.value.p;
+            result = result && sample->sequence == (uint32_t)i;
+            mail.free(sample);
+        }
+        report("Mail", DWT->CYCCNT - begin);
+    }
+    {
+        begin = DWT->CYCCNT;
+        Thread sender(channel_sender, NULL, osPriorityAboveNormal, STACK_SIZE);
+        for (uint32_t i = 0; i < MESSAGES; ) {
+            uint32_t count = channel.receive_n(samples, BATCH);
+            for (uint32_t j = 0; j < count; j++, i++) {
+                result = result && samples[j].sequence == i;
+            }
+        }
+        report("Channel", DWT->CYCCNT - begin);
+    }
+    {
+        Ticker ticker;
+        
+        begin = DWT->CYCCNT;
+        ticker.attach_us(isr_sender, ISR_PERIOD_US);
+        for (uint32_t i = 0; i < MESSAGES; ) {
+            uint32_t count = channel.receive_n(samples, BATCH);
+            for (uint32_t j = 0; j < count; j++, i++) {
+                result = result && samples[j].sequence == i;
+            }
+        }
+        ticker.detach();
+        report("Channel from ISR", DWT->CYCCNT - begin);
+        printf("overruns %lu\r\n", isr_overruns);
+    }
+    
+    notify_completion(result);
+}
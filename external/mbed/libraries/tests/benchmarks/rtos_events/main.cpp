@@ -0,0 +1,108 @@
+#include "mbed.h"
+#include "rtos.h"
+#include "test_env.h"
+
+// ISR-to-thread latency, in CPU cycles, of an event posted from a Ticker
+// interrupt to an EventQueue, with the cycle count as its payload, next to
+// that of a thread of its own woken with a signal, as drivers did before.
+// It also checks that a periodic event runs as often as it should while the
+// interrupt posts, and that no event is dropped.
+#if !defined(__CORTEX_M3) && !defined(__CORTEX_M4)
+#error This benchmark needs the DWT cycle counter
+#endif
+
+namespace {
+    const int PERIOD_US = 1000;
+    const int SAMPLE_MS = 1000;
+    const int TIMED_MS = 10;
+    const uint32_t STACK_SIZE = 512;
+    const int32_t SIGNAL = 0x1;
+}
+
+static EventQueue queue(16, 2);
+static osThreadId signalled;
+static volatile uint32_t posted;
+static volatile uint32_t samples;
+static volatile uint32_t latency_sum;
+static volatile uint32_t latency_max;
+static volatile uint32_t timed;
+
+static void record(uint32_t latency) {
+    latency_sum += latency;
+    if (latency > latency_max) {
+        latency_max = latency;
+    }
+    samples++;
+}
+
+static void run_event(void const *payload) {
+    uint32_t now = DWT->CYCCNT;
+
+    record(now - *(const uint32_t*)payload);
+}
+
+static void run_timed(void const *argument) {
+    timed++;
+}
+
+static void post_event() {
+    uint32_t now = DWT->CYCCNT;
+
+    queue.post(run_event, &now, sizeof(now));
+}
+
+static void signal_thread() {
+    posted = DWT->CYCCNT;
+    osSignalSet(signalled, SIGNAL);
+}
+
+static void waiter(void const *argument) {
+    for (;;) {
+        Thread::signal_wait(SIGNAL);
+        record(DWT->CYCCNT - posted);
+    }
+}
+
+static void sample(const char *name, void (*isr)()) {
+    Ticker ticker;
+
+    __disable_irq();
+    samples = 0;
+    latency_sum = 0;
+    latency_max = 0;
+    __enable_irq();
+    ticker.attach_us(isr, PERIOD_US);
+    Thread::wait(SAMPLE_MS);
+    ticker.detach();
+    Thread::wait(10);
+
+    printf("%-12s %6u %8u %8u\r\n", name, (unsigned)samples,
+           (unsigned)(samples ? latency_sum / samples : 0), (unsigned)latency_max);
+}
+
+int main() {
+    bool result = true;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    Thread worker(EventQueue::worker, &queue, osPriorityHigh, STACK_SIZE);
+    Thread waiting(waiter, NULL, osPriorityHigh, STACK_SIZE);
+    signalled = waiting.gettid();
+
+    printf("handoff      events  avg cyc  max cyc\r\n");
+    int32_t id = queue.post_every(TIMED_MS, run_timed);
+    sample("EventQueue", post_event);
+    result = queue.cancel(id) && result;
+    sample("signal", signal_thread);
+
+    // The ticker ran for SAMPLE_MS, the periodic event alongside it.
+    uint32_t expected = SAMPLE_MS / TIMED_MS;
+    printf("periodic events: %u of %u, dropped: %u\r\n", (unsigned)timed,
+           (unsigned)expected, (unsigned)queue.dropped());
+    result = timed + 2 >= expected && timed <= expected + 2 && result;
+    result = queue.dropped() == 0 && result;
+
+    notify_completion(result);
+}
@@ -0,0 +1,59 @@
+#include "mbed.h"
+#include "rtos.h"
+#include "test_env.h"
+
+// Runs a 500 us control loop on a HighResTimer and reports how late its
+// callbacks start, then gives it a callback which every fourth time takes
+// longer than two periods, and checks that every expiration is accounted
+// for, either run or counted as an overrun, none dropped.
+
+namespace {
+    const uint32_t PERIOD_US = 500;
+    const uint32_t SLOW_US = 1200;
+    const int SAMPLE_MS = 1000;
+}
+
+static volatile uint32_t loops;
+
+static void control_loop(void const *argument) {
+    loops++;
+}
+
+static void slow_loop(void const *argument) {
+    if (loops++ % 4 == 0) {
+        wait_us(SLOW_US);
+    }
+}
+
+static bool sample(const char *name, HighResTimer &timer) {
+    HighResTimerStats stats;
+    uint32_t expected = SAMPLE_MS * 1000 / PERIOD_US;
+
+    loops = 0;
+    timer.reset_stats();
+    timer.start(PERIOD_US);
+    Thread::wait(SAMPLE_MS);
+    timer.stop();
+    timer.stats(&stats);
+
+    printf("%-6s runs %5u overruns %5u late min %4u max %4u jitter %4u us\r\n", name,
+           (unsigned)stats.runs, (unsigned)stats.overruns, (unsigned)stats.min_late_us,
+           (unsigned)stats.max_late_us, (unsigned)stats.jitter_us);
+
+    uint32_t expirations = stats.runs + stats.overruns;
+    return stats.runs == loops && expirations + 2 >= expected && expirations <= expected + 2;
+}
+
+int main() {
+    bool result = true;
+
+    HighResTimer::start_thread(osPriorityRealtime);
+
+    HighResTimer fast(control_loop);
+    result = sample("fast", fast) && result;
+
+    HighResTimer slow(slow_loop);
+    result = sample("slow", slow) && result;
+
+    notify_completion(result);
+}
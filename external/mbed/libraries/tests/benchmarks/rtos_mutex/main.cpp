@@ -0,0 +1,84 @@
+#include "mbed.h"
+#include "rtos.h"
+#include "test_env.h"
+
+// Cycles taken by Mutex and Semaphore operations.  Uncontended lock/unlock
+// and wait/release pairs are made by the calling thread without a service
+// call; a nested lock still takes one and serves as the reference.  In the
+// contended case a high priority thread blocks on a mutex held by main and
+// is handed it on unlock, which costs two thread switches per round.
+#if !defined(__CORTEX_M3) && !defined(__CORTEX_M4)
+#error This benchmark needs the DWT cycle counter
+#endif
+
+namespace {
+    const int ROUNDS = 1000;
+    const uint32_t STACK_SIZE = 512;
+}
+
+static Mutex mutex;
+static Semaphore start(0);
+static Semaphore done(0);
+static volatile int handed;
+
+static void contender(void const *argument) {
+    for (;;) {
+        start.wait();
+        mutex.lock();
+        handed++;
+        mutex.unlock();
+        done.release();
+    }
+}
+
+static void report(const char *name, uint32_t cycles) {
+    printf("%-26s %6lu\r\n", name, cycles / ROUNDS);
+}
+
+int main() {
+    bool result = true;
+    Semaphore semaphore(1);
+    uint32_t begin;
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
+    printf("operation                  cycles\r\n");
+    begin = DWT->CYCCNT;
+    for (int i = 0; i < ROUNDS; i++) {
+        mutex.lock();
+        mutex.unlock();
+    }
+    report("Mutex lock/unlock", DWT->CYCCNT - begin);
+    
+    mutex.lock();
+    begin = DWT->CYCCNT;
+    for (int i = 0; i < ROUNDS; i++) {
+        mutex.lock();
+        mutex.unlock();
+    }
+    report("nested lock/unlock (svc)", DWT->CYCCNT - begin);
+    result = result && mutex.unlock() == osOK && mutex.unlock() == osErrorResource;
+    
+    begin = DWT->CYCCNT;
+    for (int i = 0; i < ROUNDS; i++) {
+        semaphore.wait();
+        semaphore.release();
+    }
+    report("Semaphore wait/release", DWT->CYCCNT - begin);
+    result = result && semaphore.wait(0) == 1 && semaphore.wait(0) == 0;
+    
+    Thread thread(contender, NULL, osPriorityHigh, STACK_SIZE);
+    begin = DWT->CYCCNT;
+    for (int i = 0; i < ROUNDS; i++) {
+        mutex.lock();
+        start.release();
+        mutex.unlock();
+        done.wait();
+    }
+    report("contended lock/handover", DWT->CYCCNT - begin);
+    result = result && handed == ROUNDS;
+    
+    notify_completion(result);
+}
@@ -0,0 +1,58 @@
+#include "mbed.h"
+#include "rtos.h"
+#include "test_env.h"
+
+// Checks that the high-water marks of painted thread stacks follow what the
+// threads actually used, for threads on heap stacks and on a StackPool, then
+// prints the stack report with suggested sizes.  The rtos library must be
+// built with OS_STKPAINT set to 1 in RTX_Conf_CM.c.
+
+namespace {
+    const uint32_t DEPTHS[] = { 64, 256, 1024 };
+    const uint32_t STACK_SIZE = 2048;
+}
+
+static StackPool<STACK_SIZE, 3> stacks;
+
+// Use at least depth bytes of stack, in a way the compiler can't drop.
+static void use_stack(void const *argument) {
+    volatile uint8_t buffer[1024];
+    uint32_t depth = *(const uint32_t*)argument;
+
+    for (uint32_t i = 0; i < depth && i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t)i;
+    }
+}
+
+static bool check(Thread &thread, uint32_t depth) {
+    uint32_t used = thread.max_stack();
+    bool ok = used >= depth && used < thread.stack_size();
+
+    printf("used %4u bytes of %4u for %4u: %s\r\n", (unsigned)used,
+           (unsigned)thread.stack_size(), (unsigned)depth, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main() {
+    bool result = true;
+
+    for (unsigned int i = 0; i < sizeof(DEPTHS) / sizeof(DEPTHS[0]); i++) {
+        Thread heap_thread(use_stack, (void*)&DEPTHS[i], osPriorityNormal, STACK_SIZE);
+        Thread pool_thread(use_stack, stacks, (void*)&DEPTHS[i]);
+        Thread::wait(10);
+        result = check(heap_thread, DEPTHS[i]) && result;
+        result = check(pool_thread, DEPTHS[i]) && result;
+    }
+
+    // Stacks given back to the pool are painted again for their next thread,
+    // so it doesn't inherit the deepest use so far.
+    Thread first(use_stack, stacks, (void*)&DEPTHS[0]);
+    Thread second(use_stack, stacks, (void*)&DEPTHS[1]);
+    Thread::wait(10);
+    result = check(first, DEPTHS[0]) && first.max_stack() < DEPTHS[2] && result;
+
+    // Every thread, main, the timer and idle threads included.
+    stack_report();
+
+    notify_completion(result);
+}
@@ -0,0 +1,70 @@
+#include "mbed.h"
+#include "rtos.h"
+#include "test_env.h"
+
+// Checks that thread delays and RtosTimer periods keep time when RTX stops
+// its tick while idle, and reports the ticks skipped and how late the idle
+// thread woke up.  The rtos library must be built with OS_TICKLESS set to 1
+// in RTX_Conf_CM.c.
+
+namespace {
+    const uint32_t DELAYS[] = { 2, 5, 10, 50, 100, 500 };
+    const int REPEATS = 5;
+    const int TOLERANCE_US = 1500;
+    const int TIMER_PERIOD_MS = 20;
+    const int TIMER_RUN_MS = 1000;
+}
+
+static volatile int timer_calls;
+
+static void count(void const *argument) {
+    timer_calls++;
+}
+
+int main() {
+    bool result = true;
+    Timer timer;
+    TicklessStats before;
+    TicklessStats after;
+    
+    timer.start();
+    printf("delay ms  worst us off  skipped  sleeps  early  max late us\r\n");
+    for (unsigned int i = 0; i < sizeof(DELAYS) / sizeof(DELAYS[0]); i++) {
+        int worst = 0;
+        
+        tickless_stats(&before);
+        for (int j = 0; j < REPEATS; j++) {
+            // Start on a tick so that the delay is a whole number of ticks.
+            Thread::wait(1);
+            int start = timer.read_us();
+            Thread::wait(DELAYS[i]);
+            int off = timer.read_us() - start - (int)DELAYS[i] * 1000;
+            if (abs(off) > abs(worst)) {
+                worst = off;
+            }
+        }
+        tickless_stats(&after);
+        
+        printf("%8lu  %12d  %7lu  %6lu  %5lu  %11lu\r\n", DELAYS[i], worst,
+               after.skipped - before.skipped, after.sleeps - before.sleeps,
+               after.early - before.early, after.max_late_us);
+        if (abs(worst) > TOLERANCE_US) {
+            result = false;
+        }
+        if (DELAYS[i] > 2 && after.skipped == before.skipped) {
+            printf("No ticks were skipped, is OS_TICKLESS set?\r\n");
+            result = false;
+        }
+    }
+    
+    RtosTimer periodic(count, osTimerPeriodic);
+    periodic.start(TIMER_PERIOD_MS);
+    Thread::wait(TIMER_RUN_MS + TIMER_PERIOD_MS / 2);
+    periodic.stop();
+    printf("RtosTimer: %d calls of %d expected\r\n", timer_calls, TIMER_RUN_MS / TIMER_PERIOD_MS);
+    if (timer_calls != TIMER_RUN_MS / TIMER_PERIOD_MS) {
+        result = false;
+    }
+    
+    notify_completion(result);
+}
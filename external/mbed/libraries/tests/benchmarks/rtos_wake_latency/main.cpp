@@ -0,0 +1,108 @@
+#include "mbed.h"
+#include "rtos.h"
+#include "test_env.h"
+
+// Wake-to-run latency of a high priority thread released from a Ticker
+// interrupt, and the cost of Thread::yield(), in CPU cycles, with a growing
+// number of ready threads of normal priority yielding to each other.  RTX
+// kept its ready list sorted by priority, so that both grew with the number
+// of ready threads; with a FIFO per priority they should stay flat.
+#if !defined(__CORTEX_M3) && !defined(__CORTEX_M4)
+#error This benchmark needs the DWT cycle counter
+#endif
+
+namespace {
+    const int MAX_READY = 10;
+    const int COUNTS[] = { 0, 1, 2, 4, 6, 8, 10 };
+    const int PERIOD_US = 1000;
+    const int SAMPLE_MS = 500;
+    const uint32_t STACK_SIZE = 512;
+}
+
+static Semaphore semaphore(0);
+static volatile uint32_t released;
+static volatile uint32_t samples;
+static volatile uint32_t latency_sum;
+static volatile uint32_t latency_max;
+static volatile uint32_t yields;
+
+static void wake() {
+    released = DWT->CYCCNT;
+    semaphore.release();
+}
+
+static void waiter(void const *argument) {
+    for (;;) {
+        semaphore.wait();
+        uint32_t latency = DWT->CYCCNT - released;
+        
+        latency_sum += latency;
+        if (latency > latency_max) {
+            latency_max = latency;
+        }
+        samples++;
+    }
+}
+
+static void yielder(void const *argument) {
+    for (;;) {
+        yields++;
+        Thread::yield();
+    }
+}
+
+int main() {
+    bool result = true;
+    int ready = 0;
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
+    Thread waiting(waiter, NULL, osPriorityHigh, STACK_SIZE);
+    Ticker ticker;
+    ticker.attach_us(wake, PERIOD_US);
+    
+    printf("ready  wake avg  wake max  cycles/yield\r\n");
+    for (unsigned int i = 0; i < sizeof(COUNTS) / sizeof(COUNTS[0]); i++) {
+        // The yielding threads are never stopped, so only ever add more.
+        while (ready < COUNTS[i] && ready < MAX_READY) {
+            new Thread(yielder, NULL, osPriorityNormal, STACK_SIZE);
+            ready++;
+        }
+        Thread::wait(SAMPLE_MS / 10);
+        
+        __disable_irq();
+        samples = 0;
+        latency_sum = 0;
+        latency_max = 0;
+        yields = 0;
+        uint32_t start = DWT->CYCCNT;
+        __enable_irq();
+        
+        // main is one more normal priority thread, delayed while the others run.
+        Thread::wait(SAMPLE_MS);
+        
+        __disable_irq();
+        uint32_t cycles = DWT->CYCCNT - start;
+        uint32_t count = samples;
+        uint32_t sum = latency_sum;
+        uint32_t max = latency_max;
+        uint32_t yielded = yields;
+        __enable_irq();
+        
+        if (count == 0) {
+            printf("%5d  no wakeups\r\n", ready);
+            result = false;
+            continue;
+        }
+        if (yielded) {
+            printf("%5d  %8lu  %8lu  %12lu\r\n", ready, sum / count, max, cycles / yielded);
+        } else {
+            printf("%5d  %8lu  %8lu  %12s\r\n", ready, sum / count, max, "-");
+        }
+    }
+    ticker.detach();
+    
+    notify_completion(result);
+}
@@ -0,0 +1,70 @@
+#include "mbed.h"
+#include "EthernetInterface.h"
+#include "mbed_rpc.h"
+
+namespace {
+    const int ECHO_SERVER_PORT = 7;
+    const int BUFFER_SIZE = 64;
+}
+
+Serial pc(USBTX, USBRX);
+
+// Reply with the counters which most often explain dropped traffic:
+// PBUF_POOL and TCP_PCB usage/failures, link drops and tcpip mailbox depth.
+void netstats(Arguments *args, Reply *reply) {
+    EthernetStats stats;
+    EthernetInterface::getStats(&stats);
+    
+    reply->putData<int>(stats.heap.max);
+    reply->putData<int>(stats.pools[MEMP_PBUF_POOL].max);
+    reply->putData<int>(stats.pools[MEMP_PBUF_POOL].err);
+    reply->putData<int>(stats.pools[MEMP_TCP_PCB].max);
+    reply->putData<int>(stats.pools[MEMP_TCP_PCB].err);
+    reply->putData<int>(stats.link_drop);
+    reply->putData<int>(stats.tcpip_depth_max);
+    reply->putData<int>(stats.tcpip_wait_max_us);
+}
+
+// Serve "/netstats/run" (or any other RPC) typed on the serial port.
+void rpc_thread(void const *argument) {
+    char inbuf[RPC_MAX_STRING];
+    char outbuf[RPC_MAX_STRING];
+    
+    while (true) {
+        pc.gets(inbuf, sizeof(inbuf));
+        RPC::call(inbuf, outbuf);
+        pc.printf("%s\r\n", outbuf);
+    }
+}
+
+int main (void) {
+    char buffer[BUFFER_SIZE] = {0};
+    EthernetInterface eth;
+    eth.init(); //Use DHCP
+    eth.connect();
+    printf("MBED: Server IP Address is %s:%d\r\n", eth.getIPAddress(), ECHO_SERVER_PORT);
+    
+    RPCFunction rpc_netstats(&netstats, "netstats");
+    Thread rpc(rpc_thread);
+    
+    TCPSocketServer server;
+    server.bind(ECHO_SERVER_PORT);
+    server.listen();
+    
+    while (true) {
+        TCPSocketConnection client;
+        server.accept(client);
+        client.set_blocking(false, 1500); // Timeout after (1.5)s
+        
+        while (true) {
+            const int n = client.receive(buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+            client.send_all(buffer, n);
+        }
+        client.close();
+        
+        EthernetInterface::printStats(&pc);
+    }
+}
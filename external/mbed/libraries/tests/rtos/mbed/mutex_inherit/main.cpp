@@ -0,0 +1,66 @@
+#include "mbed.h"
+#include "test_env.h"
+#include "rtos.h"
+
+/*
+ * A low priority thread locks two mutexes without contention, so without the
+ * kernel.  A high priority thread then waits for the second, which raises the
+ * low one to high, before a medium priority thread waits for the first.  Once
+ * the low priority thread has unlocked both it must be back at low priority.
+ */
+
+Mutex first;
+Mutex second;
+Semaphore locked(0);
+Semaphore go(0);
+Semaphore done(0);
+
+volatile osPriority raised = osPriorityError;
+volatile osPriority restored = osPriorityError;
+
+void low_thread(void const *args) {
+    first.lock();
+    second.lock();
+    locked.release();
+    go.wait();
+    second.unlock();
+    first.unlock();
+    restored = osThreadGetPriority(osThreadGetId());
+    done.release();
+}
+
+void waiter_thread(void const *args) {
+    Mutex *mutex = (Mutex *)args;
+
+    mutex->lock();
+    mutex->unlock();
+    done.release();
+}
+
+int main() {
+    bool result = true;
+
+    // Run above all of the threads below so that each step completes before
+    // the next one starts.
+    osThreadSetPriority(osThreadGetId(), osPriorityRealtime);
+
+    Thread low(low_thread, NULL, osPriorityLow);
+    locked.wait();
+
+    Thread high(waiter_thread, &second, osPriorityHigh);
+    Thread::wait(10);
+    raised = low.get_priority();
+    Thread medium(waiter_thread, &first, osPriorityAboveNormal);
+    Thread::wait(10);
+
+    go.release();
+    for (int i = 0; i < 3; i++) {
+        result = result && done.wait(1000) > 0;
+    }
+
+    printf("low thread priority: %d raised, %d after unlocking\r\n", (int)raised, (int)restored);
+    result = result && raised == osPriorityHigh && restored == osPriorityLow;
+
+    notify_completion(result);
+    return 0;
+}
@@ -0,0 +1,171 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Validates the Montgomery path of axTLS's bi_mod_power() against the Barrett
+   path it replaces for odd moduli and then compares the time each takes for
+   the 1024 and 2048 bit modular exponentiations done by RSA.
+   tests/benchmarks/bigint_modexp is the on device counterpart.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "os_port.h"
+#include "crypto.h"
+
+
+static uint8_t g_buffer[2][512];
+
+
+static uint64_t readMicroseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+static bigint* randomBigint(BI_CTX* pCtx, int bytes, bool isOdd)
+{
+    uint8_t buffer[512];
+
+    for (int i = 0 ; i < bytes ; i++)
+        buffer[i] = rand();
+    buffer[0] |= 0x80;
+    if (isOdd)
+        buffer[bytes - 1] |= 1;
+    else
+        buffer[bytes - 1] &= ~1;
+    return bi_import(pCtx, buffer, bytes);
+}
+
+/* bi_mod_power() takes the Barrett path when there is no R^2 for the modulus,
+   as is the case for even moduli. */
+static bigint* modPower(BI_CTX* pCtx, bigint* pBase, bigint* pExp, bool useBarrett)
+{
+    bigint* pRR = pCtx->bi_mont_RR[pCtx->mod_offset];
+
+    if (useBarrett)
+        pCtx->bi_mont_RR[pCtx->mod_offset] = NULL;
+    bigint* pResult = bi_mod_power(pCtx, bi_copy(pBase), bi_copy(pExp));
+    pCtx->bi_mont_RR[pCtx->mod_offset] = pRR;
+
+    return pResult;
+}
+
+static bool resultsMatch(BI_CTX* pCtx, bigint* pBase, bigint* pExp, int bytes)
+{
+    bigint* pExpected = modPower(pCtx, pBase, pExp, true);
+    bigint* pActual = modPower(pCtx, pBase, pExp, false);
+
+    bi_export(pCtx, pExpected, g_buffer[0], bytes);
+    bi_export(pCtx, pActual, g_buffer[1], bytes);
+    return memcmp(g_buffer[0], g_buffer[1], bytes) == 0;
+}
+
+static int validate(void)
+{
+    static const int modBytes[] = { 4, 8, 12, 20, 64, 128, 132, 256 };
+    static const int expBytes[] = { 0, 1, 3, 4, 9, 33, 64, 128, 256 };
+    int              failures = 0;
+
+    for (size_t i = 0 ; i < sizeof(modBytes) / sizeof(modBytes[0]) ; i++)
+    {
+        for (size_t j = 0 ; j < sizeof(expBytes) / sizeof(expBytes[0]) ; j++)
+        {
+            BI_CTX* pCtx = bi_initialize();
+            int     bytes = modBytes[i];
+
+            bi_set_mod(pCtx, randomBigint(pCtx, bytes, true), BIGINT_M_OFFSET);
+            pCtx->mod_offset = BIGINT_M_OFFSET;
+
+            /* Bases both below and above the modulus, with an exponent of zero
+               when expBytes[j] is 0. */
+            bigint* pExp = expBytes[j] ? randomBigint(pCtx, expBytes[j], true) : int_to_bi(pCtx, 0);
+            bigint* pBases[] = { randomBigint(pCtx, bytes - 1, false),
+                                 randomBigint(pCtx, bytes, true),
+                                 randomBigint(pCtx, bytes + 4, true),
+                                 int_to_bi(pCtx, 2) };
+            for (size_t k = 0 ; k < sizeof(pBases) / sizeof(pBases[0]) ; k++)
+            {
+                if (!resultsMatch(pCtx, pBases[k], pExp, bytes))
+                {
+                    printf("FAIL: %d bit modulus, %d bit exponent, base %u\n",
+                           bytes * 8, expBytes[j] * 8, (unsigned)k);
+                    failures++;
+                }
+                bi_free(pCtx, pBases[k]);
+            }
+            bi_free(pCtx, pExp);
+            bi_free_mod(pCtx, BIGINT_M_OFFSET);
+            bi_terminate(pCtx);
+        }
+    }
+    return failures;
+}
+
+static void benchmark(int bits, int expBits, bool useBarrett)
+{
+    BI_CTX* pCtx = bi_initialize();
+    int     bytes = bits / 8;
+
+    bi_set_mod(pCtx, randomBigint(pCtx, bytes, true), BIGINT_M_OFFSET);
+    pCtx->mod_offset = BIGINT_M_OFFSET;
+    bigint* pBase = randomBigint(pCtx, bytes - 1, false);
+    bigint* pExp = expBits == 17 ? int_to_bi(pCtx, 65537) : randomBigint(pCtx, expBits / 8, true);
+    bi_permanent(pBase);
+    bi_permanent(pExp);
+
+    int      iterations = 0;
+    uint64_t start = readMicroseconds();
+    uint64_t elapsed;
+    do
+    {
+        bi_free(pCtx, modPower(pCtx, pBase, pExp, useBarrett));
+        iterations++;
+        elapsed = readMicroseconds() - start;
+    } while (elapsed < 500000);
+
+    printf("%-10s %4d bit modulus, %4d bit exponent: %9.3f ms\n", useBarrett ? "Barrett" : "Montgomery",
+           bits, expBits, elapsed / 1000.0 / iterations);
+
+    bi_depermanent(pBase);
+    bi_depermanent(pExp);
+    bi_free(pCtx, pBase);
+    bi_free(pCtx, pExp);
+    bi_free_mod(pCtx, BIGINT_M_OFFSET);
+    bi_terminate(pCtx);
+}
+
+int main(void)
+{
+    disable_memory_buf();
+
+    int failures = validate();
+    printf("bi_mod_power validation: %s\n", failures ? "FAILED" : "passed");
+    if (failures)
+        return 1;
+
+    /* The public key operation, a CRT half and a full private key operation. */
+    static const int sizes[][2] = { { 1024, 17 }, { 512, 512 }, { 1024, 1024 },
+                                    { 2048, 17 }, { 2048, 2048 } };
+    for (size_t i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; i++)
+    {
+        benchmark(sizes[i][0], sizes[i][1], true);
+        benchmark(sizes[i][0], sizes[i][1], false);
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Validates lwip_chksum_copy() against a separate MEMCPY() and inet_chksum()
+   for every source/destination alignment and then compares the throughput of
+   the two approaches.  The makefile builds lwIP with the portable single pass
+   version (LWIP_CHKSUM_COPY_ALGORITHM 2), which other builds don't use.
+   tests/benchmarks/chksum_copy is the on device counterpart which measures the
+   Thumb-2 assembly language versions.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/inet_chksum.h"
+
+
+static const unsigned int bufferSize = 2048;
+static const unsigned int iterations = 200000;
+static uint8_t            g_source[bufferSize + 8];
+static uint8_t            g_dest[bufferSize + 8];
+static uint8_t            g_reference[bufferSize + 8];
+
+
+static uint64_t readCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+static u16_t copyThenChecksum(void* pDest, const void* pSource, u16_t length)
+{
+    memcpy(pDest, pSource, length);
+    return ~inet_chksum(pDest, length);
+}
+
+static int validate(void)
+{
+    static const u16_t lengths[] = { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 63, 536, 1459, 1460 };
+    int                failures = 0;
+
+    for (size_t i = 0 ; i < sizeof(g_source) ; i++)
+        g_source[i] = rand();
+
+    for (int srcOffset = 0 ; srcOffset < 4 ; srcOffset++)
+    {
+        for (int destOffset = 0 ; destOffset < 4 ; destOffset++)
+        {
+            for (size_t i = 0 ; i < sizeof(lengths) / sizeof(lengths[0]) ; i++)
+            {
+                u16_t length = lengths[i];
+
+                memset(g_dest, 0xAA, sizeof(g_dest));
+                memset(g_reference, 0xAA, sizeof(g_reference));
+                u16_t expected = copyThenChecksum(g_reference + destOffset, g_source + srcOffset,
+                                                  length);
+                u16_t actual = lwip_chksum_copy(g_dest + destOffset, g_source + srcOffset,
+                                                length);
+                if (actual != expected || memcmp(g_dest, g_reference, sizeof(g_dest)) != 0)
+                {
+                    printf("FAIL: src+%d dest+%d length %u: 0x%04x != 0x%04x\n",
+                           srcOffset, destOffset, length, actual, expected);
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+static void benchmark(const char* pName, u16_t (*pCopy)(void*, const void*, u16_t),
+                      int srcOffset, u16_t length)
+{
+    volatile u16_t result = 0;
+    uint64_t       start = readCycles();
+
+    for (unsigned int i = 0 ; i < iterations ; i++)
+        result += pCopy(g_dest, g_source + srcOffset, length);
+    uint64_t elapsed = readCycles() - start;
+
+    printf("%-22s src+%d %4u bytes: %6.3f bytes/%s\n", pName, srcOffset, length,
+           ((double)length * iterations) / elapsed,
+#if defined(__x86_64__) || defined(__i386__)
+           "cycle"
+#else
+           "ns"
+#endif
+           );
+}
+
+int main(void)
+{
+    int failures = validate();
+    printf("lwip_chksum_copy validation: %s\n", failures ? "FAILED" : "passed");
+    if (failures)
+        return 1;
+
+    for (int srcOffset = 0 ; srcOffset < 2 ; srcOffset++)
+    {
+        benchmark("memcpy + inet_chksum", copyThenChecksum, srcOffset, 1460);
+        benchmark("lwip_chksum_copy", lwip_chksum_copy, srcOffset, 1460);
+    }
+    benchmark("memcpy + inet_chksum", copyThenChecksum, 0, 64);
+    benchmark("lwip_chksum_copy", lwip_chksum_copy, 0, 64);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Reference implementations for CryptoBench from the host's OpenSSL.  They
+   are kept out of main.cpp because OpenSSL and axTLS both define types such
+   as SHA256_CTX.
+*/
+#include <stdio.h>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+
+#include "Reference.h"
+
+
+static const EVP_CIPHER* aesCipher(const char* pMode, int keyLength)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "AES-%d-%s", keyLength * 8, pMode);
+    return EVP_get_cipherbyname(name);
+}
+
+static bool encrypt(const EVP_CIPHER* pCipher, const uint8_t* pKey, const uint8_t* pIv,
+                    const uint8_t* pIn, uint8_t* pOut, int length)
+{
+    EVP_CIPHER_CTX* pCtx = EVP_CIPHER_CTX_new();
+    int             outLength = 0;
+    int             finalLength = 0;
+    bool            result;
+
+    result = EVP_EncryptInit_ex(pCtx, pCipher, NULL, pKey, pIv) == 1 &&
+             EVP_CIPHER_CTX_set_padding(pCtx, 0) == 1 &&
+             EVP_EncryptUpdate(pCtx, pOut, &outLength, pIn, length) == 1 &&
+             EVP_EncryptFinal_ex(pCtx, pOut + outLength, &finalLength) == 1;
+    EVP_CIPHER_CTX_free(pCtx);
+
+    return result && outLength + finalLength == length;
+}
+
+bool refAesCbcEncrypt(const uint8_t* pKey, int keyLength, const uint8_t* pIv,
+                      const uint8_t* pIn, uint8_t* pOut, int length)
+{
+    return encrypt(aesCipher("CBC", keyLength), pKey, pIv, pIn, pOut, length);
+}
+
+bool refAesCtrEncrypt(const uint8_t* pKey, int keyLength, const uint8_t* pIv,
+                      const uint8_t* pIn, uint8_t* pOut, int length)
+{
+    return encrypt(aesCipher("CTR", keyLength), pKey, pIv, pIn, pOut, length);
+}
+
+bool refAesGcmEncrypt(const uint8_t* pKey, int keyLength, const uint8_t* pIv,
+                      const uint8_t* pAad, int aadLength,
+                      const uint8_t* pIn, uint8_t* pOut, int length, uint8_t* pTag)
+{
+    EVP_CIPHER_CTX* pCtx = EVP_CIPHER_CTX_new();
+    int             outLength = 0;
+    int             finalLength = 0;
+    bool            result;
+
+    result = EVP_EncryptInit_ex(pCtx, aesCipher("GCM", keyLength), NULL, pKey, pIv) == 1 &&
+             (aadLength == 0 || EVP_EncryptUpdate(pCtx, NULL, &outLength, pAad, aadLength) == 1) &&
+             EVP_EncryptUpdate(pCtx, pOut, &outLength, pIn, length) == 1 &&
+             EVP_EncryptFinal_ex(pCtx, pOut + outLength, &finalLength) == 1 &&
+             EVP_CIPHER_CTX_ctrl(pCtx, EVP_CTRL_GCM_GET_TAG, 16, pTag) == 1;
+    EVP_CIPHER_CTX_free(pCtx);
+
+    return result;
+}
+
+bool refSha256(const uint8_t* pIn, int length, uint8_t* pDigest)
+{
+    return SHA256(pIn, length, pDigest) != NULL;
+}
+
+bool refHmacSha256(const uint8_t* pKey, int keyLength, const uint8_t* pIn, int length, uint8_t* pDigest)
+{
+    return HMAC(EVP_sha256(), pKey, keyLength, pIn, length, pDigest, NULL) != NULL;
+}
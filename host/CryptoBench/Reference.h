@@ -0,0 +1,33 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef _REFERENCE_H_
+#define _REFERENCE_H_
+
+#include <stdint.h>
+
+
+/* The same operations as axTLS's crypto library, from the host's OpenSSL.
+   Each returns false if OpenSSL fails.  Keys are 16 or 32 bytes. */
+bool refAesCbcEncrypt(const uint8_t* pKey, int keyLength, const uint8_t* pIv,
+                      const uint8_t* pIn, uint8_t* pOut, int length);
+bool refAesCtrEncrypt(const uint8_t* pKey, int keyLength, const uint8_t* pIv,
+                      const uint8_t* pIn, uint8_t* pOut, int length);
+bool refAesGcmEncrypt(const uint8_t* pKey, int keyLength, const uint8_t* pIv,
+                      const uint8_t* pAad, int aadLength,
+                      const uint8_t* pIn, uint8_t* pOut, int length, uint8_t* pTag);
+bool refSha256(const uint8_t* pIn, int length, uint8_t* pDigest);
+bool refHmacSha256(const uint8_t* pKey, int keyLength, const uint8_t* pIn, int length, uint8_t* pDigest);
+
+#endif /* _REFERENCE_H_ */
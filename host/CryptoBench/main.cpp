@@ -0,0 +1,306 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Validates the AES modes, GHASH and SHA-256 of axTLS's crypto library
+   against the host's OpenSSL (see Reference.cpp) and then measures the bulk
+   throughput of each cipher and digest that TLS records use.
+   tests/benchmarks/crypto_throughput is the on device counterpart.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "os_port.h"
+#include "crypto.h"
+#include "Reference.h"
+
+
+namespace
+{
+    // The largest plaintext in one axTLS record.
+    const int BUFFER_SIZE = 2048;
+}
+
+
+static uint8_t g_key[32];
+static uint8_t g_iv[AES_IV_SIZE];
+static uint8_t g_in[BUFFER_SIZE + 16];
+static uint8_t g_expected[BUFFER_SIZE + 16];
+static uint8_t g_actual[BUFFER_SIZE + 16];
+
+
+static uint64_t readMicroseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+static void randomFill(uint8_t* pBuffer, int length)
+{
+    for (int i = 0 ; i < length ; i++)
+        pBuffer[i] = rand();
+}
+
+static int check(bool isMatch, const char* pName, int keyBits, int length)
+{
+    if (isMatch)
+        return 0;
+    printf("FAIL: %s, %d bit key, %d bytes\n", pName, keyBits, length);
+    return 1;
+}
+
+static int validateCbc(AES_MODE mode, int keyLength)
+{
+    int failures = 0;
+
+    for (int length = 0 ; length <= 256 ; length += AES_BLOCKSIZE)
+    {
+        AES_CTX ctx;
+
+        randomFill(g_key, keyLength);
+        randomFill(g_iv, sizeof(g_iv));
+        randomFill(g_in, length);
+        refAesCbcEncrypt(g_key, keyLength, g_iv, g_in, g_expected, length);
+
+        AES_set_key(&ctx, g_key, g_iv, mode);
+        AES_cbc_encrypt(&ctx, g_in, g_actual, length);
+        failures += check(memcmp(g_expected, g_actual, length) == 0, "AES-CBC encrypt", keyLength * 8, length);
+
+        AES_set_key(&ctx, g_key, g_iv, mode);
+        AES_convert_key(&ctx);
+        AES_cbc_decrypt(&ctx, g_expected, g_actual, length);
+        failures += check(memcmp(g_in, g_actual, length) == 0, "AES-CBC decrypt", keyLength * 8, length);
+    }
+    return failures;
+}
+
+static int validateCtr(AES_MODE mode, int keyLength)
+{
+    int failures = 0;
+
+    for (int length = 1 ; length <= 100 ; length += 3)
+    {
+        AES_CTX ctx;
+
+        randomFill(g_key, keyLength);
+        randomFill(g_iv, sizeof(g_iv));
+        /* Make the counter carry out of its low words. */
+        if (length & 1)
+            memset(g_iv + 8, 0xff, 8);
+        randomFill(g_in, length);
+        refAesCtrEncrypt(g_key, keyLength, g_iv, g_in, g_expected, length);
+
+        AES_set_key(&ctx, g_key, g_iv, mode);
+        AES_ctr_encrypt(&ctx, g_in, g_actual, length);
+        failures += check(memcmp(g_expected, g_actual, length) == 0, "AES-CTR", keyLength * 8, length);
+    }
+    return failures;
+}
+
+/* Encrypts and decrypts a message in pieces of random size, as the TLS
+   record layer does, with the output 8 bytes before the input in the same
+   buffer as when the explicit nonce of a record is stripped. */
+static int validateGcm(AES_MODE mode, int keyLength)
+{
+    static AES_GCM_CTX ctx;
+    uint8_t            aad[40];
+    uint8_t            expectedTag[AES_GCM_TAG_SIZE];
+    uint8_t            actualTag[AES_GCM_TAG_SIZE];
+    int                failures = 0;
+
+    for (int length = 0 ; length <= 300 ; length += 7)
+    {
+        int aadLength = length % sizeof(aad);
+
+        randomFill(g_key, keyLength);
+        randomFill(g_iv, AES_GCM_IV_SIZE);
+        randomFill(aad, aadLength);
+        randomFill(g_in, length);
+        refAesGcmEncrypt(g_key, keyLength, g_iv, aad, aadLength, g_in, g_expected, length, expectedTag);
+
+        AES_gcm_set_key(&ctx, g_key, mode);
+        AES_gcm_start(&ctx, g_iv, aad, aadLength);
+        for (int offset = 0, piece ; offset < length ; offset += piece)
+        {
+            piece = rand() % 40 + 1;
+            if (piece > length - offset)
+                piece = length - offset;
+            AES_gcm_encrypt(&ctx, g_in + offset, g_actual + offset, piece);
+        }
+        AES_gcm_finish(&ctx, actualTag);
+        failures += check(memcmp(g_expected, g_actual, length) == 0 &&
+                          memcmp(expectedTag, actualTag, sizeof(actualTag)) == 0,
+                          "AES-GCM encrypt", keyLength * 8, length);
+
+        memcpy(g_actual + 8, g_expected, length);
+        AES_gcm_start(&ctx, g_iv, aad, aadLength);
+        for (int offset = 0, piece ; offset < length ; offset += piece)
+        {
+            piece = rand() % 40 + 1;
+            if (piece > length - offset)
+                piece = length - offset;
+            AES_gcm_decrypt(&ctx, g_actual + 8 + offset, g_actual + offset, piece);
+        }
+        AES_gcm_finish(&ctx, actualTag);
+        failures += check(memcmp(g_in, g_actual, length) == 0 &&
+                          memcmp(expectedTag, actualTag, sizeof(actualTag)) == 0,
+                          "AES-GCM decrypt", keyLength * 8, length);
+    }
+    return failures;
+}
+
+static int validateSha256(void)
+{
+    uint8_t expected[SHA256_SIZE];
+    uint8_t actual[SHA256_SIZE];
+    int     failures = 0;
+
+    for (int length = 0 ; length <= 300 ; length += 5)
+    {
+        SHA256_CTX ctx;
+        int        split = length ? rand() % length : 0;
+
+        randomFill(g_in, length);
+        refSha256(g_in, length, expected);
+        SHA256_Init(&ctx);
+        SHA256_Update(&ctx, g_in, split);
+        SHA256_Update(&ctx, g_in + split, length - split);
+        SHA256_Final(actual, &ctx);
+        failures += check(memcmp(expected, actual, sizeof(actual)) == 0, "SHA-256", 0, length);
+
+        int keyLength = length % 33 + 16;
+        randomFill(g_key, keyLength > 32 ? 32 : keyLength);
+        keyLength = keyLength > 32 ? 32 : keyLength;
+        refHmacSha256(g_key, keyLength, g_in, length, expected);
+        hmac_sha256(g_in, length, g_key, keyLength, actual);
+        failures += check(memcmp(expected, actual, sizeof(actual)) == 0, "HMAC-SHA256", keyLength * 8, length);
+    }
+    return failures;
+}
+
+static int validate(void)
+{
+    int failures = 0;
+
+    failures += validateCbc(AES_MODE_128, 16);
+    failures += validateCbc(AES_MODE_256, 32);
+    failures += validateCtr(AES_MODE_128, 16);
+    failures += validateCtr(AES_MODE_256, 32);
+    failures += validateGcm(AES_MODE_128, 16);
+    failures += validateGcm(AES_MODE_256, 32);
+    failures += validateSha256();
+
+    return failures;
+}
+
+
+static AES_CTX     g_aes;
+static AES_GCM_CTX g_gcm;
+static RC4_CTX     g_rc4;
+
+static void aesCbcEncrypt(void)
+{
+    AES_cbc_encrypt(&g_aes, g_in, g_actual, BUFFER_SIZE);
+}
+
+static void aesCbcDecrypt(void)
+{
+    AES_cbc_decrypt(&g_aes, g_in, g_actual, BUFFER_SIZE);
+}
+
+static void aesCtr(void)
+{
+    AES_ctr_encrypt(&g_aes, g_in, g_actual, BUFFER_SIZE);
+}
+
+static void aesGcm(void)
+{
+    uint8_t tag[AES_GCM_TAG_SIZE];
+
+    AES_gcm_start(&g_gcm, g_iv, g_key, 13);
+    AES_gcm_encrypt(&g_gcm, g_in, g_actual, BUFFER_SIZE);
+    AES_gcm_finish(&g_gcm, tag);
+}
+
+static void rc4(void)
+{
+    RC4_crypt(&g_rc4, g_in, g_actual, BUFFER_SIZE);
+}
+
+static void sha1(void)
+{
+    SHA1_CTX ctx;
+
+    SHA1_Init(&ctx);
+    SHA1_Update(&ctx, g_in, BUFFER_SIZE);
+    SHA1_Final(g_actual, &ctx);
+}
+
+static void sha256(void)
+{
+    SHA256_CTX ctx;
+
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, g_in, BUFFER_SIZE);
+    SHA256_Final(g_actual, &ctx);
+}
+
+static void benchmark(const char* pName, void (*pFunction)(void))
+{
+    int      iterations = 0;
+    uint64_t start = readMicroseconds();
+    uint64_t elapsed;
+
+    do
+    {
+        pFunction();
+        iterations++;
+        elapsed = readMicroseconds() - start;
+    } while (elapsed < 500000);
+
+    printf("%-16s %8.1f MB/s\n", pName, (double)iterations * BUFFER_SIZE / elapsed);
+}
+
+int main(void)
+{
+    disable_memory_buf();
+
+    int failures = validate();
+    printf("crypto validation: %s\n", failures ? "FAILED" : "passed");
+    if (failures)
+        return 1;
+
+    randomFill(g_key, sizeof(g_key));
+    randomFill(g_iv, sizeof(g_iv));
+    randomFill(g_in, BUFFER_SIZE);
+
+    AES_set_key(&g_aes, g_key, g_iv, AES_MODE_128);
+    benchmark("AES-128-CBC enc", aesCbcEncrypt);
+    benchmark("AES-128-CTR", aesCtr);
+    AES_convert_key(&g_aes);
+    benchmark("AES-128-CBC dec", aesCbcDecrypt);
+    AES_set_key(&g_aes, g_key, g_iv, AES_MODE_256);
+    benchmark("AES-256-CBC enc", aesCbcEncrypt);
+    AES_gcm_set_key(&g_gcm, g_key, AES_MODE_128);
+    benchmark("AES-128-GCM", aesGcm);
+    RC4_setup(&g_rc4, g_key, 16);
+    benchmark("RC4", rc4);
+    benchmark("SHA-1", sha1);
+    benchmark("SHA-256", sha256);
+
+    return 0;
+}
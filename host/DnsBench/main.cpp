@@ -0,0 +1,522 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Host benchmark for the host name lookups made by Endpoint::set_address().
+   Two copies of lwIP are connected through the paired in-memory EMAC as in
+   NetBench.  The server process runs a minimal DNS server while the client
+   process resolves a working set of names, some of which don't exist, from
+   several threads, first through lwIP's resolver alone, as set_address() used
+   to, and then through DNSCache.  Each test reports the lookup latency seen
+   by the threads and the number of queries which reached the server.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "lwip/tcpip.h"
+#include "lwip/inet.h"
+#include "lwip/api.h"
+#include "lwip/dns.h"
+#include "netif/etharp.h"
+#include "eth_arch.h"
+#include "pair_emac.h"
+
+#include "UDPSocket.h"
+#include "Endpoint.h"
+#include "DNSCache.h"
+
+
+namespace
+{
+    const char* const SERVER_IP = "10.0.0.1";
+    const char* const CLIENT_IP = "10.0.0.2";
+    const char* const NETMASK   = "255.255.255.0";
+
+    const int DNS_PORT          = 53;
+    const int MAX_THREADS       = 16;
+    const int HOST_NAMES        = 6;
+    const int MISSING_NAMES     = 2;
+    const int ASYNC_LOOKUPS     = 32;
+}
+
+
+struct Options
+{
+    unsigned int latencyUs;
+    unsigned int ttl;
+    unsigned int threads;
+    unsigned int lookups;
+};
+
+
+struct Lookups
+{
+    const char*  pTest;
+    bool         useCache;
+    unsigned int index;
+    unsigned int count;
+    unsigned int failures;
+    unsigned int wrong;
+    uint64_t     totalNs;
+    uint64_t     maxNs;
+};
+
+
+static const char* g_pRole = "client";
+
+
+static uint64_t readClock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* The two processes synchronize through a pair of pipes which are kept
+   outside of lwIP so that they don't perturb the measurements. */
+static void sendCommand(int fd, char command)
+{
+    if (write(fd, &command, 1) != 1)
+    {
+        perror("error: Failed to write control pipe");
+        _exit(1);
+    }
+}
+
+static char receiveCommand(int fd)
+{
+    char command;
+
+    if (read(fd, &command, 1) != 1)
+        return 'q';
+    return command;
+}
+
+
+static void tcpipInitDone(void* pv)
+{
+    sys_sem_signal((sys_sem_t*)pv);
+}
+
+static void bringUpNetwork(int fd, const char* pIpAddress, uint8_t macLastByte, const Options* pOptions)
+{
+    static struct netif netif;
+    pair_emac_config_t  config;
+    sys_sem_t           initDone;
+    ip_addr_t           ip;
+    ip_addr_t           mask;
+    ip_addr_t           gateway;
+
+    memset(&config, 0, sizeof(config));
+    config.fd = fd;
+    config.latency_us = pOptions->latencyUs;
+    config.seed = macLastByte;
+    config.hwaddr[0] = 0x02;
+    config.hwaddr[5] = macLastByte;
+    pair_emac_configure(&config);
+
+    sys_sem_new(&initDone, 0);
+    tcpip_init(tcpipInitDone, &initDone);
+    sys_arch_sem_wait(&initDone, 0);
+
+    inet_aton(pIpAddress, &ip);
+    inet_aton(NETMASK, &mask);
+    ip_addr_set_zero(&gateway);
+    netif_add(&netif, &ip, &mask, &gateway, NULL, eth_arch_enetif_init, tcpip_input);
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+    eth_arch_enable_interrupts();
+}
+
+
+/* Server side.  A name whose first label is h<N> resolves to 10.0.1.<N>, one
+   whose first label starts with "missing" doesn't exist, and anything else
+   resolves to 10.0.2.1.  A ttl<N> label anywhere in the name overrides the
+   TTL given with -t. */
+static unsigned int g_queries;
+
+static int parseQuestion(const unsigned char* pQuery, int length, char* pName, int nameSize)
+{
+    int offset = 12;
+    int nameLength = 0;
+
+    while (offset < length && pQuery[offset] != 0)
+    {
+        int labelLength = pQuery[offset++];
+        if (labelLength > 63 || offset + labelLength > length || nameLength + labelLength + 1 >= nameSize)
+            return -1;
+        if (nameLength)
+            pName[nameLength++] = '.';
+        memcpy(pName + nameLength, pQuery + offset, labelLength);
+        nameLength += labelLength;
+        offset += labelLength;
+    }
+    pName[nameLength] = '\0';
+    // Skip the terminating zero length label along with QTYPE and QCLASS.
+    offset += 5;
+    return (offset <= length) ? offset : -1;
+}
+
+static unsigned int nameTtl(const char* pName, unsigned int ttl)
+{
+    for (const char* p = pName ; p ; p = strchr(p, '.'))
+    {
+        if (*p == '.')
+            p++;
+        if (strncmp(p, "ttl", 3) == 0)
+            return strtoul(p + 3, NULL, 10);
+    }
+    return ttl;
+}
+
+static int buildResponse(unsigned char* pPacket, int length, const Options* pOptions)
+{
+    char name[256];
+    int  questionEnd = parseQuestion(pPacket, length, name, sizeof(name));
+
+    if (questionEnd < 0)
+        return -1;
+
+    bool         isMissing = strncmp(name, "missing", 7) == 0;
+    unsigned int ttl = nameTtl(name, pOptions->ttl);
+    uint8_t      lastByte = 1;
+    uint8_t      subnet = 2;
+    if (name[0] == 'h' && name[1] >= '0' && name[1] <= '9')
+    {
+        subnet = 1;
+        lastByte = strtoul(name + 1, NULL, 10);
+    }
+
+    pPacket[2] = 0x81;                          // Response, recursion desired.
+    pPacket[3] = isMissing ? 0x83 : 0x80;       // Recursion available, NXDOMAIN.
+    pPacket[6] = 0;
+    pPacket[7] = isMissing ? 0 : 1;
+    memset(pPacket + 8, 0, 4);
+    if (isMissing)
+        return questionEnd;
+
+    unsigned char* p = pPacket + questionEnd;
+    static const unsigned char answer[] = { 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01 };
+    memcpy(p, answer, sizeof(answer));
+    p += sizeof(answer);
+    *p++ = ttl >> 24;
+    *p++ = ttl >> 16;
+    *p++ = ttl >> 8;
+    *p++ = ttl;
+    *p++ = 0;
+    *p++ = 4;
+    *p++ = 10;
+    *p++ = 0;
+    *p++ = subnet;
+    *p++ = lastByte;
+    return p - pPacket;
+}
+
+static void* serveDns(void* pv)
+{
+    const Options* pOptions = (const Options*)pv;
+    unsigned char  packet[512];
+    UDPSocket      server;
+    Endpoint       client;
+
+    server.bind(DNS_PORT);
+    for (;;)
+    {
+        int n = server.receiveFrom(client, (char*)packet, sizeof(packet) - 16);
+        if (n < 12)
+            continue;
+        __sync_fetch_and_add(&g_queries, 1);
+        n = buildResponse(packet, n, pOptions);
+        if (n > 0)
+            server.sendTo(client, (char*)packet, n);
+    }
+    return NULL;
+}
+
+static void runServer(int fd, int commandFd, int replyFd, const Options* pOptions)
+{
+    pthread_t thread;
+
+    g_pRole = "server";
+    bringUpNetwork(fd, SERVER_IP, 0x01, pOptions);
+    pthread_create(&thread, NULL, serveDns, (void*)pOptions);
+
+    // The DNS server runs until the process exits.  Commands just report the
+    // queries it has answered since the last one.
+    while (receiveCommand(commandFd) != 'q')
+    {
+        printf("[%s] dns server: %u queries\n", g_pRole, __sync_fetch_and_and(&g_queries, 0));
+        fflush(stdout);
+        sendCommand(replyFd, 'd');
+    }
+    sendCommand(replyFd, 'd');
+}
+
+
+/* Client side. */
+static int resolve(const char* pName, bool useCache, ip_addr_t* pAddress)
+{
+    if (useCache)
+        return DNSCache::resolve(pName, pAddress);
+    return (netconn_gethostbyname(pName, pAddress) == ERR_OK) ? 0 : -1;
+}
+
+/* Each thread cycles through the working set of HOST_NAMES names and
+   MISSING_NAMES names which don't exist, starting from its own position. */
+static void* runLookups(void* pv)
+{
+    Lookups*     pLookups = (Lookups*)pv;
+    unsigned int names = HOST_NAMES + MISSING_NAMES;
+
+    for (unsigned int i = 0 ; i < pLookups->count ; i++)
+    {
+        unsigned int which = (pLookups->index + i) % names;
+        char         name[64];
+        ip_addr_t    address;
+
+        if (which < (unsigned int)HOST_NAMES)
+            snprintf(name, sizeof(name), "h%u.%s.bench", which + 1, pLookups->pTest);
+        else
+            snprintf(name, sizeof(name), "missing%u.%s.bench", which, pLookups->pTest);
+
+        uint64_t start = readClock();
+        int      result = resolve(name, pLookups->useCache, &address);
+        uint64_t elapsed = readClock() - start;
+
+        pLookups->totalNs += elapsed;
+        if (elapsed > pLookups->maxNs)
+            pLookups->maxNs = elapsed;
+        if (which < (unsigned int)HOST_NAMES)
+        {
+            if (result != 0)
+                pLookups->failures++;
+            else if (ip4_addr4(&address) != which + 1 || ip4_addr3(&address) != 1)
+                pLookups->wrong++;
+        }
+        else if (result == 0)
+        {
+            pLookups->wrong++;
+        }
+    }
+    return NULL;
+}
+
+static void reportCache(void)
+{
+    DNSCacheStats stats;
+
+    DNSCache::get_stats(&stats, true);
+    printf("[%s]   cache: %u lookups, %u hits, %u negative hits, %u coalesced, %u queries, "
+           "%u failed, query avg %.1f ms max %u ms\n", g_pRole,
+           stats.lookups, stats.hits, stats.negative_hits, stats.coalesced, stats.queries, stats.failures,
+           stats.queries ? (double)stats.query_ms_total / stats.queries : 0.0, stats.query_ms_max);
+}
+
+static void countQueries(int commandFd, int replyFd)
+{
+    fflush(stdout);
+    sendCommand(commandFd, 'c');
+    receiveCommand(replyFd);
+}
+
+static void runWorkingSet(const char* pTest, bool useCache, const Options* pOptions, int commandFd, int replyFd)
+{
+    pthread_t threads[MAX_THREADS];
+    Lookups   lookups[MAX_THREADS];
+    uint64_t  start = readClock();
+
+    for (unsigned int i = 0 ; i < pOptions->threads ; i++)
+    {
+        memset(&lookups[i], 0, sizeof(lookups[i]));
+        lookups[i].pTest = pTest;
+        lookups[i].useCache = useCache;
+        lookups[i].index = i * 3;
+        lookups[i].count = pOptions->lookups;
+        pthread_create(&threads[i], NULL, runLookups, &lookups[i]);
+    }
+
+    Lookups total;
+    memset(&total, 0, sizeof(total));
+    for (unsigned int i = 0 ; i < pOptions->threads ; i++)
+    {
+        pthread_join(threads[i], NULL);
+        total.count += lookups[i].count;
+        total.failures += lookups[i].failures;
+        total.wrong += lookups[i].wrong;
+        total.totalNs += lookups[i].totalNs;
+        if (lookups[i].maxNs > total.maxNs)
+            total.maxNs = lookups[i].maxNs;
+    }
+    double seconds = (readClock() - start) / 1e9;
+
+    printf("[%s] %-6s: %u threads x %u lookups in %.3f s, avg %.3f ms max %.1f ms, %u failed, %u wrong\n",
+           g_pRole, pTest, pOptions->threads, pOptions->lookups, seconds,
+           total.totalNs / 1e6 / total.count, total.maxNs / 1e6, total.failures, total.wrong);
+    if (useCache)
+        reportCache();
+    countQueries(commandFd, replyFd);
+}
+
+/* Many lookups of a few names which aren't cached yet, all started at once
+   from the calling thread. */
+struct AsyncLookups
+{
+    sys_sem_t    done;
+    unsigned int pending;
+    unsigned int found;
+};
+
+static void asyncDone(const ip_addr_t* pAddress, void* pv)
+{
+    AsyncLookups* pLookups = (AsyncLookups*)pv;
+
+    if (pAddress)
+        __sync_fetch_and_add(&pLookups->found, 1);
+    if (__sync_sub_and_fetch(&pLookups->pending, 1) == 0)
+        sys_sem_signal(&pLookups->done);
+}
+
+static void runAsync(int commandFd, int replyFd)
+{
+    static DNSRequest requests[ASYNC_LOOKUPS];
+    AsyncLookups      lookups;
+
+    sys_sem_new(&lookups.done, 0);
+    lookups.pending = ASYNC_LOOKUPS;
+    lookups.found = 0;
+
+    uint64_t start = readClock();
+    for (int i = 0 ; i < ASYNC_LOOKUPS ; i++)
+    {
+        char name[64];
+
+        snprintf(name, sizeof(name), "h%d.async.bench", i % 4 + 1);
+        DNSCache::resolve_async(name, &requests[i], asyncDone, &lookups);
+    }
+    sys_arch_sem_wait(&lookups.done, 0);
+    double ms = (readClock() - start) / 1e6;
+    sys_sem_free(&lookups.done);
+
+    printf("[%s] async : %d lookups of 4 names in %.1f ms, %u found\n", g_pRole, ASYNC_LOOKUPS, ms, lookups.found);
+    reportCache();
+    countQueries(commandFd, replyFd);
+}
+
+/* Addresses are only kept for the TTL of their record. */
+static void runExpiry(int commandFd, int replyFd)
+{
+    ip_addr_t address;
+    int       found = 0;
+
+    found += DNSCache::resolve("h9.ttl1.expiry.bench", &address) == 0;
+    found += DNSCache::resolve("h9.ttl1.expiry.bench", &address) == 0;
+    usleep(1100000);
+    found += DNSCache::resolve("h9.ttl1.expiry.bench", &address) == 0;
+
+    printf("[%s] expiry: 3 lookups of a name with a 1 s TTL over 1.1 s, %d found\n", g_pRole, found);
+    reportCache();
+    countQueries(commandFd, replyFd);
+}
+
+static void runClient(int fd, int commandFd, int replyFd, const Options* pOptions)
+{
+    ip_addr_t server;
+
+    bringUpNetwork(fd, CLIENT_IP, 0x02, pOptions);
+    inet_aton(SERVER_IP, &server);
+    dns_setserver(0, &server);
+    printf("[%s] latency %u us, ttl %u s, %u names of which %u missing\n",
+           g_pRole, pOptions->latencyUs, pOptions->ttl, HOST_NAMES + MISSING_NAMES, MISSING_NAMES);
+
+    runWorkingSet("lwip", false, pOptions, commandFd, replyFd);
+    runWorkingSet("cache", true, pOptions, commandFd, replyFd);
+    runAsync(commandFd, replyFd);
+    runExpiry(commandFd, replyFd);
+
+    sendCommand(commandFd, 'q');
+    receiveCommand(replyFd);
+}
+
+
+static void usage(const char* pProgram)
+{
+    fprintf(stderr, "Usage: %s [-l latency_us] [-t ttl_seconds] [-c threads] [-n lookups]\n", pProgram);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    Options options = { 5000, 300, 4, 200 };
+    int     fds[2];
+    int     commandPipe[2];
+    int     replyPipe[2];
+    int     opt;
+
+    while ((opt = getopt(argc, argv, "l:t:c:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            options.latencyUs = strtoul(optarg, NULL, 0);
+            break;
+        case 't':
+            options.ttl = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            options.threads = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            options.lookups = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (options.threads < 1 || options.threads > (unsigned int)MAX_THREADS || options.lookups < 1)
+        usage(argv[0]);
+
+    if (pair_emac_create_link(fds) != 0)
+    {
+        perror("error: Failed to create link");
+        return 1;
+    }
+    if (pipe(commandPipe) != 0 || pipe(replyPipe) != 0)
+    {
+        perror("error: Failed to create control pipes");
+        return 1;
+    }
+
+    fflush(stdout);
+    pid_t server = fork();
+    if (server < 0)
+    {
+        perror("error: Failed to fork server");
+        return 1;
+    }
+    if (server == 0)
+    {
+        runServer(fds[1], commandPipe[0], replyPipe[1], &options);
+        _exit(0);
+    }
+
+    runClient(fds[0], commandPipe[1], replyPipe[0], &options);
+    int status = 0;
+    waitpid(server, &status, 0);
+    return 0;
+}
@@ -0,0 +1,411 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Checks that the TLSF heap of mbed_heap.h hands out aligned blocks which
+   don't overlap, from several regions, that realloc() keeps the contents of
+   a block, that pools serve the small blocks and fall back to the heap when
+   empty, and that freed blocks are merged back together, through a long run
+   of random allocations, a few threads at a time.  It then reports what a
+   malloc() and free() pair costs next to the host's own malloc(), and how
+   fragmented the heap is after a random workload.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "mbed_heap.h"
+
+
+static const int    benchRounds = 1000000;
+static const int    liveBlocks = 512;
+static const int    benchLive = 256;
+static int          g_failures;
+
+/* Regions of RAM to give to the heap.  The last is bigger than a block can
+   be, so it is split. */
+static uint64_t g_region1[64 * 1024 / sizeof(uint64_t)];
+static uint64_t g_region2[16 * 1024 / sizeof(uint64_t)];
+static uint64_t g_region3[300 * 1024 / sizeof(uint64_t)];
+
+/* Blocks are merged up to the largest size a list holds, so once everything
+   is freed the last region is one or two blocks, the larger of which is at
+   least half of it. */
+static const uint32_t g_mergedFree = 150 * 1024 - 64;
+
+
+#define CHECK(X) \
+    do \
+    { \
+        if (!(X)) \
+        { \
+            printf("FAIL: line %d: %s\n", __LINE__, #X); \
+            g_failures++; \
+        } \
+    } while (0)
+
+
+static uint64_t readNanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+static mbed_heap_stats_t readStats(void)
+{
+    mbed_heap_stats_t stats;
+
+    mbed_heap_stats(&stats);
+    return stats;
+}
+
+
+/* Fill a block with a pattern which depends on its owner, and check it
+   later, to catch blocks which overlap. */
+static void fillBlock(void* pBlock, size_t size, unsigned int seed)
+{
+    unsigned char* p = (unsigned char*)pBlock;
+
+    for (size_t i = 0 ; i < size ; i++)
+        p[i] = (unsigned char)(seed * 7 + i);
+}
+
+static bool isBlockIntact(const void* pBlock, size_t size, unsigned int seed)
+{
+    const unsigned char* p = (const unsigned char*)pBlock;
+
+    for (size_t i = 0 ; i < size ; i++)
+    {
+        if (p[i] != (unsigned char)(seed * 7 + i))
+            return false;
+    }
+    return true;
+}
+
+
+/* Mostly small blocks, as in a network stack, with a few large ones. */
+static size_t randomSize(unsigned int* pSeed)
+{
+    unsigned int choice = rand_r(pSeed) % 100;
+
+    if (choice < 60)
+        return 1 + rand_r(pSeed) % 64;
+    if (choice < 95)
+        return 1 + rand_r(pSeed) % 1024;
+    return 1 + rand_r(pSeed) % 8192;
+}
+
+
+static void testRegions(void)
+{
+    CHECK(mbed_heap_malloc(16) == NULL);
+    CHECK(readStats().failures == 1);
+    CHECK(mbed_heap_add_region(g_region1, 16) == -1);
+
+    CHECK(mbed_heap_add_region(g_region1, sizeof(g_region1)) == 0);
+    CHECK(mbed_heap_add_region(g_region2, sizeof(g_region2)) == 0);
+    CHECK(mbed_heap_add_region(g_region3, sizeof(g_region3)) == 0);
+    CHECK(mbed_heap_check() == 0);
+
+    mbed_heap_stats_t stats = readStats();
+    CHECK(stats.regions == 3);
+    CHECK(stats.size == sizeof(g_region1) + sizeof(g_region2) + sizeof(g_region3));
+    CHECK(stats.used == 0);
+    CHECK(stats.largest_free >= 256 * 1024 - 64);
+
+    /* Nothing as big as the largest block a list can hold. */
+    CHECK(mbed_heap_malloc(256 * 1024) == NULL);
+    CHECK(mbed_heap_malloc((size_t)-1) == NULL);
+    CHECK(readStats().failures == 3);
+
+    /* A block which only one region can hold. */
+    void* pBig = mbed_heap_malloc(200 * 1024);
+    CHECK(pBig != NULL);
+    CHECK((char*)pBig >= (char*)g_region3 && (char*)pBig < (char*)g_region3 + sizeof(g_region3));
+    mbed_heap_free(pBig);
+    CHECK(mbed_heap_check() == 0);
+    CHECK(readStats().used == 0);
+    CHECK(readStats().largest_free >= g_mergedFree);
+}
+
+
+static void testSizes(void)
+{
+    static void* s_blocks[512];
+
+    for (size_t size = 0 ; size < 512 ; size++)
+    {
+        s_blocks[size] = mbed_heap_malloc(size);
+        CHECK(s_blocks[size] != NULL);
+        CHECK(((uintptr_t)s_blocks[size] & 7) == 0);
+        fillBlock(s_blocks[size], size, 0);
+    }
+    CHECK(mbed_heap_check() == 0);
+    for (size_t size = 0 ; size < 512 ; size++)
+    {
+        CHECK(isBlockIntact(s_blocks[size], size, 0));
+        mbed_heap_free(s_blocks[size]);
+    }
+    CHECK(mbed_heap_check() == 0);
+    CHECK(readStats().used == 0);
+
+    mbed_heap_free(NULL);
+}
+
+
+static void testCalloc(void)
+{
+    char* p = (char*)mbed_heap_malloc(256);
+    memset(p, 0xff, 256);
+    mbed_heap_free(p);
+
+    char* pZeroed = (char*)mbed_heap_calloc(64, 4);
+    CHECK(pZeroed != NULL);
+    bool isZeroed = true;
+    for (int i = 0 ; i < 256 ; i++)
+        isZeroed &= pZeroed[i] == 0;
+    CHECK(isZeroed);
+    mbed_heap_free(pZeroed);
+
+    CHECK(mbed_heap_calloc((size_t)-1 / 2, 4) == NULL);
+    CHECK(readStats().used == 0);
+}
+
+
+static void testRealloc(void)
+{
+    /* Grows in place into the free block which follows. */
+    char* p = (char*)mbed_heap_realloc(NULL, 100);
+    fillBlock(p, 100, 1);
+    char* pGrown = (char*)mbed_heap_realloc(p, 1000);
+    CHECK(pGrown == p);
+    CHECK(isBlockIntact(pGrown, 100, 1));
+
+    /* Shrinks in place, giving the end back. */
+    size_t used = readStats().used;
+    char* pShrunk = (char*)mbed_heap_realloc(pGrown, 50);
+    CHECK(pShrunk == p);
+    CHECK(readStats().used < used);
+    CHECK(isBlockIntact(pShrunk, 50, 1));
+
+    /* Moves when the next block is taken. */
+    void* pBlocker = mbed_heap_malloc(16);
+    fillBlock(pShrunk, 56, 2);
+    char* pMoved = (char*)mbed_heap_realloc(pShrunk, 4000);
+    CHECK(pMoved != NULL && pMoved != pShrunk);
+    CHECK(isBlockIntact(pMoved, 56, 2));
+    CHECK(mbed_heap_check() == 0);
+
+    CHECK(mbed_heap_realloc(pMoved, 0) == NULL);
+    mbed_heap_free(pBlocker);
+    CHECK(mbed_heap_check() == 0);
+}
+
+
+static void testPools(void)
+{
+    static void* s_blocks[80];
+
+    mbed_heap_stats_t before = readStats();
+    CHECK(mbed_heap_add_pool(32, 64) == 0);
+    CHECK(mbed_heap_add_pool(12, 16) == 0);
+    CHECK(mbed_heap_add_pool(1024 * 1024, 1) == -1);
+
+    /* The smallest pool which fits serves the block. */
+    void* pSmall = mbed_heap_malloc(10);
+    void* pMedium = mbed_heap_malloc(32);
+    CHECK(readStats().pooled == before.pooled + 2);
+    mbed_heap_free(pSmall);
+    mbed_heap_free(pMedium);
+    CHECK(mbed_heap_malloc(10) == pSmall);
+    mbed_heap_free(pSmall);
+
+    /* An empty pool falls back to the heap. */
+    for (int i = 0 ; i < 80 ; i++)
+    {
+        s_blocks[i] = mbed_heap_malloc(20);
+        fillBlock(s_blocks[i], 20, i);
+    }
+    CHECK(readStats().pooled == before.pooled + 3 + 64);
+    pMedium = mbed_heap_realloc(s_blocks[0], 24);
+    CHECK(pMedium == s_blocks[0]);
+    s_blocks[0] = mbed_heap_realloc(s_blocks[0], 200);
+    CHECK(isBlockIntact(s_blocks[0], 20, 0));
+    for (int i = 0 ; i < 80 ; i++)
+    {
+        CHECK(isBlockIntact(s_blocks[i], 20, i));
+        mbed_heap_free(s_blocks[i]);
+    }
+    CHECK(mbed_heap_check() == 0);
+}
+
+
+static void runRandom(unsigned int seed, int rounds, bool checkAll)
+{
+    void*        blocks[liveBlocks];
+    size_t       sizes[liveBlocks];
+    unsigned int owner = seed;
+
+    memset(blocks, 0, sizeof(blocks));
+    for (int i = 0 ; i < rounds ; i++)
+    {
+        int slot = rand_r(&seed) % liveBlocks;
+        if (blocks[slot])
+        {
+            CHECK(isBlockIntact(blocks[slot], sizes[slot], slot + owner));
+            if (rand_r(&seed) % 4 == 0)
+            {
+                size_t size = randomSize(&seed);
+                void*  p = mbed_heap_realloc(blocks[slot], size);
+                if (p)
+                {
+                    CHECK(isBlockIntact(p, size < sizes[slot] ? size : sizes[slot], slot + owner));
+                    blocks[slot] = p;
+                    sizes[slot] = size;
+                    fillBlock(p, size, slot + owner);
+                }
+                continue;
+            }
+            mbed_heap_free(blocks[slot]);
+            blocks[slot] = NULL;
+        }
+        else
+        {
+            sizes[slot] = randomSize(&seed);
+            blocks[slot] = mbed_heap_malloc(sizes[slot]);
+            if (blocks[slot])
+                fillBlock(blocks[slot], sizes[slot], slot + owner);
+        }
+        if (checkAll && i % 1000 == 0)
+            CHECK(mbed_heap_check() == 0);
+    }
+    for (int i = 0 ; i < liveBlocks ; i++)
+    {
+        if (blocks[i])
+        {
+            CHECK(isBlockIntact(blocks[i], sizes[i], i + owner));
+            mbed_heap_free(blocks[i]);
+        }
+    }
+}
+
+static void testRandom(void)
+{
+    mbed_heap_stats_t before = readStats();
+
+    runRandom(1, 200000, true);
+    CHECK(mbed_heap_check() == 0);
+
+    /* Everything was merged back together. */
+    mbed_heap_stats_t after = readStats();
+    CHECK(after.used == before.used);
+    CHECK(after.largest_free >= g_mergedFree);
+    CHECK(after.peak > before.used);
+    CHECK(after.allocs - before.allocs == after.frees - before.frees);
+}
+
+
+static void* randomThread(void* pArgument)
+{
+    runRandom((unsigned int)(uintptr_t)pArgument, 100000, false);
+    return NULL;
+}
+
+static void testThreads(void)
+{
+    pthread_t         threads[4];
+    mbed_heap_stats_t before = readStats();
+
+    for (int i = 0 ; i < 4 ; i++)
+        pthread_create(&threads[i], NULL, randomThread, (void*)(uintptr_t)(100 + i * 1000));
+    for (int i = 0 ; i < 4 ; i++)
+        pthread_join(threads[i], NULL);
+    CHECK(mbed_heap_check() == 0);
+    CHECK(readStats().used == before.used);
+    CHECK(readStats().largest_free >= g_mergedFree);
+}
+
+
+static void printStats(void)
+{
+    mbed_heap_stats_t stats = readStats();
+
+    printf("\nTLSF heap after the run, %d blocks still live:\n", benchLive);
+    printf("  size:           %lu\n", (unsigned long)stats.size);
+    printf("  used:           %lu\n", (unsigned long)stats.used);
+    printf("  peak:           %lu\n", (unsigned long)stats.peak);
+    printf("  largest free:   %lu\n", (unsigned long)stats.largest_free);
+    printf("  fragmentation:  %lu%%\n", (unsigned long)stats.fragmentation);
+    printf("  allocs:         %lu (%lu pooled)\n", (unsigned long)stats.allocs, (unsigned long)stats.pooled);
+    printf("  failures:       %lu\n", (unsigned long)stats.failures);
+}
+
+
+/* Time malloc() and free() pairs of random sizes, with many blocks live. */
+static uint64_t timeAllocator(void* (*pMalloc)(size_t), void (*pFree)(void*), void (*pReport)(void))
+{
+    static void*  s_blocks[benchLive];
+    static size_t s_sizes[benchRounds];
+    unsigned int  seed = 42;
+
+    for (int i = 0 ; i < benchRounds ; i++)
+        s_sizes[i] = randomSize(&seed);
+    for (int i = 0 ; i < benchLive ; i++)
+        s_blocks[i] = pMalloc(s_sizes[i]);
+
+    uint64_t start = readNanoseconds();
+    for (int i = 0 ; i < benchRounds ; i++)
+    {
+        int slot = s_sizes[i] % benchLive;
+        pFree(s_blocks[slot]);
+        s_blocks[slot] = pMalloc(s_sizes[i]);
+    }
+    uint64_t elapsed = readNanoseconds() - start;
+
+    if (pReport)
+        pReport();
+    for (int i = 0 ; i < benchLive ; i++)
+        pFree(s_blocks[i]);
+    return elapsed;
+}
+
+static void benchmark(void)
+{
+    uint64_t tlsf = timeAllocator(mbed_heap_malloc, mbed_heap_free, printStats);
+    uint64_t host = timeAllocator(malloc, free, NULL);
+
+    printf("\nmalloc()+free() of random sizes, %d blocks live:\n", benchLive);
+    printf("  TLSF heap:  %5.1f ns\n", (double)tlsf / benchRounds);
+    printf("  host libc:  %5.1f ns\n", (double)host / benchRounds);
+}
+
+
+int main(void)
+{
+    testRegions();
+    testSizes();
+    testCalloc();
+    testRealloc();
+    testPools();
+    testRandom();
+    testThreads();
+    printf("heap validation: %s\n", g_failures ? "FAILED" : "passed");
+
+    benchmark();
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,357 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* HTTPS server for HttpsBench, built on the host's OpenSSL.  It is kept out
+   of main.cpp because OpenSSL and axTLS both name their connection type SSL.
+   Responses are bodies filled with tlsBodyByte().  A server which ignores
+   the client's max_fragment_length extension is built on the host's GnuTLS
+   instead, as OpenSSL always honours it.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <gnutls/gnutls.h>
+
+#include "TCPSocketConnection.h"
+#include "TlsServer.h"
+
+
+namespace
+{
+    // A full TLS record, as most servers send.
+    const unsigned int CHUNK_SIZE = 16384;
+
+    const unsigned int EXT_MAX_FRAGMENT_LENGTH = 1;
+}
+
+
+struct TlsServerContext
+{
+    SSL_CTX*                         pContext;
+    // Only set for a server which ignores max_fragment_length.
+    gnutls_certificate_credentials_t credentials;
+};
+
+
+/* The TLS connection serveRequests() answers GET requests on. */
+class TlsConnection
+{
+public:
+    virtual ~TlsConnection() {}
+
+    virtual int read(char* pData, int length) = 0;
+    virtual int write(const char* pData, int length) = 0;
+};
+
+class OpenSslConnection : public TlsConnection
+{
+public:
+    OpenSslConnection(SSL* pSsl) : m_pSsl(pSsl) {}
+
+    virtual int read(char* pData, int length) { return SSL_read(m_pSsl, pData, length); }
+    virtual int write(const char* pData, int length) { return SSL_write(m_pSsl, pData, length); }
+
+protected:
+    SSL* m_pSsl;
+};
+
+class GnuTlsConnection : public TlsConnection
+{
+public:
+    GnuTlsConnection(gnutls_session_t session) : m_session(session) {}
+
+    virtual int read(char* pData, int length) { return gnutls_record_recv(m_session, pData, length); }
+    virtual int write(const char* pData, int length) { return gnutls_record_send(m_session, pData, length); }
+
+protected:
+    gnutls_session_t m_session;
+};
+
+
+/* OpenSSL reads and writes the connection through a BIO which
+   calls the TCPSocketConnection. */
+static int bioWrite(BIO* pBio, const char* pData, int length)
+{
+    TCPSocketConnection* pSocket = (TCPSocketConnection*)BIO_get_data(pBio);
+
+    return pSocket->send_all((char*)pData, length);
+}
+
+static int bioRead(BIO* pBio, char* pData, int length)
+{
+    TCPSocketConnection* pSocket = (TCPSocketConnection*)BIO_get_data(pBio);
+
+    return pSocket->receive(pData, length);
+}
+
+static long bioCtrl(BIO* pBio, int command, long arg, void* pArg)
+{
+    return command == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+static BIO* createSocketBio(TCPSocketConnection* pSocket)
+{
+    static BIO_METHOD* pMethod = NULL;
+
+    if (!pMethod)
+    {
+        pMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "TCPSocketConnection");
+        BIO_meth_set_write(pMethod, bioWrite);
+        BIO_meth_set_read(pMethod, bioRead);
+        BIO_meth_set_ctrl(pMethod, bioCtrl);
+    }
+    BIO* pBio = BIO_new(pMethod);
+    BIO_set_data(pBio, pSocket);
+    BIO_set_init(pBio, 1);
+    return pBio;
+}
+
+/* GnuTLS reads and writes the connection through the same
+   TCPSocketConnection calls. */
+static ssize_t gnutlsPush(gnutls_transport_ptr_t pTransport, const void* pData, size_t length)
+{
+    return ((TCPSocketConnection*)pTransport)->send_all((char*)pData, length);
+}
+
+static ssize_t gnutlsPull(gnutls_transport_ptr_t pTransport, void* pData, size_t length)
+{
+    return ((TCPSocketConnection*)pTransport)->receive((char*)pData, length);
+}
+
+/* Stand in for GnuTLS's own handling of max_fragment_length, so that the
+   client's request is dropped and the server hello doesn't echo it. */
+static int ignoreExtension(gnutls_session_t session, const unsigned char* pData, size_t length)
+{
+    return 0;
+}
+
+static int omitExtension(gnutls_session_t session, gnutls_buffer_t extensionData)
+{
+    return 0;
+}
+
+static std::string writePem(int (*pWrite)(BIO*, void*), void* pObject)
+{
+    BIO*  pBio = BIO_new(BIO_s_mem());
+    char* pPem;
+
+    pWrite(pBio, pObject);
+    long length = BIO_get_mem_data(pBio, &pPem);
+    std::string pem(pPem, length);
+    BIO_free(pBio);
+    return pem;
+}
+
+static int writeCertificate(BIO* pBio, void* pCert)
+{
+    return PEM_write_bio_X509(pBio, (X509*)pCert);
+}
+
+static int writeKey(BIO* pBio, void* pKey)
+{
+    return PEM_write_bio_PrivateKey(pBio, (EVP_PKEY*)pKey, NULL, NULL, 0, NULL, NULL);
+}
+
+static gnutls_certificate_credentials_t createGnuTlsCredentials(X509* pCert, EVP_PKEY* pKey)
+{
+    gnutls_certificate_credentials_t credentials;
+    std::string                      certPem = writePem(writeCertificate, pCert);
+    std::string                      keyPem = writePem(writeKey, pKey);
+    gnutls_datum_t                   cert = { (unsigned char*)certPem.data(), (unsigned int)certPem.size() };
+    gnutls_datum_t                   key = { (unsigned char*)keyPem.data(), (unsigned int)keyPem.size() };
+
+    gnutls_certificate_allocate_credentials(&credentials);
+    if (gnutls_certificate_set_x509_key_mem(credentials, &cert, &key, GNUTLS_X509_FMT_PEM) < 0)
+    {
+        fprintf(stderr, "error: GnuTLS refused the server certificate\n");
+        _exit(1);
+    }
+    return credentials;
+}
+
+/* A self-signed certificate for a freshly generated RSA key.  axTLS only
+   supports RSA key exchange, which OpenSSL only allows at security level 0. */
+TlsServerContext* tlsCreateServerContext(const char* pCommonName, unsigned int keyBits, const char* pCiphers,
+                                         unsigned int recordSize, bool cacheSessions, bool ignoreFragmentLength)
+{
+    EVP_PKEY* pKey = EVP_RSA_gen(keyBits);
+    X509*     pCert = X509_new();
+    SSL_CTX*  pContext = SSL_CTX_new(TLS_server_method());
+
+    X509_set_version(pCert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(pCert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(pCert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(pCert), 24 * 60 * 60);
+    X509_NAME_add_entry_by_txt(X509_get_subject_name(pCert), "CN", MBSTRING_ASC,
+                               (const unsigned char*)pCommonName, -1, -1, 0);
+    X509_set_issuer_name(pCert, X509_get_subject_name(pCert));
+    X509_set_pubkey(pCert, pKey);
+    X509_sign(pCert, pKey, EVP_sha256());
+
+    SSL_CTX_set_security_level(pContext, 0);
+    SSL_CTX_set_min_proto_version(pContext, TLS1_VERSION);
+    std::string cipherList = std::string(pCiphers) + ":@SECLEVEL=0";
+    SSL_CTX_set_options(pContext, SSL_OP_NO_TICKET);
+    SSL_CTX_set_session_id_context(pContext, (const unsigned char*)"HttpsBench", 10);
+    SSL_CTX_set_session_cache_mode(pContext, cacheSessions ? SSL_SESS_CACHE_SERVER : SSL_SESS_CACHE_OFF);
+    if (recordSize)
+        SSL_CTX_set_max_send_fragment(pContext, recordSize);
+    if (SSL_CTX_set_cipher_list(pContext, cipherList.c_str()) != 1 ||
+        SSL_CTX_use_certificate(pContext, pCert) != 1 || SSL_CTX_use_PrivateKey(pContext, pKey) != 1)
+    {
+        ERR_print_errors_fp(stderr);
+        _exit(1);
+    }
+
+    TlsServerContext* pServerContext = new TlsServerContext;
+    pServerContext->pContext = pContext;
+    pServerContext->credentials = ignoreFragmentLength ? createGnuTlsCredentials(pCert, pKey) : NULL;
+    X509_free(pCert);
+    EVP_PKEY_free(pKey);
+    return pServerContext;
+}
+
+static bool writeAll(TlsConnection* pConnection, const char* pData, int length)
+{
+    return pConnection->write(pData, length) == length;
+}
+
+/* Answers GET requests on a connection until the client closes it. */
+static unsigned int serveRequests(TlsConnection* pConnection)
+{
+    static char  body[CHUNK_SIZE];
+    char         request[512];
+    char         header[128];
+    unsigned int served = 0;
+
+    for (unsigned int i = 0 ; i < sizeof(body) ; i++)
+        body[i] = tlsBodyByte(i);
+    for (;;)
+    {
+        int requestLength = 0;
+
+        // Read until the blank line which terminates the request headers.
+        request[0] = '\0';
+        while (!strstr(request, "\r\n\r\n") && requestLength < (int)sizeof(request) - 1)
+        {
+            int n = pConnection->read(request + requestLength, sizeof(request) - 1 - requestLength);
+            if (n <= 0)
+                return served;
+            requestLength += n;
+            request[requestLength] = '\0';
+        }
+
+        unsigned int bodySize = 0;
+        bool         chunked = strstr(request, "/chunked ") != NULL;
+        if (sscanf(request, "GET /%u", &bodySize) != 1)
+            return served;
+
+        int headerLength;
+        if (chunked)
+            headerLength = snprintf(header, sizeof(header),
+                                    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+        else
+            headerLength = snprintf(header, sizeof(header),
+                                    "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n\r\n", bodySize);
+        if (!writeAll(pConnection, header, headerLength))
+            return served;
+        for (unsigned int sent = 0 ; sent < bodySize ; )
+        {
+            unsigned int chunk = bodySize - sent;
+            if (chunk > sizeof(body))
+                chunk = sizeof(body);
+            if (chunked)
+            {
+                headerLength = snprintf(header, sizeof(header), "%x\r\n", chunk);
+                if (!writeAll(pConnection, header, headerLength))
+                    return served;
+            }
+            if (!writeAll(pConnection, body + (sent % sizeof(body)), chunk))
+                return served;
+            if (chunked && !writeAll(pConnection, "\r\n", 2))
+                return served;
+            sent += chunk;
+        }
+        if (chunked && !writeAll(pConnection, "0\r\n\r\n", 5))
+            return served;
+        served++;
+    }
+}
+
+/* GnuTLS sends records of up to 16kB, whatever the client asked for. */
+static unsigned int serveGnuTlsConnection(TlsServerContext* pContext, TCPSocketConnection* pSocket)
+{
+    gnutls_session_t session;
+    unsigned int     served = 0;
+    int              ret;
+
+    gnutls_init(&session, GNUTLS_SERVER);
+    gnutls_session_ext_register(session, "max_fragment_length", EXT_MAX_FRAGMENT_LENGTH, GNUTLS_EXT_TLS,
+                                ignoreExtension, omitExtension, NULL, NULL, NULL,
+                                GNUTLS_EXT_FLAG_OVERRIDE_INTERNAL | GNUTLS_EXT_FLAG_CLIENT_HELLO |
+                                GNUTLS_EXT_FLAG_TLS12_SERVER_HELLO);
+    gnutls_priority_set_direct(session, "NORMAL:-VERS-TLS1.3:+RSA", NULL);
+    gnutls_credentials_set(session, GNUTLS_CRD_CERTIFICATE, pContext->credentials);
+    gnutls_transport_set_ptr(session, pSocket);
+    gnutls_transport_set_push_function(session, gnutlsPush);
+    gnutls_transport_set_pull_function(session, gnutlsPull);
+    if ((ret = gnutls_handshake(session)) == GNUTLS_E_SUCCESS)
+    {
+        GnuTlsConnection connection(session);
+        served = serveRequests(&connection);
+        gnutls_bye(session, GNUTLS_SHUT_WR);
+    }
+    else
+    {
+        fprintf(stderr, "error: GnuTLS handshake failed: %s\n", gnutls_strerror(ret));
+    }
+    gnutls_deinit(session);
+    return served;
+}
+
+unsigned int tlsServeConnection(TlsServerContext* pContext, TCPSocketConnection* pSocket)
+{
+    unsigned int served = 0;
+    int          nodelay = 1;
+
+    // Like HTTPSClient, don't let Nagle's algorithm hold back the last
+    // record of a response.
+    pSocket->set_option(IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    if (pContext->credentials)
+        return serveGnuTlsConnection(pContext, pSocket);
+
+    SSL* pSsl = SSL_new(pContext->pContext);
+    BIO* pBio = createSocketBio(pSocket);
+
+    SSL_set_bio(pSsl, pBio, pBio);
+    if (SSL_accept(pSsl) == 1)
+    {
+        OpenSslConnection connection(pSsl);
+        served = serveRequests(&connection);
+    }
+    else
+    {
+        ERR_print_errors_fp(stderr);
+    }
+    SSL_shutdown(pSsl);
+    SSL_free(pSsl);
+    return served;
+}
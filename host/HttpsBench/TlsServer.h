@@ -0,0 +1,44 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef _TLS_SERVER_H_
+#define _TLS_SERVER_H_
+
+class TCPSocketConnection;
+struct TlsServerContext;
+
+
+static inline char tlsBodyByte(unsigned int offset)
+{
+    return (char)offset;
+}
+
+/* Creates a server context with a self-signed certificate for a new RSA key
+   of keyBits, which accepts the OpenSSL cipher list pCiphers.  The records
+   it sends hold at most recordSize bytes of data, or OpenSSL's default of
+   16kB when it is 0.  Sessions are only cached, and so resumable, when
+   cacheSessions is set.  With ignoreFragmentLength set, the server ignores
+   the client's max_fragment_length extension and sends 16kB records, with
+   GnuTLS's own choice of cipher, and sessions aren't cached. */
+TlsServerContext* tlsCreateServerContext(const char* pCommonName, unsigned int keyBits, const char* pCiphers,
+                                         unsigned int recordSize, bool cacheSessions,
+                                         bool ignoreFragmentLength);
+
+/* Makes the TLS handshake on an accepted connection and answers GET requests
+   on it until the client closes it.  The path gives the size of the body,
+   ie. /4096, which is sent with chunked encoding when followed by /chunked.
+   Returns the number of requests answered. */
+unsigned int      tlsServeConnection(TlsServerContext* pContext, TCPSocketConnection* pSocket);
+
+#endif /* _TLS_SERVER_H_ */
@@ -0,0 +1,507 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Host benchmark for HTTPSClient.  Like NetBench, two copies of lwIP are run,
+   one per process, and connected through the paired in-memory EMAC.  The
+   server process runs an HTTPS server built on the host's OpenSSL (see
+   TlsServer.cpp), over the mbed Socket classes, while the client process
+   makes GET requests with HTTPSClient and reports the number of TLS
+   handshakes, how many of them resumed a cached session, and the time they
+   took.  It then downloads a large body, as for a firmware update, with
+   Content-Length and chunked encoding and reports the throughput.  The last
+   download reads into a buffer large enough for the server's records, which
+   HTTPSClient::read() then decrypts straight into.  The client asks for
+   records which fit in its record buffer, so the server's are limited to
+   2kB with the default CONFIG_SSL_RECORD_BUFFER_SIZE, or less with -f.
+   Last, the body is downloaded from a server which ignores that request
+   and sends 16kB records, which the client reads into a larger buffer.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "lwip/tcpip.h"
+#include "lwip/inet.h"
+#include "netif/etharp.h"
+#include "eth_arch.h"
+#include "pair_emac.h"
+
+#include "TCPSocketConnection.h"
+#include "TCPSocketServer.h"
+#include "HTTPSClient.h"
+#include "os_port.h"
+#include "FileHandle.h"
+#include "TlsServer.h"
+
+
+namespace
+{
+    const char* const SERVER_IP = "10.0.0.1";
+    const char* const CLIENT_IP = "10.0.0.2";
+    const char* const NETMASK   = "255.255.255.0";
+
+    const int NO_RESUME_PORT  = 4431;
+    const int RESUME_PORT     = 4432;
+    const int KEEP_ALIVE_PORT = 4433;
+    const int DOWNLOAD_PORT   = 4434;
+    const int NO_MFL_PORT     = 4435;
+
+    const unsigned int DOWNLOAD_REQUESTS = 4;
+    const unsigned int NO_MFL_REQUESTS = 2;
+    const int CHUNK_SIZE = 1024;
+    const int RECORD_CHUNK_SIZE = 16 * 1024;
+}
+
+
+struct Options
+{
+    unsigned int latencyUs;
+    unsigned int requests;
+    unsigned int bodySize;
+    unsigned int keyBits;
+    unsigned int downloadSize;
+    const char*  pCiphers;
+    unsigned int recordSize;
+};
+
+
+static const char* g_pRole = "client";
+
+
+/* Checks the downloaded body as HTTPSClient::read_to() writes it. */
+class VerifySink : public mbed::FileHandle
+{
+public:
+    VerifySink() : m_received(0), m_intact(true) {}
+
+    virtual ssize_t write(const void* buffer, size_t length)
+    {
+        const char* pData = (const char*)buffer;
+
+        for (size_t i = 0 ; i < length ; i++)
+        {
+            if (pData[i] != tlsBodyByte(m_received + i))
+                m_intact = false;
+        }
+        m_received += length;
+        return length;
+    }
+    virtual int close() { return 0; }
+    virtual ssize_t read(void* buffer, size_t length) { return -1; }
+    virtual int isatty() { return 0; }
+    virtual off_t lseek(off_t offset, int whence) { return -1; }
+    virtual int fsync() { return 0; }
+
+    unsigned int received() const { return m_received; }
+    bool         intact() const { return m_intact; }
+
+protected:
+    unsigned int m_received;
+    bool         m_intact;
+};
+
+/* Normally provided by retarget.cpp in the mbed library which isn't built for
+   the host. */
+mbed::FileHandle::~FileHandle()
+{
+}
+
+
+static uint64_t readClock(clockid_t clock = CLOCK_MONOTONIC)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* The two processes synchronize through a pair of pipes which are kept
+   outside of lwIP so that they don't perturb the measurements. */
+static void sendCommand(int fd, char command)
+{
+    if (write(fd, &command, 1) != 1)
+    {
+        perror("error: Failed to write control pipe");
+        _exit(1);
+    }
+}
+
+static char receiveCommand(int fd)
+{
+    char command;
+
+    if (read(fd, &command, 1) != 1)
+        return 'q';
+    return command;
+}
+
+
+static void tcpipInitDone(void* pv)
+{
+    sys_sem_signal((sys_sem_t*)pv);
+}
+
+static void bringUpNetwork(int fd, const char* pIpAddress, uint8_t macLastByte, const Options* pOptions)
+{
+    static struct netif netif;
+    pair_emac_config_t  config;
+    sys_sem_t           initDone;
+    ip_addr_t           ip;
+    ip_addr_t           mask;
+    ip_addr_t           gateway;
+
+    memset(&config, 0, sizeof(config));
+    config.fd = fd;
+    config.latency_us = pOptions->latencyUs;
+    config.seed = macLastByte;
+    config.hwaddr[0] = 0x02;
+    config.hwaddr[5] = macLastByte;
+    pair_emac_configure(&config);
+
+    sys_sem_new(&initDone, 0);
+    tcpip_init(tcpipInitDone, &initDone);
+    sys_arch_sem_wait(&initDone, 0);
+
+    inet_aton(pIpAddress, &ip);
+    inet_aton(NETMASK, &mask);
+    ip_addr_set_zero(&gateway);
+    netif_add(&netif, &ip, &mask, &gateway, NULL, eth_arch_enetif_init, tcpip_input);
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+    eth_arch_enable_interrupts();
+}
+
+
+/* Server side. */
+static void serveHttps(int port, TlsServerContext* pContext, unsigned int requests, int replyFd)
+{
+    TCPSocketServer server;
+    unsigned int    served = 0;
+
+    server.bind(port);
+    server.listen();
+    sendCommand(replyFd, 'r');
+    while (served < requests)
+    {
+        TCPSocketConnection client;
+
+        if (server.accept(client) < 0)
+            break;
+        unsigned int answered = tlsServeConnection(pContext, &client);
+        client.close();
+        // Give up on a client whose handshake failed rather than wait for
+        // requests which won't come.
+        if (answered == 0)
+            break;
+        served += answered;
+    }
+    server.close();
+}
+
+static void runServer(int fd, int commandFd, int replyFd, const Options* pOptions)
+{
+    g_pRole = "server";
+    bringUpNetwork(fd, SERVER_IP, 0x01, pOptions);
+
+    TlsServerContext* pCaching = tlsCreateServerContext(SERVER_IP, pOptions->keyBits, pOptions->pCiphers,
+                                                        pOptions->recordSize, true, false);
+    TlsServerContext* pNotCaching = tlsCreateServerContext(SERVER_IP, pOptions->keyBits, pOptions->pCiphers,
+                                                           pOptions->recordSize, false, false);
+    TlsServerContext* pIgnoringMfl = tlsCreateServerContext(SERVER_IP, pOptions->keyBits, pOptions->pCiphers,
+                                                            0, false, true);
+    for (;;)
+    {
+        char command = receiveCommand(commandFd);
+        switch (command)
+        {
+        case 'n':
+            serveHttps(NO_RESUME_PORT, pNotCaching, pOptions->requests, replyFd);
+            break;
+        case 'r':
+            serveHttps(RESUME_PORT, pCaching, pOptions->requests, replyFd);
+            break;
+        case 'k':
+            serveHttps(KEEP_ALIVE_PORT, pCaching, pOptions->requests, replyFd);
+            break;
+        case 'd':
+            serveHttps(DOWNLOAD_PORT, pCaching, DOWNLOAD_REQUESTS, replyFd);
+            break;
+        case 'i':
+            serveHttps(NO_MFL_PORT, pIgnoringMfl, NO_MFL_REQUESTS, replyFd);
+            break;
+        default:
+            sendCommand(replyFd, 'd');
+            return;
+        }
+        sendCommand(replyFd, 'd');
+    }
+}
+
+
+/* Client side. */
+static bool readBody(HTTPSClient* pClient, const Options* pOptions)
+{
+    char         buffer[CHUNK_SIZE];
+    unsigned int received = 0;
+    bool         intact = true;
+
+    for (;;)
+    {
+        int n = pClient->read(buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        for (int i = 0 ; i < n ; i++)
+        {
+            if (buffer[i] != tlsBodyByte(received + i))
+                intact = false;
+        }
+        received += n;
+    }
+    return intact && received == pOptions->bodySize;
+}
+
+/* Makes the requests with a new connection each unless keepAlive is set.
+   The time spent in connect() is the handshake time; get() only makes a
+   handshake when it has to reconnect, which these tests don't provoke. */
+static void runRequests(const char* pTest, int port, bool keepAlive, const Options* pOptions)
+{
+    HTTPSClient  client;
+    unsigned int completed = 0;
+    uint64_t     handshakeNs = 0;
+    uint64_t     start = readClock();
+    char         path[32];
+
+    snprintf(path, sizeof(path), "/%u", pOptions->bodySize);
+    for (unsigned int i = 0 ; i < pOptions->requests ; i++)
+    {
+        if (!keepAlive || !client.is_connected())
+        {
+            uint64_t connectStart = readClock();
+            if (client.connect(SERVER_IP, port) < 0)
+                continue;
+            handshakeNs += readClock() - connectStart;
+        }
+
+        HTTPHeader header = client.get(path);
+        if (header.getStatusCode() != 200)
+            continue;
+        if (readBody(&client, pOptions))
+            completed++;
+        if (!keepAlive)
+            client.close();
+    }
+    client.close();
+    double       seconds = (readClock() - start) / 1e9;
+    unsigned int handshakes = client.get_handshakes();
+    unsigned int resumed = client.get_resumed_handshakes();
+
+    printf("[%s] %-10s: %u of %u requests, %u handshakes (%u resumed), %.2f ms/handshake, "
+           "%.3f handshakes/request, %.2f ms/request\n",
+           g_pRole, pTest, completed, pOptions->requests, handshakes, resumed,
+           handshakes ? (handshakeNs / 1e6) / handshakes : 0.0,
+           (double)handshakes / pOptions->requests, (seconds * 1e3) / pOptions->requests);
+}
+
+static void runNoResume(const Options* pOptions)
+{
+    runRequests("no resume", NO_RESUME_PORT, false, pOptions);
+}
+
+static void runResume(const Options* pOptions)
+{
+    runRequests("resume", RESUME_PORT, false, pOptions);
+}
+
+static void runKeepAlive(const Options* pOptions)
+{
+    runRequests("keep-alive", KEEP_ALIVE_PORT, true, pOptions);
+}
+
+/* Times a download of the body at pPath on an established connection, into
+   a VerifySink with read_to(), or through a buffer of bufferSize bytes with
+   read() when it isn't 0. */
+static void downloadBody(HTTPSClient* pClient, const char* pTest, const char* pPath,
+                         int bufferSize, const Options* pOptions)
+{
+    static char buffer[RECORD_CHUNK_SIZE];
+    VerifySink  sink;
+    uint64_t   start = readClock();
+    uint64_t   cpuStart = readClock(CLOCK_PROCESS_CPUTIME_ID);
+
+    HTTPHeader header = pClient->get(pPath);
+    if (header.getStatusCode() == 200)
+    {
+        if (bufferSize == 0)
+        {
+            pClient->read_to(&sink);
+        }
+        else
+        {
+            int n;
+            while ((n = pClient->read(buffer, bufferSize)) > 0)
+                sink.write(buffer, n);
+        }
+    }
+    double seconds = (readClock() - start) / 1e9;
+    double cpuSeconds = (readClock(CLOCK_PROCESS_CPUTIME_ID) - cpuStart) / 1e9;
+    double megabytes = sink.received() / (1024.0 * 1024.0);
+
+    printf("[%s] %-10s: %u of %u bytes %s, %.1f Mbit/s, %.2f ms CPU/MB\n",
+           g_pRole, pTest, sink.received(), pOptions->downloadSize,
+           sink.intact() && sink.received() == pOptions->downloadSize ? "intact" : "CORRUPT",
+           (sink.received() * 8 / 1e6) / seconds, megabytes > 0 ? (cpuSeconds * 1e3) / megabytes : 0.0);
+}
+
+static void runDownload(const Options* pOptions)
+{
+    HTTPSClient client;
+    char        path[32];
+    char        chunkedPath[40];
+
+    snprintf(path, sizeof(path), "/%u", pOptions->downloadSize);
+    snprintf(chunkedPath, sizeof(chunkedPath), "/%u/chunked", pOptions->downloadSize);
+    if (client.connect(SERVER_IP, DOWNLOAD_PORT) < 0)
+        return;
+    downloadBody(&client, "read_to", path, 0, pOptions);
+    downloadBody(&client, "chunked", chunkedPath, 0, pOptions);
+    downloadBody(&client, "read 1kB", path, CHUNK_SIZE, pOptions);
+    downloadBody(&client, "read 16kB", path, RECORD_CHUNK_SIZE, pOptions);
+    client.close();
+}
+
+/* The server ignores max_fragment_length, so its records only fit in the
+   16kB buffer the client takes from the heap instead. */
+static void runIgnoredFragmentLength(const Options* pOptions)
+{
+    HTTPSClient client;
+    char        path[32];
+
+    snprintf(path, sizeof(path), "/%u", pOptions->downloadSize);
+    if (client.connect(SERVER_IP, NO_MFL_PORT) < 0)
+    {
+        printf("[%s] %-10s: handshake failed\n", g_pRole, "no MFL");
+        return;
+    }
+    downloadBody(&client, "no MFL", path, 0, pOptions);
+    downloadBody(&client, "no MFL 1kB", path, CHUNK_SIZE, pOptions);
+    client.close();
+}
+
+static void runTest(void (*pTest)(const Options*), char command,
+                    int commandFd, int replyFd, const Options* pOptions)
+{
+    sendCommand(commandFd, command);
+    if (receiveCommand(replyFd) != 'r')
+        return;
+    pTest(pOptions);
+    receiveCommand(replyFd);
+    fflush(stdout);
+}
+
+static void runClient(int fd, int commandFd, int replyFd, const Options* pOptions)
+{
+    bringUpNetwork(fd, CLIENT_IP, 0x02, pOptions);
+    disable_memory_buf();
+    printf("[%s] latency %u us, %u bit RSA key, %u byte bodies, %s, %u byte server records, %u byte SSL\n",
+           g_pRole, pOptions->latencyUs, pOptions->keyBits, pOptions->bodySize, pOptions->pCiphers,
+           pOptions->recordSize ? pOptions->recordSize : 16384, (unsigned)sizeof(SSL));
+
+    runTest(runNoResume, 'n', commandFd, replyFd, pOptions);
+    runTest(runResume, 'r', commandFd, replyFd, pOptions);
+    runTest(runKeepAlive, 'k', commandFd, replyFd, pOptions);
+    runTest(runDownload, 'd', commandFd, replyFd, pOptions);
+    runTest(runIgnoredFragmentLength, 'i', commandFd, replyFd, pOptions);
+
+    sendCommand(commandFd, 'q');
+    receiveCommand(replyFd);
+}
+
+
+static void usage(const char* pProgram)
+{
+    fprintf(stderr, "Usage: %s [-l latency_us] [-n requests] [-s body_bytes] [-k rsa_key_bits] "
+                    "[-d download_bytes] [-c server_ciphers] [-f server_record_bytes]\n", pProgram);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    Options options = { 0, 20, 4096, 2048, 4 * 1024 * 1024, "AES128-SHA:AES256-SHA", 0 };
+    int     fds[2];
+    int     commandPipe[2];
+    int     replyPipe[2];
+    int     opt;
+
+    while ((opt = getopt(argc, argv, "l:n:s:k:d:c:f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            options.latencyUs = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            options.requests = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            options.bodySize = strtoul(optarg, NULL, 0);
+            break;
+        case 'k':
+            options.keyBits = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            options.downloadSize = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            options.pCiphers = optarg;
+            break;
+        case 'f':
+            options.recordSize = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (pair_emac_create_link(fds) != 0)
+    {
+        perror("error: Failed to create link");
+        return 1;
+    }
+    if (pipe(commandPipe) != 0 || pipe(replyPipe) != 0)
+    {
+        perror("error: Failed to create control pipes");
+        return 1;
+    }
+
+    fflush(stdout);
+    pid_t server = fork();
+    if (server < 0)
+    {
+        perror("error: Failed to fork server");
+        return 1;
+    }
+    if (server == 0)
+    {
+        runServer(fds[1], commandPipe[0], replyPipe[1], &options);
+        _exit(0);
+    }
+
+    runClient(fds[0], commandPipe[1], replyPipe[0], &options);
+    int status = 0;
+    waitpid(server, &status, 0);
+    return 0;
+}
@@ -0,0 +1,769 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Host benchmark for the lwIP stack and the mbed Socket classes.  Two copies
+   of the stack are run, one per process, and connected through the paired
+   in-memory EMAC.  The server process runs the equivalent of the TCP/UDP echo
+   servers from the mbed networking tests plus a bulk sink, a small HTTP
+   server and a file server while the client process drives them and reports
+   throughput, CPU cost per frame and lwIP pool high-water marks for both
+   sides.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "lwip/tcpip.h"
+#include "lwip/inet.h"
+#include "lwip/stats.h"
+#include "lwip/memp.h"
+#include "netif/etharp.h"
+#include "eth_arch.h"
+#include "pair_emac.h"
+
+#include "TCPSocketConnection.h"
+#include "TCPSocketServer.h"
+#include "UDPSocket.h"
+#include "Endpoint.h"
+#include "FileHandle.h"
+
+
+namespace
+{
+    const char* const SERVER_IP   = "10.0.0.1";
+    const char* const CLIENT_IP   = "10.0.0.2";
+    const char* const NETMASK     = "255.255.255.0";
+
+    const int ECHO_PORT     = 7;
+    const int HTTP_PORT     = 80;
+    const int SINK_PORT     = 5001;
+    const int FREAD_PORT    = 8080;
+    const int SENDFILE_PORT = 8081;
+
+    const int ECHO_SIZE     = 64;
+    const int CHUNK_SIZE    = 1460;
+    const int FILE_CHUNK    = 2048;
+    const int UDP_IDLE_MS   = 1000;
+}
+
+
+struct Options
+{
+    unsigned int latencyUs;
+    unsigned int lossPpm;
+    unsigned int bulkBytes;
+    unsigned int iterations;
+    unsigned int httpBodySize;
+    unsigned int httpRequests;
+};
+
+
+struct Sample
+{
+    uint64_t             wallNs;
+    uint64_t             cpuNs;
+    pair_emac_counters_t link;
+};
+
+
+static const char* const g_poolNames[] =
+{
+#define LWIP_MEMPOOL(name,num,size,desc) desc,
+#include "lwip/memp_std.h"
+};
+
+static const char* g_pRole = "client";
+static struct netif g_netif;
+
+
+/* FileHandle over a host file so that TCPSocketConnection::send_file() can be
+   measured against the fread() and send_all() loop it replaces. */
+class HostFileHandle : public mbed::FileHandle
+{
+public:
+    HostFileHandle(int fd) : m_fd(fd) {}
+
+    virtual ssize_t write(const void* buffer, size_t length) { return ::write(m_fd, buffer, length); }
+    virtual int close() { return 0; }
+    virtual ssize_t read(void* buffer, size_t length) { return ::read(m_fd, buffer, length); }
+    virtual int isatty() { return 0; }
+    virtual off_t lseek(off_t offset, int whence) { return ::lseek(m_fd, offset, whence); }
+    virtual int fsync() { return 0; }
+
+protected:
+    int m_fd;
+};
+
+/* Normally provided by retarget.cpp in the mbed library which isn't built for
+   the host. */
+mbed::FileHandle::~FileHandle()
+{
+}
+
+
+static uint64_t readClock(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static void takeSample(Sample* pSample)
+{
+    pSample->wallNs = readClock(CLOCK_MONOTONIC);
+    pSample->cpuNs = readClock(CLOCK_PROCESS_CPUTIME_ID);
+    pair_emac_get_counters(&pSample->link);
+}
+
+static void reportCpu(const char* pTest, const Sample* pStart, const Sample* pEnd)
+{
+    unsigned int frames = (pEnd->link.tx_frames - pStart->link.tx_frames) +
+                          (pEnd->link.rx_frames - pStart->link.rx_frames);
+    uint64_t     cpuNs = pEnd->cpuNs - pStart->cpuNs;
+
+    printf("[%s] %-10s: %u frames, %.2f us CPU/frame\n",
+           g_pRole, pTest, frames, frames ? (cpuNs / 1000.0) / frames : 0.0);
+}
+
+static double elapsedSeconds(const Sample* pStart, const Sample* pEnd)
+{
+    return (pEnd->wallNs - pStart->wallNs) / 1e9;
+}
+
+/* The two processes synchronize through a pair of pipes which are kept
+   outside of lwIP so that they don't perturb the measurements. */
+static void sendCommand(int fd, char command)
+{
+    if (write(fd, &command, 1) != 1)
+    {
+        perror("error: Failed to write control pipe");
+        _exit(1);
+    }
+}
+
+static char receiveCommand(int fd)
+{
+    char command;
+
+    if (read(fd, &command, 1) != 1)
+        return 'q';
+    return command;
+}
+
+static void reportStats(void)
+{
+    pair_emac_counters_t link;
+
+    pair_emac_get_counters(&link);
+    printf("[%s] link      : tx %u frames/%u bytes, rx %u frames/%u bytes\n",
+           g_pRole, link.tx_frames, link.tx_bytes, link.rx_frames, link.rx_bytes);
+    printf("[%s] link drops: lost %u, no pbuf %u, latency overflow %u\n",
+           g_pRole, link.rx_lost, link.rx_no_pbuf, link.rx_delay_overflow);
+    printf("[%s] netif     : rx %u packets/%u bytes, %u dropped, tx %u packets/%u bytes\n", g_pRole,
+           (unsigned)g_netif.stats.rx_pkts, (unsigned)g_netif.stats.rx_bytes, (unsigned)g_netif.stats.rx_drop,
+           (unsigned)g_netif.stats.tx_pkts, (unsigned)g_netif.stats.tx_bytes);
+    printf("[%s] heap      : max %u of %u bytes, %u failures\n", g_pRole,
+           (unsigned)lwip_stats.mem.max, (unsigned)lwip_stats.mem.avail, (unsigned)lwip_stats.mem.err);
+    for (int i = 0 ; i < MEMP_MAX ; i++)
+    {
+        const struct stats_mem* pPool = &lwip_stats.memp[i];
+        printf("[%s] pool %-16s: max %3u of %3u, %u failures\n", g_pRole,
+               g_poolNames[i], (unsigned)pPool->max, (unsigned)pPool->avail, (unsigned)pPool->err);
+    }
+    printf("[%s] tcpip mbox: %u msgs, %u dropped, depth max %u, wait avg %.1f us max %u us\n", g_pRole,
+           (unsigned)lwip_stats.tcpip.msgs, (unsigned)lwip_stats.tcpip.err, (unsigned)lwip_stats.tcpip.depth_max,
+           lwip_stats.tcpip.msgs ? (double)lwip_stats.tcpip.wait_us / lwip_stats.tcpip.msgs : 0.0,
+           (unsigned)lwip_stats.tcpip.wait_us_max);
+    fflush(stdout);
+}
+
+
+static void tcpipInitDone(void* pv)
+{
+    sys_sem_signal((sys_sem_t*)pv);
+}
+
+static void bringUpNetwork(int fd, const char* pIpAddress, uint8_t macLastByte, const Options* pOptions)
+{
+    pair_emac_config_t  config;
+    sys_sem_t           initDone;
+    ip_addr_t           ip;
+    ip_addr_t           mask;
+    ip_addr_t           gateway;
+
+    memset(&config, 0, sizeof(config));
+    config.fd = fd;
+    config.latency_us = pOptions->latencyUs;
+    config.loss_ppm = pOptions->lossPpm;
+    config.seed = macLastByte;
+    config.hwaddr[0] = 0x02;
+    config.hwaddr[5] = macLastByte;
+    pair_emac_configure(&config);
+
+    sys_sem_new(&initDone, 0);
+    tcpip_init(tcpipInitDone, &initDone);
+    sys_arch_sem_wait(&initDone, 0);
+
+    inet_aton(pIpAddress, &ip);
+    inet_aton(NETMASK, &mask);
+    ip_addr_set_zero(&gateway);
+    netif_add(&g_netif, &ip, &mask, &gateway, NULL, eth_arch_enetif_init, tcpip_input);
+    netif_set_default(&g_netif);
+    netif_set_up(&g_netif);
+    eth_arch_enable_interrupts();
+}
+
+
+/* Server side.  Services are started one at a time, when the client asks
+   for them over the control pipe, so that the benchmark fits within the
+   netconn and PCB limits of the device configuration. */
+static void serveTcpSink(TCPSocketServer& server)
+{
+    static char         buffer[CHUNK_SIZE];
+    TCPSocketConnection client;
+    uint32_t            expected = 0;
+    uint32_t            received = 0;
+
+    if (server.accept(client) < 0)
+        return;
+    if (client.receive_all((char*)&expected, sizeof(expected)) != sizeof(expected))
+        return;
+    while (received < expected)
+    {
+        int n = client.receive(buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        received += n;
+    }
+    client.send_all((char*)&received, sizeof(received));
+    client.close();
+}
+
+static void serveTcpEcho(TCPSocketServer& server)
+{
+    char                buffer[ECHO_SIZE];
+    TCPSocketConnection client;
+
+    if (server.accept(client) < 0)
+        return;
+    for (;;)
+    {
+        int n = client.receive(buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        client.send_all(buffer, n);
+    }
+    client.close();
+}
+
+static void serveHttp(TCPSocketServer& server, const Options* pOptions)
+{
+    static char body[CHUNK_SIZE];
+    char        request[256];
+    char        header[128];
+
+    memset(body, 'x', sizeof(body));
+    for (unsigned int i = 0 ; i < pOptions->httpRequests ; i++)
+    {
+        TCPSocketConnection client;
+        int                 requestLength = 0;
+
+        if (server.accept(client) < 0)
+            continue;
+        // Read until the blank line which terminates the request headers.
+        while (requestLength < (int)sizeof(request) - 1)
+        {
+            int n = client.receive(request + requestLength, sizeof(request) - 1 - requestLength);
+            if (n <= 0)
+                break;
+            requestLength += n;
+            request[requestLength] = '\0';
+            if (strstr(request, "\r\n\r\n"))
+                break;
+        }
+
+        int headerLength = snprintf(header, sizeof(header),
+                                    "HTTP/1.0 200 OK\r\nContent-Length: %u\r\n\r\n",
+                                    pOptions->httpBodySize);
+        client.send_all(header, headerLength);
+        for (unsigned int sent = 0 ; sent < pOptions->httpBodySize ; )
+        {
+            unsigned int chunk = pOptions->httpBodySize - sent;
+            if (chunk > sizeof(body))
+                chunk = sizeof(body);
+            if (client.send_all(body, chunk) != (int)chunk)
+                break;
+            sent += chunk;
+        }
+        client.close();
+    }
+}
+
+static int createBenchFile(unsigned int size)
+{
+    static unsigned char buffer[FILE_CHUNK];
+    char                 path[] = "/tmp/NetBenchXXXXXX";
+    int                  fd = mkstemp(path);
+
+    if (fd < 0)
+    {
+        perror("error: Failed to create file");
+        return -1;
+    }
+    unlink(path);
+    for (unsigned int offset = 0 ; offset < size ; offset += sizeof(buffer))
+    {
+        unsigned int chunk = size - offset;
+        if (chunk > sizeof(buffer))
+            chunk = sizeof(buffer);
+        for (unsigned int i = 0 ; i < chunk ; i++)
+            buffer[i] = (unsigned char)(offset + i);
+        if (write(fd, buffer, chunk) != (ssize_t)chunk)
+        {
+            perror("error: Failed to write file");
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+static void serveFile(TCPSocketServer& server, char command, const Options* pOptions)
+{
+    static char         buffer[FILE_CHUNK];
+    TCPSocketConnection client;
+    Sample              start;
+    Sample              end;
+    int                 fd = createBenchFile(pOptions->bulkBytes);
+
+    if (fd < 0)
+        return;
+    if (server.accept(client) < 0)
+    {
+        close(fd);
+        return;
+    }
+
+    takeSample(&start);
+    if (command == 's')
+    {
+        HostFileHandle file(fd);
+
+        lseek(fd, 0, SEEK_SET);
+        client.send_file(&file);
+    }
+    else
+    {
+        FILE* pFile = fdopen(dup(fd), "r");
+
+        rewind(pFile);
+        for (;;)
+        {
+            size_t n = fread(buffer, 1, sizeof(buffer), pFile);
+            if (n == 0 || client.send_all(buffer, n) != (int)n)
+                break;
+        }
+        fclose(pFile);
+    }
+    takeSample(&end);
+    client.close();
+    close(fd);
+    reportCpu(command == 's' ? "send_file" : "fread", &start, &end);
+}
+
+static void serveTcp(int port, char command, const Options* pOptions, int replyFd)
+{
+    TCPSocketServer server;
+
+    server.bind(port);
+    server.listen();
+    sendCommand(replyFd, 'r');
+    switch (command)
+    {
+    case 'b':
+        serveTcpSink(server);
+        break;
+    case 'e':
+        serveTcpEcho(server);
+        break;
+    case 'h':
+        serveHttp(server, pOptions);
+        break;
+    case 'f':
+    case 's':
+        serveFile(server, command, pOptions);
+        break;
+    }
+    server.close();
+}
+
+static void serveUdpEcho(const Options* pOptions, int replyFd)
+{
+    char      buffer[ECHO_SIZE];
+    UDPSocket server;
+    Endpoint  client;
+
+    server.bind(ECHO_PORT);
+    server.set_blocking(false, UDP_IDLE_MS + pOptions->latencyUs / 500);
+    sendCommand(replyFd, 'r');
+    for (;;)
+    {
+        // A 1 byte datagram or a long silence marks the end of the test.
+        int n = server.receiveFrom(client, buffer, sizeof(buffer));
+        if (n <= 1)
+            break;
+        server.sendTo(client, buffer, n);
+    }
+    server.close();
+}
+
+static void runServer(int fd, int commandFd, int replyFd, const Options* pOptions)
+{
+    g_pRole = "server";
+    bringUpNetwork(fd, SERVER_IP, 0x01, pOptions);
+
+    for (;;)
+    {
+        char command = receiveCommand(commandFd);
+        switch (command)
+        {
+        case 'b':
+            serveTcp(SINK_PORT, command, pOptions, replyFd);
+            break;
+        case 'e':
+            serveTcp(ECHO_PORT, command, pOptions, replyFd);
+            break;
+        case 'h':
+            serveTcp(HTTP_PORT, command, pOptions, replyFd);
+            break;
+        case 'f':
+            serveTcp(FREAD_PORT, command, pOptions, replyFd);
+            break;
+        case 's':
+            serveTcp(SENDFILE_PORT, command, pOptions, replyFd);
+            break;
+        case 'u':
+            serveUdpEcho(pOptions, replyFd);
+            break;
+        default:
+            reportStats();
+            sendCommand(replyFd, 'd');
+            return;
+        }
+        sendCommand(replyFd, 'd');
+    }
+}
+
+
+/* Client side. */
+static void runTcpBulk(const Options* pOptions)
+{
+    static char         buffer[CHUNK_SIZE];
+    TCPSocketConnection socket;
+    Sample              start;
+    Sample              end;
+    uint32_t            total = pOptions->bulkBytes;
+    uint32_t            received = 0;
+
+    memset(buffer, 0x55, sizeof(buffer));
+    if (socket.connect(SERVER_IP, SINK_PORT) < 0)
+    {
+        printf("[%s] tcp bulk  : connect failed\n", g_pRole);
+        return;
+    }
+
+    takeSample(&start);
+    socket.send_all((char*)&total, sizeof(total));
+    for (uint32_t sent = 0 ; sent < total ; )
+    {
+        uint32_t chunk = total - sent;
+        if (chunk > sizeof(buffer))
+            chunk = sizeof(buffer);
+        if (socket.send_all(buffer, chunk) != (int)chunk)
+            break;
+        sent += chunk;
+    }
+    socket.receive_all((char*)&received, sizeof(received));
+    takeSample(&end);
+    socket.close();
+
+    double seconds = elapsedSeconds(&start, &end);
+    printf("[%s] tcp bulk  : %u of %u bytes in %.3f s = %.2f Mbit/s\n",
+           g_pRole, received, total, seconds, (received * 8.0) / (seconds * 1e6));
+    reportCpu("tcp bulk", &start, &end);
+}
+
+static void runTcpEcho(const Options* pOptions)
+{
+    char                out[ECHO_SIZE];
+    char                in[ECHO_SIZE];
+    TCPSocketConnection socket;
+    Sample              start;
+    Sample              end;
+    unsigned int        failures = 0;
+
+    memset(out, 'e', sizeof(out));
+    if (socket.connect(SERVER_IP, ECHO_PORT) < 0)
+    {
+        printf("[%s] tcp echo  : connect failed\n", g_pRole);
+        return;
+    }
+
+    takeSample(&start);
+    for (unsigned int i = 0 ; i < pOptions->iterations ; i++)
+    {
+        if (socket.send_all(out, sizeof(out)) != sizeof(out) ||
+            socket.receive_all(in, sizeof(in)) != sizeof(in) ||
+            memcmp(in, out, sizeof(in)) != 0)
+        {
+            failures++;
+        }
+    }
+    takeSample(&end);
+    socket.close();
+
+    double seconds = elapsedSeconds(&start, &end);
+    printf("[%s] tcp echo  : %u x %d bytes, %u failures, %.1f us/round trip\n",
+           g_pRole, pOptions->iterations, ECHO_SIZE, failures, (seconds * 1e6) / pOptions->iterations);
+    reportCpu("tcp echo", &start, &end);
+}
+
+static void runUdpEcho(const Options* pOptions)
+{
+    char         out[ECHO_SIZE];
+    char         in[ECHO_SIZE];
+    UDPSocket    socket;
+    Endpoint     server;
+    Endpoint     from;
+    Sample       start;
+    Sample       end;
+    unsigned int received = 0;
+
+    memset(out, 'u', sizeof(out));
+    socket.init();
+    socket.set_blocking(false, 100 + pOptions->latencyUs / 500);
+    server.set_address(SERVER_IP, ECHO_PORT);
+
+    takeSample(&start);
+    for (unsigned int i = 0 ; i < pOptions->iterations ; i++)
+    {
+        socket.sendTo(server, out, sizeof(out));
+        if (socket.receiveFrom(from, in, sizeof(in)) == sizeof(in))
+            received++;
+    }
+    takeSample(&end);
+    // Let the server know that the test is over.  Should these all be lost
+    // then it will give up once the link has been idle for UDP_IDLE_MS.
+    for (int i = 0 ; i < 3 ; i++)
+        socket.sendTo(server, out, 1);
+    socket.close();
+
+    double seconds = elapsedSeconds(&start, &end);
+    printf("[%s] udp echo  : %u x %d bytes, %u answered, %.1f us/round trip\n",
+           g_pRole, pOptions->iterations, ECHO_SIZE, received, (seconds * 1e6) / pOptions->iterations);
+    reportCpu("udp echo", &start, &end);
+}
+
+static void runHttpGet(const Options* pOptions)
+{
+    static char  buffer[CHUNK_SIZE];
+    char         request[] = "GET /bench.bin HTTP/1.0\r\nHost: 10.0.0.1\r\n\r\n";
+    Sample       start;
+    Sample       end;
+    unsigned int requests = pOptions->httpRequests;
+    unsigned int completed = 0;
+    uint64_t     bytes = 0;
+
+    takeSample(&start);
+    for (unsigned int i = 0 ; i < requests ; i++)
+    {
+        TCPSocketConnection socket;
+        unsigned int        responseBytes = 0;
+
+        if (socket.connect(SERVER_IP, HTTP_PORT) < 0)
+            continue;
+        socket.send_all(request, sizeof(request) - 1);
+        for (;;)
+        {
+            int n = socket.receive(buffer, sizeof(buffer));
+            if (n <= 0)
+                break;
+            responseBytes += n;
+        }
+        socket.close();
+        if (responseBytes >= pOptions->httpBodySize)
+            completed++;
+        bytes += responseBytes;
+    }
+    takeSample(&end);
+
+    double seconds = elapsedSeconds(&start, &end);
+    printf("[%s] http get  : %u of %u requests x %u bytes, %.1f requests/s, %.2f Mbit/s\n",
+           g_pRole, completed, requests, pOptions->httpBodySize,
+           completed / seconds, (bytes * 8.0) / (seconds * 1e6));
+    reportCpu("http get", &start, &end);
+}
+
+static void receiveFile(const char* pTest, int port, const Options* pOptions)
+{
+    static unsigned char buffer[CHUNK_SIZE];
+    TCPSocketConnection  socket;
+    Sample               start;
+    Sample               end;
+    unsigned int         received = 0;
+    unsigned int         mismatches = 0;
+
+    if (socket.connect(SERVER_IP, port) < 0)
+    {
+        printf("[%s] %-10s: connect failed\n", g_pRole, pTest);
+        return;
+    }
+
+    takeSample(&start);
+    for (;;)
+    {
+        int n = socket.receive((char*)buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+        for (int i = 0 ; i < n ; i++)
+        {
+            if (buffer[i] != (unsigned char)(received + i))
+                mismatches++;
+        }
+        received += n;
+    }
+    takeSample(&end);
+    socket.close();
+
+    double seconds = elapsedSeconds(&start, &end);
+    printf("[%s] %-10s: %u of %u bytes, %u corrupt, in %.3f s = %.2f Mbit/s\n",
+           g_pRole, pTest, received, pOptions->bulkBytes, mismatches, seconds, (received * 8.0) / (seconds * 1e6));
+}
+
+static void runFileRead(const Options* pOptions)
+{
+    receiveFile("fread", FREAD_PORT, pOptions);
+}
+
+static void runSendFile(const Options* pOptions)
+{
+    receiveFile("send_file", SENDFILE_PORT, pOptions);
+}
+
+static void runTest(void (*pTest)(const Options*), char command,
+                    int commandFd, int replyFd, const Options* pOptions)
+{
+    sendCommand(commandFd, command);
+    if (receiveCommand(replyFd) != 'r')
+        return;
+    pTest(pOptions);
+    receiveCommand(replyFd);
+    fflush(stdout);
+}
+
+static void runClient(int fd, int commandFd, int replyFd, const Options* pOptions)
+{
+    bringUpNetwork(fd, CLIENT_IP, 0x02, pOptions);
+    printf("[%s] latency %u us, loss %u ppm\n", g_pRole, pOptions->latencyUs, pOptions->lossPpm);
+
+    runTest(runTcpBulk, 'b', commandFd, replyFd, pOptions);
+    runTest(runTcpEcho, 'e', commandFd, replyFd, pOptions);
+    runTest(runUdpEcho, 'u', commandFd, replyFd, pOptions);
+    runTest(runHttpGet, 'h', commandFd, replyFd, pOptions);
+    runTest(runFileRead, 'f', commandFd, replyFd, pOptions);
+    runTest(runSendFile, 's', commandFd, replyFd, pOptions);
+    reportStats();
+
+    // Ask the server to dump its statistics and wait for it to finish.
+    sendCommand(commandFd, 'q');
+    receiveCommand(replyFd);
+}
+
+
+static void usage(const char* pProgram)
+{
+    fprintf(stderr, "Usage: %s [-l latency_us] [-p loss_ppm] [-b bulk_bytes] "
+                    "[-n iterations] [-s http_body_bytes]\n", pProgram);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    Options options = { 0, 0, 4 * 1024 * 1024, 1000, 16 * 1024, 0 };
+    int     fds[2];
+    int     commandPipe[2];
+    int     replyPipe[2];
+    int     opt;
+
+    while ((opt = getopt(argc, argv, "l:p:b:n:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            options.latencyUs = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            options.lossPpm = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            options.bulkBytes = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            options.iterations = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            options.httpBodySize = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    options.httpRequests = options.iterations / 10 + 1;
+
+    if (pair_emac_create_link(fds) != 0)
+    {
+        perror("error: Failed to create link");
+        return 1;
+    }
+    if (pipe(commandPipe) != 0 || pipe(replyPipe) != 0)
+    {
+        perror("error: Failed to create control pipes");
+        return 1;
+    }
+
+    fflush(stdout);
+    pid_t server = fork();
+    if (server < 0)
+    {
+        perror("error: Failed to fork server");
+        return 1;
+    }
+    if (server == 0)
+    {
+        runServer(fds[1], commandPipe[0], replyPipe[1], &options);
+        _exit(0);
+    }
+
+    runClient(fds[0], commandPipe[1], replyPipe[0], &options);
+    int status = 0;
+    waitpid(server, &status, 0);
+    return 0;
+}
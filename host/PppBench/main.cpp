@@ -0,0 +1,508 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Validates the bulk PPP framing in lwip/netif/ppp/pppframe.c, used by
+   pppifOutput(), pppWrite() and pppInProc() for cellular links, against the
+   byte at a time code it replaces.  It then decodes PPP frames as they
+   appear on the wire, and compares the bytes per second of both approaches
+   when framing and deframing full sized IP packets.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/mem.h"
+#include "lwip/sys.h"
+#include "pppframe.h"
+
+
+#define PPP_FLAG        0x7e
+#define PPP_ESCAPE      0x7d
+#define PPP_TRANS       0x20
+#define PPP_INITFCS     0xffff
+#define PPP_GOODFCS     0xf0b8
+
+#define ESCAPE_P(accm, c) ((accm)[(c) >> 3] & (1 << ((c) & 0x07)))
+
+static const int      packetSize = 1500;
+static const unsigned iterations = 20000;
+static int            g_failures;
+
+
+static uint64_t readNanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Receive and transmit ACCMs: all of the control characters, as used until
+   LCP has negotiated, none of them, and just XON/XOFF.  The flag and escape
+   are always set. */
+static void setAccm(u8_t* pAccm, u32_t asyncmap)
+{
+    memset(pAccm, 0, 32);
+    for (int i = 0 ; i < 4 ; i++)
+        pAccm[i] = (u8_t)(asyncmap >> (i * 8));
+    pAccm[15] = 0x60;
+}
+
+
+/* The byte at a time code which pppframe.c replaces. */
+static u16_t fcsBitwise(u16_t fcs, const u8_t* pData, int length)
+{
+    while (length-- > 0)
+    {
+        fcs ^= *pData++;
+        for (int bit = 0 ; bit < 8 ; bit++)
+            fcs = (fcs & 1) ? (fcs >> 1) ^ 0x8408 : fcs >> 1;
+    }
+    return fcs;
+}
+
+static u16_t fcsBytewise(u16_t fcs, u8_t c)
+{
+    return (fcs >> 8) ^ pppfcstab[0][(fcs ^ c) & 0xff];
+}
+
+/* Frames length bytes into a chain of buffers of PBUF_POOL_BUFSIZE bytes, as
+   the old pppWrite() did with pppAppend(). */
+static int frameBytewise(u8_t* pDest, const u8_t* pSrc, int length, const u8_t* pAccm)
+{
+    int  out = 0;
+    int  bufferLength = 0;
+    u16_t fcs = PPP_INITFCS;
+    u8_t fcsBytes[2];
+
+    pDest[out++] = PPP_FLAG;
+    bufferLength++;
+    for (int i = 0 ; i < length + 2 ; i++)
+    {
+        u8_t c;
+        if (i < length)
+        {
+            c = pSrc[i];
+            fcs = fcsBytewise(fcs, c);
+        }
+        else
+        {
+            if (i == length)
+            {
+                fcsBytes[0] = ~fcs & 0xff;
+                fcsBytes[1] = (~fcs >> 8) & 0xff;
+            }
+            c = fcsBytes[i - length];
+        }
+
+        if (PBUF_POOL_BUFSIZE - bufferLength < 2)
+            bufferLength = 0;
+        if (ESCAPE_P(pAccm, c))
+        {
+            pDest[out++] = PPP_ESCAPE;
+            pDest[out++] = c ^ PPP_TRANS;
+            bufferLength += 2;
+        }
+        else
+        {
+            pDest[out++] = c;
+            bufferLength++;
+        }
+    }
+    pDest[out++] = PPP_FLAG;
+    return out;
+}
+
+/* Frames length bytes the way pppWrite() now does, with pppfcs16() and then
+   pppframe_escape() into each buffer in turn. */
+static int frameBulk(u8_t* pDest, const u8_t* pSrc, int length, const u8_t* pAccm, int bufferSize)
+{
+    int   out = 0;
+    u16_t fcs = pppfcs16(PPP_INITFCS, pSrc, length);
+    u8_t  fcsBytes[2] = { (u8_t)(~fcs & 0xff), (u8_t)((~fcs >> 8) & 0xff) };
+    int   bufferLength = 1;
+
+    pDest[out++] = PPP_FLAG;
+    for (int part = 0 ; part < 2 ; part++)
+    {
+        const u8_t* p = part ? fcsBytes : pSrc;
+        int         n = part ? 2 : length;
+
+        while (n > 0)
+        {
+            int consumed;
+
+            if (bufferSize - bufferLength < 2)
+                bufferLength = 0;
+            int written = pppframe_escape(pDest + out, bufferSize - bufferLength, p, n, pAccm, &consumed);
+            out += written;
+            bufferLength += written;
+            p += consumed;
+            n -= consumed;
+        }
+    }
+    pDest[out++] = PPP_FLAG;
+    return out;
+}
+
+/* Receive state for the deframers.  Frames are checked and counted as their
+   closing flag arrives. */
+struct Deframer
+{
+    u8_t  packet[2048];
+    int   length;
+    u16_t fcs;
+    u8_t  escaped;
+    int   goodFrames;
+    int   badFrames;
+    int   lastLength;
+};
+
+static void endFrame(Deframer* pState)
+{
+    if (pState->length >= 4)
+    {
+        if (pState->fcs == PPP_GOODFCS)
+        {
+            pState->goodFrames++;
+            pState->lastLength = pState->length - 2;
+        }
+        else
+        {
+            pState->badFrames++;
+        }
+    }
+    pState->length = 0;
+    pState->fcs = PPP_INITFCS;
+    pState->escaped = 0;
+}
+
+/* The old pppInProc() loop, which checked the ACCM for each byte under
+   SYS_ARCH_PROTECT(). */
+static void deframeBytewise(Deframer* pState, const u8_t* pSrc, int length, const u8_t* pAccm)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    while (length-- > 0)
+    {
+        u8_t c = *pSrc++;
+        u8_t escaped;
+
+        SYS_ARCH_PROTECT(lev);
+        escaped = ESCAPE_P(pAccm, c);
+        SYS_ARCH_UNPROTECT(lev);
+        if (escaped)
+        {
+            if (c == PPP_ESCAPE)
+                pState->escaped = 1;
+            else if (c == PPP_FLAG)
+                endFrame(pState);
+            continue;
+        }
+        if (pState->escaped)
+        {
+            pState->escaped = 0;
+            c ^= PPP_TRANS;
+        }
+        if (pState->length < (int)sizeof(pState->packet))
+            pState->packet[pState->length++] = c;
+        pState->fcs = fcsBytewise(pState->fcs, c);
+    }
+}
+
+/* The new pppInProc() loop, which unescapes runs of data with
+   pppframe_unescape() into buffers of bufferSize bytes. */
+static void deframeBulk(Deframer* pState, const u8_t* pSrc, int length, const u8_t* pAccm, int bufferSize)
+{
+    while (length > 0)
+    {
+        if (*pSrc == PPP_FLAG)
+        {
+            endFrame(pState);
+            pSrc++;
+            length--;
+            continue;
+        }
+
+        int room = bufferSize - pState->length % bufferSize;
+        if (room > (int)sizeof(pState->packet) - pState->length)
+            room = sizeof(pState->packet) - pState->length;
+        u8_t* pDest = pState->packet + pState->length;
+        int   consumed;
+        int   written = pppframe_unescape(pDest, room, pSrc, length, pAccm, &pState->escaped, &consumed);
+        pState->fcs = pppfcs16(pState->fcs, pDest, written);
+        pState->length += written;
+        pSrc += consumed;
+        length -= consumed;
+        if (room == 0)
+            break;
+    }
+}
+
+
+static void validateFcs(void)
+{
+    u8_t data[256 + 4];
+
+    for (size_t i = 0 ; i < sizeof(data) ; i++)
+        data[i] = rand();
+    for (int offset = 0 ; offset < 4 ; offset++)
+    {
+        for (int length = 0 ; length <= 256 ; length++)
+        {
+            u16_t expected = fcsBitwise(PPP_INITFCS, data + offset, length);
+            u16_t actual = pppfcs16(PPP_INITFCS, data + offset, length);
+            if (actual != expected)
+            {
+                printf("FAIL: pppfcs16() +%d length %d: 0x%04x != 0x%04x\n", offset, length, actual, expected);
+                g_failures++;
+            }
+        }
+    }
+
+    // Running the FCS over the data and its complemented FCS gives the good FCS.
+    u16_t fcs = ~pppfcs16(PPP_INITFCS, data, 100);
+    data[100] = fcs & 0xff;
+    data[101] = fcs >> 8;
+    if (pppfcs16(PPP_INITFCS, data, 102) != PPP_GOODFCS)
+    {
+        printf("FAIL: pppfcs16() of a frame with its FCS isn't 0x%04x\n", PPP_GOODFCS);
+        g_failures++;
+    }
+}
+
+static void validateFraming(void)
+{
+    // The last asyncmap is extended to escape 0xff too.
+    static const u32_t asyncmaps[] = { 0xffffffff, 0x00000000, 0x000a0000, 0x00000000 };
+    const size_t       asyncmapCount = sizeof(asyncmaps) / sizeof(asyncmaps[0]);
+    static const int   bufferSizes[] = { 2, 3, 7, 64, PBUF_POOL_BUFSIZE };
+    static u8_t        packet[packetSize];
+    static u8_t        expected[packetSize * 2 + 8];
+    static u8_t        actual[packetSize * 2 + 8];
+    static u8_t        noisy[packetSize * 3 + 8];
+    u8_t               accm[32];
+
+    for (size_t a = 0 ; a < asyncmapCount ; a++)
+    {
+        setAccm(accm, asyncmaps[a]);
+        if (a == asyncmapCount - 1)
+            accm[0xff >> 3] |= 0x80;
+        for (int round = 0 ; round < 200 ; round++)
+        {
+            // Plenty of bytes which need escaping, in runs and on their own.
+            int length = 1 + rand() % packetSize;
+            for (int i = 0 ; i < length ; i++)
+            {
+                switch (rand() % 8)
+                {
+                case 0:  packet[i] = PPP_FLAG;          break;
+                case 1:  packet[i] = PPP_ESCAPE;        break;
+                case 2:  packet[i] = rand() % 0x20;     break;
+                case 3:  packet[i] = 0xff;              break;
+                default: packet[i] = rand();            break;
+                }
+            }
+
+            int expectedLength = frameBytewise(expected, packet, length, accm);
+            int bufferSize = bufferSizes[round % (sizeof(bufferSizes) / sizeof(bufferSizes[0]))];
+            int actualLength = frameBulk(actual, packet, length, accm, bufferSize);
+            if (actualLength != expectedLength || memcmp(actual, expected, expectedLength) != 0)
+            {
+                printf("FAIL: framing asyncmap %08x length %d buffer %d\n", asyncmaps[a], length, bufferSize);
+                g_failures++;
+                continue;
+            }
+
+            // Deframe it in random pieces, with control characters which
+            // are in the ACCM, and so must be dropped, inserted along the way.
+            int noisyLength = 0;
+            for (int i = 0 ; i < expectedLength ; i++)
+            {
+                if (asyncmaps[a] && rand() % 16 == 0)
+                    noisy[noisyLength++] = 0x11;
+                noisy[noisyLength++] = expected[i];
+            }
+            Deframer state;
+            memset(&state, 0, sizeof(state));
+            endFrame(&state);
+            for (int offset = 0 ; offset < noisyLength ; )
+            {
+                int piece = 1 + rand() % 64;
+                if (piece > noisyLength - offset)
+                    piece = noisyLength - offset;
+                deframeBulk(&state, noisy + offset, piece, accm, bufferSize);
+                offset += piece;
+            }
+            if (state.goodFrames != 1 || state.badFrames != 0 || state.lastLength != length ||
+                memcmp(state.packet, packet, length) != 0)
+            {
+                printf("FAIL: deframing asyncmap %08x length %d buffer %d\n", asyncmaps[a], length, bufferSize);
+                g_failures++;
+            }
+        }
+    }
+}
+
+/* Frames as they appear on the wire: an LCP Configure-Request and an IPCP
+   Configure-Request with every control character escaped, then an ICMP echo
+   request containing flag and escape bytes, sent once LCP has agreed that no
+   control characters need escaping. */
+static const u8_t g_lcpFrame[] =
+{
+    0x7e, 0xff, 0x7d, 0x23, 0xc0, 0x21, 0x7d, 0x21, 0x7d, 0x21, 0x7d, 0x20, 0x7d, 0x34, 0x7d, 0x22,
+    0x7d, 0x26, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x25, 0x7d, 0x26, 0x2a, 0x4b,
+    0x7d, 0x3c, 0x3d, 0x7d, 0x27, 0x7d, 0x22, 0x7d, 0x28, 0x7d, 0x22, 0x69, 0xeb, 0x7e
+};
+static const u8_t g_lcpPacket[] =
+{
+    0xff, 0x03, 0xc0, 0x21, 0x01, 0x01, 0x00, 0x14, 0x02, 0x06, 0x00, 0x00, 0x00, 0x00, 0x05, 0x06,
+    0x2a, 0x4b, 0x1c, 0x3d, 0x07, 0x02, 0x08, 0x02
+};
+static const u8_t g_ipcpFrame[] =
+{
+    0x7e, 0xff, 0x7d, 0x23, 0x80, 0x21, 0x7d, 0x21, 0x7d, 0x21, 0x7d, 0x20, 0x7d, 0x36, 0x7d, 0x23,
+    0x7d, 0x26, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x81, 0x7d, 0x26, 0x7d, 0x20, 0x7d,
+    0x20, 0x7d, 0x20, 0x7d, 0x20, 0x83, 0x7d, 0x26, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20, 0x7d, 0x20,
+    0x6e, 0xdb, 0x7e
+};
+static const u8_t g_ipcpPacket[] =
+{
+    0xff, 0x03, 0x80, 0x21, 0x01, 0x01, 0x00, 0x16, 0x03, 0x06, 0x00, 0x00, 0x00, 0x00, 0x81, 0x06,
+    0x00, 0x00, 0x00, 0x00, 0x83, 0x06, 0x00, 0x00, 0x00, 0x00
+};
+static const u8_t g_ipFrame[] =
+{
+    0x7e, 0xff, 0x03, 0x00, 0x21, 0x45, 0x00, 0x00, 0x2c, 0x1a, 0x2b, 0x00, 0x00, 0x40, 0x01, 0x00,
+    0x00, 0x0a, 0x40, 0x00, 0x01, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x7d, 0x5e, 0x7d, 0x5d, 0x00,
+    0x01, 0x00, 0x01, 0x7d, 0x5e, 0x7d, 0x5d, 0x7d, 0x5e, 0x7d, 0x5d, 0x11, 0x13, 0x00, 0x1f, 0x20,
+    0x7d, 0x5e, 0x20, 0x20, 0x20, 0x7d, 0x5d, 0x7d, 0x5d, 0x7d, 0x5d, 0x00, 0x11, 0x22, 0x33, 0x54,
+    0xf7, 0x7e
+};
+static const u8_t g_ipPacket[] =
+{
+    0xff, 0x03, 0x00, 0x21, 0x45, 0x00, 0x00, 0x2c, 0x1a, 0x2b, 0x00, 0x00, 0x40, 0x01, 0x00, 0x00,
+    0x0a, 0x40, 0x00, 0x01, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x7e, 0x7d, 0x00, 0x01, 0x00, 0x01,
+    0x7e, 0x7d, 0x7e, 0x7d, 0x11, 0x13, 0x00, 0x1f, 0x20, 0x7e, 0x20, 0x20, 0x20, 0x7d, 0x7d, 0x7d,
+    0x00, 0x11, 0x22, 0x33
+};
+
+static void checkWireFrame(const char* pName, const u8_t* pFrame, int frameLength,
+                           const u8_t* pPacket, int packetLength, u32_t asyncmap)
+{
+    u8_t accm[32];
+    u8_t framed[256];
+
+    setAccm(accm, asyncmap);
+    for (int pieceSize = 1 ; pieceSize <= frameLength ; pieceSize++)
+    {
+        Deframer state;
+        memset(&state, 0, sizeof(state));
+        endFrame(&state);
+        for (int offset = 0 ; offset < frameLength ; offset += pieceSize)
+        {
+            int piece = frameLength - offset < pieceSize ? frameLength - offset : pieceSize;
+            deframeBulk(&state, pFrame + offset, piece, accm, PBUF_POOL_BUFSIZE);
+        }
+        if (state.goodFrames != 1 || state.badFrames != 0 || state.lastLength != packetLength ||
+            memcmp(state.packet, pPacket, packetLength) != 0)
+        {
+            printf("FAIL: %s frame in pieces of %d bytes\n", pName, pieceSize);
+            g_failures++;
+            break;
+        }
+    }
+
+    int framedLength = frameBulk(framed, pPacket, packetLength, accm, PBUF_POOL_BUFSIZE);
+    if (framedLength != frameLength || memcmp(framed, pFrame, frameLength) != 0)
+    {
+        printf("FAIL: %s frame isn't reproduced by frameBulk()\n", pName);
+        g_failures++;
+    }
+}
+
+static void validateWireFrames(void)
+{
+    checkWireFrame("LCP", g_lcpFrame, sizeof(g_lcpFrame), g_lcpPacket, sizeof(g_lcpPacket), 0xffffffff);
+    checkWireFrame("IPCP", g_ipcpFrame, sizeof(g_ipcpFrame), g_ipcpPacket, sizeof(g_ipcpPacket), 0xffffffff);
+    checkWireFrame("IP", g_ipFrame, sizeof(g_ipFrame), g_ipPacket, sizeof(g_ipPacket), 0);
+}
+
+
+static void benchmark(u32_t asyncmap, const char* pAsyncmapName)
+{
+    static u8_t packet[packetSize];
+    static u8_t framed[packetSize * 2 + 8];
+    u8_t        accm[32];
+    int         framedLength = 0;
+    Deframer    state;
+
+    setAccm(accm, asyncmap);
+    for (int i = 0 ; i < packetSize ; i++)
+        packet[i] = rand();
+
+    uint64_t start = readNanoseconds();
+    for (unsigned int i = 0 ; i < iterations ; i++)
+        framedLength = frameBytewise(framed, packet, packetSize, accm);
+    uint64_t byteFrame = readNanoseconds() - start;
+
+    start = readNanoseconds();
+    for (unsigned int i = 0 ; i < iterations ; i++)
+        framedLength = frameBulk(framed, packet, packetSize, accm, PBUF_POOL_BUFSIZE);
+    uint64_t bulkFrame = readNanoseconds() - start;
+
+    memset(&state, 0, sizeof(state));
+    endFrame(&state);
+    start = readNanoseconds();
+    for (unsigned int i = 0 ; i < iterations ; i++)
+        deframeBytewise(&state, framed, framedLength, accm);
+    uint64_t byteDeframe = readNanoseconds() - start;
+
+    memset(&state, 0, sizeof(state));
+    endFrame(&state);
+    start = readNanoseconds();
+    for (unsigned int i = 0 ; i < iterations ; i++)
+        deframeBulk(&state, framed, framedLength, accm, PBUF_POOL_BUFSIZE);
+    uint64_t bulkDeframe = readNanoseconds() - start;
+    if (state.goodFrames != (int)iterations)
+    {
+        printf("FAIL: only %d of %u frames were good\n", state.goodFrames, iterations);
+        g_failures++;
+    }
+
+    double megabytes = (double)packetSize * iterations / (1024.0 * 1024.0);
+    printf("asyncmap %-10s frame  : %7.1f MB/s byte at a time, %7.1f MB/s bulk\n",
+           pAsyncmapName, megabytes / (byteFrame / 1e9), megabytes / (bulkFrame / 1e9));
+    printf("asyncmap %-10s deframe: %7.1f MB/s byte at a time, %7.1f MB/s bulk\n",
+           pAsyncmapName, megabytes / (byteDeframe / 1e9), megabytes / (bulkDeframe / 1e9));
+}
+
+
+int main(void)
+{
+    sys_init();
+
+    validateFcs();
+    validateFraming();
+    validateWireFrames();
+    printf("PPP framing validation: %s\n", g_failures ? "FAILED" : "passed");
+    if (g_failures)
+        return 1;
+
+    benchmark(0x00000000, "00000000");
+    benchmark(0xffffffff, "ffffffff");
+
+    return g_failures ? 1 : 0;
+}
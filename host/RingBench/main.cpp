@@ -0,0 +1,497 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Checks mbed::SPSCRingBuffer, including its wakeups between a writer and a
+   reader thread, and then compares its cost per byte with MtxCircBuffer, the
+   mutex protected buffer it replaces in the cellular serial streams and
+   USBHostSerial, both from one thread and between two.  The cellular stack's
+   copy of MtxCircBuffer.h lives on here as it has no other users.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include "SPSCRingBuffer.h"
+#include "MtxCircBuffer.h"
+
+using namespace mbed;
+
+
+typedef SPSCRingBuffer<uint8_t, 256> Ring;
+typedef MtxCircBuffer<uint8_t, 256>  MtxRing;
+
+static const uint32_t threadBytes = 8 * 1024 * 1024;
+static const uint32_t benchBytes = 32 * 1024 * 1024;
+static const uint32_t chunkSize = 64;
+static int            g_failures;
+
+
+#define CHECK(X) \
+    do \
+    { \
+        if (!(X)) \
+        { \
+            printf("FAIL: line %d: %s\n", __LINE__, #X); \
+            g_failures++; \
+        } \
+    } while (0)
+
+
+static uint64_t readNanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+static void testItems(void)
+{
+    Ring    ring;
+    uint8_t c = 0;
+
+    CHECK(ring.empty() && ring.available() == 0 && ring.space() == 256);
+    CHECK(!ring.get(&c));
+    for (int i = 0 ; i < 256 ; i++)
+        CHECK(ring.put(i));
+    CHECK(ring.full() && ring.available() == 256 && ring.space() == 0);
+    CHECK(!ring.put(0xff));
+    for (int i = 0 ; i < 256 ; i++)
+        CHECK(ring.get(&c) && c == (uint8_t)i);
+    CHECK(ring.empty() && !ring.get(&c));
+}
+
+static void testBulk(void)
+{
+    Ring     ring;
+    uint8_t  out[300];
+    uint8_t  in[300];
+    uint32_t written = 0;
+    uint32_t read = 0;
+
+    // Lengths which aren't a factor of the size move the wrap point around.
+    for (int round = 0 ; round < 50 ; round++)
+    {
+        uint32_t length = 1 + (round * 37) % 200;
+        for (uint32_t i = 0 ; i < length ; i++)
+            out[i] = (uint8_t)(written + i);
+        CHECK(ring.write(out, length) == length);
+        written += length;
+
+        CHECK(ring.read(in, length) == length);
+        for (uint32_t i = 0 ; i < length ; i++)
+            CHECK(in[i] == (uint8_t)(read + i));
+        read += length;
+    }
+
+    // Only what fits is written and only what is there is read.
+    CHECK(ring.write(out, 300) == 256);
+    CHECK(ring.write(out, 1) == 0);
+    CHECK(ring.read(in, 300) == 256);
+    CHECK(memcmp(in, out, 256) == 0);
+    CHECK(ring.read(in, 1) == 0);
+}
+
+static void testSpans(void)
+{
+    Ring           ring;
+    uint8_t*       pWrite;
+    const uint8_t* pRead;
+    uint8_t        c;
+
+    for (int i = 0 ; i < 200 ; i++)
+    {
+        ring.put(i);
+        ring.get(&c);
+    }
+
+    // The free slots wrap at the end of the buffer.
+    CHECK(ring.write_span(&pWrite) == 56);
+    memset(pWrite, 0xaa, 56);
+    ring.commit(56);
+    CHECK(ring.write_span(&pWrite) == 200);
+    memset(pWrite, 0x55, 10);
+    ring.commit(10);
+    CHECK(ring.available() == 66);
+
+    CHECK(ring.read_span(&pRead) == 56);
+    CHECK(pRead[0] == 0xaa && pRead[55] == 0xaa);
+    ring.consume(56);
+    CHECK(ring.read_span(&pRead) == 10);
+    CHECK(pRead[0] == 0x55 && pRead[9] == 0x55);
+    ring.consume(10);
+    CHECK(ring.empty() && ring.read_span(&pRead) == 0);
+}
+
+static void testWakeups(void)
+{
+    Ring    ring;
+    uint8_t data[256];
+    uint8_t c;
+
+    memset(data, 0, sizeof(data));
+
+    // The reader is only woken once what it asked for is there, and just once.
+    CHECK(!ring.reader_wakeup());
+    CHECK(!ring.arm_reader(10));
+    ring.write(data, 9);
+    CHECK(!ring.reader_wakeup());
+    ring.put(0);
+    CHECK(ring.reader_wakeup());
+    CHECK(!ring.reader_wakeup());
+
+    // Nothing is due when the items are there already or after a disarm.
+    CHECK(ring.arm_reader(10));
+    CHECK(!ring.reader_wakeup());
+    CHECK(!ring.arm_reader(20));
+    ring.disarm_reader();
+    ring.write(data, 20);
+    CHECK(!ring.reader_wakeup());
+
+    // Same for the writer, waiting for space.
+    ring.write(data, sizeof(data));
+    CHECK(ring.full());
+    CHECK(!ring.arm_writer(2));
+    ring.get(&c);
+    CHECK(!ring.writer_wakeup());
+    ring.read(data, 1);
+    CHECK(ring.writer_wakeup());
+    CHECK(!ring.writer_wakeup());
+    CHECK(ring.arm_writer(2));
+    CHECK(!ring.writer_wakeup());
+}
+
+
+/* A writer and a reader thread move a counting pattern through the buffer in
+   chunks of varying sizes.  Each waits on a semaphore, with a timeout which
+   catches lost wakeups, for a varying number of items or free slots. */
+struct ThreadTest
+{
+    Ring     ring;
+    sem_t    readable;
+    sem_t    writable;
+    uint32_t lostWakeups;
+    uint32_t mismatches;
+    uint32_t waits;
+};
+
+static bool waitFor(sem_t* pSemaphore)
+{
+    struct timespec timeout;
+
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_sec += 2;
+    while (sem_timedwait(pSemaphore, &timeout) != 0)
+    {
+        if (errno != EINTR)
+            return false;
+    }
+    return true;
+}
+
+static void* writeThread(void* pv)
+{
+    ThreadTest*  pTest = (ThreadTest*)pv;
+    uint8_t      chunk[chunkSize * 2];
+    unsigned int seed = 1;
+    uint32_t     written = 0;
+
+    while (written < threadBytes)
+    {
+        uint32_t length = 1 + rand_r(&seed) % sizeof(chunk);
+        if (length > threadBytes - written)
+            length = threadBytes - written;
+        for (uint32_t i = 0 ; i < length ; i++)
+            chunk[i] = (uint8_t)(written + i);
+
+        uint32_t done = 0;
+        while (done < length)
+        {
+            if (length - done == 1)
+                done += pTest->ring.put(chunk[done]) ? 1 : 0;
+            else
+                done += pTest->ring.write(chunk + done, length - done);
+            if (pTest->ring.reader_wakeup())
+                sem_post(&pTest->readable);
+            if (done < length && !pTest->ring.arm_writer(1 + rand_r(&seed) % (length - done)))
+            {
+                pTest->waits++;
+                if (!waitFor(&pTest->writable))
+                {
+                    pTest->lostWakeups++;
+                    pTest->ring.disarm_writer();
+                }
+            }
+        }
+        written += length;
+    }
+    return NULL;
+}
+
+static void* readThread(void* pv)
+{
+    ThreadTest*  pTest = (ThreadTest*)pv;
+    uint8_t      chunk[chunkSize * 2];
+    unsigned int seed = 2;
+    uint32_t     read = 0;
+
+    while (read < threadBytes)
+    {
+        uint32_t wanted = 1 + rand_r(&seed) % chunkSize;
+        if (wanted > threadBytes - read)
+            wanted = threadBytes - read;
+        if (!pTest->ring.arm_reader(wanted))
+        {
+            pTest->waits++;
+            if (!waitFor(&pTest->readable))
+            {
+                pTest->lostWakeups++;
+                pTest->ring.disarm_reader();
+            }
+        }
+
+        uint32_t length = pTest->ring.read(chunk, 1 + rand_r(&seed) % sizeof(chunk));
+        for (uint32_t i = 0 ; i < length ; i++)
+        {
+            if (chunk[i] != (uint8_t)(read + i))
+                pTest->mismatches++;
+        }
+        read += length;
+        if (pTest->ring.writer_wakeup())
+            sem_post(&pTest->writable);
+    }
+    return NULL;
+}
+
+static void testThreads(void)
+{
+    static ThreadTest test;
+    pthread_t         threads[2];
+
+    sem_init(&test.readable, 0, 0);
+    sem_init(&test.writable, 0, 0);
+    pthread_create(&threads[0], NULL, writeThread, &test);
+    pthread_create(&threads[1], NULL, readThread, &test);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    sem_destroy(&test.readable);
+    sem_destroy(&test.writable);
+
+    printf("threads: %u bytes, %u waits, %u lost wakeups, %u corrupt bytes\n",
+           threadBytes, test.waits, test.lostWakeups, test.mismatches);
+    CHECK(test.lostWakeups == 0);
+    CHECK(test.mismatches == 0);
+}
+
+
+/* One thread fills the buffer with a chunk and then empties it again, the way
+   a receive interrupt and the thread reading the stream take turns on a
+   single core. */
+static void benchMutex(void)
+{
+    static MtxRing ring;
+    uint8_t        c = 0;
+    uint32_t       sum = 0;
+
+    uint64_t start = readNanoseconds();
+    for (uint32_t offset = 0 ; offset < benchBytes ; offset += chunkSize)
+    {
+        for (uint32_t i = 0 ; i < chunkSize ; i++)
+            ring.queue((uint8_t)i);
+        for (uint32_t i = 0 ; i < chunkSize ; i++)
+        {
+            ring.dequeue(&c);
+            sum += c;
+        }
+    }
+    uint64_t elapsed = readNanoseconds() - start;
+
+    printf("MtxCircBuffer queue/dequeue : %6.2f ns/byte (%u)\n", (double)elapsed / benchBytes, sum & 1);
+}
+
+static void benchItems(void)
+{
+    static Ring ring;
+    uint8_t     c = 0;
+    uint32_t    sum = 0;
+
+    uint64_t start = readNanoseconds();
+    for (uint32_t offset = 0 ; offset < benchBytes ; offset += chunkSize)
+    {
+        for (uint32_t i = 0 ; i < chunkSize ; i++)
+            ring.put((uint8_t)i);
+        for (uint32_t i = 0 ; i < chunkSize ; i++)
+        {
+            ring.get(&c);
+            sum += c;
+        }
+    }
+    uint64_t elapsed = readNanoseconds() - start;
+
+    printf("SPSCRingBuffer put/get      : %6.2f ns/byte (%u)\n", (double)elapsed / benchBytes, sum & 1);
+}
+
+static void benchBulk(void)
+{
+    static Ring ring;
+    uint8_t     out[chunkSize];
+    uint8_t     in[chunkSize];
+    uint32_t    sum = 0;
+
+    for (uint32_t i = 0 ; i < chunkSize ; i++)
+        out[i] = i;
+
+    uint64_t start = readNanoseconds();
+    for (uint32_t offset = 0 ; offset < benchBytes ; offset += chunkSize)
+    {
+        ring.write(out, chunkSize);
+        ring.read(in, chunkSize);
+        sum += in[offset & (chunkSize - 1)];
+    }
+    uint64_t elapsed = readNanoseconds() - start;
+
+    printf("SPSCRingBuffer write/read   : %6.2f ns/byte (%u)\n", (double)elapsed / benchBytes, sum & 1);
+}
+
+
+/* A writer and a reader thread which spin, yielding, while the buffer is full
+   or empty. */
+enum Method
+{
+    METHOD_MUTEX,
+    METHOD_ITEMS,
+    METHOD_BULK
+};
+
+struct StreamTest
+{
+    Method  method;
+    MtxRing mtxRing;
+    Ring    ring;
+};
+
+static void* streamWriter(void* pv)
+{
+    StreamTest* pTest = (StreamTest*)pv;
+    uint8_t     chunk[chunkSize];
+
+    memset(chunk, 0x5a, sizeof(chunk));
+    for (uint32_t written = 0 ; written < benchBytes ; )
+    {
+        switch (pTest->method)
+        {
+        case METHOD_MUTEX:
+            // queue() drops the oldest byte once it fills the buffer, so
+            // stop while there is room for two.
+            if (pTest->mtxRing.available() >= 256 - 2)
+                sched_yield();
+            else
+            {
+                pTest->mtxRing.queue(chunk[written & (chunkSize - 1)]);
+                written++;
+            }
+            break;
+        case METHOD_ITEMS:
+            if (pTest->ring.put(chunk[written & (chunkSize - 1)]))
+                written++;
+            else
+                sched_yield();
+            break;
+        case METHOD_BULK:
+        {
+            uint32_t length = benchBytes - written;
+            if (length > chunkSize)
+                length = chunkSize;
+            uint32_t done = pTest->ring.write(chunk, length);
+            if (done == 0)
+                sched_yield();
+            written += done;
+            break;
+        }
+        }
+    }
+    return NULL;
+}
+
+static void* streamReader(void* pv)
+{
+    StreamTest* pTest = (StreamTest*)pv;
+    uint8_t     chunk[chunkSize];
+
+    for (uint32_t read = 0 ; read < benchBytes ; )
+    {
+        uint32_t done = 0;
+        switch (pTest->method)
+        {
+        case METHOD_MUTEX:
+            done = pTest->mtxRing.dequeue(chunk) ? 1 : 0;
+            break;
+        case METHOD_ITEMS:
+            done = pTest->ring.get(chunk) ? 1 : 0;
+            break;
+        case METHOD_BULK:
+            done = pTest->ring.read(chunk, sizeof(chunk));
+            break;
+        }
+        if (done == 0)
+            sched_yield();
+        read += done;
+    }
+    return NULL;
+}
+
+static void benchThreads(Method method, const char* pName)
+{
+    static StreamTest test;
+    pthread_t         threads[2];
+
+    test.method = method;
+    test.ring.reset();
+    uint64_t start = readNanoseconds();
+    pthread_create(&threads[0], NULL, streamWriter, &test);
+    pthread_create(&threads[1], NULL, streamReader, &test);
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+    uint64_t elapsed = readNanoseconds() - start;
+
+    printf("%-28s: %7.1f MB/s between threads\n", pName, benchBytes / (elapsed / 1e9) / (1024 * 1024));
+}
+
+
+int main(void)
+{
+    testItems();
+    testBulk();
+    testSpans();
+    testWakeups();
+    testThreads();
+    printf("SPSCRingBuffer validation: %s\n", g_failures ? "FAILED" : "passed");
+    if (g_failures)
+        return 1;
+
+    benchMutex();
+    benchItems();
+    benchBulk();
+    benchThreads(METHOD_MUTEX, "MtxCircBuffer queue/dequeue");
+    benchThreads(METHOD_ITEMS, "SPSCRingBuffer put/get");
+    benchThreads(METHOD_BULK, "SPSCRingBuffer write/read");
+
+    return 0;
+}
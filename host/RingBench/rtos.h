@@ -0,0 +1,55 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Just enough of the rtos library for MtxCircBuffer.h to be built on the host.
+   Like rtos::Mutex, the mutex is recursive, which MtxCircBuffer::queue()
+   relies on. */
+#ifndef RTOS_H
+#define RTOS_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+
+class Mutex
+{
+public:
+    Mutex()
+    {
+        pthread_mutexattr_t attributes;
+
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&m_mutex, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+    }
+    ~Mutex()
+    {
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    void lock()
+    {
+        pthread_mutex_lock(&m_mutex);
+    }
+    void unlock()
+    {
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+protected:
+    pthread_mutex_t m_mutex;
+};
+
+#endif /* RTOS_H */
@@ -0,0 +1,32 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* The pins which parse_pins() knows about on every target. */
+#ifndef MBED_PINNAMES_H
+#define MBED_PINNAMES_H
+
+typedef enum
+{
+    LED1,
+    LED2,
+    LED3,
+    LED4,
+    USBTX,
+    USBRX,
+
+    // Not connected
+    NC = (int)0xFFFFFFFF
+} PinName;
+
+#endif /* MBED_PINNAMES_H */
@@ -0,0 +1,52 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* The character I/O of mbed::Stream, which on the device goes through the C
+   library's FILE for the stream.  The host writes straight to _putc(). */
+#ifndef MBED_STREAM_H
+#define MBED_STREAM_H
+
+#include "platform.h"
+
+namespace mbed {
+
+class Stream
+{
+public:
+    Stream(const char* pName = NULL) {}
+    virtual ~Stream() {}
+
+    int putc(int c)
+    {
+        return _putc(c);
+    }
+    int puts(const char* pString)
+    {
+        while (*pString)
+            _putc(*pString++);
+        return 0;
+    }
+    int getc()
+    {
+        return _getc();
+    }
+
+protected:
+    virtual int _putc(int c) = 0;
+    virtual int _getc() = 0;
+};
+
+} // namespace mbed
+
+#endif /* MBED_STREAM_H */
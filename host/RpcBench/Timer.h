@@ -0,0 +1,50 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* mbed::Timer counting the milliseconds which the bench sets in
+   g_hostMilliseconds, so that it can step through subscription periods. */
+#ifndef MBED_TIMER_H
+#define MBED_TIMER_H
+
+#include "platform.h"
+
+extern uint32_t g_hostMilliseconds;
+
+namespace mbed {
+
+class Timer
+{
+public:
+    Timer() : m_start(g_hostMilliseconds) {}
+
+    void start()
+    {
+        m_start = g_hostMilliseconds;
+    }
+    void reset()
+    {
+        m_start = g_hostMilliseconds;
+    }
+    int read_ms()
+    {
+        return g_hostMilliseconds - m_start;
+    }
+
+protected:
+    uint32_t m_start;
+};
+
+} // namespace mbed
+
+#endif /* MBED_TIMER_H */
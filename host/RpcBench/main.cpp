@@ -0,0 +1,871 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Checks the hashed object index and method cache of the mbed RPC dispatcher,
+   with the requests of tests/mbed/rpc and with hundreds of objects, and the
+   text batches, binary frames and subscriptions of RPCStream over a loopback
+   stream.  It then reports how many requests per second RPC::call() serves
+   as the number of objects grows, and what it takes to read 50 variables
+   over a stream each way.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rpc.h"
+#include "RPCVariable.h"
+#include "RPCFunction.h"
+#include "RPCStream.h"
+
+using namespace mbed;
+
+
+static const int maxObjects = 1024;
+static const int benchRequests = 1000000;
+static int       g_failures;
+
+
+#define CHECK(X) \
+    do \
+    { \
+        if (!(X)) \
+        { \
+            printf("FAIL: line %d: %s\n", __LINE__, #X); \
+            g_failures++; \
+        } \
+    } while (0)
+
+
+static uint64_t readNanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/* Stands in for RpcDigitalOut, which needs the target's DigitalOut. */
+class RpcCounter : public RPC
+{
+public:
+    RpcCounter(int value, const char* pName = NULL) : RPC(pName), m_value(value) {}
+
+    void write(int value) { m_value = value; }
+    int  read(void) { return m_value; }
+    void increment(void) { m_value++; }
+
+    virtual const struct rpc_method* get_rpc_methods()
+    {
+        static const rpc_method rpc_methods[] =
+        {
+            {"write", rpc_method_caller<RpcCounter, int, &RpcCounter::write>},
+            {"read", rpc_method_caller<int, RpcCounter, &RpcCounter::read>},
+            {"increment", rpc_method_caller<RpcCounter, &RpcCounter::increment>},
+            RPC_METHOD_SUPER(RPC)
+        };
+        return rpc_methods;
+    }
+    static struct rpc_class* get_rpc_class()
+    {
+        static const rpc_function funcs[] =
+        {
+            {"new", rpc_function_caller<const char*, int, const char*, &RPC::construct<RpcCounter, int, const char*> >},
+            RPC_METHOD_END
+        };
+        static rpc_class c = {"Counter", funcs, NULL};
+        return &c;
+    }
+
+private:
+    int m_value;
+};
+
+
+/* parse_pins.cpp only knows the pins of real targets. */
+PinName mbed::parse_pins(const char* pString)
+{
+    if (strncmp(pString, "LED", 3) == 0 && pString[3] >= '1' && pString[3] <= '4')
+        return (PinName)(LED1 + pString[3] - '1');
+    return NC;
+}
+
+
+static bool call(const char* pRequest, const char* pExpected)
+{
+    char reply[RPC_MAX_STRING];
+
+    if (!RPC::call(pRequest, reply))
+    {
+        printf("FAIL: %s: call failed\n", pRequest);
+        g_failures++;
+        return false;
+    }
+    if (strcmp(reply, pExpected) != 0)
+    {
+        printf("FAIL: %s: '%s' != '%s'\n", pRequest, reply, pExpected);
+        g_failures++;
+        return false;
+    }
+    return true;
+}
+
+static bool fails(const char* pRequest)
+{
+    char reply[RPC_MAX_STRING];
+
+    return !RPC::call(pRequest, reply);
+}
+
+
+static void triple(Arguments* pArgs, Reply* pReply)
+{
+    pReply->putData<int>(pArgs->getArg<int>() * 3);
+}
+
+/* The requests of tests/mbed/rpc, with Counter in place of DigitalOut. */
+static void testRequests(void)
+{
+    float f = 0;
+
+    RPCVariable<float> rpcFloat(&f, "f");
+    call("/f/write 1", "");
+    call("/f/read", "1");
+    CHECK(f == 1.0f);
+
+    RPCFunction rpcTriple(&triple, "triple");
+    call("/triple/run 14", "42");
+
+    RPC::add_rpc_class<RpcCounter>();
+    call("/Counter/new 7 c2", "c2");
+    call("/c2/read", "7");
+    call("/c2/write 1", "");
+    call("/c2/increment", "");
+    call("/c2/read", "2");
+
+    RpcCounter rpcCounter(5, "c1");
+    call("/c1/write 1", "");
+    call("/c1/read", "1");
+
+    call("/", "c1 c2 triple f Counter RPC");
+    call("/f", "read write delete");
+    call("/triple", "run delete");
+    call("/Counter", "new");
+    call("/c1", "write read increment delete");
+
+    CHECK(fails("/c3/read"));
+    CHECK(fails("/c1/reed"));
+    CHECK(fails("/c1/readx"));
+    CHECK(fails("/Counter/old"));
+
+    call("/c2/delete", "");
+    call("/", "c1 triple f Counter RPC");
+    CHECK(RPC::lookup("c2") == NULL);
+    CHECK(fails("/c2/read"));
+
+    // Objects which weren't created over rpc stay.
+    call("/c1/delete", "");
+    CHECK(RPC::lookup("c1") == &rpcCounter);
+    call("/Counter/new 3 c3", "c3");
+    call("/RPC/objects", "c3");
+    call("/RPC/clear", "");
+    call("/", "c1 triple f Counter RPC");
+}
+
+/* The same method names, in different classes, go to the right class. */
+static void testSharedMethodNames(void)
+{
+    int                value = 10;
+    RPCVariable<int>   rpcInt(&value, "int");
+    RpcCounter         rpcCounter(20, "counter");
+
+    for (int i = 0 ; i < 3 ; i++)
+    {
+        call("/int/read", "10");
+        call("/counter/read", "20");
+        call("/int/write 11", "");
+        call("/counter/write 21", "");
+        call("/int/read", "11");
+        call("/counter/read", "21");
+        call("/int/write 10", "");
+        call("/counter/write 20", "");
+        CHECK(fails("/int/increment"));
+    }
+}
+
+/* Names are significant up to MBED_OBJECT_NAME_MAX - 1 characters. */
+static void testLongNames(void)
+{
+    char longName[MBED_OBJECT_NAME_MAX + 8];
+    char request[RPC_MAX_STRING];
+    int  value = 99;
+
+    memset(longName, 'n', sizeof(longName) - 1);
+    longName[sizeof(longName) - 1] = '\0';
+    RPCVariable<int> rpcLong(&value, longName);
+
+    CHECK(RPC::lookup(longName) == &rpcLong);
+    longName[MBED_OBJECT_NAME_MAX - 1] = '\0';
+    CHECK(RPC::lookup(longName) == &rpcLong);
+    longName[MBED_OBJECT_NAME_MAX - 2] = '\0';
+    CHECK(RPC::lookup(longName) == NULL);
+
+    snprintf(request, sizeof(request), "/%s/read", longName);
+    CHECK(fails(request));
+    longName[MBED_OBJECT_NAME_MAX - 2] = 'n';
+    snprintf(request, sizeof(request), "/%s/read", longName);
+    call(request, "99");
+
+    RpcCounter unnamed(0);
+    char       name[MBED_OBJECT_NAME_MAX];
+    snprintf(name, sizeof(name), "obj%p", &unnamed);
+    CHECK(RPC::lookup(name) == &unnamed);
+}
+
+/* Enough objects that every bucket holds several. */
+static void testManyObjects(void)
+{
+    static RPCVariable<int>* objects[maxObjects];
+    static int               values[maxObjects];
+    char                     name[16];
+    char                     request[32];
+    char                     expected[16];
+
+    for (int i = 0 ; i < maxObjects ; i++)
+    {
+        values[i] = i * 7;
+        snprintf(name, sizeof(name), "var%d", i);
+        objects[i] = new RPCVariable<int>(&values[i], name);
+    }
+    for (int i = 0 ; i < maxObjects ; i++)
+    {
+        snprintf(name, sizeof(name), "var%d", i);
+        CHECK(RPC::lookup(name) == objects[i]);
+    }
+
+    // Delete every other object, from the middle of bucket chains.
+    for (int i = 0 ; i < maxObjects ; i += 2)
+    {
+        delete objects[i];
+        objects[i] = NULL;
+    }
+    for (int i = 0 ; i < maxObjects ; i++)
+    {
+        snprintf(name, sizeof(name), "var%d", i);
+        snprintf(request, sizeof(request), "/var%d/read", i);
+        snprintf(expected, sizeof(expected), "%d", i * 7);
+        if (objects[i])
+        {
+            CHECK(RPC::lookup(name) == objects[i]);
+            call(request, expected);
+        }
+        else
+        {
+            CHECK(RPC::lookup(name) == NULL);
+            CHECK(fails(request));
+        }
+    }
+
+    for (int i = 1 ; i < maxObjects ; i += 2)
+        delete objects[i];
+    call("/", "Counter RPC");
+}
+
+
+/* The server's end of a loopback link.  What RPCStream writes is collected
+   for the checks, and what the client sends is passed to receive(). */
+class LoopbackStream : public Stream
+{
+public:
+    LoopbackStream() : m_length(0) {}
+
+    void clear()
+    {
+        m_length = 0;
+    }
+    const uint8_t* data()
+    {
+        m_data[m_length] = '\0';
+        return m_data;
+    }
+    size_t length()
+    {
+        return m_length;
+    }
+
+protected:
+    virtual int _putc(int c)
+    {
+        if (m_length < sizeof(m_data) - 1)
+            m_data[m_length++] = c;
+        return c;
+    }
+    virtual int _getc()
+    {
+        return EOF;
+    }
+
+    uint8_t m_data[64 * 1024];
+    size_t  m_length;
+};
+
+uint32_t g_hostMilliseconds;
+
+static void send(RPCStream* pServer, const void* pData, size_t length)
+{
+    const uint8_t* p = (const uint8_t*)pData;
+
+    while (length--)
+        pServer->receive(*p++);
+}
+
+static void sendText(RPCStream* pServer, const char* pText)
+{
+    send(pServer, pText, strlen(pText));
+}
+
+static bool replied(LoopbackStream* pStream, const char* pExpected)
+{
+    bool matched = pStream->length() == strlen(pExpected) && memcmp(pStream->data(), pExpected, pStream->length()) == 0;
+
+    if (!matched)
+        printf("FAIL: '%s' != '%s'\n", pStream->data(), pExpected);
+    pStream->clear();
+    return matched;
+}
+
+
+/* Builds the calls of a binary request frame, as a client would. */
+class BinaryRequest
+{
+public:
+    BinaryRequest()
+    {
+        m_length = 3;
+    }
+
+    BinaryRequest& call(const char* pObject, const char* pMethod, int argc = 0)
+    {
+        string(pObject);
+        string(pMethod);
+        m_data[m_length++] = argc;
+        return *this;
+    }
+    BinaryRequest& string(const char* pString)
+    {
+        size_t length = strlen(pString);
+        m_data[m_length++] = length;
+        memcpy(&m_data[m_length], pString, length);
+        m_length += length;
+        return *this;
+    }
+    BinaryRequest& stringArg(const char* pString)
+    {
+        m_data[m_length++] = RPC_TYPE_STRING;
+        return string(pString);
+    }
+    BinaryRequest& intArg(int32_t value)
+    {
+        m_data[m_length++] = RPC_TYPE_INT;
+        putInt(value);
+        return *this;
+    }
+    BinaryRequest& floatArg(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        m_data[m_length++] = RPC_TYPE_FLOAT;
+        putInt(bits);
+        return *this;
+    }
+    BinaryRequest& raw(uint8_t byte)
+    {
+        m_data[m_length++] = byte;
+        return *this;
+    }
+
+    const uint8_t* frame()
+    {
+        m_data[0] = RPC_FRAME_REQUEST;
+        m_data[1] = (m_length - 3) & 0xFF;
+        m_data[2] = (m_length - 3) >> 8;
+        return m_data;
+    }
+    size_t length()
+    {
+        return m_length;
+    }
+
+protected:
+    void putInt(uint32_t value)
+    {
+        for (int i = 0 ; i < 4 ; i++)
+            m_data[m_length++] = value >> (8 * i);
+    }
+
+    uint8_t m_data[1024];
+    size_t  m_length;
+};
+
+/* Walks the calls of a reply frame. */
+class BinaryReply
+{
+public:
+    BinaryReply(LoopbackStream* pStream, int type = RPC_FRAME_REPLY)
+    {
+        const uint8_t* p = pStream->data();
+        m_pNext = p + 3;
+        m_pEnd = m_pNext + (p[1] | (p[2] << 8));
+        m_valid = pStream->length() >= 3 && p[0] == type && (size_t)(m_pEnd - p) == pStream->length();
+        pStream->clear();
+    }
+
+    bool valid()
+    {
+        return m_valid;
+    }
+    bool done()
+    {
+        return m_pNext == m_pEnd;
+    }
+    bool status(int expected, int length)
+    {
+        if (!m_valid || m_pEnd - m_pNext < 2 || m_pNext[0] != expected || m_pNext[1] != length)
+            return false;
+        m_pNext += 2;
+        return true;
+    }
+    bool overflowed()
+    {
+        // The values which fitted are kept.
+        if (!m_valid || m_pEnd - m_pNext < 2 || m_pNext[0] != RPC_STATUS_OVERFLOW)
+            return false;
+        m_pNext += 2 + m_pNext[1];
+        return true;
+    }
+    bool name(const char* pExpected)
+    {
+        size_t length = strlen(pExpected);
+        if (!m_valid || m_pNext[0] != length || memcmp(m_pNext + 1, pExpected, length) != 0)
+            return false;
+        m_pNext += 1 + length;
+        return true;
+    }
+    bool intValue(int32_t expected)
+    {
+        if (m_pNext[0] != RPC_TYPE_INT || getInt(m_pNext + 1) != (uint32_t)expected)
+            return false;
+        m_pNext += 5;
+        return true;
+    }
+    bool floatValue(float expected)
+    {
+        uint32_t bits;
+        memcpy(&bits, &expected, sizeof(bits));
+        if (m_pNext[0] != RPC_TYPE_FLOAT || getInt(m_pNext + 1) != bits)
+            return false;
+        m_pNext += 5;
+        return true;
+    }
+    bool stringValue(const char* pExpected)
+    {
+        size_t length = strlen(pExpected);
+        if (m_pNext[0] != RPC_TYPE_STRING || m_pNext[1] != length || memcmp(m_pNext + 2, pExpected, length) != 0)
+            return false;
+        m_pNext += 2 + length;
+        return true;
+    }
+
+protected:
+    static uint32_t getInt(const uint8_t* p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    const uint8_t* m_pNext;
+    const uint8_t* m_pEnd;
+    bool           m_valid;
+};
+
+
+static void testTextBatches(void)
+{
+    LoopbackStream   stream;
+    RPCStream        server(stream, "rpc");
+    int              a = 1;
+    float            f = 0;
+    RPCVariable<int> rpcA(&a, "a");
+    RPCVariable<float> rpcF(&f, "f");
+
+    sendText(&server, "/a/read\n");
+    CHECK(replied(&stream, "1\n"));
+    sendText(&server, "/a/read;/a/write 5;/a/read;/nope/read;/f/write 2.5;/f/read\r\n");
+    CHECK(replied(&stream, "1;;5;!;;2.5\n"));
+    CHECK(a == 5 && f == 2.5f);
+
+    // Empty lines are ignored, and lines too long to hold are refused.
+    sendText(&server, "\n\r\n");
+    CHECK(replied(&stream, ""));
+    for (int i = 0 ; i < RPC_MAX_FRAME ; i++)
+        sendText(&server, "/a/read;");
+    sendText(&server, "\n/a/read\n");
+    CHECK(replied(&stream, "!\n5\n"));
+
+    // As are single requests longer than Arguments holds.
+    char request[RPC_MAX_STRING + 16];
+    memset(request, 'x', sizeof(request));
+    request[0] = '/';
+    memcpy(&request[sizeof(request) - 2], "\n", 2);
+    sendText(&server, request);
+    CHECK(replied(&stream, "!\n"));
+
+    sendText(&server, "/rpc\n");
+    CHECK(replied(&stream, "subscribe unsubscribe delete\n"));
+}
+
+static void testBinaryFrames(void)
+{
+    LoopbackStream     stream;
+    RPCStream          server(stream, "rpc");
+    int                a = 1;
+    float              f = 0;
+    RPCVariable<int>   rpcA(&a, "a");
+    RPCVariable<float> rpcF(&f, "f");
+    RpcCounter         rpcCounter(3, "counter");
+
+    BinaryRequest request;
+    request.call("a", "read")
+           .call("a", "write", 1).intArg(-7)
+           .call("a", "read")
+           .call("f", "write", 1).floatArg(1.25f)
+           .call("f", "read")
+           .call("f", "write", 1).intArg(3)
+           .call("f", "read")
+           .call("a", "write", 1).stringArg("42")
+           .call("a", "read")
+           .call("nope", "read")
+           .call("counter", "")
+           .call("", "");
+    send(&server, request.frame(), request.length());
+
+    BinaryReply reply(&stream);
+    CHECK(reply.valid());
+    CHECK(reply.status(RPC_STATUS_OK, 5) && reply.intValue(1));
+    CHECK(reply.status(RPC_STATUS_OK, 0));
+    CHECK(reply.status(RPC_STATUS_OK, 5) && reply.intValue(-7));
+    CHECK(reply.status(RPC_STATUS_OK, 0));
+    CHECK(reply.status(RPC_STATUS_OK, 5) && reply.floatValue(1.25f));
+    CHECK(reply.status(RPC_STATUS_OK, 0));
+    CHECK(reply.status(RPC_STATUS_OK, 5) && reply.floatValue(3.0f));
+    CHECK(reply.status(RPC_STATUS_OK, 0));
+    CHECK(reply.status(RPC_STATUS_OK, 5) && reply.intValue(42));
+    CHECK(reply.status(RPC_STATUS_FAILED, 0));
+    CHECK(reply.status(RPC_STATUS_OK, 7 + 6 + 11 + 8));
+    CHECK(reply.stringValue("write") && reply.stringValue("read") && reply.stringValue("increment") && reply.stringValue("delete"));
+    CHECK(reply.status(RPC_STATUS_OK, 5 + 3 + 9 + 3 + 9 + 5) && reply.stringValue("counter") && reply.stringValue("f") &&
+          reply.stringValue("a") && reply.stringValue("rpc") && reply.stringValue("Counter") && reply.stringValue("RPC"));
+    CHECK(reply.done());
+
+    // Text and binary requests can follow each other on the stream.
+    BinaryRequest single;
+    single.call("a", "read");
+    sendText(&server, "/a/read\n");
+    CHECK(replied(&stream, "42\n"));
+    send(&server, single.frame(), single.length());
+    BinaryReply singleReply(&stream);
+    CHECK(singleReply.status(RPC_STATUS_OK, 5) && singleReply.intValue(42) && singleReply.done());
+    sendText(&server, "/f/read\n");
+    CHECK(replied(&stream, "3\n"));
+
+    // A call which is cut short, or has an unknown type, ends the frame.
+    BinaryRequest malformed;
+    malformed.call("a", "read").call("a", "write", 1).raw('x').raw(0);
+    send(&server, malformed.frame(), malformed.length());
+    BinaryReply badType(&stream);
+    CHECK(badType.status(RPC_STATUS_OK, 5) && badType.intValue(42));
+    CHECK(badType.status(RPC_STATUS_MALFORMED, 0) && badType.done());
+
+    BinaryRequest truncated;
+    truncated.call("a", "write", 2).intArg(1);
+    send(&server, truncated.frame(), truncated.length());
+    BinaryReply cutShort(&stream);
+    CHECK(cutShort.status(RPC_STATUS_MALFORMED, 0) && cutShort.done());
+    CHECK(a == 42);
+
+    // Frames too large to hold are skipped.
+    BinaryRequest large;
+    for (int i = 0 ; i < RPC_MAX_FRAME / 7 + 1 ; i++)
+        large.call("a", "read");
+    send(&server, large.frame(), large.length());
+    BinaryReply skipped(&stream);
+    CHECK(skipped.status(RPC_STATUS_MALFORMED, 0) && skipped.done());
+
+    // Replies which don't fit in the frame overflow, and once there is no
+    // room left for their status, the remaining calls aren't made.
+    BinaryRequest many;
+    for (int i = 0 ; i < 20 ; i++)
+        many.call("counter", "");
+    send(&server, many.frame(), many.length());
+    BinaryReply partial(&stream);
+    int calls = 0;
+    while (partial.valid() && !partial.done() && partial.status(RPC_STATUS_OK, 32) &&
+           partial.stringValue("write") && partial.stringValue("read") &&
+           partial.stringValue("increment") && partial.stringValue("delete"))
+    {
+        calls++;
+    }
+    CHECK(calls == RPC_MAX_FRAME / 34);
+    while (partial.valid() && !partial.done() && partial.overflowed())
+        calls++;
+    CHECK(partial.done() && calls < 20);
+}
+
+static void testSubscriptions(void)
+{
+    LoopbackStream     stream;
+    RPCStream          server(stream, "rpc");
+    int                a = 1;
+    int                b = 10;
+    float              f = 0.5f;
+    RPCVariable<int>   rpcA(&a, "a");
+    RPCVariable<int>   rpcB(&b, "b");
+    RPCVariable<float> rpcF(&f, "f");
+
+    sendText(&server, "/rpc/subscribe a 0;/rpc/subscribe b 100;/rpc/subscribe nope 0\n");
+    CHECK(replied(&stream, "1;1;0\n"));
+
+    // Both are pushed at first, and then a only when it changes and b each 100ms.
+    server.poll();
+    CHECK(replied(&stream, "+a 1\n+b 10\n"));
+    g_hostMilliseconds += 50;
+    server.poll();
+    CHECK(replied(&stream, ""));
+    a = 2;
+    server.poll();
+    CHECK(replied(&stream, "+a 2\n"));
+    g_hostMilliseconds += 50;
+    server.poll();
+    CHECK(replied(&stream, "+b 10\n"));
+    b = 11;
+    g_hostMilliseconds += 99;
+    server.poll();
+    CHECK(replied(&stream, ""));
+    g_hostMilliseconds += 1;
+    server.poll();
+    CHECK(replied(&stream, "+b 11\n"));
+
+    // Subscribing again changes the period.
+    sendText(&server, "/rpc/subscribe b 0\n");
+    CHECK(replied(&stream, "1\n"));
+    server.poll();
+    CHECK(replied(&stream, "+b 11\n"));
+    g_hostMilliseconds += 1000;
+    server.poll();
+    CHECK(replied(&stream, ""));
+
+    // Subscriptions made in binary are pushed in binary.
+    BinaryRequest request;
+    request.call("rpc", "subscribe", 2).stringArg("f").intArg(0);
+    send(&server, request.frame(), request.length());
+    BinaryReply reply(&stream);
+    CHECK(reply.status(RPC_STATUS_OK, 5) && reply.intValue(1) && reply.done());
+    server.poll();
+    BinaryReply push(&stream, RPC_FRAME_PUSH);
+    CHECK(push.valid() && push.name("f") && push.floatValue(0.5f) && push.done());
+
+    // Unsubscribed and deleted objects are no longer pushed.
+    sendText(&server, "/rpc/unsubscribe a\n");
+    CHECK(replied(&stream, "\n"));
+    RpcCounter* pCounter = new RpcCounter(1, "c");
+    sendText(&server, "/rpc/subscribe c 0\n");
+    CHECK(replied(&stream, "1\n"));
+    server.poll();
+    CHECK(replied(&stream, "+c 1\n"));
+    delete pCounter;
+    a = 3;
+    b = 12;
+    server.poll();
+    CHECK(replied(&stream, "+b 12\n"));
+    pCounter = new RpcCounter(1, "c");
+    server.poll();
+    CHECK(replied(&stream, ""));
+    delete pCounter;
+
+    // There are only so many subscriptions.
+    char names[RPC_MAX_SUBSCRIPTIONS][8];
+    RPCVariable<int>* variables[RPC_MAX_SUBSCRIPTIONS];
+    int subscribed = 0;
+    for (int i = 0 ; i < RPC_MAX_SUBSCRIPTIONS ; i++)
+    {
+        char line[32];
+        snprintf(names[i], sizeof(names[i]), "v%d", i);
+        variables[i] = new RPCVariable<int>(&a, names[i]);
+        snprintf(line, sizeof(line), "/rpc/subscribe v%d 1000\n", i);
+        sendText(&server, line);
+        subscribed += (stream.data()[0] == '1');
+        stream.clear();
+    }
+    CHECK(subscribed == RPC_MAX_SUBSCRIPTIONS - 2);
+    for (int i = 0 ; i < RPC_MAX_SUBSCRIPTIONS ; i++)
+        delete variables[i];
+}
+
+
+/* Polls objects in turn, the way an HMI reads its variables. */
+static void benchCalls(int objectCount, const char* pMethod)
+{
+    static RPCVariable<int>* objects[maxObjects];
+    static int               values[maxObjects];
+    static char              requests[maxObjects][32];
+    char                     name[16];
+    char                     reply[RPC_MAX_STRING];
+    int                      succeeded = 0;
+
+    for (int i = 0 ; i < objectCount ; i++)
+    {
+        values[i] = i;
+        snprintf(name, sizeof(name), "var%d", i);
+        objects[i] = new RPCVariable<int>(&values[i], name);
+        snprintf(requests[i], sizeof(requests[i]), "/var%d/%s", i, pMethod);
+    }
+
+    uint64_t start = readNanoseconds();
+    for (int i = 0 ; i < benchRequests ; i++)
+        succeeded += RPC::call(requests[i % objectCount], reply);
+    uint64_t elapsed = readNanoseconds() - start;
+
+    for (int i = 0 ; i < objectCount ; i++)
+        delete objects[i];
+
+    CHECK(succeeded == benchRequests);
+    printf("%4d objects, %-7s: %9.0f requests/s\n", objectCount, pMethod, benchRequests / (elapsed / 1e9));
+}
+
+/* Reads 50 float variables each way an HMI could over the link: one text
+   request per line, one batch line, or one binary frame.  Reports the round trips
+   and bytes each takes, the time those bytes take at 115200 baud, and the
+   time RPCStream takes to serve them on the host. */
+static const int pollVariables = 50;
+static const int pollRounds = 20000;
+
+enum PollMethod
+{
+    POLL_LINES,
+    POLL_BATCH,
+    POLL_BINARY
+};
+
+static void benchPolls(PollMethod method, const char* pName)
+{
+    static LoopbackStream stream;
+    RPCStream             server(stream, "rpc");
+    RPCVariable<float>*   variables[pollVariables];
+    float                 values[pollVariables];
+    char                  lines[pollVariables][16];
+    char                  batch[pollVariables * 16];
+    BinaryRequest         binary;
+    size_t                sent = 0;
+    size_t                received = 0;
+    int                   roundTrips = 0;
+
+    batch[0] = '\0';
+    for (int i = 0 ; i < pollVariables ; i++)
+    {
+        char name[8];
+        values[i] = 20.0f + i * 0.1f;
+        snprintf(name, sizeof(name), "v%d", i);
+        variables[i] = new RPCVariable<float>(&values[i], name);
+        snprintf(lines[i], sizeof(lines[i]), "/v%d/read\n", i);
+        snprintf(batch + strlen(batch), sizeof(batch) - strlen(batch), "%s/v%d/read", i ? ";" : "", i);
+        binary.call(name, "read");
+    }
+    strcat(batch, "\n");
+
+    uint64_t start = readNanoseconds();
+    for (int round = 0 ; round < pollRounds ; round++)
+    {
+        stream.clear();
+        switch (method)
+        {
+        case POLL_LINES:
+            for (int i = 0 ; i < pollVariables ; i++)
+            {
+                sendText(&server, lines[i]);
+                if (round == 0)
+                    sent += strlen(lines[i]);
+            }
+            roundTrips = pollVariables;
+            break;
+        case POLL_BATCH:
+            sendText(&server, batch);
+            sent = strlen(batch);
+            roundTrips = 1;
+            break;
+        case POLL_BINARY:
+            send(&server, binary.frame(), binary.length());
+            sent = binary.length();
+            roundTrips = 1;
+            break;
+        }
+        if (round == 0)
+            received = stream.length();
+    }
+    uint64_t elapsed = readNanoseconds() - start;
+
+    for (int i = 0 ; i < pollVariables ; i++)
+        delete variables[i];
+
+    if (method == POLL_BINARY)
+    {
+        CHECK(received == 3 + pollVariables * (2 + 5));
+    }
+    else
+    {
+        size_t separators = 0;
+        for (size_t i = 0 ; i < received ; i++)
+            separators += (stream.data()[i] == '\n' || stream.data()[i] == ';');
+        CHECK(separators == pollVariables && strchr((const char*)stream.data(), '!') == NULL);
+    }
+    printf("%-12s: %2d round trips, %4zu bytes sent, %4zu bytes received, %5.1f ms at 115200, %6.2f us on host\n",
+           pName, roundTrips, sent, received, (sent + received) * 10 * 1000.0 / 115200,
+           elapsed / 1000.0 / pollRounds);
+}
+
+
+int main(void)
+{
+    testRequests();
+    testSharedMethodNames();
+    testLongNames();
+    testManyObjects();
+    testTextBatches();
+    testBinaryFrames();
+    testSubscriptions();
+    printf("RPC validation: %s\n", g_failures ? "FAILED" : "passed");
+    if (g_failures)
+        return 1;
+
+    static const int objectCounts[] = { 1, 16, 256, 1024 };
+    for (size_t i = 0 ; i < sizeof(objectCounts) / sizeof(objectCounts[0]) ; i++)
+    {
+        benchCalls(objectCounts[i], "read");
+        benchCalls(objectCounts[i], "write 5");
+    }
+    benchPolls(POLL_LINES, "Text lines");
+    benchPolls(POLL_BATCH, "Text batch");
+    benchPolls(POLL_BINARY, "Binary frame");
+
+    return g_failures ? 1 : 0;
+}
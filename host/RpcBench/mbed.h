@@ -0,0 +1,31 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Just enough of the mbed API for the RPC dispatcher to be built on the host. */
+#ifndef MBED_H
+#define MBED_H
+
+#include "platform.h"
+#include "Stream.h"
+#include "Timer.h"
+
+#include <math.h>
+#include <time.h>
+
+namespace mbed {}
+
+using namespace mbed;
+using namespace std;
+
+#endif /* MBED_H */
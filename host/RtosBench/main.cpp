@@ -0,0 +1,776 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Checks that the rtos:: classes, on the host simulation of RTX, schedule
+   threads by the same priority rules as RTX, with priority inheritance for
+   mutexes, threads on pooled stacks, timeouts and timers on the virtual
+   clock, and calls from ISR context.  It checks that a Channel delivers the
+   messages of several senders, threads and interrupts alike, in order for
+   each sender, and that an EventQueue runs events in order, delayed and
+   periodic ones on time, posted from threads and interrupts alike.  It then
+   reports what a thread switch, an uncontended mutex, a message through a
+   Queue or a Channel and an event through an EventQueue cost on the host.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "rtos.h"
+
+
+static const int benchRounds = 100000;
+static int       g_failures;
+
+
+#define CHECK(X) \
+    do \
+    { \
+        if (!(X)) \
+        { \
+            printf("FAIL: line %d: %s\n", __LINE__, #X); \
+            g_failures++; \
+        } \
+    } while (0)
+
+
+static uint64_t readNanoseconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/* The order in which threads got somewhere, as a string of their names. */
+static char g_log[64];
+
+static void logEvent(char event)
+{
+    size_t length = strlen(g_log);
+
+    if (length < sizeof(g_log) - 1)
+        g_log[length] = event;
+}
+
+static void clearLog(void)
+{
+    memset(g_log, 0, sizeof(g_log));
+}
+
+
+static void logThread(void const* pArgument)
+{
+    logEvent(*(const char*)pArgument);
+}
+
+static void testPreemption(void)
+{
+    clearLog();
+    logEvent('m');
+    {
+        /* A higher priority thread runs as soon as it is created, and lower
+           or equal ones only once main waits. */
+        Thread high(logThread, (void*)"h", osPriorityHigh);
+        logEvent('m');
+        Thread normal(logThread, (void*)"n", osPriorityNormal);
+        Thread low(logThread, (void*)"l", osPriorityLow);
+        logEvent('m');
+        Thread::wait(1);
+        CHECK(high.get_state() == Thread::Inactive);
+        CHECK(low.get_state() == Thread::Inactive);
+    }
+    CHECK(strcmp(g_log, "mhmmnl") == 0);
+}
+
+
+static void yieldThread(void const* pArgument)
+{
+    for (int i = 0 ; i < 3 ; i++)
+    {
+        logEvent(*(const char*)pArgument);
+        Thread::yield();
+    }
+}
+
+static void testYield(void)
+{
+    clearLog();
+    {
+        Thread a(yieldThread, (void*)"a");
+        Thread b(yieldThread, (void*)"b");
+        Thread::wait(1);
+    }
+    CHECK(strcmp(g_log, "ababab") == 0);
+}
+
+
+static void testStackPool(void)
+{
+    static StackPool<512, 2> s_stacks;
+
+    clearLog();
+    {
+        /* Threads take their stacks from the pool and give them back. */
+        Thread a(logThread, s_stacks, (void*)"a");
+        Thread b(logThread, s_stacks, (void*)"b", osPriorityHigh);
+        CHECK(a.stack_size() == 512);
+        CHECK(s_stacks.alloc_stack() == NULL);
+        Thread::wait(1);
+    }
+    CHECK(strcmp(g_log, "ba") == 0);
+
+    unsigned char* pFirst = s_stacks.alloc_stack();
+    unsigned char* pSecond = s_stacks.alloc_stack();
+    CHECK(pFirst != NULL && pSecond != NULL && pFirst != pSecond);
+    s_stacks.free_stack(pFirst);
+    s_stacks.free_stack(pSecond);
+}
+
+
+static void timeoutThread(void const* pArgument)
+{
+    Semaphore* pSemaphore = (Semaphore*)pArgument;
+
+    Thread::wait(250);
+    pSemaphore->release();
+}
+
+static void testVirtualClock(void)
+{
+    Semaphore semaphore(0);
+    uint64_t  start = readNanoseconds();
+    uint32_t  time = os_host_time();
+
+    CHECK(semaphore.wait(100) == 0);
+    CHECK(os_host_time() - time == 100);
+
+    Thread::wait(60 * 1000);
+    CHECK(os_host_time() - time == 60100);
+
+    Thread thread(timeoutThread, &semaphore);
+    time = os_host_time();
+    CHECK(semaphore.wait(1000) == 1);
+    CHECK(os_host_time() - time == 250);
+    CHECK(readNanoseconds() - start < 1000000000ULL);
+}
+
+
+static Mutex* g_pMutex;
+
+static void lowMutexThread(void const* pArgument)
+{
+    g_pMutex->lock();
+    logEvent('l');
+    Thread::wait(10);
+    logEvent('l');
+    g_pMutex->unlock();
+    logEvent('l');
+}
+
+static void highMutexThread(void const* pArgument)
+{
+    g_pMutex->lock();
+    logEvent('h');
+    g_pMutex->unlock();
+}
+
+static void mediumThread(void const* pArgument)
+{
+    Thread::wait(9);
+    logEvent('m');
+}
+
+static void testPriorityInheritance(void)
+{
+    Mutex mutex;
+
+    g_pMutex = &mutex;
+    clearLog();
+    {
+        /* Low takes the mutex and sleeps; high then waits for it, which
+           lifts low to high so that medium, woken on the same tick as low,
+           doesn't run before low lets go. */
+        Thread low(lowMutexThread, NULL, osPriorityLow);
+        Thread::wait(1);
+        Thread high(highMutexThread, NULL, osPriorityHigh);
+        Thread medium(mediumThread, NULL, osPriorityNormal);
+        CHECK(low.get_priority() == osPriorityHigh);
+        Thread::wait(20);
+        CHECK(low.get_state() == Thread::Inactive);
+    }
+    CHECK(strcmp(g_log, "llhml") == 0);
+
+    CHECK(mutex.trylock());
+    CHECK(mutex.trylock());
+    CHECK(mutex.unlock() == osOK);
+    CHECK(mutex.unlock() == osOK);
+    CHECK(mutex.unlock() == osErrorResource);
+}
+
+
+typedef Queue<int, 4> IntQueue;
+
+static void consumerThread(void const* pArgument)
+{
+    IntQueue* pQueue = (IntQueue*)pArgument;
+
+    for (;;)
+    {
+        osEvent evt = pQueue->get();
+        if (evt.status != osEventMessage || evt.value.p == NULL)
+            break;
+        logEvent('0' + *(int*)evt.value.p);
+        Thread::wait(10);
+    }
+}
+
+struct Message
+{
+    int      value;
+    uint32_t time;
+};
+
+static void mailThread(void const* pArgument)
+{
+    Mail<Message, 2>* pMail = (Mail<Message, 2>*)pArgument;
+
+    for (int i = 0 ; i < 4 ; i++)
+    {
+        Message* pMessage = pMail->alloc(osWaitForever);
+        pMessage->value = i;
+        pMessage->time = os_host_time();
+        pMail->put(pMessage);
+    }
+}
+
+static void testQueues(void)
+{
+    static int values[] = {1, 2, 3, 4, 5, 6};
+    IntQueue   queue;
+
+    clearLog();
+    {
+        /* The queue holds 4, so the 6th put waits for the consumer. */
+        Thread consumer(consumerThread, &queue, osPriorityBelowNormal);
+        uint32_t time = os_host_time();
+        for (size_t i = 0 ; i < sizeof(values) / sizeof(values[0]) ; i++)
+            CHECK(queue.put(&values[i], osWaitForever) == osOK);
+        CHECK(os_host_time() - time == 10);
+        CHECK(queue.put(&values[0], 0) == osErrorResource);
+        CHECK(queue.put(NULL, 100) == osOK);
+        Thread::wait(100);
+    }
+    CHECK(strcmp(g_log, "123456") == 0);
+    CHECK(queue.get(0).status == osOK);
+    CHECK(queue.get(5).status == osEventTimeout);
+
+    /* Mail allocations wait for a free block. */
+    Mail<Message, 2> mail;
+    Thread producer(mailThread, &mail, osPriorityAboveNormal);
+    for (int i = 0 ; i < 4 ; i++)
+    {
+        osEvent evt = mail.get();
+        CHECK(evt.status == osEventMail);
+        Message* pMessage = (Message*)evt.value.p;
+        CHECK(pMessage->value == i);
+        Thread::wait(5);
+        CHECK(mail.free(pMessage) == osOK);
+    }
+    CHECK(mail.free((Message*)values) == osErrorValue);
+    CHECK(mail.get(0).status == osOK);
+
+    MemoryPool<Message, 3> pool;
+    Message* pBlocks[4];
+    for (int i = 0 ; i < 4 ; i++)
+        pBlocks[i] = pool.alloc();
+    CHECK(pBlocks[2] != NULL && pBlocks[3] == NULL);
+    CHECK(pool.free(pBlocks[1]) == osOK);
+    CHECK(pool.calloc() == pBlocks[1]);
+}
+
+
+static int g_ticks;
+
+static void tickTimer(void const* pArgument)
+{
+    g_ticks++;
+}
+
+static void testTimers(void)
+{
+    RtosTimer periodic(tickTimer, osTimerPeriodic);
+    RtosTimer once(tickTimer, osTimerOnce);
+
+    g_ticks = 0;
+    CHECK(periodic.start(100) == osOK);
+    Thread::wait(1050);
+    CHECK(g_ticks == 10);
+    CHECK(periodic.stop() == osOK);
+    CHECK(periodic.stop() == osErrorResource);
+
+    g_ticks = 0;
+    once.start(30);
+    Thread::wait(500);
+    CHECK(g_ticks == 1);
+}
+
+
+static void releaseFromIsr(void const* pArgument)
+{
+    CHECK(osThreadGetId() == NULL);
+    CHECK(osDelay(1) == osErrorISR);
+    ((Semaphore*)pArgument)->release();
+}
+
+static void signalFromIsr(void const* pArgument)
+{
+    ((Thread*)pArgument)->signal_set(0x3);
+}
+
+static void signalThread(void const* pArgument)
+{
+    osEvent evt = Thread::signal_wait(0x3, 1000);
+    CHECK(evt.status == osEventSignal && evt.value.signals == 0x3);
+    evt = Thread::signal_wait(0, 10);
+    CHECK(evt.status == osEventTimeout);
+}
+
+static void* foreignThread(void* pArgument)
+{
+    static int value = 42;
+
+    ((IntQueue*)pArgument)->put(&value);
+    return NULL;
+}
+
+static void testInterrupts(void)
+{
+    Semaphore semaphore(0);
+    uint32_t  time = os_host_time();
+
+    CHECK(os_host_interrupt(70, releaseFromIsr, &semaphore) == osOK);
+    CHECK(semaphore.wait(osWaitForever) == 1);
+    CHECK(os_host_time() - time == 70);
+
+    Thread thread(signalThread);
+    os_host_interrupt(5, signalFromIsr, &thread);
+    Thread::wait(100);
+    CHECK(thread.get_state() == Thread::Inactive);
+
+    /* Other pthreads are interrupt handlers as far as the kernel knows. */
+    IntQueue  queue;
+    pthread_t foreign;
+    pthread_create(&foreign, NULL, foreignThread, &queue);
+    osEvent evt = queue.get();
+    CHECK(evt.status == osEventMessage && *(int*)evt.value.p == 42);
+    pthread_join(foreign, NULL);
+}
+
+
+struct Sample
+{
+    uint16_t sender;
+    uint16_t sequence;
+    uint32_t value;
+};
+
+typedef Channel<Sample, 16> SampleChannel;
+
+static const int senderCount = 4;
+static const int senderMessages = 20000;
+
+static void* senderThread(void* pArgument)
+{
+    SampleChannel* pChannel = (SampleChannel*)pArgument;
+    static int     nextSender;
+    Sample         sample;
+
+    sample.sender = __sync_fetch_and_add(&nextSender, 1) % senderCount;
+    for (int i = 0 ; i < senderMessages ; i++)
+    {
+        sample.sequence = i;
+        sample.value = sample.sender * 100000 + i;
+        while (!pChannel->try_send(sample))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void sendFromIsr(void const* pArgument)
+{
+    Sample sample = {7, 0, 70};
+
+    CHECK(((SampleChannel*)pArgument)->try_send(sample));
+}
+
+static void testChannel(void)
+{
+    SampleChannel channel;
+    Sample        samples[16];
+    uint32_t      time = os_host_time();
+
+    /* Timeouts, and a receiver woken by an interrupt at the right time. */
+    CHECK(!channel.receive(samples[0], 0));
+    CHECK(!channel.receive(samples[0], 20));
+    CHECK(os_host_time() - time == 20);
+    os_host_interrupt(30, sendFromIsr, &channel);
+    CHECK(channel.receive(samples[0]));
+    CHECK(os_host_time() - time == 50 && samples[0].sender == 7 && samples[0].value == 70);
+
+    /* The ring holds 16 and receive_n() takes what is there. */
+    for (int i = 0 ; i < 17 ; i++)
+    {
+        Sample sample = {0, (uint16_t)i, 0};
+        CHECK(channel.try_send(sample) == (i < 16));
+    }
+    CHECK(channel.receive_n(samples, 10) == 10 && samples[9].sequence == 9);
+    CHECK(channel.receive_n(samples, 16, 0) == 6 && samples[5].sequence == 15);
+    CHECK(channel.empty());
+
+    /* Senders running truly in parallel, in order each. */
+    pthread_t senders[senderCount];
+    uint16_t  expected[senderCount] = {0};
+    int       received = 0;
+    for (int i = 0 ; i < senderCount ; i++)
+        pthread_create(&senders[i], NULL, senderThread, &channel);
+    while (received < senderCount * senderMessages)
+    {
+        uint32_t count = channel.receive_n(samples, 16);
+        for (uint32_t i = 0 ; i < count ; i++)
+        {
+            Sample* pSample = &samples[i];
+            CHECK(pSample->sender < senderCount);
+            CHECK(pSample->sequence == expected[pSample->sender % senderCount]);
+            CHECK(pSample->value == pSample->sender * 100000U + pSample->sequence);
+            expected[pSample->sender % senderCount] = pSample->sequence + 1;
+        }
+        received += count;
+    }
+    for (int i = 0 ; i < senderCount ; i++)
+        pthread_join(senders[i], NULL);
+    CHECK(channel.empty());
+}
+
+
+/* Events posted to an EventQueue, in the order run. */
+static uint32_t g_events[64];
+static int      g_eventCount;
+
+static void recordEvent(void const* pArgument)
+{
+    if (g_eventCount < 64)
+        g_events[g_eventCount++] = (uint32_t)(uintptr_t)pArgument;
+}
+
+static void recordPayload(void const* pPayload)
+{
+    uint32_t value;
+
+    memcpy(&value, pPayload, sizeof(value));
+    recordEvent((void*)(uintptr_t)value);
+}
+
+static void breakDispatch(void const* pArgument)
+{
+    ((EventQueue*)pArgument)->break_dispatch();
+}
+
+static void postFromIsr(void const* pArgument)
+{
+    CHECK(((EventQueue*)pArgument)->post(recordEvent, (void*)7));
+}
+
+static void clearEvents(void)
+{
+    memset(g_events, 0, sizeof(g_events));
+    g_eventCount = 0;
+}
+
+struct Posted
+{
+    uint16_t sender;
+    uint16_t sequence;
+};
+
+static uint16_t g_expected[senderCount];
+static int      g_postedCount;
+
+static void checkPosted(void const* pPayload)
+{
+    Posted posted;
+
+    memcpy(&posted, pPayload, sizeof(posted));
+    CHECK(posted.sender < senderCount);
+    CHECK(posted.sequence == g_expected[posted.sender % senderCount]);
+    g_expected[posted.sender % senderCount] = posted.sequence + 1;
+    g_postedCount++;
+}
+
+static void* posterThread(void* pArgument)
+{
+    EventQueue* pQueue = (EventQueue*)pArgument;
+    static int  nextSender;
+    Posted      posted;
+
+    posted.sender = __sync_fetch_and_add(&nextSender, 1) % senderCount;
+    for (int i = 0 ; i < senderMessages ; i++)
+    {
+        posted.sequence = i;
+        while (!pQueue->post(checkPosted, &posted, sizeof(posted)))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void testEventQueue(void)
+{
+    EventQueue queue(4, 2);
+    uint32_t   time = os_host_time();
+
+    /* Runs in the order posted, with payloads copied, and drops when full. */
+    clearEvents();
+    uint32_t value = 3;
+    CHECK(queue.post(recordEvent, (void*)1));
+    CHECK(queue.post(recordPayload, &value, sizeof(value)));
+    value = 4;
+    CHECK(queue.post(recordEvent, (void*)2));
+    CHECK(queue.post(recordEvent));
+    CHECK(!queue.post(recordEvent, (void*)5));
+    CHECK(!queue.post(recordEvent, g_events, EventQueue::payload_size + 1));
+    CHECK(queue.dropped() == 1);
+    CHECK(queue.dispatch(0) == 4);
+    CHECK(g_eventCount == 4 && g_events[0] == 1 && g_events[1] == 3 && g_events[2] == 2 && g_events[3] == 0);
+    CHECK(os_host_time() == time);
+
+    /* A dispatcher asleep is woken by an interrupt, and times out. */
+    os_host_interrupt(30, postFromIsr, &queue);
+    CHECK(queue.dispatch(50) == 1);
+    CHECK(g_events[4] == 7 && os_host_time() - time == 50);
+
+    /* Delayed and periodic events, on the virtual clock. */
+    clearEvents();
+    time = os_host_time();
+    int32_t once = queue.post_in(30, recordEvent, (void*)30);
+    int32_t every = queue.post_every(20, recordEvent, (void*)20);
+    CHECK(once > 0 && every > 0 && once != every);
+    CHECK(queue.post_in(10, recordEvent) == 0);
+    CHECK(queue.dispatch(105) == 6);
+    CHECK(g_eventCount == 6 && g_events[0] == 20 && g_events[1] == 30 && g_events[5] == 20);
+    CHECK(!queue.cancel(once));
+    CHECK(queue.cancel(every));
+    CHECK(!queue.cancel(every));
+    CHECK(queue.dispatch(100) == 0);
+    CHECK(os_host_time() - time == 205);
+
+    /* A cancelled event is not run, and its slot is used again. */
+    clearEvents();
+    once = queue.post_in(10, recordEvent, (void*)10);
+    CHECK(queue.cancel(once));
+    CHECK(queue.dispatch(0) == 0);
+    CHECK(queue.post_in(10, recordEvent, (void*)11) > 0);
+    CHECK(queue.post_in(20, breakDispatch, &queue) > 0);
+    CHECK(queue.dispatch() == 2);
+    CHECK(g_eventCount == 1 && g_events[0] == 11);
+
+    /* A worker thread of higher priority runs events as soon as posted. */
+    EventQueue workerQueue;
+    Thread     worker(EventQueue::worker, &workerQueue, osPriorityHigh);
+    clearEvents();
+    CHECK(workerQueue.post(recordEvent, (void*)1));
+    CHECK(g_eventCount == 1);
+
+    /* Interrupts posting truly in parallel, in order each. */
+    EventQueue parallelQueue(16, 0);
+    pthread_t  posters[senderCount];
+    memset(g_expected, 0, sizeof(g_expected));
+    g_postedCount = 0;
+    for (int i = 0 ; i < senderCount ; i++)
+        pthread_create(&posters[i], NULL, posterThread, &parallelQueue);
+    while (g_postedCount < senderCount * senderMessages)
+        parallelQueue.dispatch(10);
+    for (int i = 0 ; i < senderCount ; i++)
+        pthread_join(posters[i], NULL);
+    CHECK(parallelQueue.dispatch(0) == 0);
+}
+
+
+static void pingThread(void const* pArgument)
+{
+    Semaphore* pSemaphores = (Semaphore*)pArgument;
+
+    for (int i = 0 ; i < benchRounds ; i++)
+    {
+        pSemaphores[0].wait();
+        pSemaphores[1].release();
+    }
+}
+
+static void producerThread(void const* pArgument)
+{
+    IntQueue* pQueue = (IntQueue*)pArgument;
+    static int value;
+
+    for (int i = 0 ; i < benchRounds ; i++)
+        pQueue->put(&value, osWaitForever);
+}
+
+static void channelThread(void const* pArgument)
+{
+    Channel<int, 64>* pChannel = (Channel<int, 64>*)pArgument;
+
+    for (int i = 0 ; i < benchRounds ; i++)
+    {
+        while (!pChannel->try_send(i))
+            Thread::yield();
+    }
+}
+
+static void* channelSender(void* pArgument)
+{
+    Channel<int, 64>* pChannel = (Channel<int, 64>*)pArgument;
+
+    for (int i = 0 ; i < benchRounds / senderCount ; i++)
+    {
+        while (!pChannel->try_send(i))
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void countEvent(void const* pArgument)
+{
+    (*(int*)pArgument)++;
+}
+
+static void eventPoster(void const* pArgument)
+{
+    EventQueue* pQueue = (EventQueue*)pArgument;
+    static int  count;
+
+    for (int i = 0 ; i < benchRounds ; i++)
+    {
+        while (!pQueue->post(countEvent, &count))
+            Thread::yield();
+    }
+    while (!pQueue->post(breakDispatch, pQueue))
+        Thread::yield();
+}
+
+static void benchmark(void)
+{
+    uint64_t start;
+    uint64_t elapsed;
+
+    {
+        Semaphore semaphores[2] = {Semaphore(0), Semaphore(0)};
+        Thread    ping(pingThread, semaphores, osPriorityAboveNormal);
+
+        start = readNanoseconds();
+        for (int i = 0 ; i < benchRounds ; i++)
+        {
+            semaphores[0].release();
+            semaphores[1].wait();
+        }
+        elapsed = readNanoseconds() - start;
+        printf("Semaphore ping-pong : %7.2f us/switch\n", elapsed / 1000.0 / (2.0 * benchRounds));
+    }
+
+    {
+        Mutex mutex;
+
+        start = readNanoseconds();
+        for (int i = 0 ; i < benchRounds ; i++)
+        {
+            mutex.lock();
+            mutex.unlock();
+        }
+        elapsed = readNanoseconds() - start;
+        printf("Mutex lock/unlock   : %7.2f us\n", elapsed / 1000.0 / benchRounds);
+    }
+
+    {
+        IntQueue queue;
+        Thread   producer(producerThread, &queue);
+
+        start = readNanoseconds();
+        for (int i = 0 ; i < benchRounds ; i++)
+            queue.get();
+        elapsed = readNanoseconds() - start;
+        printf("Queue put/get       : %7.2f us/message\n", elapsed / 1000.0 / benchRounds);
+    }
+
+    {
+        Channel<int, 64> channel;
+        Thread           sender(channelThread, &channel);
+        int              messages[16];
+
+        start = readNanoseconds();
+        for (int i = 0 ; i < benchRounds ; )
+            i += channel.receive_n(messages, 16);
+        elapsed = readNanoseconds() - start;
+        printf("Channel from thread : %7.2f us/message, %.0f messages/s\n",
+               elapsed / 1000.0 / benchRounds, benchRounds * 1e9 / elapsed);
+    }
+
+    {
+        Channel<int, 64> channel;
+        pthread_t        senders[senderCount];
+        int              messages[16];
+
+        start = readNanoseconds();
+        for (int i = 0 ; i < senderCount ; i++)
+            pthread_create(&senders[i], NULL, channelSender, &channel);
+        for (int i = 0 ; i < benchRounds / senderCount * senderCount ; )
+            i += channel.receive_n(messages, 16);
+        elapsed = readNanoseconds() - start;
+        for (int i = 0 ; i < senderCount ; i++)
+            pthread_join(senders[i], NULL);
+        printf("Channel from %d ISRs : %7.2f us/message, %.0f messages/s\n",
+               senderCount, elapsed / 1000.0 / benchRounds, benchRounds * 1e9 / elapsed);
+    }
+
+    {
+        EventQueue queue(64, 0);
+        Thread     poster(eventPoster, &queue);
+
+        start = readNanoseconds();
+        queue.dispatch();
+        elapsed = readNanoseconds() - start;
+        printf("EventQueue post/run : %7.2f us/event, %.0f events/s\n",
+               elapsed / 1000.0 / benchRounds, benchRounds * 1e9 / elapsed);
+    }
+}
+
+
+int main(void)
+{
+    testPreemption();
+    testYield();
+    testStackPool();
+    testVirtualClock();
+    testPriorityInheritance();
+    testQueues();
+    testTimers();
+    testInterrupts();
+    testChannel();
+    testEventQueue();
+    printf("rtos validation: %s\n", g_failures ? "FAILED" : "passed");
+
+    benchmark();
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,731 @@
+/* Copyright 2014 Adam Green (http://mbed.org/users/AdamGreen/)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+/* Decodes the trace which RTX keeps when built with OS_TRACE=1, as written by
+   os_trace_dump() or rtos::Trace::dump(), into how much of the CPU each thread
+   and interrupt used, how long threads were blocked, and a timeline in the
+   Chrome trace event format for chrome://tracing.
+
+       RtxTrace [-j timeline.json] trace.bin
+
+   The dump may be surrounded by other output, such as that captured from a
+   serial port.  When run without a trace it decodes a synthetic one and checks
+   the results.
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Layout of the dump, from rt_Trace.h. */
+static const uint32_t traceMagic = 0x54585452;
+static const uint16_t traceVersion = 1;
+static const size_t   headerSize = 24;
+static const size_t   taskSize = 8;
+static const size_t   recordSize = 12;
+
+enum
+{
+    typeIncomplete = 0,
+    typeSwitch = 1,
+    typeIsrEnter = 2,
+    typeIsrExit = 3,
+    typeWait = 4,
+    typeMarker = 5
+};
+
+/* RTX task states, from rt_Task.h. */
+static const uint8_t stateWaitDelay = 3;
+static const uint8_t idleTaskId = 255;
+
+static const int maxIsrNesting = 16;
+static const int histogramBuckets = 24;
+
+
+struct TaskInfo
+{
+    uint8_t  id;
+    uint8_t  prio;
+    uint8_t  state;
+    uint32_t entry;
+};
+
+struct Record
+{
+    uint64_t time;
+    uint32_t sequence;
+    uint8_t  type;
+    uint8_t  task;
+    uint16_t data;
+    uint32_t arg;
+};
+
+struct Trace
+{
+    uint32_t  tickCycles;
+    uint32_t  tickMicroseconds;
+    uint32_t  written;
+    uint32_t  incomplete;
+    uint32_t  taskCount;
+    TaskInfo  tasks[256];
+    uint32_t  recordCount;
+    Record*   pRecords;
+};
+
+struct Usage
+{
+    uint64_t cycles;
+    uint32_t count;
+};
+
+struct BlockStats
+{
+    uint32_t buckets[histogramBuckets];
+    uint32_t count;
+    uint64_t maxCycles;
+};
+
+struct Analysis
+{
+    uint64_t   startTime;
+    uint64_t   endTime;
+    uint32_t   switches;
+    uint32_t   markers;
+    Usage      taskUsage[256];
+    Usage      isrUsage[256];
+    BlockStats blocked[256];
+};
+
+
+static int g_failures;
+
+
+#define CHECK(X) \
+    do \
+    { \
+        if (!(X)) \
+        { \
+            printf("FAIL: line %d: %s\n", __LINE__, #X); \
+            g_failures++; \
+        } \
+    } while (0)
+
+
+static uint16_t readU16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t readU32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int compareRecords(const void* pv1, const void* pv2)
+{
+    const Record* p1 = (const Record*)pv1;
+    const Record* p2 = (const Record*)pv2;
+
+    if (p1->time != p2->time)
+        return p1->time < p2->time ? -1 : 1;
+    return p1->sequence < p2->sequence ? -1 : (p1->sequence > p2->sequence);
+}
+
+/* Interrupt numbers are signed: SysTick is -1, PendSV -2, device IRQs from 0. */
+static int isrIndex(uint16_t irq)
+{
+    return (int16_t)irq + 16;
+}
+
+
+static const uint8_t* findTrace(const uint8_t* pData, size_t size)
+{
+    for (size_t i = 0 ; i + headerSize <= size ; i++)
+    {
+        if (readU32(pData + i) == traceMagic && readU16(pData + i + 4) == traceVersion &&
+            readU16(pData + i + 6) == recordSize)
+        {
+            return pData + i;
+        }
+    }
+    return NULL;
+}
+
+static bool parseTrace(Trace* pTrace, const uint8_t* pData, size_t size)
+{
+    const uint8_t* pStart = findTrace(pData, size);
+    const uint8_t* pEnd = pData + size;
+    const uint8_t* p;
+    uint32_t       count;
+    uint64_t       time = 0;
+    uint32_t       lastRaw = 0;
+
+    memset(pTrace, 0, sizeof(*pTrace));
+    if (!pStart)
+    {
+        fprintf(stderr, "error: no RTX trace found\n");
+        return false;
+    }
+    pTrace->tickCycles = readU32(pStart + 8);
+    pTrace->tickMicroseconds = readU32(pStart + 12);
+    pTrace->written = readU32(pStart + 16);
+    count = readU16(pStart + 20);
+    pTrace->taskCount = readU16(pStart + 22);
+    p = pStart + headerSize;
+    if (pTrace->taskCount > 256 || (size_t)(pEnd - p) < pTrace->taskCount * taskSize + count * recordSize ||
+        pTrace->tickCycles == 0 || pTrace->tickMicroseconds == 0)
+    {
+        fprintf(stderr, "error: RTX trace is truncated or corrupt\n");
+        return false;
+    }
+
+    for (uint32_t i = 0 ; i < pTrace->taskCount ; i++, p += taskSize)
+    {
+        pTrace->tasks[i].id = p[0];
+        pTrace->tasks[i].prio = p[1];
+        pTrace->tasks[i].state = p[2];
+        pTrace->tasks[i].entry = readU32(p + 4);
+    }
+
+    /* The 32-bit timestamps wrap, and a record claimed by a thread may be
+       timed after those of an interrupt which preempted it, so they are
+       unrolled by signed deltas, sorted, and made to start from 0. */
+    pTrace->pRecords = (Record*)calloc(count ? count : 1, sizeof(Record));
+    for (uint32_t i = 0 ; i < count ; i++, p += recordSize)
+    {
+        Record* pRecord = &pTrace->pRecords[pTrace->recordCount];
+        uint32_t raw = readU32(p);
+
+        if (p[4] == typeIncomplete)
+        {
+            pTrace->incomplete++;
+            continue;
+        }
+        if (pTrace->recordCount == 0)
+            time = 1ULL << 32;
+        else
+            time += (int32_t)(raw - lastRaw);
+        lastRaw = raw;
+        pRecord->time = time;
+        pRecord->sequence = i;
+        pRecord->type = p[4];
+        pRecord->task = p[5];
+        pRecord->data = readU16(p + 6);
+        pRecord->arg = readU32(p + 8);
+        pTrace->recordCount++;
+    }
+    qsort(pTrace->pRecords, pTrace->recordCount, sizeof(Record), compareRecords);
+    for (uint32_t i = pTrace->recordCount ; i-- > 0 ; )
+        pTrace->pRecords[i].time -= pTrace->pRecords[0].time;
+    return true;
+}
+
+static void freeTrace(Trace* pTrace)
+{
+    free(pTrace->pRecords);
+    pTrace->pRecords = NULL;
+}
+
+
+static int log2Bucket(uint64_t value)
+{
+    int bucket = 0;
+
+    while (value > 1 && bucket < histogramBuckets - 1)
+    {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static uint64_t toMicroseconds(const Trace* pTrace, uint64_t cycles)
+{
+    return cycles * pTrace->tickMicroseconds / pTrace->tickCycles;
+}
+
+static void analyzeTrace(Analysis* pAnalysis, const Trace* pTrace)
+{
+    uint64_t blockedSince[256];
+    bool     isBlocked[256];
+    int      isrStack[maxIsrNesting];
+    int      isrDepth = 0;
+    uint8_t  current;
+    uint64_t lastTime;
+
+    memset(pAnalysis, 0, sizeof(*pAnalysis));
+    memset(isBlocked, 0, sizeof(isBlocked));
+    if (pTrace->recordCount == 0)
+        return;
+
+    /* Until the first switch, the thread is that which records were made for. */
+    current = pTrace->pRecords[0].task;
+    pAnalysis->startTime = lastTime = pTrace->pRecords[0].time;
+    pAnalysis->endTime = pTrace->pRecords[pTrace->recordCount - 1].time;
+    for (uint32_t i = 0 ; i < pTrace->recordCount ; i++)
+    {
+        const Record* pRecord = &pTrace->pRecords[i];
+        uint64_t      elapsed = pRecord->time - lastTime;
+
+        if (isrDepth > 0)
+            pAnalysis->isrUsage[isrStack[isrDepth - 1]].cycles += elapsed;
+        else
+            pAnalysis->taskUsage[current].cycles += elapsed;
+        lastTime = pRecord->time;
+
+        switch (pRecord->type)
+        {
+        case typeSwitch:
+        {
+            uint8_t old = pRecord->data & 0xFF;
+            uint8_t oldState = pRecord->data >> 8;
+
+            if (oldState >= stateWaitDelay && !isBlocked[old])
+            {
+                isBlocked[old] = true;
+                blockedSince[old] = pRecord->time;
+            }
+            current = pRecord->task;
+            pAnalysis->switches++;
+            pAnalysis->taskUsage[current].count++;
+            if (isBlocked[current])
+            {
+                BlockStats* pStats = &pAnalysis->blocked[current];
+                uint64_t    cycles = pRecord->time - blockedSince[current];
+
+                pStats->buckets[log2Bucket(toMicroseconds(pTrace, cycles))]++;
+                pStats->count++;
+                if (cycles > pStats->maxCycles)
+                    pStats->maxCycles = cycles;
+                isBlocked[current] = false;
+            }
+            break;
+        }
+        case typeWait:
+            /* Blocked from here, if the thread is then switched out. */
+            isBlocked[pRecord->task] = true;
+            blockedSince[pRecord->task] = pRecord->time;
+            break;
+        case typeIsrEnter:
+            if (isrDepth < maxIsrNesting)
+                isrStack[isrDepth++] = isrIndex(pRecord->data);
+            pAnalysis->isrUsage[isrIndex(pRecord->data)].count++;
+            break;
+        case typeIsrExit:
+            if (isrDepth > 0 && isrStack[isrDepth - 1] == isrIndex(pRecord->data))
+                isrDepth--;
+            break;
+        case typeMarker:
+            pAnalysis->markers++;
+            break;
+        }
+    }
+}
+
+
+static const TaskInfo* findTask(const Trace* pTrace, uint8_t id)
+{
+    for (uint32_t i = 0 ; i < pTrace->taskCount ; i++)
+    {
+        if (pTrace->tasks[i].id == id)
+            return &pTrace->tasks[i];
+    }
+    return NULL;
+}
+
+static void taskName(char* pName, size_t size, const Trace* pTrace, uint8_t id)
+{
+    const TaskInfo* pTask = findTask(pTrace, id);
+
+    if (id == idleTaskId)
+        snprintf(pName, size, "idle");
+    else if (pTask)
+        snprintf(pName, size, "thread %u @%08X", id, pTask->entry);
+    else
+        snprintf(pName, size, "thread %u", id);
+}
+
+static void isrName(char* pName, size_t size, int index)
+{
+    if (index == 15)
+        snprintf(pName, size, "SysTick");
+    else if (index == 14)
+        snprintf(pName, size, "PendSV");
+    else
+        snprintf(pName, size, "IRQ %d", index - 16);
+}
+
+static void printReport(const Trace* pTrace, const Analysis* pAnalysis)
+{
+    uint64_t total = pAnalysis->endTime - pAnalysis->startTime;
+    char     name[64];
+
+    printf("%u records, %u lost, %u incomplete, over %llu us\n",
+           pTrace->recordCount, pTrace->written - pTrace->recordCount - pTrace->incomplete, pTrace->incomplete,
+           (unsigned long long)toMicroseconds(pTrace, total));
+    printf("%u thread switches, %u markers\n\n", pAnalysis->switches, pAnalysis->markers);
+    if (total == 0)
+        return;
+
+    printf("%-24s %8s %12s %7s\n", "CPU", "runs", "us", "%");
+    for (int i = 0 ; i < 256 ; i++)
+    {
+        const Usage* pUsage = &pAnalysis->taskUsage[i];
+
+        if (pUsage->cycles == 0 && pUsage->count == 0)
+            continue;
+        taskName(name, sizeof(name), pTrace, i);
+        printf("%-24s %8u %12llu %6.2f%%\n", name, pUsage->count,
+               (unsigned long long)toMicroseconds(pTrace, pUsage->cycles), 100.0 * pUsage->cycles / total);
+    }
+    for (int i = 0 ; i < 256 ; i++)
+    {
+        const Usage* pUsage = &pAnalysis->isrUsage[i];
+
+        if (pUsage->cycles == 0 && pUsage->count == 0)
+            continue;
+        isrName(name, sizeof(name), i);
+        printf("%-24s %8u %12llu %6.2f%%\n", name, pUsage->count,
+               (unsigned long long)toMicroseconds(pTrace, pUsage->cycles), 100.0 * pUsage->cycles / total);
+    }
+
+    for (int i = 0 ; i < 256 ; i++)
+    {
+        const BlockStats* pStats = &pAnalysis->blocked[i];
+
+        if (pStats->count == 0)
+            continue;
+        taskName(name, sizeof(name), pTrace, i);
+        printf("\n%s blocked %u times, at most %llu us\n", name, pStats->count,
+               (unsigned long long)toMicroseconds(pTrace, pStats->maxCycles));
+        for (int bucket = 0 ; bucket < histogramBuckets ; bucket++)
+        {
+            if (pStats->buckets[bucket] == 0)
+                continue;
+            printf("  %8llu us+ %8u\n", bucket ? 1ULL << bucket : 0ULL, pStats->buckets[bucket]);
+        }
+    }
+}
+
+
+static void writeSlice(FILE* pFile, bool* pFirst, const Trace* pTrace, uint64_t start, uint64_t end, int tid,
+                       const char* pName)
+{
+    if (end <= start)
+        return;
+    fprintf(pFile, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            *pFirst ? "" : ",", pName, tid,
+            (double)start * pTrace->tickMicroseconds / pTrace->tickCycles,
+            (double)(end - start) * pTrace->tickMicroseconds / pTrace->tickCycles);
+    *pFirst = false;
+}
+
+/* Threads are shown by their task ID and interrupts on tids from 1000 up. */
+static void writeTimeline(FILE* pFile, const Trace* pTrace)
+{
+    uint64_t sliceStart[maxIsrNesting];
+    int      isrStack[maxIsrNesting];
+    int      isrDepth = 0;
+    bool     first = true;
+    bool     named[256 + 256];
+    char     name[64];
+    uint8_t  current;
+    uint64_t runStart;
+
+    memset(named, 0, sizeof(named));
+    fprintf(pFile, "{\"traceEvents\":[");
+    if (pTrace->recordCount > 0)
+    {
+        current = pTrace->pRecords[0].task;
+        runStart = pTrace->pRecords[0].time;
+        for (uint32_t i = 0 ; i < pTrace->recordCount ; i++)
+        {
+            const Record* pRecord = &pTrace->pRecords[i];
+
+            switch (pRecord->type)
+            {
+            case typeSwitch:
+                taskName(name, sizeof(name), pTrace, current);
+                writeSlice(pFile, &first, pTrace, runStart, pRecord->time, current, name);
+                named[current] = true;
+                current = pRecord->task;
+                runStart = pRecord->time;
+                break;
+            case typeIsrEnter:
+                if (isrDepth < maxIsrNesting)
+                {
+                    isrStack[isrDepth] = isrIndex(pRecord->data);
+                    sliceStart[isrDepth++] = pRecord->time;
+                }
+                break;
+            case typeIsrExit:
+                if (isrDepth > 0 && isrStack[isrDepth - 1] == isrIndex(pRecord->data))
+                {
+                    isrDepth--;
+                    isrName(name, sizeof(name), isrStack[isrDepth]);
+                    writeSlice(pFile, &first, pTrace, sliceStart[isrDepth], pRecord->time,
+                               1000 + isrStack[isrDepth], name);
+                    named[256 + isrStack[isrDepth]] = true;
+                }
+                break;
+            case typeMarker:
+                fprintf(pFile, "%s\n{\"name\":\"marker %u\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%u,"
+                        "\"ts\":%.3f,\"args\":{\"value\":%u}}",
+                        first ? "" : ",", pRecord->data, pRecord->task,
+                        (double)pRecord->time * pTrace->tickMicroseconds / pTrace->tickCycles, pRecord->arg);
+                first = false;
+                break;
+            }
+        }
+        taskName(name, sizeof(name), pTrace, current);
+        writeSlice(pFile, &first, pTrace, runStart, pTrace->pRecords[pTrace->recordCount - 1].time, current, name);
+        named[current] = true;
+    }
+
+    for (int i = 0 ; i < 256 + 256 ; i++)
+    {
+        if (!named[i])
+            continue;
+        if (i < 256)
+            taskName(name, sizeof(name), pTrace, i);
+        else
+            isrName(name, sizeof(name), i - 256);
+        fprintf(pFile, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", i < 256 ? i : 1000 + i - 256, name);
+        first = false;
+    }
+    fprintf(pFile, "\n]}\n");
+}
+
+
+/* Builds a dump the way os_trace_dump() lays it out. */
+class TraceBuilder
+{
+public:
+    TraceBuilder()
+    {
+        m_length = 0;
+        m_recordCount = 0;
+    }
+
+    void text(const char* pText)
+    {
+        memcpy(m_data + m_length, pText, strlen(pText));
+        m_length += strlen(pText);
+    }
+
+    void header(uint32_t tickCycles, uint32_t tickMicroseconds, uint32_t written, uint16_t records, uint16_t tasks)
+    {
+        putU32(traceMagic);
+        putU16(traceVersion);
+        putU16(recordSize);
+        putU32(tickCycles);
+        putU32(tickMicroseconds);
+        putU32(written);
+        putU16(records);
+        putU16(tasks);
+    }
+
+    void task(uint8_t id, uint8_t prio, uint8_t state, uint32_t entry)
+    {
+        m_data[m_length++] = id;
+        m_data[m_length++] = prio;
+        m_data[m_length++] = state;
+        m_data[m_length++] = 0;
+        putU32(entry);
+    }
+
+    void record(uint32_t time, uint8_t type, uint8_t task, uint16_t data, uint32_t arg)
+    {
+        putU32(time);
+        m_data[m_length++] = type;
+        m_data[m_length++] = task;
+        putU16(data);
+        putU32(arg);
+        m_recordCount++;
+    }
+
+    const uint8_t* data()
+    {
+        return m_data;
+    }
+
+    size_t length()
+    {
+        return m_length;
+    }
+
+protected:
+    void putU16(uint16_t value)
+    {
+        m_data[m_length++] = value;
+        m_data[m_length++] = value >> 8;
+    }
+
+    void putU32(uint32_t value)
+    {
+        putU16(value);
+        putU16(value >> 16);
+    }
+
+    uint8_t m_data[4096];
+    size_t  m_length;
+    uint32_t m_recordCount;
+};
+
+
+/* 96 cycles per microsecond.  Thread 1 runs, waits 1ms on a semaphore while
+   thread 2 and then idle run, and is made ready by an IRQ, with the cycle
+   counter wrapping along the way. */
+static void testSyntheticTrace(void)
+{
+    static const uint32_t base = 0xFFFF0000;
+    static const uint32_t us = 96;
+    TraceBuilder builder;
+    Trace        trace;
+    Analysis     analysis;
+
+    builder.text("Trace follows\r\n");
+    builder.header(96000, 1000, 20, 10, 3);
+    builder.task(1, 4, 2, 0x1001);
+    builder.task(2, 3, 1, 0x2001);
+    builder.task(idleTaskId, 0, 1, 0x3001);
+    builder.record(base, typeMarker, 1, 7, 42);
+    builder.record(base + 100 * us, typeWait, 1, 0xFFFF, 0x10000100);
+    builder.record(base + 100 * us, typeSwitch, 2, 1 | (7 << 8), 0x2001);
+    /* Claimed by thread 2, then preempted by the IRQ before taking its time. */
+    builder.record(base + 1000 * us, typeSwitch, idleTaskId, 2 | (7 << 8), 0x3001);
+    builder.record(base + 800 * us, typeIsrEnter, 2, 5, 0);
+    builder.record(base + 810 * us, typeIsrExit, 2, 5, 0);
+    builder.record(0, typeIncomplete, 0, 0, 0);
+    builder.record(base + 1100 * us, typeIsrEnter, idleTaskId, 0xFFFE, 0);
+    builder.record(base + 1100 * us + 10 * us, typeSwitch, 1, idleTaskId | (1 << 8), 0x1001);
+    builder.record(base + 1100 * us + 20 * us, typeIsrExit, 1, 0xFFFE, 0);
+    builder.text("\r\nDone\r\n");
+
+    CHECK(parseTrace(&trace, builder.data(), builder.length()));
+    CHECK(trace.taskCount == 3);
+    CHECK(trace.tasks[2].id == idleTaskId && trace.tasks[0].entry == 0x1001);
+    CHECK(trace.recordCount == 9);
+    CHECK(trace.incomplete == 1);
+    CHECK(trace.pRecords[3].type == typeIsrEnter && trace.pRecords[5].type == typeSwitch);
+    CHECK(trace.pRecords[0].time == 0 && trace.pRecords[8].time == 1120 * us);
+
+    analyzeTrace(&analysis, &trace);
+    CHECK(analysis.switches == 3);
+    CHECK(analysis.markers == 1);
+    CHECK(analysis.taskUsage[1].cycles == 100 * us);
+    CHECK(analysis.taskUsage[2].cycles == 890 * us);
+    CHECK(analysis.isrUsage[isrIndex(5)].cycles == 10 * us);
+    CHECK(analysis.taskUsage[idleTaskId].cycles == 100 * us);
+    CHECK(analysis.isrUsage[isrIndex(0xFFFE)].cycles == 20 * us);
+    CHECK(analysis.blocked[1].count == 1);
+    CHECK(analysis.blocked[1].maxCycles == 1010 * us);
+    CHECK(analysis.blocked[1].buckets[9] == 1);
+    CHECK(analysis.blocked[2].count == 0);
+
+    FILE* pFile = tmpfile();
+    char  json[4096];
+    size_t length;
+
+    writeTimeline(pFile, &trace);
+    rewind(pFile);
+    length = fread(json, 1, sizeof(json) - 1, pFile);
+    json[length] = '\0';
+    fclose(pFile);
+    CHECK(strstr(json, "\"name\":\"thread 2 @00002001\",\"ph\":\"X\",\"pid\":0,\"tid\":2,\"ts\":100.000,"
+                       "\"dur\":900.000") != NULL);
+    CHECK(strstr(json, "\"name\":\"IRQ 5\",\"ph\":\"X\",\"pid\":0,\"tid\":1021,\"ts\":800.000,\"dur\":10.000") != NULL);
+    CHECK(strstr(json, "\"name\":\"marker 7\",\"ph\":\"i\"") != NULL);
+    CHECK(strstr(json, "\"args\":{\"name\":\"PendSV\"}") != NULL);
+
+    printReport(&trace, &analysis);
+    freeTrace(&trace);
+
+    CHECK(!parseTrace(&trace, (const uint8_t*)"no trace here", 13));
+    freeTrace(&trace);
+}
+
+
+static uint8_t* readFile(const char* pFilename, size_t* pSize)
+{
+    FILE*    pFile = fopen(pFilename, "rb");
+    uint8_t* pData;
+    long     size;
+
+    if (!pFile)
+    {
+        perror(pFilename);
+        return NULL;
+    }
+    fseek(pFile, 0, SEEK_END);
+    size = ftell(pFile);
+    rewind(pFile);
+    pData = (uint8_t*)malloc(size ? size : 1);
+    *pSize = fread(pData, 1, size, pFile);
+    fclose(pFile);
+    return pData;
+}
+
+int main(int argc, char** argv)
+{
+    const char* pTimeline = NULL;
+    const char* pInput = NULL;
+
+    for (int i = 1 ; i < argc ; i++)
+    {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            pTimeline = argv[++i];
+        else
+            pInput = argv[i];
+    }
+
+    if (!pInput)
+    {
+        testSyntheticTrace();
+        printf("\nRtxTrace validation: %s\n", g_failures ? "FAILED" : "passed");
+        return g_failures ? 1 : 0;
+    }
+
+    Trace    trace;
+    Analysis analysis;
+    size_t   size = 0;
+    uint8_t* pData = readFile(pInput, &size);
+
+    if (!pData || !parseTrace(&trace, pData, size))
+    {
+        free(pData);
+        return 1;
+    }
+    analyzeTrace(&analysis, &trace);
+    printReport(&trace, &analysis);
+    if (pTimeline)
+    {
+        FILE* pFile = fopen(pTimeline, "w");
+        if (!pFile)
+        {
+            perror(pTimeline);
+        }
+        else
+        {
+            writeTimeline(pFile, &trace);
+            fclose(pFile);
+            printf("\nTimeline written to %s\n", pTimeline);
+        }
+    }
+    freeTrace(&trace);
+    free(pData);
+    return 0;
+}
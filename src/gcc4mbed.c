@@ -18,6 +18,10 @@
 #include <errno.h>
 #include <mri.h>
 #include <cmsis.h>
+#if TLSF_HEAP
+#include <reent.h>
+#include <mbed_heap.h>
+#endif
 
 
 extern unsigned int __bss_start__;
@@ -75,6 +79,55 @@ int __wrap__isatty(int file)
 }
 
 
+#if TLSF_HEAP
+/* Route newlib's allocations, including the reentrant ones that it makes internally, to the TLSF heap. */
+void* __wrap_malloc(size_t size)
+{
+    return mbed_heap_malloc(size);
+}
+
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    return mbed_heap_realloc(ptr, size);
+}
+
+
+void __wrap_free(void* ptr)
+{
+    mbed_heap_free(ptr);
+}
+
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    return mbed_heap_calloc(count, size);
+}
+
+
+void* __wrap__malloc_r(struct _reent* pReent, size_t size)
+{
+    return mbed_heap_malloc(size);
+}
+
+
+void* __wrap__realloc_r(struct _reent* pReent, void* ptr, size_t size)
+{
+    return mbed_heap_realloc(ptr, size);
+}
+
+
+void __wrap__free_r(struct _reent* pReent, void* ptr)
+{
+    mbed_heap_free(ptr);
+}
+
+
+void* __wrap__calloc_r(struct _reent* pReent, size_t count, size_t size)
+{
+    return mbed_heap_calloc(count, size);
+}
+#else
 /* Wrap memory allocation routines to make sure that they aren't being called from interrupt handler. */
 static void breakOnHeapOpFromInterruptHandler(void)
 {
@@ -108,6 +161,7 @@ void __wrap_free(void* ptr)
     breakOnHeapOpFromInterruptHandler();
     __real_free(ptr);
 }
+#endif
 
 
 int __wrap_semihost_connected(void)